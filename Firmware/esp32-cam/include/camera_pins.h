@@ -0,0 +1,33 @@
+#pragma once
+// ======================================================
+// 📷 AI-THINKER ESP32-CAM (OV2640) PINOUT
+// ======================================================
+//
+// ⚠️ Lưu ý:
+// - GPIO4 nối LED flash, GPIO33 là LED đỏ trên board (active LOW).
+// - PSRAM dùng GPIO16/17, không dùng cho việc khác.
+// - GPIO0 kéo LOW khi nạp firmware; camera dùng GPIO0 làm XCLK nên
+//   phải tháo jumper nạp trước khi chạy.
+//
+// ======================================================
+
+#define CAM_PIN_PWDN     32
+#define CAM_PIN_RESET    -1   // không nối, reset bằng PWDN
+#define CAM_PIN_XCLK     0
+#define CAM_PIN_SIOD     26   // SCCB SDA
+#define CAM_PIN_SIOC     27   // SCCB SCL
+
+#define CAM_PIN_D7       35
+#define CAM_PIN_D6       34
+#define CAM_PIN_D5       39
+#define CAM_PIN_D4       36
+#define CAM_PIN_D3       21
+#define CAM_PIN_D2       19
+#define CAM_PIN_D1       18
+#define CAM_PIN_D0       5
+#define CAM_PIN_VSYNC    25
+#define CAM_PIN_HREF     23
+#define CAM_PIN_PCLK     22
+
+#define CAM_LED_FLASH    4
+#define CAM_LED_STATUS   33
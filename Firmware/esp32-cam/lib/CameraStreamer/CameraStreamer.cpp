@@ -0,0 +1,509 @@
+#include "CameraStreamer.h"
+#include <ArduinoJson.h>
+#include <WiFi.h>
+#include <esp_timer.h>
+#include <img_converters.h>
+#include "MessageTypes.h"
+#include "camera_pins.h"
+
+// Độ phân giải từ thấp tới cao; begin() cắt ở maxSize
+static const framesize_t LADDER[] = { FRAMESIZE_QVGA, FRAMESIZE_CIF, FRAMESIZE_HVGA, FRAMESIZE_VGA, FRAMESIZE_SVGA };
+static const uint8_t LADDER_COUNT = sizeof(LADDER) / sizeof(LADDER[0]);
+static const uint16_t LADDER_WIDTH[] = { 320, 400, 480, 640, 800 };
+static const uint16_t LADDER_HEIGHT[] = { 240, 296, 320, 480, 600 };
+
+static const uint8_t QUALITY_STEP = 4;
+static const uint8_t PRESSURE_HIGH_PCT = 75;      // % ngân sách 1/fps
+static const uint8_t PRESSURE_LOW_PCT = 30;
+static const uint16_t CALM_FRAMES_TO_STEP_UP = 45; // ~3 s ở 15 fps
+static const uint16_t COOLDOWN_FRAMES = 8;
+static const uint8_t DETECT_EVERY_ACTIVE = 3;
+
+bool CameraStreamer::FrameSocket::sendFragment(bool first, const uint8_t *data, size_t length, bool fin) {
+    // headerToPayload = false: thư viện ghi header WS riêng rồi ghi thẳng data
+    return sendFrame(&_client, first ? WSop_binary : WSop_continuation, (uint8_t *)data, length, fin, false);
+}
+
+CameraStreamer::CameraStreamer(const char *host, uint16_t port, const char *robotId)
+: host(host), port(port), robotId(robotId), connectionId(""),
+  cameraReady(false), ready(false), streaming(true),
+  level(0), maxLevel(0), quality(12), targetFps(DEFAULT_FPS), intervalUs(1000000UL / DEFAULT_FPS), nextFrameUs(0),
+  sendAvgUs(0), calmFrames(0), cooldownFrames(0),
+  seq(0), sentFrames(0), sentBytes(0), sendErrors(0), adaptations(0),
+  windowStartMs(0), windowFrames(0), fps(0),
+  gating(false), active(true), holdMs(10000), keyframeMs(30000), lastMotionMs(0), lastPirMs(0), lastUploadMs(0),
+  visualStreak(0), detectSkip(0), rgbBuf(nullptr), grayBuf(nullptr), motionEvents(0), keyframes(0),
+  sendHist(Metrics::histogram("cam.send_us")), detectHist(Metrics::histogram("cam.detect_us")),
+  frameBytes(Metrics::histogram("cam.frame_bytes")) {
+}
+
+void CameraStreamer::setServer(const char *host, uint16_t port, const char *robotId) {
+    this->host = host;
+    this->port = port;
+    this->robotId = robotId;
+}
+
+bool CameraStreamer::begin(framesize_t maxSize, uint8_t startQuality) {
+    maxLevel = 0;
+    for (uint8_t i = 0; i < LADDER_COUNT && LADDER[i] <= maxSize; i++) {
+        maxLevel = i;
+    }
+
+    camera_config_t config = {};
+    config.pin_pwdn = CAM_PIN_PWDN;
+    config.pin_reset = CAM_PIN_RESET;
+    config.pin_xclk = CAM_PIN_XCLK;
+    config.pin_sccb_sda = CAM_PIN_SIOD;
+    config.pin_sccb_scl = CAM_PIN_SIOC;
+    config.pin_d7 = CAM_PIN_D7;
+    config.pin_d6 = CAM_PIN_D6;
+    config.pin_d5 = CAM_PIN_D5;
+    config.pin_d4 = CAM_PIN_D4;
+    config.pin_d3 = CAM_PIN_D3;
+    config.pin_d2 = CAM_PIN_D2;
+    config.pin_d1 = CAM_PIN_D1;
+    config.pin_d0 = CAM_PIN_D0;
+    config.pin_vsync = CAM_PIN_VSYNC;
+    config.pin_href = CAM_PIN_HREF;
+    config.pin_pclk = CAM_PIN_PCLK;
+    config.xclk_freq_hz = 20000000;
+    config.ledc_timer = LEDC_TIMER_0;
+    config.ledc_channel = LEDC_CHANNEL_0;
+    config.pixel_format = PIXFORMAT_JPEG;
+    config.jpeg_quality = startQuality;
+
+    if (psramFound()) {
+        // 2 buffer: DMA ghi ảnh mới trong lúc ảnh cũ đang được gửi
+        config.fb_count = 2;
+        config.fb_location = CAMERA_FB_IN_PSRAM;
+        config.grab_mode = CAMERA_GRAB_LATEST;
+    } else {
+        // Không PSRAM: một buffer nhỏ trong DRAM, không pipeline được
+        config.fb_count = 1;
+        config.fb_location = CAMERA_FB_IN_DRAM;
+        config.grab_mode = CAMERA_GRAB_WHEN_EMPTY;
+        maxLevel = min<uint8_t>(maxLevel, 1);
+        Serial.println("[Camera] No PSRAM, streaming limited to CIF");
+    }
+    config.frame_size = LADDER[maxLevel];
+
+    esp_err_t err = esp_camera_init(&config);
+    if (err != ESP_OK) {
+        Serial.printf("[Camera] Init failed: 0x%x\n", err);
+        return false;
+    }
+    cameraReady = true;
+
+    // Bắt đầu ở độ phân giải tối đa; backpressure tự hạ xuống nếu mạng không kịp
+    level = maxLevel;
+    quality = constrain(startQuality, QUALITY_BEST, QUALITY_WORST);
+    applySettings();
+
+    socket.begin(host, port, "/");
+    socket.onEvent([this](WStype_t type, uint8_t *payload, size_t length) { onEvent(type, payload, length); });
+    socket.setReconnectInterval(5000);
+    socket.enableHeartbeat(15000, 3000, 2);
+    Serial.printf("[Camera] Streaming up to %ux%u @ %u fps to %s:%u\n",
+                  LADDER_WIDTH[maxLevel], LADDER_HEIGHT[maxLevel], targetFps, host, port);
+    return true;
+}
+
+// ============================================
+// STREAM
+// ============================================
+
+void CameraStreamer::update() {
+    socket.loop();
+    if (!cameraReady || !ready || !streaming) {
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    if (now < nextFrameUs) {
+        return;
+    }
+    // Chậm hơn một chu kỳ thì không chạy bù, bắt đầu lại từ bây giờ
+    uint32_t interval = active ? intervalUs : 1000000UL / IDLE_FPS;
+    nextFrameUs = now - nextFrameUs > (int64_t)interval ? now + interval : nextFrameUs + interval;
+
+    camera_fb_t *fb = esp_camera_fb_get();
+    if (fb == nullptr) {
+        Serial.println("[Camera] Frame capture failed");
+        return;
+    }
+    if (!shouldUpload(fb)) {
+        esp_camera_fb_return(fb);
+        return;
+    }
+    int64_t start = esp_timer_get_time();
+    bool ok = sendFrame(fb);
+    uint32_t sendUs = (uint32_t)(esp_timer_get_time() - start);
+    frameBytes->record(fb->len);
+    esp_camera_fb_return(fb);
+
+    sendHist->record(sendUs);
+    adapt(sendUs, ok);
+
+    windowFrames++;
+    uint32_t ms = millis();
+    if (ms - windowStartMs >= 1000) {
+        fps = windowFrames * 1000.0f / (ms - windowStartMs);
+        windowFrames = 0;
+        windowStartMs = ms;
+    }
+}
+
+bool CameraStreamer::sendFrame(camera_fb_t *fb) {
+    int64_t capturedUs = (int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec;
+    int64_t ageMs = (esp_timer_get_time() - capturedUs) / 1000;
+
+    uint8_t head[sizeof(FrameHeader) + sizeof(VideoHeader)];
+    FrameHeader header = { BINARY_VERSION, CHANNEL_VIDEO, seq, (uint32_t)millis() };
+    VideoHeader video = { (uint16_t)fb->width, (uint16_t)fb->height, VIDEO_FORMAT_JPEG, quality,
+                          (uint16_t)constrain(ageMs, (int64_t)0, (int64_t)0xFFFF) };
+    memcpy(head, &header, sizeof(header));
+    memcpy(head + sizeof(header), &video, sizeof(video));
+
+    if (!socket.sendFragment(true, head, sizeof(head), false) ||
+        !socket.sendFragment(false, fb->buf, fb->len, true)) {
+        // Message dở dang làm lệch luồng frame phía server: đóng và kết nối lại
+        sendErrors++;
+        socket.disconnect();
+        return false;
+    }
+    seq++;
+    sentFrames++;
+    sentBytes += fb->len;
+    lastUploadMs = millis();
+    return true;
+}
+
+// ============================================
+// LỌC THEO CHUYỂN ĐỘNG
+// ============================================
+
+bool CameraStreamer::shouldUpload(camera_fb_t *fb) {
+    if (!gating) {
+        return true;
+    }
+    uint32_t ms = millis();
+    bool pirRecent = lastPirMs != 0 && ms - lastPirMs < PIR_WINDOW_MS;
+
+    // Lúc active chỉ cần biết chuyển động còn tiếp diễn, không cần xét mọi ảnh
+    if (!active || ++detectSkip >= DETECT_EVERY_ACTIVE) {
+        detectSkip = 0;
+        bool visual = detectMotion(fb);
+        visualStreak = visual ? min<uint8_t>(visualStreak + 1, 0xFF) : 0;
+        if (visual && (pirRecent || visualStreak >= CONFIRM_FRAMES)) {
+            lastMotionMs = ms;
+        }
+    }
+    // PIR một mình cũng đủ bật stream (camera có thể đang quay hướng khác)
+    if (pirRecent && (lastMotionMs == 0 || (int32_t)(lastPirMs - lastMotionMs) > 0)) {
+        lastMotionMs = lastPirMs;
+    }
+
+    bool wasActive = active;
+    active = lastMotionMs != 0 && ms - lastMotionMs < holdMs;
+    if (active != wasActive) {
+        if (active) {
+            motionEvents++;
+        }
+        Serial.printf("[Camera] %s (%u/%u blocks changed%s)\n", active ? "Motion, streaming" : "Idle",
+                      detector.getChangedBlocks(), detector.getTotalBlocks(), pirRecent ? ", PIR" : "");
+        nextFrameUs = esp_timer_get_time();
+    }
+    if (active) {
+        return true;
+    }
+    // Idle: chỉ keyframe để server vẫn thấy cảnh hiện tại
+    if (lastUploadMs == 0 || ms - lastUploadMs >= keyframeMs) {
+        keyframes++;
+        return true;
+    }
+    return false;
+}
+
+// Giải mã JPEG ở 1/8 (gần như chỉ hệ số DC, vài ms) rồi đổi sang xám
+bool CameraStreamer::detectMotion(camera_fb_t *fb) {
+    CycleTimer timer(detectHist);
+    uint16_t width = fb->width / 8;
+    uint16_t height = fb->height / 8;
+    if (rgbBuf == nullptr || !jpg2rgb565(fb->buf, fb->len, rgbBuf, JPG_SCALE_8X)) {
+        return false;
+    }
+    // Cắt về bội của khối 8x8, hàng ảnh xám liền nhau nên luôn căn 4 byte
+    uint16_t grayWidth = width - width % MotionDetector::BLOCK;
+    uint16_t grayHeight = height - height % MotionDetector::BLOCK;
+    for (uint16_t y = 0; y < grayHeight; y++) {
+        const uint8_t *src = rgbBuf + (size_t)y * width * 2;
+        uint8_t *dst = grayBuf + (size_t)y * grayWidth;
+        for (uint16_t x = 0; x < grayWidth; x++) {
+            // jpg2rgb565 ghi big-endian
+            uint16_t c = (uint16_t)(src[2 * x] << 8) | src[2 * x + 1];
+            uint32_t r = c >> 11, g = (c >> 5) & 0x3F, b = c & 0x1F;
+            dst[x] = (uint8_t)((r * 616 + g * 600 + b * 232) >> 8);   // 0.299 R + 0.587 G + 0.114 B
+        }
+    }
+    detector.process(grayBuf, grayWidth, grayHeight);
+    return detector.isMotion();
+}
+
+bool CameraStreamer::setMotionGating(bool enabled, uint32_t hold, uint32_t keyframe) {
+    holdMs = hold;
+    keyframeMs = keyframe;
+    if (enabled && rgbBuf == nullptr) {
+        uint16_t width = LADDER_WIDTH[maxLevel] / 8;
+        uint16_t height = LADDER_HEIGHT[maxLevel] / 8;
+        size_t rgbSize = (size_t)width * height * 2;
+        rgbBuf = (uint8_t *)(psramFound() ? ps_malloc(rgbSize) : malloc(rgbSize));
+        grayBuf = (uint8_t *)malloc((size_t)width * height);
+        if (rgbBuf == nullptr || grayBuf == nullptr || !detector.begin(width, height)) {
+            free(rgbBuf);
+            free(grayBuf);
+            rgbBuf = nullptr;
+            grayBuf = nullptr;
+            Serial.println("[Camera] Not enough memory for motion detection");
+            return false;
+        }
+    }
+    gating = enabled;
+    active = !enabled;
+    detector.reset();
+    visualStreak = 0;
+    return true;
+}
+
+void CameraStreamer::setMotionThresholds(uint8_t pixelDelta, uint16_t minBlocks) {
+    detector.setThresholds(pixelDelta, minBlocks);
+}
+
+void CameraStreamer::triggerMotion() {
+    lastPirMs = millis();
+    if (lastPirMs == 0) {
+        lastPirMs = 1;
+    }
+}
+
+bool CameraStreamer::isActive() const {
+    return active;
+}
+
+// ============================================
+// THÍCH ỨNG THEO BACKPRESSURE
+// ============================================
+
+void CameraStreamer::adapt(uint32_t sendUs, bool ok) {
+    sendAvgUs = sendAvgUs == 0 ? sendUs : sendAvgUs + ((int32_t)(sendUs - sendAvgUs) >> 3);
+    if (cooldownFrames > 0) {
+        cooldownFrames--;
+        return;
+    }
+
+    uint32_t pressurePct = (uint32_t)((uint64_t)sendAvgUs * 100 / intervalUs);
+    if (!ok || pressurePct > PRESSURE_HIGH_PCT) {
+        calmFrames = 0;
+        stepDown();
+        return;
+    }
+    if (pressurePct < PRESSURE_LOW_PCT) {
+        if (++calmFrames >= CALM_FRAMES_TO_STEP_UP) {
+            calmFrames = 0;
+            stepUp();
+        }
+    } else {
+        calmFrames = 0;
+    }
+}
+
+// Nén mạnh hơn trước, hết nấc nén mới giảm độ phân giải
+void CameraStreamer::stepDown() {
+    if (quality < QUALITY_WORST) {
+        quality = min<uint8_t>(quality + QUALITY_STEP, QUALITY_WORST);
+    } else if (level > 0) {
+        level--;
+        quality = (QUALITY_BEST + QUALITY_WORST) / 2;   // ảnh nhỏ hơn ~1/2, nới nén lại
+    } else {
+        return;
+    }
+    applySettings();
+}
+
+// Ngược lại: lấy lại độ phân giải trước, ảnh to hơn nên bắt đầu ở mức nén cao
+bool CameraStreamer::stepUp() {
+    if (level < maxLevel && quality <= (QUALITY_BEST + QUALITY_WORST) / 2) {
+        level++;
+        quality = QUALITY_WORST - QUALITY_STEP;
+    } else if (quality > QUALITY_BEST) {
+        quality = max<uint8_t>(quality - QUALITY_STEP, QUALITY_BEST);
+    } else {
+        return false;
+    }
+    applySettings();
+    return true;
+}
+
+void CameraStreamer::applySettings() {
+    sensor_t *sensor = esp_camera_sensor_get();
+    if (sensor == nullptr) {
+        return;
+    }
+    sensor->set_framesize(sensor, LADDER[level]);
+    sensor->set_quality(sensor, quality);
+    adaptations++;
+    cooldownFrames = COOLDOWN_FRAMES;
+    Serial.printf("[Camera] %ux%u q%u (send avg %u us of %u us)\n",
+                  LADDER_WIDTH[level], LADDER_HEIGHT[level], quality, sendAvgUs, intervalUs);
+}
+
+// ============================================
+// WEBSOCKET
+// ============================================
+
+void CameraStreamer::onEvent(WStype_t type, uint8_t *payload, size_t length) {
+    switch (type) {
+        case WStype_DISCONNECTED:
+            if (ready) {
+                Serial.println("[Camera] Disconnected from server");
+            }
+            ready = false;
+            connectionId = "";
+            break;
+        case WStype_CONNECTED:
+            Serial.println("[Camera] Connected to server");
+            sendConnectionInit();
+            break;
+        case WStype_TEXT:
+            handleText(payload, length);
+            break;
+        default:
+            break;
+    }
+}
+
+// Cùng định dạng connection_init với WebSocketClient, thêm thông số video
+void CameraStreamer::sendConnectionInit() {
+    StaticJsonDocument<512> doc;
+    doc["id"] = generateId();
+    doc["type"] = messageTypeName(MessageType::CONNECTION_INIT);
+    doc["source"] = connectionTypeName(ConnectionType::ESP32_TYPE);
+    doc["robotId"] = robotId;
+    doc["timestamp"] = millis();
+
+    JsonObject payloadObj = doc.createNestedObject("payload");
+    payloadObj["userId"] = nullptr;
+    payloadObj["ipAddress"] = WiFi.localIP().toString();
+    JsonArray encodings = payloadObj.createNestedArray("encodings");
+    encodings.add(BINARY_ENCODING);
+
+    JsonObject video = payloadObj.createNestedObject("video");
+    video["codec"] = "mjpeg";
+    video["channel"] = (uint8_t)CHANNEL_VIDEO;
+    video["maxWidth"] = LADDER_WIDTH[maxLevel];
+    video["maxHeight"] = LADDER_HEIGHT[maxLevel];
+    video["fps"] = targetFps;
+    video["motionGated"] = gating;
+
+    String output;
+    serializeJson(doc, output);
+    socket.sendTXT(output);
+}
+
+void CameraStreamer::handleText(const uint8_t *payload, size_t length) {
+    StaticJsonDocument<384> doc;
+    if (deserializeJson(doc, (const char *)payload, length)) {
+        return;
+    }
+    MessageType type;
+    if (!messageTypeFromName(doc["type"] | "", type)) {
+        return;
+    }
+    // PIR của board chính, server chuyển tiếp sensor_alert cho camera cùng robotId
+    if (type == MessageType::SENSOR_ALERT) {
+        const char *sensor = doc["payload"]["sensorType"] | "";
+        if (strcmp(sensor, "motion") == 0) {
+            triggerMotion();
+        }
+        return;
+    }
+    if (type != MessageType::ACK) {
+        return;
+    }
+    if (doc["payload"]["connectionId"]) {
+        connectionId = doc["payload"]["connectionId"].as<String>();
+        ready = true;
+        nextFrameUs = esp_timer_get_time();
+        sendAvgUs = 0;
+        Serial.println("[Camera] Connection established with ID: " + connectionId);
+    }
+}
+
+String CameraStreamer::generateId() const {
+    char id[37];
+    sprintf(id, "%08x-%04x-%04x-%04x-%012x",
+            (unsigned)esp_random(), (unsigned)(esp_random() & 0xFFFF),
+            (unsigned)((esp_random() & 0x0FFF) | 0x4000), (unsigned)((esp_random() & 0x3FFF) | 0x8000),
+            (unsigned)esp_random());
+    return String(id);
+}
+
+// ============================================
+// CẤU HÌNH / THỐNG KÊ
+// ============================================
+
+void CameraStreamer::setStreaming(bool enabled) {
+    streaming = enabled;
+    nextFrameUs = esp_timer_get_time();
+}
+
+void CameraStreamer::setTargetFps(uint8_t value) {
+    targetFps = value == 0 ? 1 : min<uint8_t>(value, 30);
+    intervalUs = 1000000UL / targetFps;
+    calmFrames = 0;
+}
+
+bool CameraStreamer::isReady() const {
+    return ready;
+}
+
+framesize_t CameraStreamer::getFrameSize() const {
+    return LADDER[level];
+}
+
+uint8_t CameraStreamer::getQuality() const {
+    return quality;
+}
+
+float CameraStreamer::getFps() const {
+    return fps;
+}
+
+uint32_t CameraStreamer::getSentFrames() const {
+    return sentFrames;
+}
+
+uint32_t CameraStreamer::getSendErrors() const {
+    return sendErrors;
+}
+
+uint32_t CameraStreamer::getAdaptations() const {
+    return adaptations;
+}
+
+uint32_t CameraStreamer::getMotionEvents() const {
+    return motionEvents;
+}
+
+uint32_t CameraStreamer::getKeyframes() const {
+    return keyframes;
+}
+
+void CameraStreamer::printStats(Print &out) const {
+    out.printf("[Camera] %.1f fps, %ux%u q%u, %u frames (%u KB), %u send errors, %u adaptations, send avg %u us\n",
+               fps, LADDER_WIDTH[level], LADDER_HEIGHT[level], quality, sentFrames, sentBytes / 1024,
+               sendErrors, adaptations, sendAvgUs);
+    if (gating) {
+        out.printf("[Camera] %s, %u motion events, %u keyframes\n",
+                   active ? "active" : "idle", motionEvents, keyframes);
+    }
+}
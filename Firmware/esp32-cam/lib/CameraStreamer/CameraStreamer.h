@@ -0,0 +1,148 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WebSocketsClient.h>
+#include <esp_camera.h>
+#include "BinaryFrame.h"
+#include "Metrics.h"
+#include "MotionDetector.h"
+
+// ======================================================
+// 📷 Stream MJPEG qua WebSocket homeguard, không copy frame
+// ======================================================
+//
+// OV2640 nén JPEG bằng phần cứng vào 2 frame buffer trong PSRAM
+// (CAMERA_GRAB_LATEST): trong lúc một buffer đang được gửi, DMA ghi ảnh kế
+// tiếp vào buffer còn lại. Mỗi ảnh là một message nhị phân CHANNEL_VIDEO
+// (BinaryFrame.h) gửi thành 2 fragment: fragment đầu là FrameHeader +
+// VideoHeader (16 byte), fragment continuation trỏ thẳng vào fb->buf, nên
+// ảnh đi từ PSRAM vào TCP mà không qua buffer trung gian.
+//
+// Bắt tay giống WebSocketClient: connection_init (quảng bá "bin1" và thông
+// số video), chỉ stream sau khi nhận ack có connectionId.
+//
+// Thời gian ghi một ảnh vào socket chính là áp lực hàng đợi gửi (write chặn
+// khi buffer TCP của lwIP đầy). Trung bình trượt của nó so với ngân sách
+// 1/targetFps: vượt 75% thì tăng nén rồi giảm độ phân giải, dưới 30% một lúc
+// thì làm ngược lại, để giữ targetFps trên mạng bận.
+//
+// Chế độ chỉ-gửi-khi-có-chuyển-động (setMotionGating): lúc nhà trống camera
+// vẫn chụp ở IDLE_FPS nhưng chỉ giải mã JPEG ở 1/8 kích thước thành ảnh xám
+// cho MotionDetector, không gửi gì ngoài một keyframe mỗi keyframeMs. Khi có
+// chuyển động thì stream đủ targetFps thêm holdMs sau lần cuối thấy chuyển
+// động. PIR của board chính (sensor_alert "motion" server chuyển tới, hoặc
+// triggerMotion()) bật stream ngay và hạ ngưỡng xác nhận hình ảnh trong
+// PIR_WINDOW_MS; không có PIR thì phải thấy chuyển động CONFIRM_FRAMES ảnh
+// liên tiếp, tránh bật vì nhiễu sáng.
+
+class CameraStreamer {
+public:
+    static const uint8_t DEFAULT_FPS = 15;
+    static const uint8_t QUALITY_BEST = 10;    // jpeg_quality OV2640: thấp = đẹp hơn, ảnh to hơn
+    static const uint8_t QUALITY_WORST = 30;
+    static const uint8_t IDLE_FPS = 4;
+    static const uint32_t PIR_WINDOW_MS = 5000;
+    static const uint8_t CONFIRM_FRAMES = 2;
+
+    CameraStreamer(const char *host, uint16_t port, const char *robotId);
+
+    // Đổi server/robotId (ví dụ theo Provisioning) trước begin(); chỉ giữ con trỏ,
+    // chuỗi phải còn sống suốt thời gian stream
+    void setServer(const char *host, uint16_t port, const char *robotId);
+
+    // Khởi tạo camera ở maxSize (buffer cấp theo cỡ này, sau đó chỉ giảm/tăng
+    // trong giới hạn) và mở WebSocket. false nếu camera không khởi tạo được.
+    bool begin(framesize_t maxSize = FRAMESIZE_VGA, uint8_t quality = 12);
+    // Gọi trong loop: xử lý socket, chụp và gửi một ảnh khi tới lượt
+    void update();
+
+    void setStreaming(bool enabled);
+    void setTargetFps(uint8_t fps);
+    bool isReady() const;                       // đã nhận ack connection_init
+
+    // Chỉ stream khi có chuyển động; gọi sau begin()
+    bool setMotionGating(bool enabled, uint32_t holdMs = 10000, uint32_t keyframeMs = 30000);
+    void setMotionThresholds(uint8_t pixelDelta, uint16_t minBlocks);
+    void triggerMotion();                       // sự kiện PIR
+    bool isActive() const;                      // đang stream đủ fps
+
+    framesize_t getFrameSize() const;
+    uint8_t getQuality() const;
+    float getFps() const;                       // đo trong giây vừa qua
+    uint32_t getSentFrames() const;
+    uint32_t getSendErrors() const;
+    uint32_t getAdaptations() const;
+    uint32_t getMotionEvents() const;
+    uint32_t getKeyframes() const;
+    void printStats(Print &out = Serial) const;
+
+private:
+    // Mở sendFrame (protected trong thư viện) để gửi message nhiều fragment
+    class FrameSocket : public WebSocketsClient {
+    public:
+        bool sendFragment(bool first, const uint8_t *data, size_t length, bool fin);
+    };
+
+    void onEvent(WStype_t type, uint8_t *payload, size_t length);
+    void sendConnectionInit();
+    void handleText(const uint8_t *payload, size_t length);
+    bool sendFrame(camera_fb_t *fb);
+    bool shouldUpload(camera_fb_t *fb);
+    bool detectMotion(camera_fb_t *fb);
+    void adapt(uint32_t sendUs, bool ok);
+    void stepDown();
+    bool stepUp();
+    void applySettings();
+    String generateId() const;
+
+    FrameSocket socket;
+    const char *host;
+    uint16_t port;
+    const char *robotId;
+    String connectionId;
+    bool cameraReady;
+    bool ready;
+    bool streaming;
+
+    // Thang độ phân giải, level = chỉ số trong ladder
+    uint8_t level;
+    uint8_t maxLevel;
+    uint8_t quality;
+    uint8_t targetFps;
+    uint32_t intervalUs;
+    int64_t nextFrameUs;
+
+    // Backpressure
+    uint32_t sendAvgUs;                         // EMA 1/8 của thời gian ghi một ảnh
+    uint16_t calmFrames;                        // số ảnh liên tiếp dưới 30% ngân sách
+    uint16_t cooldownFrames;                    // chờ sau mỗi lần đổi để EMA theo kịp
+
+    uint16_t seq;
+    uint32_t sentFrames;
+    uint32_t sentBytes;
+    uint32_t sendErrors;
+    uint32_t adaptations;
+    uint32_t windowStartMs;
+    uint16_t windowFrames;
+    float fps;
+
+    // Lọc theo chuyển động
+    MotionDetector detector;
+    bool gating;
+    bool active;
+    uint32_t holdMs;
+    uint32_t keyframeMs;
+    uint32_t lastMotionMs;
+    uint32_t lastPirMs;
+    uint32_t lastUploadMs;
+    uint8_t visualStreak;                       // số ảnh liên tiếp thấy chuyển động
+    uint8_t detectSkip;                         // lúc active chỉ xét 1/3 số ảnh
+    uint8_t *rgbBuf;                            // RGB565 1/8 kích thước từ jpg2rgb565
+    uint8_t *grayBuf;
+    uint32_t motionEvents;
+    uint32_t keyframes;
+
+    Histogram *sendHist;                        // µs ghi một ảnh vào socket
+    Histogram *detectHist;                      // µs giải mã 1/8 + so khối
+    Histogram *frameBytes;                      // kích thước ảnh JPEG
+};
@@ -0,0 +1,100 @@
+#include "MotionDetector.h"
+
+MotionDetector::MotionDetector()
+: reference(nullptr), capacity(0), refWidth(0), refHeight(0),
+  blockThreshold(12 * BLOCK * BLOCK), minBlocks(3), changedBlocks(0), totalBlocks(0) {
+}
+
+MotionDetector::~MotionDetector() {
+    free(reference);
+}
+
+bool MotionDetector::begin(uint16_t maxWidth, uint16_t maxHeight) {
+    size_t needed = (size_t)maxWidth * maxHeight;
+    if (needed <= capacity) {
+        return true;
+    }
+    free(reference);
+    reference = (uint8_t *)malloc(needed);
+    capacity = reference != nullptr ? needed : 0;
+    reset();
+    return reference != nullptr;
+}
+
+void MotionDetector::setThresholds(uint8_t pixelDelta, uint16_t blocks) {
+    blockThreshold = (uint32_t)pixelDelta * BLOCK * BLOCK;
+    minBlocks = blocks == 0 ? 1 : blocks;
+}
+
+void MotionDetector::reset() {
+    refWidth = 0;
+    refHeight = 0;
+    changedBlocks = 0;
+}
+
+// |a - b| của 4 byte trong 2 làn 16 bit (byte 0,2 và byte 1,3), cộng vào acc.
+// Mỗi làn: d = 256 + a - b thuộc [1, 511] nên không mượn sang làn bên cạnh;
+// bit 8 của d cho biết a >= b, khi đó |a - b| = d & 0xFF, ngược lại
+// (d & 0xFF) ^ 0xFF + 1.
+static inline uint32_t absDiff4(uint32_t a, uint32_t b) {
+    const uint32_t LO = 0x00FF00FF;
+    const uint32_t BIAS = 0x01000100;
+    const uint32_t ONE = 0x00010001;
+    uint32_t even = ((a & LO) | BIAS) - (b & LO);
+    uint32_t odd = (((a >> 8) & LO) | BIAS) - ((b >> 8) & LO);
+    uint32_t negEven = ((even >> 8) & ONE) ^ ONE;
+    uint32_t negOdd = ((odd >> 8) & ONE) ^ ONE;
+    return (((even & LO) ^ (negEven * 0xFF)) + negEven) +
+           (((odd & LO) ^ (negOdd * 0xFF)) + negOdd);
+}
+
+uint32_t MotionDetector::blockSad(const uint8_t *a, const uint8_t *b, uint16_t stride) {
+    // Mỗi làn nhận tối đa 2 * 256 mỗi từ, 16 từ một khối: không tràn 16 bit
+    uint32_t acc = 0;
+    for (uint8_t row = 0; row < BLOCK; row++) {
+        const uint32_t *pa = (const uint32_t *)(a + row * stride);
+        const uint32_t *pb = (const uint32_t *)(b + row * stride);
+        acc += absDiff4(pa[0], pb[0]);
+        acc += absDiff4(pa[1], pb[1]);
+    }
+    return (acc & 0xFFFF) + (acc >> 16);
+}
+
+uint16_t MotionDetector::process(const uint8_t *gray, uint16_t width, uint16_t height) {
+    uint16_t cols = width / BLOCK;
+    uint16_t rows = height / BLOCK;
+    size_t size = (size_t)width * height;
+    changedBlocks = 0;
+    totalBlocks = cols * rows;
+    if (reference == nullptr || size > capacity || width % BLOCK != 0) {
+        return 0;
+    }
+
+    if (width == refWidth && height == refHeight) {
+        for (uint16_t by = 0; by < rows; by++) {
+            size_t rowOffset = (size_t)by * BLOCK * width;
+            for (uint16_t bx = 0; bx < cols; bx++) {
+                size_t offset = rowOffset + bx * BLOCK;
+                if (blockSad(gray + offset, reference + offset, width) > blockThreshold) {
+                    changedBlocks++;
+                }
+            }
+        }
+    }
+    memcpy(reference, gray, size);
+    refWidth = width;
+    refHeight = height;
+    return changedBlocks;
+}
+
+bool MotionDetector::isMotion() const {
+    return changedBlocks >= minBlocks;
+}
+
+uint16_t MotionDetector::getChangedBlocks() const {
+    return changedBlocks;
+}
+
+uint16_t MotionDetector::getTotalBlocks() const {
+    return totalBlocks;
+}
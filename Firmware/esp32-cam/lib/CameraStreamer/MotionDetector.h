@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ======================================================
+// 🏃 Phát hiện chuyển động bằng so sánh khối ảnh xám
+// ======================================================
+//
+// Mỗi ảnh xám (thường 1/8 độ phân giải stream) được chia khối 8x8 và so với
+// ảnh trước bằng SAD (tổng |a - b|). Khối có SAD trung bình trên mỗi điểm
+// vượt pixelDelta là khối đổi; đủ minBlocks khối đổi thì ảnh có chuyển động.
+//
+// SAD tính 4 điểm một lần trên từ 32 bit (SWAR): tách byte chẵn/lẻ thành 2
+// làn 16 bit, lấy |a - b| từng làn không rẽ nhánh, cộng dồn cả khối rồi mới
+// gộp làn. ESP32 (LX6) không có SIMD nên đây là cách nhanh nhất trên lõi
+// 32 bit, và cùng dạng với lệnh SIMD nếu chuyển sang ESP32-S3.
+//
+// Yêu cầu: width là bội của 8 và buffer căn 4 byte (malloc), để mọi hàng
+// bắt đầu ở địa chỉ chia hết cho 4 (Xtensa lỗi khi đọc 32 bit lệch).
+
+class MotionDetector {
+public:
+    static const uint8_t BLOCK = 8;
+
+    MotionDetector();
+    ~MotionDetector();
+
+    // Cấp buffer ảnh tham chiếu cho ảnh lớn nhất sẽ xử lý
+    bool begin(uint16_t maxWidth, uint16_t maxHeight);
+    // pixelDelta: mức xám trung bình (0-255) để tính khối đổi; minBlocks: số khối đổi tối thiểu
+    void setThresholds(uint8_t pixelDelta, uint16_t minBlocks);
+
+    // So với ảnh trước rồi giữ ảnh này làm tham chiếu. Trả về số khối đổi;
+    // ảnh đầu tiên hoặc đổi kích thước thì chỉ lưu tham chiếu và trả về 0.
+    uint16_t process(const uint8_t *gray, uint16_t width, uint16_t height);
+    bool isMotion() const;                 // kết quả của process() gần nhất
+    void reset();                          // bỏ tham chiếu (đổi cảnh, đổi độ phân giải)
+
+    uint16_t getChangedBlocks() const;
+    uint16_t getTotalBlocks() const;
+
+    // SAD của một khối 8x8, stride tính bằng byte (bội của 4)
+    static uint32_t blockSad(const uint8_t *a, const uint8_t *b, uint16_t stride);
+
+private:
+    uint8_t *reference;
+    size_t capacity;
+    uint16_t refWidth;
+    uint16_t refHeight;
+    uint32_t blockThreshold;               // pixelDelta * 64
+    uint16_t minBlocks;
+    uint16_t changedBlocks;
+    uint16_t totalBlocks;
+};
@@ -1,18 +1,58 @@
 #include <Arduino.h>
+#include "CameraStreamer.h"
+#include "WiFiConnector.h"
+#include "Provisioning.h"
+#include "camera_pins.h"
 
-// put function declarations here:
-int myFunction(int, int);
+// Thay bằng WiFi và server giống firmware robot (Firmware/esp32/src/robot.cpp)
+WiFiConnector wifi("LE HUE", "012345679", 10000);
+// robotId/server lấy từ NVS như board chính: ghi cùng id (p id=robot_017 ...) để
+// server ghép camera với robot (PIR chuyển tiếp, stream theo phòng)
+static const char *DEFAULT_WS_HOST = "your-server.com";
+static const uint16_t DEFAULT_WS_PORT = 8080;
+static RobotProvision provision;
+CameraStreamer streamer(DEFAULT_WS_HOST, DEFAULT_WS_PORT, "");
+
+static uint32_t lastStatsMs = 0;
 
 void setup() {
-  // put your setup code here, to run once:
-  int result = myFunction(2, 3);
+  Serial.begin(115200);
+  pinMode(CAM_LED_STATUS, OUTPUT);
+  digitalWrite(CAM_LED_STATUS, HIGH);   // LED đỏ tắt (active LOW)
+
+  provision = Provisioning::load({ "", DEFAULT_WS_HOST, DEFAULT_WS_PORT });
+  streamer.setServer(provision.host.c_str(), provision.port, provision.robotId.c_str());
+  Serial.printf("[Camera] %s -> %s:%u\n", provision.robotId.c_str(), provision.host.c_str(), provision.port);
+
+  wifi.connect();
+  if (!streamer.begin(FRAMESIZE_VGA, 12)) {
+    Serial.println("[Camera] Restarting in 5 s");
+    delay(5000);
+    ESP.restart();
+  }
+  // Nhà trống thì chỉ gửi keyframe mỗi 30 s; chuyển động hoặc PIR bật stream thêm 10 s
+  streamer.setMotionGating(true, 10000, 30000);
 }
 
 void loop() {
-  // put your main code here, to run repeatedly:
-}
+  wifi.update();
+  streamer.update();
+  digitalWrite(CAM_LED_STATUS, streamer.isReady() ? LOW : HIGH);
+
+  // Console giống board chính: "p id=robot_017 host=server port=8080" rồi khởi động lại
+  if (Serial.available() && Serial.read() == 'p') {
+    RobotProvision update;
+    if (Provisioning::parse(Serial.readStringUntil('\n'), update) && Provisioning::save(update)) {
+      Serial.println("[Camera] Provisioning saved, restarting...");
+      delay(100);
+      ESP.restart();
+    }
+    Serial.printf("[Camera] Provisioning unchanged (%s), usage: p id=robot_017 host=server port=8080\n",
+                  provision.robotId.c_str());
+  }
 
-// put function definitions here:
-int myFunction(int x, int y) {
-  return x + y;
-}
\ No newline at end of file
+  if (millis() - lastStatsMs >= 10000) {
+    lastStatsMs = millis();
+    streamer.printStats();
+  }
+}
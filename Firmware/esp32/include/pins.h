@@ -122,8 +122,9 @@
 #define SPK_BCLK_PIN GPIO26
 #define SPK_DIN_PIN GPIO22
 // INMP441 microphone pins
-#define INMP441_BCLK_PIN GPIO18
+// BCLK/DOUT cũ (GPIO18/GPIO21) trùng TFT_SCLK và PIR_PIN, không capture liên tục được
+#define INMP441_BCLK_PIN GPIO33
 #define INMP441_LRCL_PIN GPIO19 
-#define INMP441_DOUT_PIN GPIO21
+#define INMP441_DOUT_PIN GPIO35  // INPUT only, đủ cho data-in
 
 // ======================================================
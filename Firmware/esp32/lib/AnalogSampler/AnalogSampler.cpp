@@ -0,0 +1,157 @@
+#include "AnalogSampler.h"
+
+static const uint32_t DEFAULT_VREF_MV = 1100;   // khi eFuse không có Vref/Two Point
+
+AnalogSampler::AnalogSampler(uint16_t periodMs, uint8_t oversample, uint8_t emaShift)
+    : periodMs(periodMs), oversample(oversample > 0 ? oversample : 1), emaShift(emaShift),
+      channelCount(0), calibrationCount(0), calibrationType(ESP_ADC_CAL_VAL_DEFAULT_VREF),
+      task(nullptr), running(false), sweeps(0),
+      sweepHist(Metrics::histogram("adc.sweep_us")) {}
+
+int8_t AnalogSampler::addChannel(uint8_t pin, adc_atten_t atten) {
+    int8_t existing = channelOf(pin);
+    if (existing >= 0) {
+        return existing;
+    }
+    // ADC1: kênh 0..7; ADC2 là 10..19 và không đọc được khi WiFi bật
+    int8_t adcChannel = digitalPinToAnalogChannel(pin);
+    if (adcChannel < 0 || adcChannel >= ADC1_CHANNEL_MAX || channelCount >= MAX_CHANNELS || task != nullptr) {
+        Serial.printf("[ADC] Pin %u is not usable (ADC1 only, max %u channels)\n", pin, MAX_CHANNELS);
+        return -1;
+    }
+
+    Channel &c = channels[channelCount];
+    c.pin = pin;
+    c.channel = (adc1_channel_t)adcChannel;
+    c.atten = atten;
+    c.cal = 0;
+    c.emaQ4 = 0;
+    c.raw = 0;
+    c.milliVolts = 0;
+    c.primed = false;
+    return (int8_t)channelCount++;
+}
+
+int8_t AnalogSampler::channelOf(uint8_t pin) const {
+    for (uint8_t i = 0; i < channelCount; i++) {
+        if (channels[i].pin == pin) {
+            return (int8_t)i;
+        }
+    }
+    return -1;
+}
+
+uint8_t AnalogSampler::calibrationFor(adc_atten_t atten) {
+    for (uint8_t i = 0; i < calibrationCount; i++) {
+        if (calibrationAtten[i] == atten) {
+            return i;
+        }
+    }
+    uint8_t i = calibrationCount++;
+    calibrationAtten[i] = atten;
+    calibrationType = esp_adc_cal_characterize(ADC_UNIT_1, atten, ADC_WIDTH_BIT_12, DEFAULT_VREF_MV, &calibration[i]);
+    return i;
+}
+
+bool AnalogSampler::begin(BaseType_t core, UBaseType_t priority) {
+    if (task != nullptr) {
+        return true;
+    }
+    if (channelCount == 0) {
+        return false;
+    }
+
+    adc1_config_width(ADC_WIDTH_BIT_12);
+    for (uint8_t i = 0; i < channelCount; i++) {
+        adc1_config_channel_atten(channels[i].channel, channels[i].atten);
+        channels[i].cal = calibrationFor(channels[i].atten);
+    }
+    sample();                                 // có giá trị ngay cả trước lượt đầu của task
+
+    running = true;
+    if (xTaskCreatePinnedToCore(taskLoop, "adc_sampler", 2048, this, priority, &task, core) != pdPASS) {
+        running = false;
+        task = nullptr;
+        return false;
+    }
+    Serial.printf("[ADC] Sampling %u channel(s) every %u ms, x%u oversample, calibration: %s\n",
+                  channelCount, periodMs, oversample, calibrationSource());
+    return true;
+}
+
+void AnalogSampler::stop() {
+    if (task == nullptr) {
+        return;
+    }
+    running = false;
+    // Task tự xoá sau lượt quét hiện tại
+    while (task != nullptr) {
+        vTaskDelay(pdMS_TO_TICKS(5));
+    }
+}
+
+bool AnalogSampler::isRunning() const {
+    return task != nullptr;
+}
+
+void AnalogSampler::taskLoop(void *arg) {
+    AnalogSampler *self = static_cast<AnalogSampler *>(arg);
+    TickType_t lastWake = xTaskGetTickCount();
+    const TickType_t period = pdMS_TO_TICKS(self->periodMs) > 0 ? pdMS_TO_TICKS(self->periodMs) : 1;
+
+    while (self->running) {
+        vTaskDelayUntil(&lastWake, period);
+        self->sample();
+    }
+    self->task = nullptr;
+    vTaskDelete(nullptr);
+}
+
+// ============================================
+// QUÉT KÊNH
+// ============================================
+
+void AnalogSampler::sample() {
+    CycleTimer timer(sweepHist);
+    for (uint8_t i = 0; i < channelCount; i++) {
+        Channel &c = channels[i];
+        uint32_t sum = 0;
+        for (uint8_t n = 0; n < oversample; n++) {
+            int raw = adc1_get_raw(c.channel);
+            sum += raw > 0 ? (uint32_t)raw : 0;
+        }
+        // Trung bình ở Q4 để EMA không mất phần lẻ khi shift
+        uint32_t averageQ4 = (sum << 4) / oversample;
+        if (!c.primed) {
+            c.emaQ4 = averageQ4;
+            c.primed = true;
+        } else {
+            c.emaQ4 = (uint32_t)((int32_t)c.emaQ4 + (((int32_t)averageQ4 - (int32_t)c.emaQ4) >> emaShift));
+        }
+
+        uint16_t raw = (uint16_t)((c.emaQ4 + 8) >> 4);
+        c.raw = raw;
+        c.milliVolts = calibrationCount > 0 ? (uint16_t)esp_adc_cal_raw_to_voltage(raw, &calibration[c.cal]) : 0;
+    }
+    sweeps++;
+}
+
+uint16_t AnalogSampler::readRaw(int8_t channel) const {
+    return channel >= 0 && channel < channelCount ? channels[channel].raw : 0;
+}
+
+uint16_t AnalogSampler::readMilliVolts(int8_t channel) const {
+    return channel >= 0 && channel < channelCount ? channels[channel].milliVolts : 0;
+}
+
+uint32_t AnalogSampler::getSweeps() const {
+    return sweeps;
+}
+
+const char *AnalogSampler::calibrationSource() const {
+    switch (calibrationType) {
+        case ESP_ADC_CAL_VAL_EFUSE_VREF: return "eFuse Vref";
+        case ESP_ADC_CAL_VAL_EFUSE_TP:   return "Two Point";
+        default:                         return "default";
+    }
+}
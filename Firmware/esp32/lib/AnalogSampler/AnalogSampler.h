@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Arduino.h>
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+#include "Metrics.h"
+
+// ======================================================
+// 📈 Lấy mẫu ADC1 nền: oversampling + hiệu chuẩn eFuse + EMA
+// ======================================================
+//
+// Một task quét mọi kênh đã đăng ký mỗi periodMs: đọc mỗi kênh
+// `oversample` lần liên tiếp rồi lấy trung bình, lọc EMA (alpha = 1/2^emaShift)
+// và đổi sang mV bằng esp_adc_cal (Vref/Two Point trong eFuse nếu chip có).
+// Nơi gọi chỉ đọc giá trị đã lọc, không chờ ADC.
+//
+// Không dùng chế độ I2S-ADC DMA: trên ESP32 nó chỉ chạy trên I2S0, đang dùng
+// cho loa (I2S1 là micro). Chỉ nhận chân ADC1 (GPIO32-39), ADC2 bị WiFi chiếm.
+
+class AnalogSampler {
+public:
+    static const uint8_t MAX_CHANNELS = 8;
+
+    AnalogSampler(uint16_t periodMs = 10, uint8_t oversample = 16, uint8_t emaShift = 3);
+
+    // Đăng ký chân trước begin(); trả về chỉ số kênh, -1 nếu không phải ADC1 hoặc đã đủ kênh
+    int8_t addChannel(uint8_t pin, adc_atten_t atten = ADC_ATTEN_DB_11);
+    int8_t channelOf(uint8_t pin) const;                // -1 nếu chân chưa đăng ký
+
+    // Cấu hình ADC1, hiệu chuẩn, lấy một lượt để có giá trị ngay rồi chạy task
+    bool begin(BaseType_t core = 1, UBaseType_t priority = 3);
+    void stop();
+    bool isRunning() const;
+
+    // Một lượt quét mọi kênh (task gọi định kỳ; gọi tay được khi không chạy task)
+    void sample();
+
+    uint16_t readRaw(int8_t channel) const;             // 0..4095, đã oversample + EMA
+    uint16_t readMilliVolts(int8_t channel) const;      // sau hiệu chuẩn
+    uint32_t getSweeps() const;
+    const char *calibrationSource() const;              // "eFuse Vref", "Two Point", "default"
+
+private:
+    struct Channel {
+        uint8_t pin;
+        adc1_channel_t channel;
+        adc_atten_t atten;
+        uint8_t cal;                  // chỉ số vào calibration[]
+        uint32_t emaQ4;               // raw * 16, giữ phần lẻ của EMA
+        volatile uint16_t raw;
+        volatile uint16_t milliVolts;
+        bool primed;                  // đã có mẫu đầu để khởi tạo EMA
+    };
+
+    uint16_t periodMs;
+    uint8_t oversample;
+    uint8_t emaShift;
+    Channel channels[MAX_CHANNELS];
+    uint8_t channelCount;
+
+    // Mỗi mức suy giảm cần đường cong riêng
+    esp_adc_cal_characteristics_t calibration[4];
+    adc_atten_t calibrationAtten[4];
+    uint8_t calibrationCount;
+    esp_adc_cal_value_t calibrationType;
+
+    TaskHandle_t task;
+    volatile bool running;
+    volatile uint32_t sweeps;
+    Histogram *sweepHist;             // một lượt quét (µs)
+
+    static void taskLoop(void *arg);
+    uint8_t calibrationFor(adc_atten_t atten);
+};
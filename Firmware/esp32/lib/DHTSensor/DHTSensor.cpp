@@ -1,7 +1,16 @@
 #include "DHTSensor.h"
 
+// Bit DHT: mức thấp ~50 µs rồi mức cao 26-28 µs (0) hoặc ~70 µs (1)
+static const uint16_t DHT_BIT_ONE_US = 48;
+static const uint16_t DHT_HIGH_MAX_US = 100;     // dài hơn: line nhả, không phải bit
+static const uint16_t DHT_IDLE_US = 200;         // RMT kết thúc khi line đứng yên chừng này
+static const uint8_t DHT_BITS = 40;
+
 DHTSensor::DHTSensor(uint8_t pin, uint8_t type, String name )
-: _pin(pin), _type(type), _dht(pin, type), sensorName(name) {
+: Sensor(SENSOR_TEMPERATURE), _pin(pin), _type(type), _dht(pin, type), sensorName(name),
+  readHist(Metrics::histogram("dht.read_us")), readErrors(Metrics::counter("dht.errors")),
+  task(nullptr), running(false), periodMs(0), rmtChannel(RMT_CHANNEL_4), rmtReady(false),
+  readingLock(portMUX_INITIALIZER_UNLOCKED), reading{ NAN, NAN, 0, false }, humidityChannel(*this) {
     // Constructor khởi tạo DHT với pin và loại
 }
 
@@ -9,9 +18,205 @@ void DHTSensor::begin() {
     _dht.begin();
 }
 
+uint32_t DHTSensor::minPeriodMs() const {
+    return _type == DHT11 ? 1000 : 2000;
+}
+
+// ============================================
+// ĐỌC NỀN
+// ============================================
+
+bool DHTSensor::startBackground(uint32_t period, BaseType_t core, UBaseType_t priority, rmt_channel_t channel) {
+    if (task != nullptr) {
+        return true;
+    }
+    periodMs = max(period, minPeriodMs());
+    rmtReady = rmtReady || setupRmt(channel);
+
+    running = true;
+    if (xTaskCreatePinnedToCore(taskLoop, "dht", 3072, this, priority, &task, core) != pdPASS) {
+        running = false;
+        task = nullptr;
+        return false;
+    }
+    Serial.printf("[DHT] Background read every %u ms (%s)\n", (unsigned)periodMs, rmtReady ? "RMT" : "bit-bang");
+    return true;
+}
+
+void DHTSensor::stopBackground() {
+    if (task == nullptr) {
+        return;
+    }
+    running = false;
+    // Task tự xoá sau giao dịch hiện tại
+    while (task != nullptr) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+bool DHTSensor::isBackground() const {
+    return task != nullptr;
+}
+
+bool DHTSensor::usesRmt() const {
+    return rmtReady;
+}
+
+DHTReading DHTSensor::getReading() const {
+    portENTER_CRITICAL(&readingLock);
+    DHTReading copy = reading;
+    portEXIT_CRITICAL(&readingLock);
+    // Mất 3 chu kỳ liên tiếp thì không còn tin mẫu cũ
+    if (copy.valid && millis() - copy.timestamp > 3 * periodMs) {
+        copy.valid = false;
+    }
+    return copy;
+}
+
+void DHTSensor::taskLoop(void *arg) {
+    DHTSensor *self = static_cast<DHTSensor *>(arg);
+    TickType_t lastWake = xTaskGetTickCount();
+
+    while (self->running) {
+        float temperature, humidity;
+        bool ok = self->rmtReady ? self->readRmt(temperature, humidity) : self->readLibrary(temperature, humidity);
+        if (ok) {
+            portENTER_CRITICAL(&self->readingLock);
+            self->reading = DHTReading{ temperature, humidity, (uint32_t)millis(), true };
+            portEXIT_CRITICAL(&self->readingLock);
+        } else {
+            self->readErrors->add();
+        }
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(self->periodMs));
+    }
+    self->task = nullptr;
+    vTaskDelete(nullptr);
+}
+
+// ============================================
+// RMT
+// ============================================
+
+bool DHTSensor::setupRmt(rmt_channel_t channel) {
+    rmt_config_t config = RMT_DEFAULT_CONFIG_RX((gpio_num_t)_pin, channel);
+    config.clk_div = 80;                              // 1 tick = 1 µs
+    config.rx_config.filter_en = true;
+    config.rx_config.filter_ticks_thresh = 100;       // bỏ gai < 1.25 µs (đơn vị chu kỳ APB)
+    config.rx_config.idle_threshold = DHT_IDLE_US;
+    if (rmt_config(&config) != ESP_OK || rmt_driver_install(channel, 512, 0) != ESP_OK) {
+        Serial.println("[DHT] RMT channel unavailable, using bit-bang");
+        return false;
+    }
+    rmtChannel = channel;
+    return true;
+}
+
+bool DHTSensor::readRmt(float &temperature, float &humidity) {
+    RingbufHandle_t ring = nullptr;
+    if (rmt_get_ringbuf_handle(rmtChannel, &ring) != ESP_OK || ring == nullptr) {
+        return false;
+    }
+    size_t length = 0;
+    void *stale;
+    while ((stale = xRingbufferReceive(ring, &length, 0)) != nullptr) {
+        vRingbufferReturnItem(ring, stale);
+    }
+
+    // Xung start: kéo LOW (DHT11 >= 18 ms, DHT22 >= 1 ms); task ngủ, không bận chờ
+    pinMode(_pin, OUTPUT);
+    digitalWrite(_pin, LOW);
+    vTaskDelay(pdMS_TO_TICKS(_type == DHT11 ? 20 : 2));
+
+    CycleTimer timer(readHist);
+    pinMode(_pin, INPUT_PULLUP);
+    rmt_set_gpio(rmtChannel, RMT_MODE_RX, (gpio_num_t)_pin, false);   // pinMode vừa đổi mux của chân
+    rmt_rx_start(rmtChannel, true);
+    rmt_item32_t *items = (rmt_item32_t *)xRingbufferReceive(ring, &length, pdMS_TO_TICKS(10));
+    rmt_rx_stop(rmtChannel);
+    if (items == nullptr) {
+        return false;
+    }
+
+    // 40 xung cao cuối cùng là 40 bit (xung phản hồi 80 µs đứng trước, có thể bị lỡ)
+    uint8_t highs[64];
+    uint8_t count = 0;
+    size_t n = length / sizeof(rmt_item32_t);
+    for (size_t i = 0; i < n; i++) {
+        const uint16_t levels[2] = { (uint16_t)items[i].level0, (uint16_t)items[i].level1 };
+        const uint16_t durations[2] = { (uint16_t)items[i].duration0, (uint16_t)items[i].duration1 };
+        for (uint8_t half = 0; half < 2; half++) {
+            if (levels[half] == 1 && durations[half] > 0 && durations[half] < DHT_HIGH_MAX_US) {
+                if (count == sizeof(highs)) {
+                    memmove(highs, highs + 1, sizeof(highs) - 1);
+                    count--;
+                }
+                highs[count++] = (uint8_t)durations[half];
+            }
+        }
+    }
+    vRingbufferReturnItem(ring, items);
+    if (count < DHT_BITS) {
+        return false;
+    }
+
+    uint8_t data[5] = { 0, 0, 0, 0, 0 };
+    const uint8_t *bits = highs + count - DHT_BITS;
+    for (uint8_t i = 0; i < DHT_BITS; i++) {
+        data[i / 8] = (uint8_t)((data[i / 8] << 1) | (bits[i] > DHT_BIT_ONE_US ? 1 : 0));
+    }
+    return decode(data, temperature, humidity);
+}
+
+// Cùng định dạng với thư viện Adafruit DHT
+bool DHTSensor::decode(const uint8_t data[5], float &temperature, float &humidity) const {
+    if ((uint8_t)(data[0] + data[1] + data[2] + data[3]) != data[4] ||
+        (data[0] | data[1] | data[2] | data[3]) == 0) {
+        return false;
+    }
+    if (_type == DHT11) {
+        humidity = data[0] + data[1] * 0.1f;
+        temperature = data[2];
+        if (data[3] & 0x80) {
+            temperature = -1 - temperature;
+        }
+        temperature += (data[3] & 0x0F) * 0.1f;
+    } else {
+        humidity = ((data[0] << 8) | data[1]) * 0.1f;
+        temperature = (((data[2] & 0x7F) << 8) | data[3]) * 0.1f;
+        if (data[2] & 0x80) {
+            temperature = -temperature;
+        }
+    }
+    return true;
+}
+
+bool DHTSensor::readLibrary(float &temperature, float &humidity) {
+    CycleTimer timer(readHist);
+    if (!_dht.read(true)) {
+        return false;
+    }
+    // Cả hai lấy từ cùng giao dịch vừa đọc (thư viện cache 2 s)
+    temperature = _dht.readTemperature();
+    humidity = _dht.readHumidity();
+    return !isnan(temperature) && !isnan(humidity);
+}
+
+// ============================================
+// GETTER
+// ============================================
+
 float DHTSensor::getTemperature() {
-    float temp = _dht.readTemperature();
+    if (isBackground()) {
+        DHTReading r = getReading();
+        return r.valid ? r.temperature : -999;
+    }
+    float temp;
+    {
+        CycleTimer timer(readHist);
+        temp = _dht.readTemperature();
+    }
     if (isnan(temp)) {
+        readErrors->add();
         Serial.println("Lỗi đọc nhiệt độ!");
         return -999; // giá trị lỗi
     }
@@ -19,15 +224,44 @@ float DHTSensor::getTemperature() {
 }
 
 float DHTSensor::getHumidity() {
-    float hum = _dht.readHumidity();
+    if (isBackground()) {
+        DHTReading r = getReading();
+        return r.valid ? r.humidity : -999;
+    }
+    float hum;
+    {
+        CycleTimer timer(readHist);
+        hum = _dht.readHumidity();
+    }
     if (isnan(hum)) {
+        readErrors->add();
         Serial.println("Lỗi đọc độ ẩm!");
         return -999; // giá trị lỗi
     }
     return hum;
 }
 
+SampleQuality DHTSensor::read(float &value) {
+    value = getTemperature();
+    return value == -999 ? SAMPLE_BAD : SAMPLE_GOOD;
+}
+
+SampleQuality DHTSensor::HumidityChannel::read(float &value) {
+    value = owner.getHumidity();
+    return value == -999 ? SAMPLE_BAD : SAMPLE_GOOD;
+}
+
 void DHTSensor::printValues() {
+    if (isBackground()) {
+        DHTReading r = getReading();
+        if (r.valid) {
+            Serial.printf("Nhiệt độ: %.1f °C, Độ ẩm: %.1f %% (%lu ms trước)\n",
+                          r.temperature, r.humidity, (unsigned long)(millis() - r.timestamp));
+        } else {
+            Serial.println("Chưa có mẫu DHT hợp lệ");
+        }
+        return;
+    }
     float temp = getTemperature();
     float hum = getHumidity();
     if (temp != -999 && hum != -999) {
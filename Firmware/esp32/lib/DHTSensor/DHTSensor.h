@@ -2,8 +2,21 @@
 
 #include <Arduino.h>
 #include <DHT.h>
+#include <driver/rmt.h>
+#include "Metrics.h"
+#include "Sensor.h"
 
-class DHTSensor {
+// Kết quả một lần đọc: nhiệt độ và độ ẩm cùng một giao dịch
+struct DHTReading {
+    float temperature;       // °C
+    float humidity;          // %
+    uint32_t timestamp;      // millis() lúc đọc xong
+    bool valid;              // false: chưa có mẫu hoặc mẫu gần nhất quá cũ
+};
+
+// Là Sensor nhiệt độ; độ ẩm là kênh Sensor riêng qua humidity(), cả hai đọc
+// từ cùng một mẫu (nền: cache; không nền: thư viện DHT)
+class DHTSensor : public Sensor {
   public:
     // Constructor: truyền chân dữ liệu và loại cảm biến (DHT11, DHT22...)
     DHTSensor(uint8_t pin, uint8_t type, String name );
@@ -11,7 +24,18 @@ class DHTSensor {
     // Khởi tạo cảm biến, gọi trong setup()
     void begin();
 
-    // Lấy giá trị nhiệt độ (°C)
+    // ▶ Đọc nền: một task đọc cả nhiệt độ và độ ẩm mỗi periodMs (0 = nhanh nhất
+    // cảm biến cho phép: DHT11 1 s, DHT22 2 s) và lưu lại. Bit được bắt bằng RMT
+    // nên không tắt ngắt; không cấp được kênh RMT thì task dùng thư viện DHT,
+    // vẫn khoá ngắt ~5 ms nhưng không chặn loop.
+    bool startBackground(uint32_t periodMs = 0, BaseType_t core = 1, UBaseType_t priority = 2,
+                         rmt_channel_t channel = RMT_CHANNEL_4);
+    void stopBackground();
+    bool isBackground() const;
+    bool usesRmt() const;
+    DHTReading getReading() const;      // bản sao mẫu gần nhất, không chờ
+
+    // Lấy giá trị nhiệt độ (°C); chế độ nền trả về mẫu đã lưu, -999 nếu lỗi/quá cũ
     float getTemperature();
 
     // Lấy giá trị độ ẩm (%)
@@ -21,10 +45,45 @@ class DHTSensor {
     void printValues();
 
     String getName() const;
+    const char *name() const override { return sensorName.c_str(); }
+    Sensor &humidity() { return humidityChannel; }
+
+  protected:
+    SampleQuality read(float &value) override;
+
   private:
+    class HumidityChannel : public Sensor {
+      public:
+        explicit HumidityChannel(DHTSensor &owner) : Sensor(SENSOR_HUMIDITY), owner(owner) {}
+        const char *name() const override { return owner.name(); }
+      protected:
+        SampleQuality read(float &value) override;
+      private:
+        DHTSensor &owner;
+    };
+
+
     uint8_t _pin;
     uint8_t _type;
     DHT _dht;
     String sensorName;
-};
+    Histogram *readHist;     // một giao dịch đọc (µs); bit-bang thì block loop
+    Counter *readErrors;
 
+    // Chế độ nền
+    TaskHandle_t task;
+    volatile bool running;
+    uint32_t periodMs;
+    rmt_channel_t rmtChannel;
+    bool rmtReady;
+    mutable portMUX_TYPE readingLock;
+    DHTReading reading;
+    HumidityChannel humidityChannel;
+
+    static void taskLoop(void *arg);
+    bool setupRmt(rmt_channel_t channel);
+    bool readRmt(float &temperature, float &humidity);
+    bool readLibrary(float &temperature, float &humidity);
+    bool decode(const uint8_t data[5], float &temperature, float &humidity) const;
+    uint32_t minPeriodMs() const;
+};
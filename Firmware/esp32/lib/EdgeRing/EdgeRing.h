@@ -0,0 +1,65 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+// ======================================================
+// ⚡ Ring buffer cạnh GPIO giữa ISR và task
+// ======================================================
+//
+// Một producer (ISR) và một consumer (task), không cần khoá: ISR chỉ ghi head,
+// task chỉ ghi tail. N phải là luỹ thừa của 2. Khi đầy, cạnh mới bị bỏ và
+// đếm vào dropped() để task biết đã mất sự kiện.
+
+struct GpioEdge {
+    uint32_t us;                 // micros() lúc xảy ra cạnh
+    uint8_t level;               // mức chân ngay sau cạnh
+};
+
+template <uint8_t N>
+class EdgeRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "EdgeRing size must be a power of two");
+
+public:
+    EdgeRing() : head(0), tail(0), droppedCount(0) {}
+
+    // Gọi từ ISR; luôn inline để nằm trong IRAM cùng hàm ISR
+    inline __attribute__((always_inline)) bool push(uint32_t us, uint8_t level) {
+        uint8_t h = head.load(std::memory_order_relaxed);
+        if ((uint8_t)(h - tail.load(std::memory_order_acquire)) >= N) {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slots[h & (N - 1)] = GpioEdge{ us, level };
+        head.store((uint8_t)(h + 1), std::memory_order_release);
+        return true;
+    }
+
+    // Gọi từ task
+    bool pop(GpioEdge &edge) {
+        uint8_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        edge = slots[t & (N - 1)];
+        tail.store((uint8_t)(t + 1), std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return tail.load(std::memory_order_relaxed) == head.load(std::memory_order_acquire);
+    }
+
+    uint32_t dropped() const {
+        return droppedCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    GpioEdge slots[N];
+    std::atomic<uint8_t> head;
+    std::atomic<uint8_t> tail;
+    std::atomic<uint32_t> droppedCount;
+};
+
+// Hook ISR báo cho task biết có cạnh mới (ví dụ Scheduler::triggerFromISR)
+using EdgeNotify = void (*)(void *arg);
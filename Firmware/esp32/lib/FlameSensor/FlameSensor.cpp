@@ -1,14 +1,16 @@
 #include "FlameSensor.h"
 
 FlameSensor::FlameSensor(uint8_t sensorPin, unsigned long debounce, const char* name)
-: pin(sensorPin), mode(DIGITAL), threshold(0), flameState(false),
-  lastTriggerTime(0), debounceTime( ), sensorName(name)
+: Sensor(SENSOR_FLAME), pin(sensorPin), mode(DIGITAL), threshold(0), sampler(nullptr), samplerChannel(-1), flameState(false),
+  lastTriggerTime(0), debounceTime(debounce), sensorName(name),
+  interruptMode(false), notify(nullptr), notifyArg(nullptr), lastTriggerUs(0), lastEdgeLatencyUs(0)
 {
 }
 
 FlameSensor::FlameSensor(uint8_t sensorPin, int analogThreshold, unsigned long debounce, const char* name)
-: pin(sensorPin), mode(ANALOG_MODE), threshold(analogThreshold), flameState(false),
-  lastTriggerTime(0), debounceTime(debounce), sensorName(name)
+: Sensor(SENSOR_FLAME), pin(sensorPin), mode(ANALOG_MODE), threshold(analogThreshold), sampler(nullptr), samplerChannel(-1), flameState(false),
+  lastTriggerTime(0), debounceTime(debounce), sensorName(name),
+  interruptMode(false), notify(nullptr), notifyArg(nullptr), lastTriggerUs(0), lastEdgeLatencyUs(0)
 {
 }
 
@@ -27,12 +29,70 @@ bool FlameSensor::readSensor() const {
         // Mặc định ở đây ta coi HIGH = phát hiện. Nếu bạn dùng module khác, hãy đảo logic ở code gọi hoặc thay đổi ở đây.
         return (v == LOW) ? true : false;
     } else { // ANALOG_MODE
-        int val = analogRead(pin);
+        int val = sampler != nullptr ? sampler->readRaw(samplerChannel) : analogRead(pin);
         return (val >= threshold);
     }
 }
 
+// Module flame kéo chân xuống LOW khi có lửa (cùng logic với readSensor)
+void IRAM_ATTR FlameSensor::handleEdge(void *arg) {
+    FlameSensor *self = static_cast<FlameSensor *>(arg);
+    self->edges.push(micros(), digitalRead(self->pin) == LOW);
+    if (self->notify) {
+        self->notify(self->notifyArg);
+    }
+}
+
+bool FlameSensor::enableInterrupt(EdgeNotify notifyFn, void *arg) {
+    if (mode != DIGITAL) {
+        return false;
+    }
+    notify = notifyFn;
+    notifyArg = arg;
+    flameState = readSensor();
+    interruptMode = true;
+    attachInterruptArg(digitalPinToInterrupt(pin), handleEdge, this, CHANGE);
+    return true;
+}
+
+void FlameSensor::disableInterrupt() {
+    if (interruptMode) {
+        detachInterrupt(digitalPinToInterrupt(pin));
+        interruptMode = false;
+    }
+}
+
+bool FlameSensor::isInterruptMode() const {
+    return interruptMode;
+}
+
+// Xử lý cạnh theo timestamp của ISR: một lần chớp lửa ngắn giữa hai lần gọi
+// vẫn sinh đúng một sự kiện
+bool FlameSensor::processEdges() {
+    bool detected = false;
+    GpioEdge edge;
+    while (edges.pop(edge)) {
+        if (edge.level && !flameState) {
+            flameState = true;
+            if (lastTriggerUs == 0 || edge.us - lastTriggerUs >= debounceTime * 1000UL) {
+                uint32_t age = micros() - edge.us;
+                lastTriggerUs = edge.us;
+                lastTriggerTime = millis() - age / 1000;
+                lastEdgeLatencyUs = age;
+                detected = true;
+            }
+        } else if (!edge.level) {
+            flameState = false;
+        }
+    }
+    return detected;
+}
+
 bool FlameSensor::isFlameDetected() {
+    if (interruptMode) {
+        return processEdges();
+    }
+
     bool current = readSensor();
 
     // Nếu vừa chuyển từ không có -> có thì kiểm tra debounce
@@ -59,6 +119,15 @@ unsigned long FlameSensor::getLastTriggerTime() const {
     return lastTriggerTime;
 }
 
+bool FlameSensor::attachSampler(AnalogSampler &adc) {
+    if (mode != ANALOG_MODE) {
+        return false;
+    }
+    samplerChannel = adc.addChannel(pin);
+    sampler = samplerChannel >= 0 ? &adc : nullptr;
+    return sampler != nullptr;
+}
+
 void FlameSensor::setAnalogThreshold(int t) {
     threshold = t;
 }
@@ -87,6 +156,24 @@ void FlameSensor::printState() {
     Serial.println(lastTriggerTime);
 }
 
+uint32_t FlameSensor::getLastEdgeLatencyUs() const {
+    return lastEdgeLatencyUs;
+}
+
+uint32_t FlameSensor::getDroppedEdges() const {
+    return edges.dropped();
+}
+
 void FlameSensor::setMode(Mode m) {
+    if (m != DIGITAL) {
+        disableInterrupt();
+    } else {
+        sampler = nullptr;         // digital đọc thẳng chân
+    }
     mode = m;
 }
+
+SampleQuality FlameSensor::read(float &value) {
+    value = flameState ? 1.0f : 0.0f;
+    return SAMPLE_GOOD;
+}
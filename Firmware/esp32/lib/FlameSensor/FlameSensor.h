@@ -2,8 +2,11 @@
 #define FLAME_SENSOR_H
 
 #include <Arduino.h>
+#include "AnalogSampler.h"
+#include "EdgeRing.h"
+#include "Sensor.h"
 
-class FlameSensor {
+class FlameSensor : public Sensor {
 public:
     // Kiểu sensor: DIGITAL đọc digitalRead, ANALOG đọc analogRead và so sánh threshold
     enum Mode { DIGITAL, ANALOG_MODE };
@@ -17,6 +20,12 @@ public:
     // Khởi tạo: gọi trong setup()
     void begin();
 
+    // Chỉ cho mode DIGITAL: bật ngắt CHANGE, ISR ghi cạnh vào ring và gọi notify
+    // (nếu có) để đánh thức task xử lý. Trả về false nếu đang ở mode analog.
+    bool enableInterrupt(EdgeNotify notify = nullptr, void *arg = nullptr);
+    void disableInterrupt();
+    bool isInterruptMode() const;
+
     // Kiểm tra có vừa phát hiện lửa mới (có debounce)
     // Trả về true nếu vừa có sự kiện phát hiện lửa (một lần)
     bool isFlameDetected();
@@ -27,26 +36,52 @@ public:
     // Thời điểm last trigger theo millis()
     unsigned long getLastTriggerTime() const;
 
+    // Chỉ cho mode analog: đọc giá trị đã lọc từ task ADC thay vì analogRead
+    // (gọi trước adc.begin()). Mode digital trả về false: cấu hình kênh ADC
+    // chuyển chân sang RTC mux và digitalRead/ngắt sẽ không còn chạy.
+    bool attachSampler(AnalogSampler &adc);
+
     // Thay ngưỡng analog (nếu đang ở chế độ analog)
     void setAnalogThreshold(int threshold);
 
     // In trạng thái (gọi isFlameDetected() trước khi in để cập nhật)
     void printState();
 
+    // Độ trễ ISR -> task của sự kiện gần nhất, và số cạnh bị mất do ring đầy
+    uint32_t getLastEdgeLatencyUs() const;
+    uint32_t getDroppedEdges() const;
+
     // Cấu hình mode thủ công
     void setMode(Mode m);
 
+    const char *name() const override { return sensorName; }
+
+protected:
+    SampleQuality read(float &value) override;   // getState() dạng 0/1
+
 private:
     uint8_t pin;
     Mode mode;
     int threshold;                 // Dùng khi mode == ANALOG (0..1023)
+    AnalogSampler *sampler;        // nullptr = analogRead trực tiếp
+    int8_t samplerChannel;
     bool flameState;               // trạng thái hiện tại
     unsigned long lastTriggerTime; // lần kích hoạt cuối
     unsigned long debounceTime;    // ms
     const char* sensorName;
 
+    // Chế độ ngắt: ISR ghi cạnh vào ring, debounce làm trong task
+    EdgeRing<16> edges;
+    bool interruptMode;
+    EdgeNotify notify;
+    void *notifyArg;
+    uint32_t lastTriggerUs;        // micros() của cạnh kích hoạt gần nhất
+    uint32_t lastEdgeLatencyUs;
+
     // helper: đọc giá trị hiện tại (true = phát hiện lửa)
     bool readSensor() const;
+    static void IRAM_ATTR handleEdge(void *arg);
+    bool processEdges();
 };
 
 #endif // FLAME_SENSOR_H
@@ -1,28 +1,56 @@
 #include "GasSensor.h"
 
 GasSensor::GasSensor(int pin, int thresholdValue, String name)
-    : analogPin(pin), threshold(thresholdValue), sensorName(name) {}
+    : Sensor(SENSOR_GAS), analogPin(pin), threshold(thresholdValue), sensorName(name),
+      readHist(Metrics::histogram("gas.read_us")), sampler(nullptr), samplerChannel(-1) {}
 
 void GasSensor::begin() {
     // Nếu cảm biến cần chân output, có thể pinMode
     pinMode(analogPin, INPUT);
 }
 
+bool GasSensor::attachSampler(AnalogSampler &adc) {
+    samplerChannel = adc.addChannel(analogPin);
+    sampler = samplerChannel >= 0 ? &adc : nullptr;
+    return sampler != nullptr;
+}
+
 int GasSensor::readRaw() {
+    CycleTimer timer(readHist);
+    if (sampler != nullptr) {
+        return sampler->readRaw(samplerChannel);  // oversample + EMA, không chờ ADC
+    }
     return analogRead(analogPin);  // đọc giá trị ADC 0-4095 với ESP32
 }
+
+SampleQuality GasSensor::read(float &value) {
+    value = readRaw();
+    return SAMPLE_GOOD;
+}
+
+int GasSensor::readMilliVolts() {
+    return sampler != nullptr ? sampler->readMilliVolts(samplerChannel) : -1;
+}
+
 void GasSensor::printGas() {
     int value = readRaw();
     Serial.print(sensorName);
     Serial.print(" Raw Value: ");
-    Serial.println(value);
-    delay(100);
+    Serial.print(value);
+    if (sampler != nullptr) {
+        Serial.printf(" (%d mV)", readMilliVolts());
+    }
+    Serial.println();
 }
 bool GasSensor::isGasDetected() {
     int value = readRaw();
     return value >= threshold;     // true nếu vượt ngưỡng
 }
 
+int GasSensor::getThreshold() const {
+    return threshold;
+}
+
 String GasSensor::getName() const {
     return sensorName;
 }
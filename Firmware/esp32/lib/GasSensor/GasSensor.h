@@ -1,20 +1,33 @@
 #pragma once
 
 #include <Arduino.h>
+#include "AnalogSampler.h"
+#include "Metrics.h"
+#include "Sensor.h"
 
-class GasSensor {
+class GasSensor : public Sensor {
 private:
     int analogPin;      // chân analog đọc giá trị
     String sensorName;  // tên cảm biến
     int threshold;      // ngưỡng cảnh báo
+    Histogram *readHist; // thời gian analogRead (µs)
+    AnalogSampler *sampler; // nullptr = analogRead trực tiếp
+    int8_t samplerChannel;
 
 public:
     GasSensor(int pin, int thresholdValue, String name);  // constructor
 
     void begin();              // khởi tạo (nếu cần)
+    bool attachSampler(AnalogSampler &adc); // đọc giá trị đã lọc từ task ADC (gọi trước adc.begin())
     int readRaw();             // đọc giá trị thô ADC
+    int readMilliVolts();      // sau hiệu chuẩn, -1 nếu không có sampler
     void printGas();        // in giá trị ra Serial
     bool isGasDetected();      // kiểm tra vượt ngưỡng
+    int getThreshold() const;  // ngưỡng raw ADC
     String getName() const;    // trả về tên cảm biến
+    const char *name() const override { return sensorName.c_str(); }
+
+protected:
+    SampleQuality read(float &value) override;   // ADC raw
 };
 
@@ -0,0 +1,175 @@
+#include "Metrics.h"
+#include <esp_heap_caps.h>
+
+// Mảng POD khởi tạo 0 sẵn: dùng được cả từ constructor của object toàn cục
+static Histogram histograms[Metrics::MAX_HISTOGRAMS + 1];   // phần tử cuối: metric "tràn"
+static Counter counters[Metrics::MAX_COUNTERS + 1];
+static Gauge gauges[Metrics::MAX_GAUGES + 1];
+static uint8_t histogramCount = 0;
+static uint8_t counterCount = 0;
+static uint8_t gaugeCount = 0;
+static uint32_t windowStartMs = 0;
+static uint32_t cpuMhz = 0;
+static portMUX_TYPE metricsLock = portMUX_INITIALIZER_UNLOCKED;
+
+// ============================================
+// HISTOGRAM
+// ============================================
+
+void Histogram::record(uint32_t value) {
+    uint8_t bucket = value == 0 ? 0 : (uint8_t)(32 - __builtin_clz(value));
+    if (bucket >= BUCKETS) {
+        bucket = BUCKETS - 1;
+    }
+    // Hai core có thể ghi cùng histogram; đoạn găng chỉ vài lệnh
+    portENTER_CRITICAL(&metricsLock);
+    buckets[bucket]++;
+    count++;
+    sum += value;
+    if (value > max) {
+        max = value;
+    }
+    portEXIT_CRITICAL(&metricsLock);
+}
+
+void Histogram::recordCycles(uint32_t cycles) {
+    record(cycles / Metrics::cyclesPerUs());
+}
+
+uint32_t Histogram::percentile(uint8_t p) const {
+    if (count == 0) {
+        return 0;
+    }
+    uint32_t target = ((uint64_t)count * p + 99) / 100;
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= target) {
+            uint32_t upper = i == 0 ? 0 : (1u << i) - 1;
+            return min(upper, max);
+        }
+    }
+    return max;
+}
+
+void Histogram::reset() {
+    portENTER_CRITICAL(&metricsLock);
+    memset(buckets, 0, sizeof(buckets));
+    count = 0;
+    max = 0;
+    sum = 0;
+    portEXIT_CRITICAL(&metricsLock);
+}
+
+// ============================================
+// ĐĂNG KÝ
+// ============================================
+
+template <typename T>
+static T *findOrAdd(T *items, uint8_t &itemCount, uint8_t capacity, const char *name) {
+    portENTER_CRITICAL(&metricsLock);
+    T *found = &items[capacity];
+    for (uint8_t i = 0; i < itemCount; i++) {
+        if (strcmp(items[i].name, name) == 0) {
+            found = &items[i];
+            break;
+        }
+    }
+    if (found == &items[capacity] && itemCount < capacity) {
+        found = &items[itemCount++];
+        found->name = name;
+    }
+    portEXIT_CRITICAL(&metricsLock);
+    return found;
+}
+
+Histogram *Metrics::histogram(const char *name) {
+    return findOrAdd(histograms, histogramCount, MAX_HISTOGRAMS, name);
+}
+
+Counter *Metrics::counter(const char *name) {
+    return findOrAdd(counters, counterCount, MAX_COUNTERS, name);
+}
+
+Gauge *Metrics::gauge(const char *name) {
+    return findOrAdd(gauges, gaugeCount, MAX_GAUGES, name);
+}
+
+uint32_t Metrics::cyclesPerUs() {
+    if (cpuMhz == 0) {
+        cpuMhz = getCpuFrequencyMhz();
+    }
+    return cpuMhz;
+}
+
+// ============================================
+// XUẤT
+// ============================================
+
+void Metrics::sampleHeap() {
+    static Gauge *heapFree = gauge("heap.free");
+    static Gauge *heapMinFree = gauge("heap.min_free");
+    static Gauge *heapLargest = gauge("heap.largest");
+    static Gauge *heapFrag = gauge("heap.frag_pct");
+
+    uint32_t freeBytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    uint32_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    heapFree->set(freeBytes);
+    heapMinFree->set(heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+    heapLargest->set(largest);
+    heapFrag->set(freeBytes > 0 ? 100 - (int32_t)((uint64_t)largest * 100 / freeBytes) : 0);
+}
+
+void Metrics::toJson(JsonObject out) {
+    out["windowMs"] = millis() - windowStartMs;
+    JsonObject h = out.createNestedObject("h");
+    for (uint8_t i = 0; i < histogramCount; i++) {
+        const Histogram &hist = histograms[i];
+        if (hist.count == 0) {
+            continue;
+        }
+        JsonArray values = h.createNestedArray(hist.name);
+        values.add(hist.count);
+        values.add(hist.percentile(50));
+        values.add(hist.percentile(99));
+        values.add(hist.max);
+        values.add((uint32_t)(hist.sum / hist.count));
+    }
+    JsonObject c = out.createNestedObject("c");
+    for (uint8_t i = 0; i < counterCount; i++) {
+        c[counters[i].name] = counters[i].value;
+    }
+    JsonObject g = out.createNestedObject("g");
+    for (uint8_t i = 0; i < gaugeCount; i++) {
+        JsonArray values = g.createNestedArray(gauges[i].name);
+        values.add(gauges[i].value);
+        values.add(gauges[i].peak);
+    }
+}
+
+void Metrics::print(Print &out) {
+    out.printf("[Metrics] window %u ms\n", (unsigned)(millis() - windowStartMs));
+    out.println("[Metrics] histogram            count      p50      p99      max      avg");
+    for (uint8_t i = 0; i < histogramCount; i++) {
+        const Histogram &hist = histograms[i];
+        out.printf("[Metrics] %-20s %7u %8u %8u %8u %8u\n", hist.name, hist.count,
+                   hist.percentile(50), hist.percentile(99), hist.max,
+                   hist.count > 0 ? (uint32_t)(hist.sum / hist.count) : 0);
+    }
+    for (uint8_t i = 0; i < counterCount; i++) {
+        out.printf("[Metrics] counter %-20s %u\n", counters[i].name, counters[i].value);
+    }
+    for (uint8_t i = 0; i < gaugeCount; i++) {
+        out.printf("[Metrics] gauge   %-20s %d (peak %d)\n", gauges[i].name, gauges[i].value, gauges[i].peak);
+    }
+}
+
+void Metrics::resetWindow() {
+    for (uint8_t i = 0; i < histogramCount; i++) {
+        histograms[i].reset();
+    }
+    for (uint8_t i = 0; i < gaugeCount; i++) {
+        gauges[i].peak = gauges[i].value;
+    }
+    windowStartMs = millis();
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <esp_idf_version.h>
+#if ESP_IDF_VERSION_MAJOR >= 5
+#include <esp_cpu.h>
+#define METRICS_CCOUNT() ((uint32_t)esp_cpu_get_cycle_count())
+#else
+#include <soc/cpu.h>
+#define METRICS_CCOUNT() ((uint32_t)esp_cpu_get_ccount())
+#endif
+
+// ======================================================
+// 📈 Metrics: histogram, counter, gauge cho hot path
+// ======================================================
+//
+// Module đăng ký metric theo tên một lần lúc begin() và giữ con trỏ; hot path
+// chỉ cộng vài biến, không cấp phát, không Serial. Histogram xếp giá trị vào
+// bucket log2 (bucket i = [2^(i-1), 2^i)), nên p50/p99 là cận trên của bucket,
+// sai tối đa 2 lần, đủ để thấy đuôi trễ. CycleTimer đo bằng CCOUNT (vài chu kỳ
+// mỗi lần đọc thay vì ~1 µs của esp_timer_get_time); CCOUNT là của từng core,
+// nên chỉ dùng trong task ghim core hoặc đoạn không nhường CPU.
+//
+// Robot gửi snapshot định kỳ qua STATUS_UPDATE ("metrics") rồi reset histogram;
+// counter cộng dồn từ lúc boot. Lệnh Serial 'm' in bảng.
+
+class Histogram {
+public:
+    static const uint8_t BUCKETS = 24;     // tới ~8.4 s nếu đơn vị µs
+
+    void record(uint32_t value);
+    void recordCycles(uint32_t cycles);    // đổi chu kỳ CPU sang µs
+    uint32_t percentile(uint8_t p) const;  // cận trên bucket chứa phân vị p%
+    void reset();
+
+    const char *name;
+    uint32_t count;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t buckets[BUCKETS];
+};
+
+struct Counter {
+    void add(uint32_t n = 1) { value += n; }
+
+    const char *name;
+    volatile uint32_t value;
+};
+
+struct Gauge {
+    void set(int32_t v) {
+        value = v;
+        if (v > peak) {
+            peak = v;
+        }
+    }
+
+    const char *name;
+    volatile int32_t value;
+    volatile int32_t peak;                 // lớn nhất trong cửa sổ, reset cùng histogram
+};
+
+// Đo một đoạn code vào histogram (µs): { CycleTimer t(hist); ... }
+class CycleTimer {
+public:
+    explicit CycleTimer(Histogram *hist) : hist(hist), start(METRICS_CCOUNT()) {}
+    ~CycleTimer() { hist->recordCycles(METRICS_CCOUNT() - start); }
+
+private:
+    Histogram *hist;
+    uint32_t start;
+};
+
+class Metrics {
+public:
+    static const uint8_t MAX_HISTOGRAMS = 16;
+    static const uint8_t MAX_COUNTERS = 16;
+    static const uint8_t MAX_GAUGES = 12;
+
+    // Trả về metric có sẵn theo tên hoặc tạo mới; hết chỗ thì trả về một metric
+    // chung không được xuất, để nơi gọi không phải kiểm tra nullptr
+    static Histogram *histogram(const char *name);
+    static Counter *counter(const char *name);
+    static Gauge *gauge(const char *name);
+
+    // Heap: free, min free, khối lớn nhất, % phân mảnh
+    static void sampleHeap();
+    // {"windowMs":..,"h":{name:[n,p50,p99,max,avg]},"c":{..},"g":{name:[value,peak]}}
+    static void toJson(JsonObject out);
+    static void print(Print &out = Serial);
+    // Bắt đầu cửa sổ mới cho histogram và peak của gauge
+    static void resetWindow();
+
+    static uint32_t cyclesPerUs();
+};
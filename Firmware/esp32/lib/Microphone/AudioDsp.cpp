@@ -0,0 +1,303 @@
+#include "AudioDsp.h"
+#include <math.h>
+
+static inline int16_t saturate16(int32_t v) {
+    return v > 32767 ? 32767 : (v < -32768 ? -32768 : (int16_t)v);
+}
+
+// ============================================
+// KERNEL KHÔNG TRẠNG THÁI
+// ============================================
+
+void AudioDsp::convert32to16(const int32_t *src, int16_t *dst, size_t count, uint8_t shift) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        int32_t a = src[i], b = src[i + 1], c = src[i + 2], d = src[i + 3];
+        dst[i] = (int16_t)(a >> shift);
+        dst[i + 1] = (int16_t)(b >> shift);
+        dst[i + 2] = (int16_t)(c >> shift);
+        dst[i + 3] = (int16_t)(d >> shift);
+    }
+    for (; i < count; i++) {
+        dst[i] = (int16_t)(src[i] >> shift);
+    }
+}
+
+int16_t *AudioDsp::convertInPlace(int32_t *block, size_t count, uint8_t shift) {
+    // Mẫu 16-bit thứ i nằm ở byte 2i, luôn trước mẫu 32-bit thứ i (byte 4i) chưa đọc:
+    // đi xuôi thì không ghi đè dữ liệu chưa dùng. may_alias để compiler không đảo thứ tự
+    typedef int16_t __attribute__((__may_alias__)) AliasedPcm;
+    typedef int32_t __attribute__((__may_alias__)) AliasedRaw;
+    const AliasedRaw *src = block;
+    AliasedPcm *dst = reinterpret_cast<AliasedPcm *>(block);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        int32_t a = src[i], b = src[i + 1], c = src[i + 2], d = src[i + 3];
+        dst[i] = (int16_t)(a >> shift);
+        dst[i + 1] = (int16_t)(b >> shift);
+        dst[i + 2] = (int16_t)(c >> shift);
+        dst[i + 3] = (int16_t)(d >> shift);
+    }
+    for (; i < count; i++) {
+        dst[i] = (int16_t)(src[i] >> shift);
+    }
+    return reinterpret_cast<int16_t *>(block);
+}
+
+uint16_t AudioDsp::peak(const int16_t *samples, size_t count) {
+    int32_t hi = 0;
+    int32_t lo = 0;
+    for (size_t i = 0; i < count; i++) {
+        int32_t v = samples[i];
+        hi = v > hi ? v : hi;
+        lo = v < lo ? v : lo;
+    }
+    return (uint16_t)(hi > -lo ? hi : -lo);
+}
+
+bool AudioDsp::hasEspDsp() {
+#ifdef HOMEGUARD_HAS_ESP_DSP
+    return true;
+#else
+    return false;
+#endif
+}
+
+// ============================================
+// DC BLOCKER
+// ============================================
+
+DcBlocker::DcBlocker(uint8_t shift) : shift(shift), lastInput(0), acc(0) {}
+
+void DcBlocker::process(int16_t *samples, size_t count) {
+    int32_t a = acc;
+    int32_t last = lastInput;
+    for (size_t i = 0; i < count; i++) {
+        int32_t x = samples[i];
+        a += (x - last) * 256 - (a >> shift);
+        last = x;
+        samples[i] = saturate16((a + 128) >> 8);
+    }
+    acc = a;
+    lastInput = (int16_t)last;
+}
+
+void DcBlocker::reset() {
+    lastInput = 0;
+    acc = 0;
+}
+
+// ============================================
+// BIQUAD HIGH-PASS
+// ============================================
+
+BiquadHighPass::BiquadHighPass() : coeffs{ 1.0f, 0, 0, 0, 0 }, state{}, scratch{} {}
+
+void BiquadHighPass::configure(uint32_t sampleRate, float cutoffHz) {
+    const float w0 = 2.0f * (float)M_PI * cutoffHz / (float)sampleRate;
+    const float alpha = sinf(w0) / (2.0f * 0.7071f);
+    const float cosw = cosf(w0);
+    const float a0 = 1.0f + alpha;
+    coeffs[0] = (1.0f + cosw) / 2.0f / a0;
+    coeffs[1] = -(1.0f + cosw) / a0;
+    coeffs[2] = coeffs[0];
+    coeffs[3] = -2.0f * cosw / a0;
+    coeffs[4] = (1.0f - alpha) / a0;
+    reset();
+}
+
+void BiquadHighPass::process(int16_t *samples, size_t count) {
+    for (size_t done = 0; done < count; done += CHUNK) {
+        size_t n = min(count - done, (size_t)CHUNK);
+        int16_t *block = samples + done;
+        for (size_t i = 0; i < n; i++) {
+            scratch[i] = block[i];
+        }
+#ifdef HOMEGUARD_HAS_ESP_DSP
+        dsps_biquad_f32(scratch, scratch, (int)n, coeffs, state);
+#else
+        float w1 = state[0], w2 = state[1];
+        for (size_t i = 0; i < n; i++) {
+            float w0 = scratch[i] - coeffs[3] * w1 - coeffs[4] * w2;
+            scratch[i] = coeffs[0] * w0 + coeffs[1] * w1 + coeffs[2] * w2;
+            w2 = w1;
+            w1 = w0;
+        }
+        state[0] = w1;
+        state[1] = w2;
+#endif
+        for (size_t i = 0; i < n; i++) {
+            float v = scratch[i];
+            block[i] = saturate16((int32_t)(v >= 0 ? v + 0.5f : v - 0.5f));
+        }
+    }
+}
+
+void BiquadHighPass::reset() {
+    state[0] = 0;
+    state[1] = 0;
+}
+
+// ============================================
+// AGC
+// ============================================
+
+Agc::Agc() : targetPeak(8000), noiseFloor(200), maxGain(8 * UNITY), gain(UNITY) {}
+
+void Agc::configure(uint16_t target, int32_t maxGainQ12, uint16_t floor) {
+    targetPeak = target;
+    maxGain = maxGainQ12 > 8 * UNITY ? 8 * UNITY : maxGainQ12;
+    noiseFloor = floor;
+    reset();
+}
+
+void Agc::process(int16_t *samples, size_t count) {
+    if (count == 0) {
+        return;
+    }
+    uint16_t blockPeak = AudioDsp::peak(samples, count);
+    int32_t next = gain;
+    if (blockPeak >= noiseFloor) {
+        int32_t desired = (int32_t)targetPeak * UNITY / blockPeak;
+        desired = desired > maxGain ? maxGain : (desired < UNITY / 8 ? UNITY / 8 : desired);
+        // Attack tức thì để khối này không clip, release ~16 khối (~0.5 s với 512 @ 16 kHz)
+        next = desired < gain ? desired : gain + ((desired - gain) >> 4);
+    }
+    if (next == UNITY && gain == UNITY) {
+        return;
+    }
+
+    // Attack áp gain mới ngay từ mẫu đầu; release nội suy tuyến tính trong khối (thêm 8 bit cho bước)
+    if (next < gain) {
+        gain = next;
+    }
+    int32_t g = gain * 256;
+    int32_t step = (next - gain) * 256 / (int32_t)count;
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = saturate16((samples[i] * (g >> 8) + (1 << 11)) >> 12);
+        g += step;
+    }
+    gain = next;
+}
+
+void Agc::reset() {
+    gain = UNITY;
+}
+
+int32_t Agc::getGainQ12() const {
+    return gain;
+}
+
+// ============================================
+// DECIMATOR 48 -> 16 kHz
+// ============================================
+
+Decimator3::Decimator3() : coeffs{}, history{}, phase(0) {
+    // Sinc cửa sổ Hamming, fc = 7 kHz / 48 kHz; chuẩn hoá tổng = 1.0 (32768)
+    const uint8_t center = TAPS / 2;
+    const float fc = 7000.0f / 48000.0f;
+    float taps[TAPS / 2 + 1];
+    float sum = 0;
+    for (uint8_t k = 0; k <= center; k++) {
+        float n = (float)k - center;
+        float sinc = n == 0 ? 2.0f * fc : sinf(2.0f * (float)M_PI * fc * n) / ((float)M_PI * n);
+        float w = 0.54f - 0.46f * cosf(2.0f * (float)M_PI * k / (TAPS - 1));
+        taps[k] = sinc * w;
+        sum += k == center ? taps[k] : 2.0f * taps[k];
+    }
+    int32_t total = 0;
+    for (uint8_t k = 0; k < center; k++) {
+        coeffs[k] = (int16_t)lroundf(taps[k] / sum * 32768.0f);
+        total += 2 * coeffs[k];
+    }
+    coeffs[center] = (int16_t)(32768 - total);     // tổng đúng 32768: DC đi qua nguyên vẹn
+}
+
+size_t Decimator3::process(int16_t *samples, size_t count) {
+    const uint8_t center = TAPS / 2;
+    size_t produced = 0;
+    for (size_t done = 0; done < count; done += CHUNK) {
+        size_t n = min(count - done, (size_t)CHUNK);
+        // Chép vào history trước: mẫu ra ghi vào samples[produced], luôn trong phần đã chép
+        memcpy(history + TAPS - 1, samples + done, n * sizeof(int16_t));
+        size_t i = phase;
+        for (; i < n; i += FACTOR) {
+            const int16_t *x = history + i;          // x[0..TAPS-1], mẫu mới nhất ở cuối
+            int32_t acc = (int32_t)coeffs[center] * x[center];
+            for (uint8_t k = 0; k < center; k++) {
+                acc += (int32_t)coeffs[k] * (x[k] + x[TAPS - 1 - k]);
+            }
+            samples[produced++] = saturate16((acc + (1 << 14)) >> 15);
+        }
+        phase = (uint8_t)(i - n);
+        memmove(history, history + n, (TAPS - 1) * sizeof(int16_t));
+    }
+    return produced;
+}
+
+void Decimator3::reset() {
+    memset(history, 0, sizeof(history));
+    phase = 0;
+}
+
+// ============================================
+// CAPTURE DSP
+// ============================================
+
+CaptureDsp::CaptureDsp() : decimate(false), dcBlock(false), highPassHz(0), agcTarget(0) {}
+
+void CaptureDsp::setDecimate(bool enabled) {
+    decimate = enabled;
+}
+
+void CaptureDsp::setDcBlock(bool enabled) {
+    dcBlock = enabled;
+}
+
+void CaptureDsp::setHighPass(float cutoffHz) {
+    highPassHz = cutoffHz;
+}
+
+void CaptureDsp::setAgc(uint16_t targetPeak) {
+    agcTarget = targetPeak;
+}
+
+void CaptureDsp::begin(uint32_t sampleRate) {
+    if (highPassHz > 0) {
+        highPass.configure(sampleRate, highPassHz);
+    }
+    if (agcTarget > 0) {
+        agc.configure(agcTarget);
+    }
+    reset();
+}
+
+size_t CaptureDsp::pre(int16_t *samples, size_t count) {
+    if (decimate) {
+        count = decimator.process(samples, count);
+    }
+    if (dcBlock) {
+        dcBlocker.process(samples, count);
+    }
+    if (highPassHz > 0) {
+        highPass.process(samples, count);
+    }
+    return count;
+}
+
+void CaptureDsp::post(int16_t *samples, size_t count) {
+    if (agcTarget > 0) {
+        agc.process(samples, count);
+    }
+}
+
+void CaptureDsp::reset() {
+    decimator.reset();
+    dcBlocker.reset();
+    highPass.reset();
+    agc.reset();
+}
+
+uint8_t CaptureDsp::getDecimation() const {
+    return decimate ? Decimator3::FACTOR : 1;
+}
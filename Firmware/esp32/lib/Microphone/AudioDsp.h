@@ -0,0 +1,158 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ======================================================
+// 🎚️ Kernel DSP cho đường thu INMP441 (theo khối, tại chỗ)
+// ======================================================
+//
+// Mọi kernel nhận nguyên một buffer DMA (512 mẫu) và sửa tại chỗ, không cấp
+// phát trong task capture. Chuyển 32→16, DC blocker, AGC và bộ hạ tần 48→16 kHz
+// là số nguyên (nhân 16x16→32, không cần FPU). Biquad high-pass chạy float qua
+// dsps_biquad_f32 của esp-dsp khi có (bản ae32 viết tay cho ESP32, bản aes3
+// dùng lệnh SIMD PIE trên ESP32-S3, esp-dsp tự chọn theo target); không có
+// esp-dsp (test native) thì dùng vòng lặp C cùng công thức.
+
+#if __has_include(<esp_dsp.h>)
+#include <esp_dsp.h>
+#define HOMEGUARD_HAS_ESP_DSP 1
+#endif
+
+class AudioDsp {
+public:
+    // Chuyển 32-bit (24-bit căn trái) sang 16-bit
+    static void convert32to16(const int32_t *src, int16_t *dst, size_t count, uint8_t shift);
+    // Tại chỗ: mẫu 16-bit ghi đè lên nửa đầu của chính buffer 32-bit, trả về con trỏ PCM
+    static int16_t *convertInPlace(int32_t *block, size_t count, uint8_t shift);
+    // Biên độ lớn nhất |x| của khối
+    static uint16_t peak(const int16_t *samples, size_t count);
+    static bool hasEspDsp();
+};
+
+// ============================================
+// DC BLOCKER
+// ============================================
+
+// y[n] = x[n] - x[n-1] + (1 - 2^-k) * y[n-1], không có phép nhân.
+// k = 7: cắt ~20 Hz @ 16 kHz. Trạng thái giữ 8 bit phân số để không trôi.
+class DcBlocker {
+public:
+    explicit DcBlocker(uint8_t shift = 7);
+
+    void process(int16_t *samples, size_t count);
+    void reset();
+
+private:
+    uint8_t shift;
+    int16_t lastInput;
+    int32_t acc;                 // y[n-1] << 8
+};
+
+// ============================================
+// BIQUAD HIGH-PASS
+// ============================================
+
+// High-pass bậc 2 (RBJ cookbook, Q = 0.707), direct form II như dsps_biquad_f32
+class BiquadHighPass {
+public:
+    BiquadHighPass();
+
+    void configure(uint32_t sampleRate, float cutoffHz);
+    void process(int16_t *samples, size_t count);
+    void reset();
+
+private:
+    static const uint16_t CHUNK = 128;   // scratch float cho một phần buffer DMA
+
+    float coeffs[5];             // b0, b1, b2, a1, a2 (đúng thứ tự esp-dsp)
+    float state[2];
+    float scratch[CHUNK];
+};
+
+// ============================================
+// AGC
+// ============================================
+
+// Tăng ích theo đỉnh từng khối: giảm nhanh khi gần clip (attack), tăng chậm
+// (release), giữ nguyên khi khối nhỏ hơn ngưỡng nhiễu để không khuếch đại tiếng ồn.
+// Gain đổi dần từng mẫu trong khối để không nghe tiếng lách tách.
+class Agc {
+public:
+    static const int32_t UNITY = 1 << 12;     // gain Q12
+
+    Agc();
+
+    // targetPeak: đỉnh mong muốn; maxGainQ12 tối đa 8x để x * gain không tràn int32
+    void configure(uint16_t targetPeak, int32_t maxGainQ12 = 8 * UNITY, uint16_t noiseFloor = 200);
+    void process(int16_t *samples, size_t count);
+    void reset();
+    int32_t getGainQ12() const;
+
+private:
+    uint16_t targetPeak;
+    uint16_t noiseFloor;
+    int32_t maxGain;
+    int32_t gain;
+};
+
+// ============================================
+// DECIMATOR 48 -> 16 kHz
+// ============================================
+
+// FIR thông thấp 47 tap (sinc cửa sổ Hamming, cắt 7 kHz, Q15), chỉ tính
+// mẫu ra thứ 3; hệ số đối xứng nên mỗi mẫu ra chỉ 24 phép nhân.
+// Giữ pha giữa các khối: 512 mẫu vào cho 170 hoặc 171 mẫu ra.
+class Decimator3 {
+public:
+    static const uint8_t FACTOR = 3;
+    static const uint8_t TAPS = 47;
+
+    Decimator3();
+
+    // Ghi đè tại chỗ, trả về số mẫu ra (<= count / 3 + 1)
+    size_t process(int16_t *samples, size_t count);
+    void reset();
+
+private:
+    static const uint8_t CHUNK = 96;          // bội số của FACTOR
+
+    int16_t coeffs[TAPS / 2 + 1];
+    int16_t history[TAPS - 1 + CHUNK];        // TAPS - 1 mẫu cũ + phần khối đang xử lý
+    uint8_t phase;                            // số mẫu vào còn lại tới mẫu ra kế tiếp
+};
+
+// ============================================
+// CAPTURE DSP
+// ============================================
+
+// Chuỗi xử lý của INMP441. Mặc định tắt hết: đường thu giữ nguyên như cũ.
+//   pre():  hạ tần -> DC blocker -> high-pass (trước AEC, tuyến tính)
+//   post(): AGC (sau AEC, vì AEC cần tín hiệu tuyến tính với loa)
+class CaptureDsp {
+public:
+    CaptureDsp();
+
+    // Gọi trước INMP441::begin(): I2S chạy ở sampleRate * 3 rồi hạ về sampleRate
+    void setDecimate(bool enabled);
+    void setDcBlock(bool enabled);
+    void setHighPass(float cutoffHz);         // 0 = tắt
+    void setAgc(uint16_t targetPeak);         // 0 = tắt
+
+    void begin(uint32_t sampleRate);
+    size_t pre(int16_t *samples, size_t count);
+    void post(int16_t *samples, size_t count);
+    void reset();
+
+    uint8_t getDecimation() const;
+
+private:
+    bool decimate;
+    bool dcBlock;
+    float highPassHz;
+    uint16_t agcTarget;
+
+    Decimator3 decimator;
+    DcBlocker dcBlocker;
+    BiquadHighPass highPass;
+    Agc agc;
+};
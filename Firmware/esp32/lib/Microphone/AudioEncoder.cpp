@@ -0,0 +1,107 @@
+#include "AudioEncoder.h"
+#include <esp_timer.h>
+#include "ImaAdpcm.h"
+
+size_t AudioEncoder::encode(const int16_t *pcm, uint16_t samples, uint8_t *out, size_t capacity) {
+    int64_t start = esp_timer_get_time();
+    size_t bytes = encodeFrame(pcm, samples, out, capacity);
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+
+    if (bytes == 0) {
+        stats.failed++;
+        return 0;
+    }
+    stats.frames++;
+    stats.lastUs = elapsed;
+    stats.maxUs = max(stats.maxUs, elapsed);
+    stats.totalUs += elapsed;
+    stats.bytesIn += samples * sizeof(int16_t);
+    stats.bytesOut += bytes;
+    return bytes;
+}
+
+void AudioEncoder::printStats(Print &out) const {
+    out.printf("[Encoder] %s frames=%u failed=%u avg=%uus max=%uus ratio=%.2f\n",
+               audioCodecName(codec()), stats.frames, stats.failed,
+               getAvgEncodeUs(), stats.maxUs, getCompressionRatio());
+}
+
+// ============================================
+// PCM16
+// ============================================
+
+size_t Pcm16Encoder::encodeFrame(const int16_t *pcm, uint16_t samples, uint8_t *out, size_t capacity) {
+    size_t bytes = samples * sizeof(int16_t);
+    if (bytes > capacity) {
+        return 0;
+    }
+    memcpy(out, pcm, bytes);
+    return bytes;
+}
+
+// ============================================
+// IMA-ADPCM
+// ============================================
+
+AdpcmEncoder::AdpcmEncoder() : predictor(0), index(0) {}
+
+void AdpcmEncoder::reset() {
+    predictor = 0;
+    index = 0;
+}
+
+size_t AdpcmEncoder::encodeFrame(const int16_t *pcm, uint16_t samples, uint8_t *out, size_t capacity) {
+    size_t bytes = encodedSize(samples);
+    if (bytes > capacity) {
+        return 0;
+    }
+    out[0] = (uint8_t)(predictor & 0xFF);
+    out[1] = (uint8_t)((uint16_t)predictor >> 8);
+    out[2] = (uint8_t)index;
+    out[3] = 0;
+
+    // Nibble thấp là mẫu trước
+    uint8_t *dst = out + HEADER_BYTES;
+    for (uint16_t i = 0; i + 1 < samples; i += 2) {
+        uint8_t lo = encodeSample(pcm[i]);
+        *dst++ = lo | (encodeSample(pcm[i + 1]) << 4);
+    }
+    if (samples & 1) {
+        *dst = encodeSample(pcm[samples - 1]);
+    }
+    return bytes;
+}
+
+uint8_t AdpcmEncoder::encodeSample(int16_t sample) {
+    int32_t step = IMA_STEPS[index];
+    int32_t diff = (int32_t)sample - predictor;
+    uint8_t code = 0;
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+
+    // Lượng tử hoá 3 bit độ lớn, đồng thời tính lại đúng giá trị decoder sẽ thấy
+    int32_t delta = step >> 3;
+    if (diff >= step) {
+        code |= 4;
+        diff -= step;
+        delta += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 2;
+        diff -= step;
+        delta += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 1;
+        delta += step;
+    }
+
+    int32_t next = (code & 8) ? predictor - delta : predictor + delta;
+    predictor = (int16_t)constrain(next, -32768, 32767);
+    index = (int8_t)constrain(index + IMA_INDEX_ADJUST[code & 7], 0, 88);
+    return code;
+}
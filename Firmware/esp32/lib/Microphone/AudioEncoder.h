@@ -0,0 +1,83 @@
+#pragma once
+
+#include <Arduino.h>
+#include "BinaryFrame.h"
+
+// ======================================================
+// 🗜️ Codec audio uplink giữa ring capture và WebSocketClient
+// ======================================================
+//
+// Mỗi chunk PCM được mã hoá độc lập về mặt framing (server giải từng frame
+// CHANNEL_AUDIO_UP), encode() đo thời gian từng frame để so sánh codec khi
+// chọn cấu hình cho từng nơi triển khai:
+//
+//   pcm16  256 kbit/s   ~0 CPU
+//   adpcm   64 kbit/s   vài chục µs / 20 ms
+//   opus    16 kbit/s   vài ms / 20 ms (xem OpusFrameEncoder)
+
+struct EncoderStats {
+    uint32_t frames;
+    uint32_t failed;
+    uint32_t lastUs;
+    uint32_t maxUs;
+    uint64_t totalUs;
+    uint64_t bytesIn;            // byte PCM đầu vào
+    uint64_t bytesOut;           // byte payload sau mã hoá
+};
+
+class AudioEncoder {
+public:
+    virtual ~AudioEncoder() {}
+
+    virtual AudioCodec codec() const = 0;
+    virtual bool begin(uint32_t sampleRate) { return true; }
+    // Đầu phiên mới: xoá trạng thái dự đoán giữa các chunk
+    virtual void reset() {}
+    // true: mọi chunk phải đủ chunkSamples (Opus), chunk cuối được đệm 0
+    virtual bool fixedFrameSize() const { return false; }
+
+    // Trả về số byte ghi vào out, 0 nếu lỗi / không đủ chỗ
+    size_t encode(const int16_t *pcm, uint16_t samples, uint8_t *out, size_t capacity);
+
+    const EncoderStats &getStats() const { return stats; }
+    uint32_t getAvgEncodeUs() const { return stats.frames ? (uint32_t)(stats.totalUs / stats.frames) : 0; }
+    float getCompressionRatio() const { return stats.bytesOut ? (float)stats.bytesIn / stats.bytesOut : 0.0f; }
+    void resetStats() { memset(&stats, 0, sizeof(stats)); }
+    void printStats(Print &out = Serial) const;
+
+protected:
+    virtual size_t encodeFrame(const int16_t *pcm, uint16_t samples, uint8_t *out, size_t capacity) = 0;
+
+    EncoderStats stats = {};
+};
+
+// Không nén, giữ làm mốc so sánh thời gian / băng thông
+class Pcm16Encoder : public AudioEncoder {
+public:
+    AudioCodec codec() const override { return AUDIO_PCM16; }
+
+protected:
+    size_t encodeFrame(const int16_t *pcm, uint16_t samples, uint8_t *out, size_t capacity) override;
+};
+
+// IMA-ADPCM 4 bit/mẫu. Mỗi chunk mở đầu bằng trạng thái encoder trước chunk
+// đó nên server giải được tiếp dù mất frame giữa phiên.
+class AdpcmEncoder : public AudioEncoder {
+public:
+    static const uint8_t HEADER_BYTES = 4;     // = IMA_HEADER_BYTES
+
+    AdpcmEncoder();
+    AudioCodec codec() const override { return AUDIO_IMA_ADPCM; }
+    void reset() override;
+
+    static size_t encodedSize(uint16_t samples) { return HEADER_BYTES + (samples + 1) / 2; }
+
+protected:
+    size_t encodeFrame(const int16_t *pcm, uint16_t samples, uint8_t *out, size_t capacity) override;
+
+private:
+    uint8_t encodeSample(int16_t sample);
+
+    int16_t predictor;
+    int8_t index;
+};
@@ -0,0 +1,194 @@
+#include "EchoCanceller.h"
+#include <esp_timer.h>
+
+EchoCanceller::EchoCanceller(uint32_t sampleRate, float stepSize)
+    : sampleRate(sampleRate), frameSamples(sampleRate * FRAME_MS / 1000), mu(stepSize),
+      enabled(true), bulkDelayUs(10000), doubleTalkRatio(0.6f), refBuf(nullptr), refWritten(0),
+      anchorLock(portMUX_INITIALIZER_UNLOCKED), anchorIndex(0), anchorUs(0), anchorValid(false),
+      weights(nullptr), xbuf(nullptr), hangover(0), farEnd(false) {
+    resetStats();
+}
+
+bool EchoCanceller::begin() {
+    if (refBuf != nullptr) {
+        return true;
+    }
+    refBuf = (int16_t *)calloc(REF_CAPACITY, sizeof(int16_t));
+    weights = (float *)calloc(TAPS, sizeof(float));
+    xbuf = (float *)calloc(TAPS - 1 + frameSamples, sizeof(float));
+    return refBuf != nullptr && weights != nullptr && xbuf != nullptr;
+}
+
+void EchoCanceller::setEnabled(bool enable) {
+    enabled = enable;
+}
+
+void EchoCanceller::setBulkDelayUs(uint32_t us) {
+    bulkDelayUs = us;
+}
+
+void EchoCanceller::setDoubleTalkRatio(float ratio) {
+    doubleTalkRatio = ratio;
+}
+
+// ============================================
+// THAM CHIẾU (task mixer)
+// ============================================
+
+void EchoCanceller::pushReference(const int16_t *pcm, size_t count, int64_t playoutUs) {
+    if (refBuf == nullptr) {
+        return;
+    }
+    uint32_t index = refWritten;
+
+    // Trong một đợt phát liên tục, index <-> thời gian là tuyến tính từ anchor.
+    // Loa nghỉ rồi phát lại thì lấp khoảng nghỉ bằng 0 và đặt anchor mới.
+    portENTER_CRITICAL(&anchorLock);
+    int64_t expectedUs = anchorUs + (int64_t)(index - anchorIndex) * 1000000 / sampleRate;
+    bool rebase = !anchorValid || playoutUs > expectedUs + 2000;
+    portEXIT_CRITICAL(&anchorLock);
+
+    if (rebase) {
+        if (anchorValid) {
+            uint32_t gap = (uint32_t)min<int64_t>((playoutUs - expectedUs) * sampleRate / 1000000, REF_CAPACITY);
+            for (uint32_t i = 0; i < gap; i++) {
+                refBuf[(index + i) & (REF_CAPACITY - 1)] = 0;
+            }
+            index += gap;
+        }
+        portENTER_CRITICAL(&anchorLock);
+        anchorIndex = index;
+        anchorUs = playoutUs;
+        anchorValid = true;
+        portEXIT_CRITICAL(&anchorLock);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        refBuf[(index + i) & (REF_CAPACITY - 1)] = pcm[i];
+    }
+    refWritten = index + count;
+}
+
+int64_t EchoCanceller::refIndexAt(int64_t us) const {
+    portENTER_CRITICAL(&anchorLock);
+    int64_t index = (int64_t)anchorIndex + (us - anchorUs - (int64_t)bulkDelayUs) * sampleRate / 1000000;
+    portEXIT_CRITICAL(&anchorLock);
+    return index;
+}
+
+// ============================================
+// KHỬ VỌNG (task capture)
+// ============================================
+
+void EchoCanceller::process(int16_t *mic, size_t count, int64_t captureUs) {
+    if (!enabled || refBuf == nullptr) {
+        return;
+    }
+    for (size_t offset = 0; offset < count; offset += frameSamples) {
+        uint16_t n = (uint16_t)min<size_t>(frameSamples, count - offset);
+        processFrame(mic + offset, n, captureUs + (int64_t)offset * 1000000 / sampleRate);
+    }
+}
+
+void EchoCanceller::processFrame(int16_t *mic, uint16_t count, int64_t frameUs) {
+    int64_t start = esp_timer_get_time();
+    stats.frames++;
+
+    // Gom tham chiếu [first, first + TAPS - 1 + count) ra float; ngoài vùng hợp lệ là 0
+    // Index so sánh theo modulo 2^32: behind = số mẫu index nằm sau refWritten
+    uint32_t first = (uint32_t)(refIndexAt(frameUs) - (TAPS - 1));
+    uint32_t written = refWritten;
+    float refPeak = 0.0f;
+    uint16_t len = TAPS - 1 + count;
+    for (uint16_t i = 0; i < len; i++) {
+        uint32_t idx = first + i;
+        uint32_t behind = written - idx;
+        float x = (anchorValid && behind >= 1 && behind <= REF_CAPACITY - TAPS)
+                  ? refBuf[idx & (REF_CAPACITY - 1)] : 0.0f;
+        xbuf[i] = x;
+        refPeak = max(refPeak, fabsf(x));
+    }
+    farEnd = refPeak > 64.0f;
+    if (!farEnd) {
+        stats.lastFrameUs = (uint32_t)(esp_timer_get_time() - start);
+        return;
+    }
+
+    float micPeak = 0.0f;
+    for (uint16_t i = 0; i < count; i++) {
+        micPeak = max(micPeak, fabsf((float)mic[i]));
+    }
+    if (micPeak > doubleTalkRatio * refPeak) {
+        hangover = 5;   // giữ 50 ms sau khi người dùng ngừng nói chen
+    }
+    bool adapt = hangover == 0;
+    if (hangover > 0) {
+        hangover--;
+        stats.doubleTalkFrames++;
+    }
+
+    // Năng lượng cửa sổ TAPS, cập nhật trượt từng mẫu
+    float power = 0.0f;
+    for (uint16_t k = 0; k < TAPS; k++) {
+        power += xbuf[k] * xbuf[k];
+    }
+
+    for (uint16_t n = 0; n < count; n++) {
+        const float *x = xbuf + n;           // x[TAPS - 1] là mẫu hiện tại
+        float echo = 0.0f;
+        for (uint16_t k = 0; k < TAPS; k++) {
+            echo += weights[k] * x[TAPS - 1 - k];
+        }
+        float d = mic[n];
+        float e = d - echo;
+
+        if (adapt) {
+            float g = mu * e / (power + 1.0e4f);
+            for (uint16_t k = 0; k < TAPS; k++) {
+                weights[k] += g * x[TAPS - 1 - k];
+            }
+            echoEnergy += (double)d * d;
+            residualEnergy += (double)e * e;
+        }
+        if (n + TAPS < len) {
+            power += x[TAPS] * x[TAPS] - x[0] * x[0];
+        }
+        mic[n] = (int16_t)constrain(e, -32768.0f, 32767.0f);
+    }
+
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+    stats.activeFrames++;
+    stats.lastFrameUs = elapsed;
+    stats.maxFrameUs = max(stats.maxFrameUs, elapsed);
+    activeUsTotal += elapsed;
+}
+
+bool EchoCanceller::isFarEndActive() const {
+    return farEnd;
+}
+
+// ============================================
+// THỐNG KÊ
+// ============================================
+
+AecStats EchoCanceller::getStats() const {
+    AecStats result = stats;
+    result.avgActiveFrameUs = stats.activeFrames ? (uint32_t)(activeUsTotal / stats.activeFrames) : 0;
+    result.budgetPercent = result.avgActiveFrameUs * 100.0f / (FRAME_MS * 1000.0f);
+    result.erleDb = residualEnergy > 0 ? 10.0f * log10f((float)(echoEnergy / residualEnergy)) : 0.0f;
+    return result;
+}
+
+void EchoCanceller::resetStats() {
+    memset(&stats, 0, sizeof(stats));
+    activeUsTotal = 0;
+    echoEnergy = 0;
+    residualEnergy = 0;
+}
+
+void EchoCanceller::printStats(Print &out) const {
+    AecStats s = getStats();
+    out.printf("[AEC] frames=%u active=%u double_talk=%u | per 10ms avg=%uus max=%uus (%.1f%% budget) | ERLE=%.1f dB\n",
+               s.frames, s.activeFrames, s.doubleTalkFrames, s.avgActiveFrameUs, s.maxFrameUs,
+               s.budgetPercent, s.erleDb);
+}
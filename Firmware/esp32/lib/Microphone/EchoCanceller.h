@@ -0,0 +1,83 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ======================================================
+// 🔁 Khử vọng (AEC) NLMS cho full-duplex loa + micro
+// ======================================================
+//
+// SpeakerI2S đẩy mọi block đã phát vào pushReference() (task mixer, core 1)
+// kèm thời điểm đưa vào DMA; task capture (core 0) gọi process() trên từng
+// buffer micro trước khi ghi ring. Mẫu tham chiếu được căn theo thời gian:
+// index = anchor + (captureUs - anchorUs - bulkDelayUs) * sampleRate, khoảng
+// lệch còn lại do bộ lọc TAPS hệ số (16 ms) hấp thụ.
+//
+// Double-talk (Geigel): đỉnh micro lớn hơn ratio x đỉnh tham chiếu thì ngừng
+// học để người dùng nói chen (barge-in) không làm hỏng bộ lọc. Không có tham
+// chiếu (loa im) thì bỏ qua bộ lọc, gần như không tốn CPU.
+
+struct AecStats {
+    uint32_t frames;             // frame 10 ms đã xử lý
+    uint32_t activeFrames;       // frame có tham chiếu (loa đang phát)
+    uint32_t doubleTalkFrames;
+    uint32_t lastFrameUs;
+    uint32_t maxFrameUs;
+    uint32_t avgActiveFrameUs;
+    float budgetPercent;         // avgActiveFrameUs / 10 ms
+    float erleDb;                // suy hao vọng trung bình khi chỉ có loa
+};
+
+class EchoCanceller {
+public:
+    static const uint16_t TAPS = 256;
+    static const uint16_t FRAME_MS = 10;
+    static const uint16_t REF_CAPACITY = 4096;     // ~256 ms tham chiếu
+
+    EchoCanceller(uint32_t sampleRate = 16000, float stepSize = 0.3f);
+
+    bool begin();
+    void setEnabled(bool enable);
+    // DMA loa + đường âm học + DMA micro, phần không đo được bằng timestamp
+    void setBulkDelayUs(uint32_t us);
+    // Tỉ lệ Geigel, chỉnh theo độ lớn vọng loa -> micro của thân robot (mặc định 0.6)
+    void setDoubleTalkRatio(float ratio);
+
+    // Task mixer: block vừa đưa vào DMA loa
+    void pushReference(const int16_t *pcm, size_t count, int64_t playoutUs);
+    // Task capture: khử vọng tại chỗ
+    void process(int16_t *mic, size_t count, int64_t captureUs);
+
+    bool isFarEndActive() const;  // có tham chiếu trong frame gần nhất
+    AecStats getStats() const;
+    void resetStats();
+    void printStats(Print &out = Serial) const;
+
+private:
+    void processFrame(int16_t *mic, uint16_t count, int64_t frameUs);
+    int64_t refIndexAt(int64_t us) const;
+
+    uint32_t sampleRate;
+    uint16_t frameSamples;
+    float mu;
+    bool enabled;
+    uint32_t bulkDelayUs;
+    float doubleTalkRatio;
+
+    // Tham chiếu: ring do task mixer ghi, đọc theo index tuyệt đối
+    int16_t *refBuf;
+    volatile uint32_t refWritten;
+    mutable portMUX_TYPE anchorLock;
+    uint32_t anchorIndex;
+    int64_t anchorUs;
+    bool anchorValid;
+
+    float *weights;              // TAPS
+    float *xbuf;                 // TAPS - 1 + frameSamples tham chiếu đã căn
+    uint8_t hangover;            // số frame còn giữ trạng thái double-talk
+    volatile bool farEnd;
+
+    AecStats stats;
+    uint64_t activeUsTotal;
+    double echoEnergy;
+    double residualEnergy;
+};
@@ -1,13 +1,27 @@
 #include "INMP441.h"
+#include <esp_timer.h>
+
+// INMP441 xuất 24-bit căn trái trong khung 32-bit, >> 14 giữ thêm 2 bit gain
+static const uint8_t SAMPLE_SHIFT = 14;
+static const uint8_t I2S_EVENT_QUEUE = 8;
 
 INMP441::INMP441(i2s_port_t port, int bclk, int lrcl, int dout, int rate, int bufSize)
-    : i2sPort(port), pinBCLK(bclk), pinLRCL(lrcl), pinDOUT(dout), sampleRate(rate), bufferSize(bufSize) {}
+    : i2sPort(port), pinBCLK(bclk), pinLRCL(lrcl), pinDOUT(dout), sampleRate(rate), bufferSize(bufSize),
+      captureTask(nullptr), i2sEvents(nullptr), ring(nullptr), capturing(false),
+      rawBuffer(nullptr),
+      capturedBuffers(0), dmaOverflows(0), droppedSamples(0), maxCaptureUs(0),
+      processHist(Metrics::histogram("mic.process_us")), readGapHist(Metrics::histogram("mic.read_gap_us")),
+      overflowCounter(Metrics::counter("mic.dma_overflow")) {}
 
 void INMP441::begin() {
+    // Bật hạ tần thì I2S chạy ở 48 kHz, task capture hạ về sampleRate
+    const int i2sRate = sampleRate * dsp.getDecimation();
+    dsp.begin(sampleRate);
+
     // Cấu hình I2S
     i2s_config_t i2s_config = {
         .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX), // ESP32 làm master, nhận dữ liệu
-        .sample_rate = sampleRate,
+        .sample_rate = i2sRate,
         .bits_per_sample = I2S_BITS_PER_SAMPLE_32BIT,        // INMP441 xuất dữ liệu 32-bit
         .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,         // Chỉ 1 kênh (mono)
         .communication_format = I2S_COMM_FORMAT_I2S,
@@ -26,21 +40,29 @@ void INMP441::begin() {
         .data_in_num = pinDOUT
     };
 
-    // Khởi động driver I2S
-    i2s_driver_install(i2sPort, &i2s_config, 0, NULL);
+    // Khởi động driver I2S, kèm queue sự kiện để đếm lần tràn DMA
+    i2s_driver_install(i2sPort, &i2s_config, I2S_EVENT_QUEUE, &i2sEvents);
     i2s_set_pin(i2sPort, &pin_config);
-    i2s_set_clk(i2sPort, sampleRate, I2S_BITS_PER_SAMPLE_32BIT, I2S_CHANNEL_MONO);
+    i2s_set_clk(i2sPort, i2sRate, I2S_BITS_PER_SAMPLE_32BIT, I2S_CHANNEL_MONO);
 
     Serial.println("[INMP441] Initialized successfully.");
 }
 
-void INMP441::read(int16_t *samples, size_t count) {
-    int32_t sample32;
-    size_t bytesRead;
+void INMP441::convert32to16(const int32_t *src, int16_t *dst, size_t count) {
+    AudioDsp::convert32to16(src, dst, count, SAMPLE_SHIFT);
+}
 
-    for (size_t i = 0; i < count; i++) {
-        i2s_read(i2sPort, &sample32, sizeof(sample32), &bytesRead, portMAX_DELAY);
-        samples[i] = (int16_t)(sample32 >> 14); // chuyển 32-bit → 16-bit (giảm độ lớn)
+void INMP441::read(int16_t *samples, size_t count) {
+    // Đọc theo khối thay vì 1 lần gọi driver cho mỗi mẫu
+    int32_t raw[64];
+    size_t done = 0;
+    while (done < count) {
+        size_t chunk = min(count - done, sizeof(raw) / sizeof(raw[0]));
+        size_t bytesRead = 0;
+        i2s_read(i2sPort, raw, chunk * sizeof(int32_t), &bytesRead, portMAX_DELAY);
+        size_t got = bytesRead / sizeof(int32_t);
+        convert32to16(raw, samples + done, got);
+        done += got;
     }
 }
 
@@ -48,10 +70,140 @@ int16_t INMP441::readSample() {
     int32_t sample32 = 0;
     size_t bytesRead;
     i2s_read(i2sPort, &sample32, sizeof(sample32), &bytesRead, portMAX_DELAY);
-    return (int16_t)(sample32 >> 14);
+    return (int16_t)(sample32 >> SAMPLE_SHIFT);
 }
 
 void INMP441::stop() {
+    stopCapture();
     i2s_driver_uninstall(i2sPort);
+    i2sEvents = nullptr;
     Serial.println("[INMP441] I2S stopped and resources freed.");
 }
+
+// ============================================
+// CONTINUOUS CAPTURE
+// ============================================
+
+bool INMP441::startCapture(PcmRing &target, BaseType_t core, UBaseType_t priority) {
+    if (captureTask != nullptr) {
+        return true;
+    }
+    if (rawBuffer == nullptr) {
+        rawBuffer = (int32_t *)malloc(bufferSize * sizeof(int32_t));
+        if (rawBuffer == nullptr) {
+            Serial.println("[INMP441] Capture buffer allocation failed");
+            return false;
+        }
+    }
+
+    ring = &target;
+    dsp.reset();
+    capturing = true;
+    i2s_zero_dma_buffer(i2sPort);
+    if (xTaskCreatePinnedToCore(captureLoop, "mic_capture", 4096, this, priority, &captureTask, core) != pdPASS) {
+        capturing = false;
+        captureTask = nullptr;
+        return false;
+    }
+    Serial.printf("[INMP441] Capture started on core %d (%d frames/buffer)\n", (int)core, bufferSize);
+    return true;
+}
+
+void INMP441::stopCapture() {
+    if (captureTask == nullptr) {
+        return;
+    }
+    capturing = false;
+    // Task tự xoá sau khi đọc xong buffer hiện tại (tối đa 1 chu kỳ DMA)
+    while (captureTask != nullptr) {
+        vTaskDelay(pdMS_TO_TICKS(5));
+    }
+}
+
+void INMP441::captureLoop(void *arg) {
+    INMP441 *self = static_cast<INMP441 *>(arg);
+    const size_t bytes = self->bufferSize * sizeof(int32_t);
+    int64_t lastReadUs = 0;
+
+    while (self->capturing) {
+        size_t bytesRead = 0;
+        i2s_read(self->i2sPort, self->rawBuffer, bytes, &bytesRead, portMAX_DELAY);
+        int64_t start = esp_timer_get_time();
+        if (lastReadUs != 0) {
+            self->readGapHist->record((uint32_t)(start - lastReadUs));
+        }
+        lastReadUs = start;
+        // Nửa đầu rawBuffer thành PCM 16-bit; hạ tần thì còn ~1/3 số mẫu
+        int16_t *pcm = AudioDsp::convertInPlace(self->rawBuffer, bytesRead / sizeof(int32_t), SAMPLE_SHIFT);
+        size_t count = self->dsp.pre(pcm, bytesRead / sizeof(int32_t));
+        if (self->processor) {
+            // Buffer vừa đầy: mẫu đầu tiên được thu cách đây count / sampleRate
+            self->processor(pcm, count, start - (int64_t)count * 1000000 / self->sampleRate);
+        }
+        self->dsp.post(pcm, count);
+        size_t written = self->ring->write(pcm, count);
+        self->droppedSamples += count - written;
+        if (self->onCapture) {
+            self->onCapture(pcm, count);
+        }
+        self->capturedBuffers++;
+
+        // Driver đẩy I2S_EVENT_RX_Q_OVF khi không còn buffer DMA trống
+        i2s_event_t event;
+        while (self->i2sEvents && xQueueReceive(self->i2sEvents, &event, 0) == pdTRUE) {
+            if (event.type == I2S_EVENT_RX_Q_OVF) {
+                self->dmaOverflows++;
+                self->overflowCounter->add();
+            }
+        }
+
+        uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+        self->processHist->record(elapsed);
+        if (elapsed > self->maxCaptureUs) {
+            self->maxCaptureUs = elapsed;
+        }
+    }
+
+    self->captureTask = nullptr;
+    vTaskDelete(nullptr);
+}
+
+bool INMP441::isCapturing() const {
+    return captureTask != nullptr;
+}
+
+void INMP441::setCaptureCallback(CaptureCallback callback) {
+    onCapture = callback;
+}
+
+void INMP441::setCaptureProcessor(CaptureProcessor callback) {
+    processor = callback;
+}
+
+CaptureDsp &INMP441::getDsp() {
+    return dsp;
+}
+
+int INMP441::getSampleRate() const {
+    return sampleRate;
+}
+
+int INMP441::getBufferSize() const {
+    return bufferSize;
+}
+
+uint32_t INMP441::getCapturedBuffers() const {
+    return capturedBuffers;
+}
+
+uint32_t INMP441::getDmaOverflows() const {
+    return dmaOverflows;
+}
+
+uint32_t INMP441::getDroppedSamples() const {
+    return droppedSamples;
+}
+
+uint32_t INMP441::getMaxCaptureUs() const {
+    return maxCaptureUs;
+}
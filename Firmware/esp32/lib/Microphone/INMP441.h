@@ -1,6 +1,17 @@
 #pragma once
 #include <Arduino.h>
 #include <driver/i2s.h>
+#include <functional>
+#include "PcmRing.h"
+#include "Metrics.h"
+#include "AudioDsp.h"
+
+// Gọi trong task capture sau mỗi buffer DMA đã chuyển sang 16-bit (VAD, wake-word, AEC...)
+// Phải xử lý xong trong một chu kỳ DMA (bufferSize / sampleRate, 32 ms với 512 @ 16 kHz;
+// bật hạ tần 48→16 kHz thì 10,7 ms và ~171 mẫu mỗi lần)
+using CaptureCallback = std::function<void(const int16_t *samples, size_t count)>;
+// Chạy trước khi ghi ring, được sửa mẫu tại chỗ (AEC). captureUs: thời điểm mẫu đầu tiên
+using CaptureProcessor = std::function<void(int16_t *samples, size_t count, int64_t captureUs)>;
 
 class INMP441 {
 private:
@@ -11,6 +22,26 @@ private:
     int sampleRate;
     int bufferSize;
 
+    // Task capture liên tục
+    TaskHandle_t captureTask;
+    QueueHandle_t i2sEvents;      // sự kiện driver, dùng để phát hiện tràn DMA
+    PcmRing *ring;
+    CaptureCallback onCapture;
+    CaptureProcessor processor;
+    volatile bool capturing;
+    int32_t *rawBuffer;           // 1 buffer DMA dạng 32-bit, chuyển sang 16-bit tại chỗ
+    CaptureDsp dsp;
+
+    uint32_t capturedBuffers;
+    uint32_t dmaOverflows;        // driver báo RX queue tràn (mất buffer DMA)
+    uint32_t droppedSamples;      // ring đầy, consumer đọc không kịp
+    uint32_t maxCaptureUs;        // thời gian xử lý lâu nhất 1 buffer (đã gồm callback)
+    Histogram *processHist;       // xử lý 1 buffer (µs)
+    Histogram *readGapHist;       // khoảng cách giữa 2 lần i2s_read trả về, lớn hơn chu kỳ buffer = stall
+    Counter *overflowCounter;
+
+    static void captureLoop(void *arg);
+
 public:
     INMP441(i2s_port_t port,int bclk,int lrcl,int dout,int rate,int bufSize);
 
@@ -18,5 +49,24 @@ public:
     void read(int16_t *samples, size_t count); // Đọc nhiều mẫu âm thanh (16-bit)
     int16_t readSample();                      // Đọc 1 mẫu duy nhất (16-bit)
     void stop();                               // Dừng và giải phóng I2S
-};
 
+    // ▶ Capture liên tục: 1 task đọc nguyên buffer DMA (bufferSize frame) và đẩy vào ring
+    bool startCapture(PcmRing &target, BaseType_t core = 0, UBaseType_t priority = 10);
+    void stopCapture();
+    bool isCapturing() const;
+    void setCaptureCallback(CaptureCallback callback);
+    void setCaptureProcessor(CaptureProcessor callback);
+    // Cấu hình trước begin(), chỉ áp dụng cho capture liên tục (không cho read()):
+    // hạ tần/DC/high-pass chạy trước processor, AGC sau processor
+    CaptureDsp &getDsp();
+
+    int getSampleRate() const;
+    int getBufferSize() const;
+    uint32_t getCapturedBuffers() const;
+    uint32_t getDmaOverflows() const;
+    uint32_t getDroppedSamples() const;
+    uint32_t getMaxCaptureUs() const;
+
+    // Chuyển mẫu 32-bit (24-bit căn trái) sang 16-bit (AudioDsp::convert32to16)
+    static void convert32to16(const int32_t *src, int16_t *dst, size_t count);
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ======================================================
+// 🧮 Bảng và bước giải mã IMA-ADPCM dùng chung
+// ======================================================
+//
+// Encoder uplink (AdpcmEncoder) và clip phát loa (SpeakerI2S) dùng cùng định
+// dạng: 4 byte trạng thái (i16 predictor, u8 index, u8 0) rồi mã 4 bit,
+// nibble thấp trước.
+
+static const uint8_t IMA_HEADER_BYTES = 4;
+
+static const int16_t IMA_STEPS[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int8_t IMA_INDEX_ADJUST[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+struct ImaAdpcmState {
+    int16_t predictor;
+    int8_t index;
+};
+
+inline ImaAdpcmState imaReadHeader(const uint8_t *header) {
+    ImaAdpcmState state;
+    state.predictor = (int16_t)(header[0] | (header[1] << 8));
+    state.index = (int8_t)(header[2] > 88 ? 88 : header[2]);
+    return state;
+}
+
+inline int16_t imaDecodeSample(ImaAdpcmState &state, uint8_t code) {
+    int32_t step = IMA_STEPS[state.index];
+    int32_t delta = step >> 3;
+    if (code & 4) delta += step;
+    if (code & 2) delta += step >> 1;
+    if (code & 1) delta += step >> 2;
+    int32_t next = (code & 8) ? state.predictor - delta : state.predictor + delta;
+    state.predictor = (int16_t)constrain(next, -32768, 32767);
+    state.index = (int8_t)constrain(state.index + IMA_INDEX_ADJUST[code & 7], 0, 88);
+    return state.predictor;
+}
@@ -0,0 +1,118 @@
+#include "Mfcc.h"
+
+static float hzToMel(float hz) {
+    return 2595.0f * log10f(1.0f + hz / 700.0f);
+}
+
+static float melToHz(float mel) {
+    return 700.0f * (powf(10.0f, mel / 2595.0f) - 1.0f);
+}
+
+Mfcc::Mfcc(uint32_t sampleRate)
+    : sampleRate(sampleRate), window(nullptr), cosTable(nullptr), sinTable(nullptr), dct(nullptr) {}
+
+bool Mfcc::begin() {
+    if (window != nullptr) {
+        return true;
+    }
+    window = (float *)malloc(FRAME * sizeof(float));
+    cosTable = (float *)malloc(FRAME / 2 * sizeof(float));
+    sinTable = (float *)malloc(FRAME / 2 * sizeof(float));
+    dct = (float *)malloc(NUM_CEPS * NUM_MEL * sizeof(float));
+    if (!window || !cosTable || !sinTable || !dct) {
+        return false;
+    }
+
+    for (uint16_t i = 0; i < FRAME; i++) {
+        window[i] = 0.54f - 0.46f * cosf(2.0f * PI * i / (FRAME - 1));
+    }
+    for (uint16_t i = 0; i < FRAME / 2; i++) {
+        cosTable[i] = cosf(2.0f * PI * i / FRAME);
+        sinTable[i] = -sinf(2.0f * PI * i / FRAME);
+    }
+
+    // Biên các tam giác mel (tính theo bin FFT), 20 Hz .. Nyquist
+    float melLow = hzToMel(20.0f);
+    float melHigh = hzToMel(sampleRate / 2.0f);
+    for (uint8_t i = 0; i < NUM_MEL + 2; i++) {
+        float hz = melToHz(melLow + (melHigh - melLow) * i / (NUM_MEL + 1));
+        melEdges[i] = (uint16_t)floorf((FRAME + 1) * hz / sampleRate);
+    }
+
+    for (uint8_t k = 0; k < NUM_CEPS; k++) {
+        for (uint8_t m = 0; m < NUM_MEL; m++) {
+            dct[k * NUM_MEL + m] = cosf(PI * k * (m + 0.5f) / NUM_MEL);
+        }
+    }
+    return true;
+}
+
+// FFT radix-2 in-place (decimation in time)
+void Mfcc::fft(float *xr, float *xi) {
+    for (uint16_t i = 1, j = 0; i < FRAME; i++) {
+        uint16_t bit = FRAME >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            float t = xr[i]; xr[i] = xr[j]; xr[j] = t;
+            t = xi[i]; xi[i] = xi[j]; xi[j] = t;
+        }
+    }
+    for (uint16_t len = 2; len <= FRAME; len <<= 1) {
+        uint16_t half = len >> 1;
+        uint16_t step = FRAME / len;
+        for (uint16_t i = 0; i < FRAME; i += len) {
+            for (uint16_t k = 0; k < half; k++) {
+                float wr = cosTable[k * step];
+                float wi = sinTable[k * step];
+                uint16_t a = i + k, b = a + half;
+                float tr = xr[b] * wr - xi[b] * wi;
+                float ti = xr[b] * wi + xi[b] * wr;
+                xr[b] = xr[a] - tr;
+                xi[b] = xi[a] - ti;
+                xr[a] += tr;
+                xi[a] += ti;
+            }
+        }
+    }
+}
+
+void Mfcc::compute(const int16_t *frame, float *out) {
+    float prev = frame[0];
+    for (uint16_t i = 0; i < FRAME; i++) {
+        float s = frame[i];
+        re[i] = (s - 0.97f * prev) * window[i] * (1.0f / 32768.0f);
+        im[i] = 0.0f;
+        prev = s;
+    }
+    fft(re, im);
+
+    // Dùng lại re[] làm phổ công suất (BINS phần tử)
+    for (uint16_t i = 0; i < BINS; i++) {
+        re[i] = re[i] * re[i] + im[i] * im[i];
+    }
+
+    float mel[NUM_MEL];
+    for (uint8_t m = 0; m < NUM_MEL; m++) {
+        uint16_t lo = melEdges[m], mid = melEdges[m + 1], hi = melEdges[m + 2];
+        float sum = 0.0f;
+        for (uint16_t b = lo; b < mid; b++) {
+            sum += re[b] * (b - lo) / (float)(mid - lo);
+        }
+        for (uint16_t b = mid; b < hi && b < BINS; b++) {
+            sum += re[b] * (hi - b) / (float)(hi - mid);
+        }
+        mel[m] = logf(sum + 1e-10f);
+    }
+
+    for (uint8_t k = 0; k < NUM_CEPS; k++) {
+        const float *row = dct + k * NUM_MEL;
+        float acc = 0.0f;
+        for (uint8_t m = 0; m < NUM_MEL; m++) {
+            acc += row[m] * mel[m];
+        }
+        out[k] = acc;
+    }
+}
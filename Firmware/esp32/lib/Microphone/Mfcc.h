@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ======================================================
+// 🎛️ MFCC frontend cho wake-word (float, FPU của ESP32)
+// ======================================================
+//
+// Frame 512 mẫu (32 ms @ 16 kHz), pre-emphasis, cửa sổ Hamming, FFT radix-2,
+// NUM_MEL bộ lọc tam giác thang mel, log rồi DCT-II ra NUM_CEPS hệ số.
+// Hệ số 0 là log năng lượng; so khớp chỉ dùng 1..NUM_CEPS-1.
+
+class Mfcc {
+public:
+    static const uint16_t FRAME = 512;
+    static const uint16_t BINS = FRAME / 2 + 1;
+    static const uint8_t NUM_MEL = 26;
+    static const uint8_t NUM_CEPS = 13;
+
+    explicit Mfcc(uint32_t sampleRate);
+
+    // Tính bảng window/twiddle/filterbank, gọi một lần trước compute()
+    bool begin();
+    // frame: FRAME mẫu liên tiếp; out: NUM_CEPS hệ số
+    void compute(const int16_t *frame, float *out);
+
+private:
+    void fft(float *re, float *im);
+
+    uint32_t sampleRate;
+    float *window;               // FRAME
+    float *cosTable;             // FRAME / 2
+    float *sinTable;             // FRAME / 2
+    float *dct;                  // NUM_CEPS * NUM_MEL
+    uint16_t melEdges[NUM_MEL + 2];
+    float re[FRAME];
+    float im[FRAME];
+};
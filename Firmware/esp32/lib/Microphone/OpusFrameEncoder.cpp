@@ -0,0 +1,46 @@
+#include "OpusFrameEncoder.h"
+
+#ifdef HOMEGUARD_OPUS
+
+OpusFrameEncoder::OpusFrameEncoder(uint32_t bitrate, uint8_t complexity)
+    : encoder(nullptr), bitrate(bitrate), complexity(complexity) {}
+
+OpusFrameEncoder::~OpusFrameEncoder() {
+    if (encoder != nullptr) {
+        opus_encoder_destroy(encoder);
+    }
+}
+
+bool OpusFrameEncoder::begin(uint32_t sampleRate) {
+    if (encoder != nullptr) {
+        return true;
+    }
+    int error = OPUS_OK;
+    encoder = opus_encoder_create(sampleRate, 1, OPUS_APPLICATION_VOIP, &error);
+    if (error != OPUS_OK || encoder == nullptr) {
+        Serial.printf("[Opus] Encoder create failed: %d\n", error);
+        encoder = nullptr;
+        return false;
+    }
+    opus_encoder_ctl(encoder, OPUS_SET_BITRATE(bitrate));
+    opus_encoder_ctl(encoder, OPUS_SET_COMPLEXITY(complexity));
+    opus_encoder_ctl(encoder, OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+    opus_encoder_ctl(encoder, OPUS_SET_VBR(1));
+    return true;
+}
+
+void OpusFrameEncoder::reset() {
+    if (encoder != nullptr) {
+        opus_encoder_ctl(encoder, OPUS_RESET_STATE);
+    }
+}
+
+size_t OpusFrameEncoder::encodeFrame(const int16_t *pcm, uint16_t samples, uint8_t *out, size_t capacity) {
+    if (encoder == nullptr) {
+        return 0;
+    }
+    opus_int32 bytes = opus_encode(encoder, pcm, samples, out, (opus_int32)capacity);
+    return bytes > 0 ? (size_t)bytes : 0;
+}
+
+#endif
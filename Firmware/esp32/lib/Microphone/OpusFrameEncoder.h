@@ -0,0 +1,36 @@
+#pragma once
+
+// Chỉ build khi bật -DHOMEGUARD_OPUS và có thư viện libopus (xem platformio.ini)
+#ifdef HOMEGUARD_OPUS
+
+#include "AudioEncoder.h"
+#include <opus.h>
+
+// ======================================================
+// 🎚️ Opus (SILK, VOIP) cho mạng 2.4 GHz nghẽn
+// ======================================================
+//
+// Mỗi chunk là một packet Opus, nên chunk phải dài 10/20/40/60 ms
+// (VoiceStreamer::DEFAULT_CHUNK = 20 ms). Encoder dùng ~25 KB stack khi
+// encode: loop task phải được nâng stack (SET_LOOP_TASK_STACK_SIZE trong main.cpp).
+
+class OpusFrameEncoder : public AudioEncoder {
+public:
+    OpusFrameEncoder(uint32_t bitrate = 16000, uint8_t complexity = 2);
+    ~OpusFrameEncoder() override;
+
+    AudioCodec codec() const override { return AUDIO_OPUS; }
+    bool begin(uint32_t sampleRate) override;
+    void reset() override;
+    bool fixedFrameSize() const override { return true; }
+
+protected:
+    size_t encodeFrame(const int16_t *pcm, uint16_t samples, uint8_t *out, size_t capacity) override;
+
+private:
+    OpusEncoder *encoder;
+    uint32_t bitrate;
+    uint8_t complexity;          // 0..10, >3 không kịp 20 ms trên ESP32
+};
+
+#endif
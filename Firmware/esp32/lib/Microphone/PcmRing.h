@@ -0,0 +1,104 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+// ======================================================
+// 🎙️ Ring buffer PCM 16-bit một producer / một consumer
+// ======================================================
+//
+// Task capture ghi, task khác đọc, không cần mutex: chỉ producer ghi head và
+// chỉ consumer ghi tail. Dung lượng làm tròn lên luỹ thừa của 2 để dùng mask.
+
+class PcmRing {
+public:
+    PcmRing() : buf(nullptr), mask(0), head(0), tail(0) {}
+    ~PcmRing() { free(buf); }
+
+    // Cấp phát capacity mẫu (làm tròn lên luỹ thừa của 2)
+    bool begin(size_t capacity) {
+        size_t cap = 1;
+        while (cap < capacity) {
+            cap <<= 1;
+        }
+        free(buf);
+        buf = (int16_t *)malloc(cap * sizeof(int16_t));
+        if (buf == nullptr) {
+            mask = 0;
+            return false;
+        }
+        mask = cap - 1;
+        head.store(0);
+        tail.store(0);
+        return true;
+    }
+
+    size_t capacity() const { return buf ? mask + 1 : 0; }
+
+    size_t available() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+    }
+
+    // Tổng số mẫu đã ghi / đã đọc từ begin(), dùng để đánh dấu vị trí trong luồng
+    size_t totalWritten() const { return head.load(std::memory_order_acquire); }
+    size_t totalRead() const { return tail.load(std::memory_order_acquire); }
+
+    size_t space() const {
+        return capacity() - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+    }
+
+    // Producer: ghi tối đa n mẫu, trả về số mẫu đã ghi (phần dư bị bỏ)
+    size_t write(const int16_t *src, size_t n) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t free_ = capacity() - (h - tail.load(std::memory_order_acquire));
+        if (n > free_) {
+            n = free_;
+        }
+        copyIn(h, src, n);
+        head.store(h + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer: đọc tối đa n mẫu
+    size_t read(int16_t *dst, size_t n) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t avail = head.load(std::memory_order_acquire) - t;
+        if (n > avail) {
+            n = avail;
+        }
+        copyOut(t, dst, n);
+        tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer: bỏ qua n mẫu không đọc
+    size_t skip(size_t n) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t avail = head.load(std::memory_order_acquire) - t;
+        if (n > avail) {
+            n = avail;
+        }
+        tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+
+private:
+    void copyIn(size_t pos, const int16_t *src, size_t n) {
+        size_t start = pos & mask;
+        size_t first = min(n, capacity() - start);
+        memcpy(buf + start, src, first * sizeof(int16_t));
+        memcpy(buf, src + first, (n - first) * sizeof(int16_t));
+    }
+
+    void copyOut(size_t pos, int16_t *dst, size_t n) const {
+        size_t start = pos & mask;
+        size_t first = min(n, capacity() - start);
+        memcpy(dst, buf + start, first * sizeof(int16_t));
+        memcpy(dst + first, buf, (n - first) * sizeof(int16_t));
+    }
+
+    int16_t *buf;
+    size_t mask;
+    std::atomic<size_t> head;    // tổng số mẫu đã ghi (không wrap theo capacity)
+    std::atomic<size_t> tail;    // tổng số mẫu đã đọc
+};
@@ -0,0 +1,88 @@
+#include "VoiceActivity.h"
+
+VoiceActivity::VoiceActivity(uint32_t sampleRate, const VadConfig &config)
+    : sampleRate(sampleRate) {
+    setConfig(config);
+}
+
+void VoiceActivity::setConfig(const VadConfig &cfg) {
+    config = cfg;
+    frameSamples = max<uint32_t>(1, sampleRate * config.frameMs / 1000);
+    onsetFrames = max<uint16_t>(1, config.minSpeechMs / max<uint16_t>(1, config.frameMs));
+    hangoverFrames = max<uint16_t>(1, config.hangoverMs / max<uint16_t>(1, config.frameMs));
+    reset();
+}
+
+void VoiceActivity::reset() {
+    energyAcc = 0;
+    crossings = 0;
+    filled = 0;
+    lastSample = 0;
+    noiseFloor = config.minEnergy / config.energyRatio;
+    lastEnergy = 0;
+    speechRun = 0;
+    silenceRun = 0;
+    speech = false;
+    segments = 0;
+}
+
+void VoiceActivity::process(const int16_t *samples, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        int32_t s = samples[i];
+        energyAcc += (uint32_t)(s * s);
+        if ((s ^ lastSample) < 0) {
+            crossings++;
+        }
+        lastSample = (int16_t)s;
+        if (++filled == frameSamples) {
+            evaluateFrame();
+        }
+    }
+}
+
+void VoiceActivity::evaluateFrame() {
+    uint32_t energy = (uint32_t)(energyAcc / frameSamples);
+    uint32_t zcrPercent = (uint32_t)crossings * 100 / frameSamples;
+    energyAcc = 0;
+    crossings = 0;
+    filled = 0;
+    lastEnergy = energy;
+
+    bool speechFrame = energy >= config.minEnergy
+                    && energy > (uint64_t)noiseFloor * config.energyRatio
+                    && zcrPercent <= config.maxZcrPercent;
+
+    if (speechFrame) {
+        silenceRun = 0;
+        if (!speech && ++speechRun >= onsetFrames) {
+            speech = true;
+            segments++;
+        }
+    } else {
+        speechRun = 0;
+        // Noise floor học chậm (1/16 mỗi frame) và chỉ khi không có speech
+        if (!speech) {
+            noiseFloor += ((int32_t)energy - (int32_t)noiseFloor) / 16;
+        }
+        if (speech && ++silenceRun >= hangoverFrames) {
+            speech = false;
+            silenceRun = 0;
+        }
+    }
+}
+
+bool VoiceActivity::isSpeech() const {
+    return speech;
+}
+
+uint32_t VoiceActivity::getNoiseFloor() const {
+    return noiseFloor;
+}
+
+uint32_t VoiceActivity::getLastEnergy() const {
+    return lastEnergy;
+}
+
+uint32_t VoiceActivity::getSegments() const {
+    return segments;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ======================================================
+// 🗣️ VAD năng lượng + zero-crossing, số nguyên
+// ======================================================
+//
+// process() được gọi từ task capture (INMP441::setCaptureCallback) với mọi
+// buffer DMA; isSpeech() đọc được từ task khác. Mỗi frame (mặc định 10 ms)
+// là speech nếu năng lượng vượt noise floor * energyRatio và zero-crossing
+// không quá cao (loại nhiễu hiss). Noise floor chỉ học khi đang im lặng.
+// Cần minSpeechMs speech liên tục để mở, im lặng hangoverMs để đóng.
+
+struct VadConfig {
+    uint16_t frameMs = 10;
+    uint16_t energyRatio = 4;        // speech khi energy > noise * ratio (~ +6 dB)
+    uint32_t minEnergy = 2000;       // sàn tuyệt đối (mean square), tránh mở vì nhiễu rất nhỏ
+    uint16_t maxZcrPercent = 50;     // % mẫu đổi dấu trong frame, cao hơn coi là nhiễu
+    uint16_t minSpeechMs = 60;
+    uint16_t hangoverMs = 400;
+};
+
+class VoiceActivity {
+public:
+    explicit VoiceActivity(uint32_t sampleRate, const VadConfig &config = VadConfig());
+
+    void setConfig(const VadConfig &config);
+    void reset();
+
+    // Gọi với từng khối PCM theo thứ tự, khối có thể không chia hết frame
+    void process(const int16_t *samples, size_t count);
+
+    bool isSpeech() const;
+    uint32_t getNoiseFloor() const;
+    uint32_t getLastEnergy() const;
+    uint32_t getSegments() const;     // số lần chuyển im lặng -> speech
+
+private:
+    void evaluateFrame();
+
+    uint32_t sampleRate;
+    VadConfig config;
+    uint16_t frameSamples;
+    uint16_t onsetFrames;
+    uint16_t hangoverFrames;
+
+    // Tích luỹ của frame đang dở
+    uint64_t energyAcc;
+    uint16_t crossings;
+    uint16_t filled;
+    int16_t lastSample;
+
+    uint32_t noiseFloor;
+    volatile uint32_t lastEnergy;
+    uint16_t speechRun;
+    uint16_t silenceRun;
+    volatile bool speech;
+    volatile uint32_t segments;
+};
@@ -0,0 +1,172 @@
+#include "VoiceStreamer.h"
+#include <esp_timer.h>
+
+VoiceStreamer::VoiceStreamer(PcmRing &ring, WebSocketClient &client, uint32_t sampleRate)
+    : ring(ring), client(client), sampleRate(sampleRate), chunkSamples(DEFAULT_CHUNK),
+      vad(nullptr), preRollSamples(0), maxSegmentSamples(0), segmentSamples(0),
+      wakeWindowMs(0), wakeAtMs(0), woken(false), encoderCount(0), encoder(nullptr),
+      streaming(false), firstChunk(false), streamId(0),
+      sentChunks(0), failedChunks(0), sentBytes(0), captureStartUs(0), uploadStartUs(0) {}
+
+void VoiceStreamer::setChunkSamples(uint16_t samples) {
+    const uint16_t maxSamples = sizeof(chunk) / sizeof(chunk[0]);
+    chunkSamples = samples == 0 ? 1 : (samples > maxSamples ? maxSamples : samples);
+}
+
+bool VoiceStreamer::addEncoder(AudioEncoder *enc) {
+    if (enc == nullptr || encoderCount >= MAX_ENCODERS || !enc->begin(sampleRate)) {
+        return false;
+    }
+    encoders[encoderCount++] = enc;
+    client.offerAudioCodec(enc->codec());
+    return true;
+}
+
+AudioEncoder *VoiceStreamer::getEncoder() const {
+    return encoder;
+}
+
+void VoiceStreamer::setVad(VoiceActivity *detector, uint16_t preRollMs, uint32_t maxSegmentMs) {
+    vad = detector;
+    preRollSamples = (uint32_t)preRollMs * sampleRate / 1000;
+    maxSegmentSamples = maxSegmentMs * (sampleRate / 1000);
+}
+
+void VoiceStreamer::setWakeGate(uint32_t windowMs) {
+    wakeWindowMs = windowMs;
+}
+
+void VoiceStreamer::notifyWake() {
+    wakeAtMs = millis();
+    woken = true;
+}
+
+bool VoiceStreamer::start() {
+    if (streaming) {
+        return true;
+    }
+    if (!client.isBinaryMode()) {
+        return false;
+    }
+    encoder = nullptr;
+    for (uint8_t i = 0; i < encoderCount; i++) {
+        if (encoders[i]->codec() == client.getAudioCodec()) {
+            encoder = encoders[i];
+            encoder->reset();
+            break;
+        }
+    }
+    streamId++;
+    streaming = true;
+    firstChunk = true;
+    segmentSamples = 0;
+    // Đầu câu nằm trong pre-roll còn trong ring
+    uploadStartUs = esp_timer_get_time();
+    captureStartUs = uploadStartUs - (int64_t)ring.available() * 1000000 / sampleRate;
+    client.beginTrace();
+    client.sendVoiceCommand("start", streamId, sampleRate, audioCodecName(currentCodec()));
+    return true;
+}
+
+void VoiceStreamer::stop() {
+    if (!streaming) {
+        return;
+    }
+    // Chunk cuối mang AUDIO_FLAG_END kể cả khi rỗng để server chốt phiên
+    uint16_t samples = ring.read(chunk, min(ring.available(), (size_t)chunkSamples));
+    if (samples > 0 && encoder != nullptr && encoder->fixedFrameSize()) {
+        memset(chunk + samples, 0, (chunkSamples - samples) * sizeof(int16_t));
+        samples = chunkSamples;
+    }
+    int64_t captureEndUs = esp_timer_get_time();
+    sendChunk(chunk, samples, AUDIO_FLAG_END | (firstChunk ? AUDIO_FLAG_START : 0));
+    streaming = false;
+    client.sendVoiceCommand("end", streamId, sampleRate, audioCodecName(currentCodec()),
+                            (uint32_t)((uint64_t)segmentSamples * 1000 / sampleRate));
+    client.recordSpan("voice.capture", captureStartUs, captureEndUs);
+    client.recordSpan("voice.upload", uploadStartUs, esp_timer_get_time());
+}
+
+bool VoiceStreamer::isStreaming() const {
+    return streaming;
+}
+
+void VoiceStreamer::update() {
+    if (vad != nullptr) {
+        bool speech = vad->isSpeech();
+        if (streaming && (!speech || (maxSegmentSamples && segmentSamples >= maxSegmentSamples))) {
+            stop();  // đoạn dài quá maxSegmentMs được cắt, vòng sau mở phiên mới nếu vẫn đang nói
+        } else if (!streaming && speech) {
+            if (wakeWindowMs && woken && millis() - wakeAtMs > wakeWindowMs) {
+                woken = false;
+            }
+            if (wakeWindowMs == 0 || woken) {
+                woken = false;   // mỗi lần wake chỉ mở một phiên
+                start();
+            }
+        }
+    }
+
+    if (!streaming) {
+        // Chỉ giữ pre-roll (0 nếu không dùng VAD)
+        size_t available = ring.available();
+        if (available > preRollSamples) {
+            ring.skip(available - preRollSamples);
+        }
+        return;
+    }
+    if (!client.isBinaryMode()) {
+        // Mất kết nối giữa phiên: huỷ phiên, server tự đóng khi không còn chunk
+        streaming = false;
+        return;
+    }
+
+    while (ring.available() >= chunkSamples) {
+        ring.read(chunk, chunkSamples);
+        sendChunk(chunk, chunkSamples, firstChunk ? AUDIO_FLAG_START : 0);
+    }
+}
+
+AudioCodec VoiceStreamer::currentCodec() const {
+    return encoder != nullptr ? encoder->codec() : AUDIO_PCM16;
+}
+
+bool VoiceStreamer::sendChunk(const int16_t *pcm, uint16_t samples, uint8_t flags) {
+    const uint8_t *payload = (const uint8_t *)pcm;
+    size_t bytes = samples * sizeof(int16_t);
+    if (encoder != nullptr && samples > 0) {
+        bytes = encoder->encode(pcm, samples, encoded, sizeof(encoded));
+        payload = encoded;
+        if (bytes == 0) {
+            failedChunks++;
+            segmentSamples += samples;
+            return false;
+        }
+    }
+    bool ok = client.sendAudioFrame(streamId, currentCodec(), flags, samples, payload, bytes);
+    segmentSamples += samples;
+    if (ok) {
+        sentChunks++;
+        sentBytes += bytes;
+        firstChunk = false;
+    } else {
+        failedChunks++;
+    }
+    return ok;
+}
+
+uint16_t VoiceStreamer::getStreamId() const {
+    return streamId;
+}
+
+uint32_t VoiceStreamer::getSentChunks() const {
+    return sentChunks;
+}
+
+uint32_t VoiceStreamer::getFailedChunks() const {
+    return failedChunks;
+}
+
+uint32_t VoiceStreamer::getSentBytes() const {
+    return sentBytes;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <Arduino.h>
+#include "PcmRing.h"
+#include "WebSocketClient.h"
+#include "VoiceActivity.h"
+#include "AudioEncoder.h"
+
+// ======================================================
+// 📡 Đẩy PCM từ ring capture lên server theo chunk cố định
+// ======================================================
+//
+// Gọi update() thường xuyên từ cùng task với WebSocketClient::update()
+// (thư viện WebSockets không thread-safe). Mỗi phiên mở bằng voice_command
+// "start", sau đó là các frame CHANNEL_AUDIO_UP, đóng bằng chunk có
+// AUDIO_FLAG_END và voice_command "end". Khi không stream, mẫu trong ring bị bỏ.
+//
+// Có VAD (setVad): phiên tự mở khi có tiếng nói và đóng sau hangover, mỗi
+// phiên là một đoạn nói hoàn chỉnh để server chuyển thẳng sang transcription.
+// Lúc im lặng ring giữ preRollMs gần nhất nên đầu câu không bị mất.
+//
+// Có wake gate (setWakeGate): VAD chỉ được mở phiên trong windowMs sau lần
+// notifyWake() gần nhất, để không stream mọi tiếng nói trong phòng.
+//
+// Codec: mỗi encoder đăng ký bằng addEncoder() được quảng bá trong
+// connection_init theo thứ tự thêm vào; đầu mỗi phiên chọn encoder trùng với
+// codec server đã chọn, không có thì gửi PCM16 thô.
+//
+// Mỗi phiên mở một trace mới (WebSocketClient::beginTrace) nên voice_command
+// và câu trả lời của server cùng traceId, kèm hai span: "voice.capture" từ
+// mẫu đầu tiên (tính cả pre-roll) tới lúc đóng phiên, "voice.upload" từ
+// voice_command "start" tới "end".
+
+class VoiceStreamer {
+public:
+    static const uint16_t DEFAULT_CHUNK = 320;     // 20 ms @ 16 kHz
+
+    VoiceStreamer(PcmRing &ring, WebSocketClient &client, uint32_t sampleRate);
+
+    static const uint8_t MAX_ENCODERS = AUDIO_CODEC_COUNT;
+
+    void setChunkSamples(uint16_t samples);
+    // Đăng ký codec theo thứ tự ưu tiên, gọi trước lần kết nối đầu tiên
+    bool addEncoder(AudioEncoder *encoder);
+    AudioEncoder *getEncoder() const;      // encoder của phiên hiện tại / gần nhất, nullptr = PCM16 thô
+    // Gating bằng VAD; nullptr = stream thủ công bằng start()/stop()
+    void setVad(VoiceActivity *vad, uint16_t preRollMs = 300, uint32_t maxSegmentMs = 15000);
+    // Chỉ mở phiên trong windowMs sau wake-word; 0 = tắt gating
+    void setWakeGate(uint32_t windowMs);
+    void notifyWake();            // gọi được từ task khác (task wake-word)
+    bool start();                 // mở phiên mới, false nếu chưa thoả thuận "bin1"
+    void stop();                  // gửi phần còn lại rồi đóng phiên
+    bool isStreaming() const;
+    void update();
+
+    uint16_t getStreamId() const;
+    uint32_t getSentChunks() const;
+    uint32_t getFailedChunks() const;
+    uint32_t getSentBytes() const;
+
+private:
+    AudioCodec currentCodec() const;
+    bool sendChunk(const int16_t *pcm, uint16_t samples, uint8_t flags);
+
+    PcmRing &ring;
+    WebSocketClient &client;
+    uint32_t sampleRate;
+    uint16_t chunkSamples;
+    VoiceActivity *vad;
+    uint32_t preRollSamples;
+    uint32_t maxSegmentSamples;
+    uint32_t segmentSamples;     // số mẫu đã gửi trong phiên hiện tại
+    uint32_t wakeWindowMs;
+    volatile uint32_t wakeAtMs;
+    volatile bool woken;
+    int16_t chunk[AUDIO_MAX_PAYLOAD / sizeof(int16_t)];
+    uint8_t encoded[AUDIO_MAX_PAYLOAD];
+    AudioEncoder *encoders[MAX_ENCODERS];
+    uint8_t encoderCount;
+    AudioEncoder *encoder;
+
+    bool streaming;
+    bool firstChunk;
+    uint16_t streamId;
+    uint32_t sentChunks;
+    uint32_t failedChunks;
+    uint32_t sentBytes;
+    int64_t captureStartUs;      // esp_timer của mẫu đầu tiên trong phiên
+    int64_t uploadStartUs;       // esp_timer lúc gửi chunk đầu
+};
@@ -0,0 +1,303 @@
+#include "WakeWord.h"
+#include <esp_timer.h>
+#include <LittleFS.h>
+
+static const char WAKE_MAGIC[4] = { 'H', 'G', 'W', '1' };
+
+WakeWord::WakeWord(PcmRing &ring, uint32_t sampleRate)
+    : ring(ring), sampleRate(sampleRate), mfcc(sampleRate), task(nullptr), running(false),
+      histHead(0), histCount(0), sinceDecision(0), refractory(0),
+      templates(nullptr), templateCount(0), threshold(6.0f),
+      enrollFrames(0), enrollCollected(0), benchmark(false),
+      frameUsTotal(0), decisionUsTotal(0) {
+    memset(frame, 0, sizeof(frame));
+    setBenchmark(false);
+}
+
+bool WakeWord::begin(BaseType_t core, UBaseType_t priority) {
+    if (task != nullptr) {
+        return true;
+    }
+    if (templates == nullptr) {
+        templates = (Template *)calloc(MAX_TEMPLATES, sizeof(Template));
+    }
+    if (templates == nullptr || !mfcc.begin()) {
+        Serial.println("[WakeWord] Out of memory");
+        return false;
+    }
+    running = true;
+    if (xTaskCreatePinnedToCore(taskLoop, "wakeword", 6144, this, priority, &task, core) != pdPASS) {
+        running = false;
+        task = nullptr;
+        return false;
+    }
+    Serial.printf("[WakeWord] Running on core %d, %u template(s)\n", (int)core, templateCount);
+    return true;
+}
+
+void WakeWord::stop() {
+    running = false;
+    while (task != nullptr) {
+        vTaskDelay(pdMS_TO_TICKS(5));
+    }
+}
+
+void WakeWord::setThreshold(float score) {
+    threshold = score;
+}
+
+void WakeWord::setOnWake(WakeCallback callback) {
+    onWake = callback;
+}
+
+void WakeWord::taskLoop(void *arg) {
+    WakeWord *self = static_cast<WakeWord *>(arg);
+    while (self->running) {
+        if (self->ring.available() < HOP) {
+            vTaskDelay(pdMS_TO_TICKS(HOP * 1000 / self->sampleRate / 2));
+            continue;
+        }
+        self->processFrame();
+    }
+    self->task = nullptr;
+    vTaskDelete(nullptr);
+}
+
+void WakeWord::processFrame() {
+    int64_t start = esp_timer_get_time();
+
+    memmove(frame, frame + HOP, (Mfcc::FRAME - HOP) * sizeof(int16_t));
+    ring.read(frame + Mfcc::FRAME - HOP, HOP);
+    mfcc.compute(frame, ceps);
+
+    uint8_t slot = (histHead + histCount) % WINDOW_FRAMES;
+    if (histCount == WINDOW_FRAMES) {
+        histHead = (histHead + 1) % WINDOW_FRAMES;
+    } else {
+        histCount++;
+    }
+    memcpy(history[slot], ceps + 1, sizeof(history[slot]));
+    energy[slot] = ceps[0];
+
+    int64_t mfccDone = esp_timer_get_time();
+    uint32_t frameUs = (uint32_t)(mfccDone - start);
+    uint32_t decisionUs = 0;
+    stats.frames++;
+    frameUsTotal += frameUs;
+    stats.maxFrameUs = max(stats.maxFrameUs, frameUs);
+
+    if (enrollFrames > 0) {
+        if (++enrollCollected >= enrollFrames) {
+            finishEnrollment();
+        }
+        return;
+    }
+    if (refractory > 0) {
+        refractory--;
+    }
+
+    if (templateCount > 0 && ++sinceDecision >= DECISION_STRIDE) {
+        sinceDecision = 0;
+        for (uint8_t t = 0; t < templateCount; t++) {
+            float score = match(templates[t]);
+            if (score < stats.bestScore) {
+                stats.bestScore = score;
+            }
+            if (score < threshold && refractory == 0) {
+                refractory = (uint16_t)(sampleRate / HOP);   // chặn 1 s để không kích hoạt lặp
+                stats.detections++;
+                if (onWake) {
+                    onWake(t, score);
+                }
+                break;
+            }
+        }
+        stats.decisions++;
+        decisionUs = (uint32_t)(esp_timer_get_time() - mfccDone);
+        decisionUsTotal += decisionUs;
+        stats.maxDecisionUs = max(stats.maxDecisionUs, decisionUs);
+    }
+
+    if (frameUs + decisionUs > HOP * 1000000UL / sampleRate) {
+        stats.overBudget++;
+    }
+}
+
+float WakeWord::distance(const float *a, const float *b) {
+    float sum = 0.0f;
+    for (uint8_t i = 0; i < FEATURES; i++) {
+        float d = a[i] - b[i];
+        sum += d * d;
+    }
+    return sqrtf(sum);
+}
+
+// Subsequence DTW: template có thể bắt đầu ở bất kỳ frame nào của cửa sổ,
+// nhưng phải kết thúc trong vài frame gần nhất (vừa nói xong)
+float WakeWord::match(const Template &tpl) const {
+    uint8_t m = tpl.frames;
+    uint8_t n = min<uint16_t>(histCount, m * 3 / 2);
+    if (m == 0 || n < m / 2) {
+        return INFINITY;
+    }
+
+    float prevCol[MAX_TEMPLATE_FRAMES];
+    float col[MAX_TEMPLATE_FRAMES];
+    float best = INFINITY;
+    uint8_t first = histCount - n;
+
+    for (uint8_t j = 0; j < n; j++) {
+        const float *x = history[(histHead + first + j) % WINDOW_FRAMES];
+        col[0] = distance(tpl.features[0], x);
+        for (uint8_t i = 1; i < m; i++) {
+            float up = col[i - 1];
+            float left = j > 0 ? prevCol[i] : INFINITY;
+            float diag = j > 0 ? prevCol[i - 1] : INFINITY;
+            col[i] = distance(tpl.features[i], x) + min(up, min(left, diag));
+        }
+        if (j + 3 >= n) {
+            best = min(best, col[m - 1]);
+        }
+        memcpy(prevCol, col, m * sizeof(float));
+    }
+    return best / m;
+}
+
+// ============================================
+// ENROLLMENT
+// ============================================
+
+bool WakeWord::enrollNext(uint16_t ms) {
+    if (templates == nullptr || templateCount >= MAX_TEMPLATES || enrollFrames > 0) {
+        return false;
+    }
+    uint32_t frames = (uint32_t)ms * sampleRate / 1000 / HOP;
+    enrollCollected = 0;
+    enrollFrames = (uint16_t)min<uint32_t>(max<uint32_t>(frames, 8), WINDOW_FRAMES);
+    return true;
+}
+
+bool WakeWord::isEnrolling() const {
+    return enrollFrames > 0;
+}
+
+void WakeWord::finishEnrollment() {
+    uint8_t count = min<uint16_t>(enrollFrames, histCount);
+    uint8_t first = histCount - count;
+    enrollFrames = 0;
+
+    // Cắt khoảng lặng: giữ các frame trong khoảng 3 (log) dưới năng lượng đỉnh
+    float peak = -INFINITY;
+    for (uint8_t i = 0; i < count; i++) {
+        peak = max(peak, energy[(histHead + first + i) % WINDOW_FRAMES]);
+    }
+    uint8_t lo = 0, hi = count;
+    while (lo < hi && energy[(histHead + first + lo) % WINDOW_FRAMES] < peak - 3.0f) {
+        lo++;
+    }
+    while (hi > lo && energy[(histHead + first + hi - 1) % WINDOW_FRAMES] < peak - 3.0f) {
+        hi--;
+    }
+    uint8_t frames = min<uint16_t>(hi - lo, MAX_TEMPLATE_FRAMES);
+    if (frames < 8) {
+        Serial.println("[WakeWord] Enrollment too short, try again");
+        return;
+    }
+
+    Template &tpl = templates[templateCount];
+    for (uint8_t i = 0; i < frames; i++) {
+        memcpy(tpl.features[i], history[(histHead + first + lo + i) % WINDOW_FRAMES], sizeof(tpl.features[i]));
+    }
+    tpl.frames = frames;
+    templateCount++;
+    Serial.printf("[WakeWord] Template %u enrolled (%u frames)\n", templateCount, frames);
+}
+
+uint8_t WakeWord::getTemplateCount() const {
+    return templateCount;
+}
+
+void WakeWord::clearTemplates() {
+    templateCount = 0;
+}
+
+bool WakeWord::saveTemplates(const char *path) {
+    if (!LittleFS.begin(true)) {
+        return false;
+    }
+    File f = LittleFS.open(path, "w");
+    if (!f) {
+        return false;
+    }
+    f.write((const uint8_t *)WAKE_MAGIC, sizeof(WAKE_MAGIC));
+    f.write(templateCount);
+    for (uint8_t t = 0; t < templateCount; t++) {
+        f.write(templates[t].frames);
+        f.write((const uint8_t *)templates[t].features, templates[t].frames * FEATURES * sizeof(float));
+    }
+    f.close();
+    return true;
+}
+
+bool WakeWord::loadTemplates(const char *path) {
+    if (templates == nullptr) {
+        templates = (Template *)calloc(MAX_TEMPLATES, sizeof(Template));
+    }
+    if (templates == nullptr || !LittleFS.begin(false) || !LittleFS.exists(path)) {
+        return false;
+    }
+    File f = LittleFS.open(path, "r");
+    char magic[4];
+    uint8_t count = 0;
+    if (!f || f.read((uint8_t *)magic, 4) != 4 || memcmp(magic, WAKE_MAGIC, 4) != 0
+        || f.read(&count, 1) != 1 || count > MAX_TEMPLATES) {
+        return false;
+    }
+    templateCount = 0;
+    for (uint8_t t = 0; t < count; t++) {
+        uint8_t frames = 0;
+        size_t bytes;
+        if (f.read(&frames, 1) != 1 || frames == 0 || frames > MAX_TEMPLATE_FRAMES) {
+            break;
+        }
+        bytes = frames * FEATURES * sizeof(float);
+        if (f.read((uint8_t *)templates[t].features, bytes) != bytes) {
+            break;
+        }
+        templates[t].frames = frames;
+        templateCount++;
+    }
+    f.close();
+    return templateCount == count;
+}
+
+// ============================================
+// BENCHMARK
+// ============================================
+
+void WakeWord::setBenchmark(bool enable) {
+    benchmark = enable;
+    memset(&stats, 0, sizeof(stats));
+    stats.bestScore = INFINITY;
+    frameUsTotal = 0;
+    decisionUsTotal = 0;
+}
+
+WakeBenchmark WakeWord::getBenchmark() const {
+    WakeBenchmark result = stats;
+    result.avgFrameUs = stats.frames ? (uint32_t)(frameUsTotal / stats.frames) : 0;
+    result.avgDecisionUs = stats.decisions ? (uint32_t)(decisionUsTotal / stats.decisions) : 0;
+    float hours = (float)stats.frames * HOP / sampleRate / 3600.0f;
+    result.falseAcceptsPerHour = hours > 0 ? stats.detections / hours : 0;
+    return result;
+}
+
+void WakeWord::printBenchmark(Print &out) const {
+    WakeBenchmark b = getBenchmark();
+    out.printf("[WakeWord] frames=%u mfcc avg=%uus max=%uus | dtw avg=%uus max=%uus | over_budget=%u\n",
+               b.frames, b.avgFrameUs, b.maxFrameUs, b.avgDecisionUs, b.maxDecisionUs, b.overBudget);
+    if (benchmark) {
+        out.printf("[WakeWord] detections=%u false_accept/h=%.2f best_score=%.2f threshold=%.2f\n",
+                   b.detections, b.falseAcceptsPerHour, b.bestScore, threshold);
+    }
+}
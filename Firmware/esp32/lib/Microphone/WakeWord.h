@@ -0,0 +1,104 @@
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+#include "PcmRing.h"
+#include "Mfcc.h"
+
+// ======================================================
+// 🔔 Wake-word: MFCC + DTW so khớp mẫu đã đăng ký
+// ======================================================
+//
+// Task riêng (mặc định core 0) đọc ring PCM, tính MFCC mỗi HOP mẫu (16 ms) và
+// cứ DECISION_STRIDE frame lại so cửa sổ gần nhất với từng template bằng
+// subsequence DTW. Template thu trực tiếp trên robot (enrollNext) và lưu
+// LittleFS, nên không cần model huấn luyện sẵn. Toàn bộ xử lý 1 frame phải
+// xong trong HOP để ring không tràn.
+
+using WakeCallback = std::function<void(uint8_t templateIndex, float score)>;
+
+struct WakeBenchmark {
+    uint32_t frames;
+    uint32_t decisions;
+    uint32_t detections;
+    uint32_t overBudget;         // frame xử lý lâu hơn HOP
+    uint32_t avgFrameUs;         // MFCC
+    uint32_t maxFrameUs;
+    uint32_t avgDecisionUs;      // DTW trên tất cả template
+    uint32_t maxDecisionUs;
+    float bestScore;             // điểm thấp nhất gặp được, để chỉnh ngưỡng
+    float falseAcceptsPerHour;   // detections / giờ audio (chế độ benchmark: không ai nói wake-word)
+};
+
+class WakeWord {
+public:
+    static const uint16_t HOP = Mfcc::FRAME / 2;
+    static const uint8_t FEATURES = Mfcc::NUM_CEPS - 1;    // bỏ c0 (năng lượng)
+    static const uint8_t MAX_TEMPLATES = 3;
+    static const uint8_t MAX_TEMPLATE_FRAMES = 80;         // ~1.3 s
+    static const uint8_t WINDOW_FRAMES = 120;
+    static const uint8_t DECISION_STRIDE = 4;              // so khớp mỗi 64 ms
+
+    WakeWord(PcmRing &ring, uint32_t sampleRate);
+
+    bool begin(BaseType_t core = 0, UBaseType_t priority = 5);
+    void stop();
+
+    void setThreshold(float score);
+    void setOnWake(WakeCallback callback);
+
+    // Thu template từ ms kế tiếp của audio, tự cắt khoảng lặng hai đầu
+    bool enrollNext(uint16_t ms = 1200);
+    bool isEnrolling() const;
+    uint8_t getTemplateCount() const;
+    void clearTemplates();
+    bool saveTemplates(const char *path = "/wakeword.bin");
+    bool loadTemplates(const char *path = "/wakeword.bin");
+
+    // Benchmark: đo thời gian MFCC/DTW, đếm false-accept trên audio nền
+    void setBenchmark(bool enable);
+    WakeBenchmark getBenchmark() const;
+    void printBenchmark(Print &out = Serial) const;
+
+private:
+    struct Template {
+        float features[MAX_TEMPLATE_FRAMES][FEATURES];
+        uint8_t frames;
+    };
+
+    static void taskLoop(void *arg);
+    void processFrame();
+    void finishEnrollment();
+    float match(const Template &tpl) const;
+    static float distance(const float *a, const float *b);
+
+    PcmRing &ring;
+    uint32_t sampleRate;
+    Mfcc mfcc;
+    TaskHandle_t task;
+    volatile bool running;
+
+    int16_t frame[Mfcc::FRAME];  // cửa sổ trượt, nửa sau là HOP mẫu mới
+    float ceps[Mfcc::NUM_CEPS];
+
+    // Lịch sử đặc trưng dạng ring, history[(histHead + i) % WINDOW_FRAMES]
+    float history[WINDOW_FRAMES][FEATURES];
+    float energy[WINDOW_FRAMES];
+    uint8_t histHead;
+    uint8_t histCount;
+    uint8_t sinceDecision;
+    uint16_t refractory;         // số frame chặn detect sau một lần kích hoạt
+
+    Template *templates;         // MAX_TEMPLATES, cấp phát trong begin()
+    uint8_t templateCount;
+    float threshold;
+    WakeCallback onWake;
+
+    volatile uint16_t enrollFrames;      // > 0: đang thu template
+    uint8_t enrollCollected;
+
+    bool benchmark;
+    WakeBenchmark stats;
+    uint64_t frameUsTotal;
+    uint64_t decisionUsTotal;
+};
@@ -1,7 +1,8 @@
 #include "MotionSensor.h"
 
 MotionSensor::MotionSensor(uint8_t sensorPin, unsigned long debounce, String name)
-: pin(sensorPin), motionState(false), lastTriggerTime(0), debounceTime(debounce), sensorName(name)
+: Sensor(SENSOR_MOTION), pin(sensorPin), motionState(false), lastTriggerTime(0), debounceTime(debounce), sensorName(name),
+  interruptMode(false), notify(nullptr), notifyArg(nullptr), lastTriggerUs(0), lastEdgeLatencyUs(0)
 {
 }
 
@@ -9,7 +10,60 @@ void MotionSensor::begin() {
     pinMode(pin, INPUT);
 }
 
+void IRAM_ATTR MotionSensor::handleEdge(void *arg) {
+    MotionSensor *self = static_cast<MotionSensor *>(arg);
+    self->edges.push(micros(), digitalRead(self->pin));
+    if (self->notify) {
+        self->notify(self->notifyArg);
+    }
+}
+
+void MotionSensor::enableInterrupt(EdgeNotify notifyFn, void *arg) {
+    notify = notifyFn;
+    notifyArg = arg;
+    motionState = digitalRead(pin);
+    interruptMode = true;
+    attachInterruptArg(digitalPinToInterrupt(pin), handleEdge, this, CHANGE);
+}
+
+void MotionSensor::disableInterrupt() {
+    if (interruptMode) {
+        detachInterrupt(digitalPinToInterrupt(pin));
+        interruptMode = false;
+    }
+}
+
+bool MotionSensor::isInterruptMode() const {
+    return interruptMode;
+}
+
+// Duyệt các cạnh theo thứ tự thời gian, debounce theo timestamp của ISR
+// nên xung ngắn giữa hai lần gọi vẫn được tính
+bool MotionSensor::processEdges() {
+    bool detected = false;
+    GpioEdge edge;
+    while (edges.pop(edge)) {
+        if (edge.level && !motionState) {
+            motionState = true;
+            if (lastTriggerUs == 0 || edge.us - lastTriggerUs >= debounceTime * 1000UL) {
+                uint32_t age = micros() - edge.us;
+                lastTriggerUs = edge.us;
+                lastTriggerTime = millis() - age / 1000;
+                lastEdgeLatencyUs = age;
+                detected = true;
+            }
+        } else if (!edge.level) {
+            motionState = false;
+        }
+    }
+    return detected;
+}
+
 bool MotionSensor::isMotionDetected() {
+    if (interruptMode) {
+        return processEdges();
+    }
+
     bool currentState = digitalRead(pin);
 
     // Chống rung: chỉ trả về true nếu đủ thời gian debounce
@@ -44,6 +98,19 @@ void MotionSensor::printState() {
 }
 
 
+uint32_t MotionSensor::getLastEdgeLatencyUs() const {
+    return lastEdgeLatencyUs;
+}
+
+uint32_t MotionSensor::getDroppedEdges() const {
+    return edges.dropped();
+}
+
+SampleQuality MotionSensor::read(float &value) {
+    value = motionState ? 1.0f : 0.0f;
+    return SAMPLE_GOOD;
+}
+
 String MotionSensor::getName() const {
     return sensorName;
 }
\ No newline at end of file
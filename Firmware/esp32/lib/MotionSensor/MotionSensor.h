@@ -1,8 +1,10 @@
 #pragma once
 
 #include <Arduino.h>
+#include "EdgeRing.h"
+#include "Sensor.h"
 
-class MotionSensor {
+class MotionSensor : public Sensor {
 private:
     uint8_t pin;           // Chân gắn cảm biến
     bool motionState;      // Trạng thái chuyển động hiện tại
@@ -10,6 +12,17 @@ private:
     unsigned long debounceTime;    // Thời gian chống rung (ms)
     String sensorName;     // Tên cảm biến
 
+    // Chế độ ngắt: ISR ghi cạnh vào ring, debounce làm trong task
+    EdgeRing<16> edges;
+    bool interruptMode;
+    EdgeNotify notify;
+    void *notifyArg;
+    uint32_t lastTriggerUs;        // micros() của cạnh kích hoạt gần nhất
+    uint32_t lastEdgeLatencyUs;    // từ lúc ISR ghi cạnh tới lúc task xử lý
+
+    static void IRAM_ATTR handleEdge(void *arg);
+    bool processEdges();
+
 public:
     // Constructor
     MotionSensor(uint8_t sensorPin, unsigned long debounce, String name);
@@ -17,7 +30,13 @@ public:
     // Khởi tạo cảm biến (gọi trong setup)
     void begin();
 
-    // Kiểm tra xem có chuyển động không
+    // Bật ngắt CHANGE trên chân cảm biến; notify (nếu có) được gọi ngay trong ISR
+    // để đánh thức task xử lý, ví dụ Scheduler::triggerFromISR
+    void enableInterrupt(EdgeNotify notify = nullptr, void *arg = nullptr);
+    void disableInterrupt();
+    bool isInterruptMode() const;
+
+    // Kiểm tra xem có chuyển động không (chế độ ngắt: xử lý các cạnh đã ghi)
     bool isMotionDetected();
 
     // Lấy trạng thái hiện tại
@@ -26,9 +45,17 @@ public:
     // Lấy thời gian lần cuối phát hiện chuyển động
     unsigned long getLastTriggerTime() const;
 
+    // Độ trễ ISR -> task của sự kiện gần nhất, và số cạnh bị mất do ring đầy
+    uint32_t getLastEdgeLatencyUs() const;
+    uint32_t getDroppedEdges() const;
+
     // In trạng thái cảm biến ra Serial
     void printState();
 
     String getName() const;
+    const char *name() const override { return sensorName.c_str(); }
+
+protected:
+    SampleQuality read(float &value) override;   // getState() dạng 0/1
 };
 
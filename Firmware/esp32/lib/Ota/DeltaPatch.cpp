@@ -0,0 +1,227 @@
+#include "DeltaPatch.h"
+
+static const uint8_t MAGIC[4] = { 'H', 'G', 'P', '2' };
+static const uint8_t LOW_BITS = 0x1F;
+static const uint8_t MORE_BIT = 0x20;
+
+static uint32_t readU32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+DeltaPatch::DeltaPatch()
+: header(), state(ST_END), result(PATCH_ERR_CORRUPT), op(0), value(0), shift(0), remaining(0),
+  sourcePos(0), consumed(0), written(0), outLen(0) {
+}
+
+bool DeltaPatch::parseHeader(const uint8_t *data, size_t length, Header &out) {
+    if (length < HEADER_SIZE || memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+        return false;
+    }
+    out.sourceSize = readU32(data + 4);
+    out.targetSize = readU32(data + 8);
+    memcpy(out.sourceSha, data + 12, sizeof(out.sourceSha));
+    memcpy(out.targetSha, data + 44, sizeof(out.targetSha));
+    out.version = readU32(data + 76);
+    memcpy(out.signature, data + SIGNED_SIZE, sizeof(out.signature));
+    return out.targetSize > 0;
+}
+
+void DeltaPatch::begin(const Header &h, SourceReader reader, TargetWriter writer) {
+    header = h;
+    source = reader;
+    target = writer;
+    state = ST_OP;
+    result = PATCH_OK;
+    value = 0;
+    shift = 0;
+    remaining = 0;
+    sourcePos = 0;
+    consumed = 0;
+    written = 0;
+    outLen = 0;
+}
+
+DeltaPatch::Status DeltaPatch::status() const {
+    return result;
+}
+
+uint32_t DeltaPatch::getConsumed() const {
+    return consumed;
+}
+
+uint32_t DeltaPatch::getWritten() const {
+    return written;
+}
+
+// ============================================
+// GIẢI MÃ
+// ============================================
+
+DeltaPatch::Status DeltaPatch::feed(const uint8_t *data, size_t length) {
+    if (result == PATCH_DONE && length > 0) {
+        return fail(PATCH_ERR_CORRUPT);
+    }
+    size_t i = 0;
+    while (i < length && result == PATCH_OK) {
+        switch (state) {
+            case ST_OP: {
+                uint8_t b = data[i++];
+                op = b >> 6;
+                value = b & LOW_BITS;
+                shift = 5;
+                if (b & MORE_BIT) {
+                    state = ST_VARINT;
+                } else {
+                    startOp();
+                }
+                break;
+            }
+            case ST_VARINT: {
+                uint8_t b = data[i++];
+                if (shift > 26) {
+                    fail(PATCH_ERR_CORRUPT);
+                    break;
+                }
+                value |= (uint32_t)(b & 0x7F) << shift;
+                shift += 7;
+                if ((b & 0x80) == 0) {
+                    startOp();
+                }
+                break;
+            }
+            case ST_INSERT: {
+                size_t n = min<size_t>(remaining, length - i);
+                emit(data + i, n);
+                i += n;
+                remaining -= n;
+                if (remaining == 0 && result == PATCH_OK) {
+                    opDone();
+                }
+                break;
+            }
+            case ST_ADD: {
+                // Cộng theo từng đoạn nguồn nhỏ, buffer trên stack
+                uint8_t chunk[SOURCE_CHUNK];
+                size_t n = min<size_t>(min<size_t>(remaining, length - i), SOURCE_CHUNK);
+                if (!source(sourcePos, chunk, n)) {
+                    fail(PATCH_ERR_SOURCE);
+                    break;
+                }
+                for (size_t k = 0; k < n; k++) {
+                    chunk[k] = (uint8_t)(chunk[k] + data[i + k]);
+                }
+                emit(chunk, n);
+                i += n;
+                sourcePos += n;
+                remaining -= n;
+                if (remaining == 0 && result == PATCH_OK) {
+                    opDone();
+                }
+                break;
+            }
+            case ST_END:
+                fail(PATCH_ERR_CORRUPT);            // dữ liệu thừa sau op cuối
+                break;
+        }
+    }
+    consumed += i;
+    if (result == PATCH_OK && state == ST_END) {
+        result = flushOut() == PATCH_OK ? PATCH_DONE : result;
+    }
+    return result;
+}
+
+// Đủ targetSize thì không nhận op nào nữa
+void DeltaPatch::opDone() {
+    state = written == header.targetSize ? ST_END : ST_OP;
+}
+
+DeltaPatch::Status DeltaPatch::startOp() {
+    state = ST_OP;
+    switch (op) {
+        case OP_COPY:
+            copySource(value);
+            if (result == PATCH_OK) {
+                opDone();
+            }
+            return result;
+        case OP_SEEK: {
+            // zigzag: 0, -1, 1, -2, ... để lùi được con trỏ nguồn
+            int32_t delta = (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+            int64_t pos = (int64_t)sourcePos + delta;
+            if (pos < 0 || pos > header.sourceSize) {
+                return fail(PATCH_ERR_SOURCE);
+            }
+            sourcePos = (uint32_t)pos;
+            return PATCH_OK;
+        }
+        case OP_ADD:
+            if ((uint64_t)sourcePos + value > header.sourceSize) {
+                return fail(PATCH_ERR_SOURCE);
+            }
+            // fallthrough
+        case OP_INSERT:
+            if ((uint64_t)written + value > header.targetSize) {
+                return fail(PATCH_ERR_OVERFLOW);
+            }
+            remaining = value;
+            if (remaining > 0) {
+                state = op == OP_ADD ? ST_ADD : ST_INSERT;
+            }
+            return PATCH_OK;
+    }
+    return fail(PATCH_ERR_CORRUPT);
+}
+
+DeltaPatch::Status DeltaPatch::copySource(uint32_t n) {
+    if ((uint64_t)sourcePos + n > header.sourceSize) {
+        return fail(PATCH_ERR_SOURCE);
+    }
+    if ((uint64_t)written + n > header.targetSize) {
+        return fail(PATCH_ERR_OVERFLOW);
+    }
+    // Đọc thẳng vào buffer đích, không qua bản sao trung gian
+    while (n > 0) {
+        if (outLen == OUT_SIZE && flushOut() != PATCH_OK) {
+            return result;
+        }
+        uint16_t take = (uint16_t)min<uint32_t>(n, OUT_SIZE - outLen);
+        if (!source(sourcePos, out + outLen, take)) {
+            return fail(PATCH_ERR_SOURCE);
+        }
+        outLen += take;
+        written += take;
+        sourcePos += take;
+        n -= take;
+    }
+    return PATCH_OK;
+}
+
+DeltaPatch::Status DeltaPatch::emit(const uint8_t *data, size_t length) {
+    while (length > 0) {
+        if (outLen == OUT_SIZE && flushOut() != PATCH_OK) {
+            return result;
+        }
+        size_t take = min<size_t>(length, OUT_SIZE - outLen);
+        memcpy(out + outLen, data, take);
+        outLen += take;
+        written += take;
+        data += take;
+        length -= take;
+    }
+    return PATCH_OK;
+}
+
+DeltaPatch::Status DeltaPatch::flushOut() {
+    if (outLen > 0 && !target(out, outLen)) {
+        return fail(PATCH_ERR_WRITE);
+    }
+    outLen = 0;
+    return PATCH_OK;
+}
+
+DeltaPatch::Status DeltaPatch::fail(Status error) {
+    state = ST_END;
+    result = error;
+    return error;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+
+// ======================================================
+// 🩹 HGP2 - patch nhị phân có chữ ký giữa hai ảnh firmware
+// ======================================================
+//
+// Sinh offline bằng tools/mkdelta.py kiểu bsdiff: vùng khớp gần đúng giữa ảnh
+// cũ và mới được lưu dưới dạng hiệu từng byte (phần lớn là 0 vì chỉ địa chỉ bị
+// dịch), vùng không khớp lưu nguyên. Mọi số nguyên là little-endian.
+//
+//   "HGP2" | u32 sourceSize | u32 targetSize | u8 sourceSha[32] | u8 targetSha[32]
+//   u32 version | u8 signature[64]
+//   op...  cho tới khi đủ targetSize byte đích
+//
+// signature: ECDSA P-256 (r || s, big-endian) trên SHA-256 của SIGNED_SIZE byte
+// đầu header, tức mọi trường trước nó. targetSha nằm trong phần được ký nên ảnh
+// đích ghi ra flash bị ràng buộc với khoá của người phát hành. DeltaPatch chỉ
+// tách trường; OtaUpdater kiểm chữ ký.
+//
+// Mỗi op bắt đầu bằng một byte: 2 bit cao là loại, bit 5 = còn varint, 5 bit
+// thấp là phần thấp của n (varint LEB128 theo sau chứa n >> 5):
+//   COPY   n: chép n byte nguồn tại con trỏ nguồn, con trỏ += n
+//   ADD    n, n byte d: đích = nguồn + d (mod 256), con trỏ += n
+//   INSERT n, n byte: chép thẳng ra đích, con trỏ nguồn giữ nguyên
+//   SEEK   n: con trỏ nguồn += zigzag(n)
+//
+// Áp patch kiểu stream: feed() nhận các đoạn cắt ở vị trí bất kỳ, nguồn đọc
+// ngẫu nhiên qua SourceReader (phân vùng đang chạy), đích ghi tuần tự qua
+// TargetWriter (phân vùng OTA còn lại) theo từng khối OUT_SIZE byte.
+
+class DeltaPatch {
+public:
+    static const uint8_t SIGNED_SIZE = 80;
+    static const uint8_t HEADER_SIZE = SIGNED_SIZE + 64;
+    static const uint16_t OUT_SIZE = 1024;
+    static const uint8_t SOURCE_CHUNK = 128;
+
+    enum Op : uint8_t { OP_COPY = 0, OP_ADD = 1, OP_INSERT = 2, OP_SEEK = 3 };
+
+    enum Status : uint8_t {
+        PATCH_OK = 0,          // cần thêm dữ liệu
+        PATCH_DONE,            // đủ targetSize, đã ghi hết ra writer
+        PATCH_ERR_CORRUPT,     // op hỏng / thừa dữ liệu sau khi xong
+        PATCH_ERR_SOURCE,      // đọc ra ngoài ảnh nguồn hoặc SourceReader lỗi
+        PATCH_ERR_OVERFLOW,    // op ghi quá targetSize
+        PATCH_ERR_WRITE        // TargetWriter lỗi
+    };
+
+    struct Header {
+        uint32_t sourceSize;
+        uint32_t targetSize;
+        uint8_t sourceSha[32];
+        uint8_t targetSha[32];
+        uint32_t version;              // build của ảnh đích, phải lớn hơn build đang chạy
+        uint8_t signature[64];
+    };
+
+    using SourceReader = std::function<bool(uint32_t offset, uint8_t *dst, size_t length)>;
+    using TargetWriter = std::function<bool(const uint8_t *data, size_t length)>;
+
+    DeltaPatch();
+
+    static bool parseHeader(const uint8_t *data, size_t length, Header &header);
+
+    void begin(const Header &header, SourceReader source, TargetWriter target);
+    // Phần op sau header; trả về trạng thái sau khi xử lý hết đoạn này
+    Status feed(const uint8_t *data, size_t length);
+    Status status() const;
+
+    uint32_t getConsumed() const;      // byte op đã nhận
+    uint32_t getWritten() const;       // byte đích đã tạo (kể cả phần còn trong buffer)
+
+private:
+    enum State : uint8_t { ST_OP, ST_VARINT, ST_ADD, ST_INSERT, ST_END };
+
+    Status startOp();
+    void opDone();
+    Status copySource(uint32_t n);
+    Status emit(const uint8_t *data, size_t length);
+    Status flushOut();
+    Status fail(Status error);
+
+    Header header;
+    SourceReader source;
+    TargetWriter target;
+    State state;
+    Status result;
+
+    uint8_t op;
+    uint32_t value;                    // n đang giải mã
+    uint8_t shift;
+    uint32_t remaining;                // byte còn lại của ADD/INSERT
+    uint32_t sourcePos;
+    uint32_t consumed;
+    uint32_t written;
+
+    uint8_t out[OUT_SIZE];
+    uint16_t outLen;
+};
@@ -0,0 +1,312 @@
+#include "OtaUpdater.h"
+#include <mbedtls/ecdsa.h>
+
+static const size_t HASH_CHUNK = 1024;
+
+#ifdef HOMEGUARD_OTA_PUBKEY
+static bool parseHex(const char *hex, uint8_t *out, size_t length) {
+    if (strlen(hex) != length * 2) {
+        return false;
+    }
+    for (size_t i = 0; i < length * 2; i++) {
+        char c = hex[i];
+        uint8_t v = c >= '0' && c <= '9' ? c - '0' : (c | 0x20) >= 'a' && (c | 0x20) <= 'f' ? (c | 0x20) - 'a' + 10 : 0xFF;
+        if (v == 0xFF) {
+            return false;
+        }
+        out[i / 2] = (uint8_t)((i & 1) ? out[i / 2] | v : v << 4);
+    }
+    return true;
+}
+
+// ECDSA P-256: digest = SHA-256(signed), signature = r || s
+static bool verifySignature(const uint8_t *signedBytes, size_t length, const uint8_t signature[64]) {
+    uint8_t key[65];
+    if (!parseHex(HOMEGUARD_OTA_PUBKEY, key, sizeof(key))) {
+        Serial.println("[OTA] HOMEGUARD_OTA_PUBKEY is not a 65-byte hex point");
+        return false;
+    }
+    uint8_t digest[32];
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+    mbedtls_sha256_update(&ctx, signedBytes, length);
+    mbedtls_sha256_finish(&ctx, digest);
+    mbedtls_sha256_free(&ctx);
+
+    mbedtls_ecp_group group;
+    mbedtls_ecp_point q;
+    mbedtls_mpi r, s;
+    mbedtls_ecp_group_init(&group);
+    mbedtls_ecp_point_init(&q);
+    mbedtls_mpi_init(&r);
+    mbedtls_mpi_init(&s);
+    bool ok = mbedtls_ecp_group_load(&group, MBEDTLS_ECP_DP_SECP256R1) == 0 &&
+              mbedtls_ecp_point_read_binary(&group, &q, key, sizeof(key)) == 0 &&
+              mbedtls_ecp_check_pubkey(&group, &q) == 0 &&
+              mbedtls_mpi_read_binary(&r, signature, 32) == 0 &&
+              mbedtls_mpi_read_binary(&s, signature + 32, 32) == 0 &&
+              mbedtls_ecdsa_verify(&group, digest, sizeof(digest), &q, &r, &s) == 0;
+    mbedtls_mpi_free(&s);
+    mbedtls_mpi_free(&r);
+    mbedtls_ecp_point_free(&q);
+    mbedtls_ecp_group_free(&group);
+    return ok;
+}
+#endif
+
+OtaUpdater::OtaUpdater(WebSocketClient &ws)
+: ws(ws), header(), signedHeader{}, running(nullptr), target(nullptr), handle(0), active(false), pendingVerify(false),
+  received(0), lastFrameMs(0), rebootAtMs(0), connectedSinceMs(0), sessions(0), failures(0), resyncs(0),
+  lastStatus(OTA_OK), chunkHist(Metrics::histogram("ota.chunk_us")) {
+}
+
+void OtaUpdater::begin() {
+    running = esp_ota_get_running_partition();
+    esp_ota_img_states_t state;
+    if (running != nullptr && esp_ota_get_state_partition(running, &state) == ESP_OK &&
+        state == ESP_OTA_IMG_PENDING_VERIFY) {
+        pendingVerify = true;
+        Serial.printf("[OTA] Running new image from %s, waiting for server before confirming\n", running->label);
+    }
+}
+
+bool OtaUpdater::isActive() const {
+    return active || rebootAtMs != 0;
+}
+
+bool OtaUpdater::isPendingVerify() const {
+    return pendingVerify;
+}
+
+uint32_t OtaUpdater::getReceived() const {
+    return received;
+}
+
+void OtaUpdater::printStats(Print &out) const {
+    out.printf("[OTA] sessions=%u failures=%u resyncs=%u last=%u | active=%d received=%u written=%u pending_verify=%d\n",
+               sessions, failures, resyncs, lastStatus, active, received, patch.getWritten(), pendingVerify);
+}
+
+// ============================================
+// PHIÊN CẬP NHẬT
+// ============================================
+
+void OtaUpdater::handleFrame(const OtaHeader &h, const uint8_t *payload, size_t bytes) {
+    lastFrameMs = millis();
+    switch (h.op) {
+        case OTA_BEGIN: {
+            if (active || rebootAtMs != 0) {
+                reply(OTA_RESULT, OTA_ERR_BUSY);
+                return;
+            }
+            OtaStatus status = start(payload, bytes);
+            reply(status == OTA_OK ? OTA_ACK : OTA_RESULT, status);
+            return;
+        }
+        case OTA_DATA: {
+            if (!active) {
+                return;
+            }
+            if (h.offset != received) {
+                resyncs++;
+                reply(OTA_ACK, OTA_ERR_RESYNC);
+                return;
+            }
+            DeltaPatch::Status status;
+            {
+                CycleTimer t(chunkHist);
+                status = patch.feed(payload, bytes);
+            }
+            received += bytes;
+            if (status != DeltaPatch::PATCH_OK && status != DeltaPatch::PATCH_DONE) {
+                Serial.printf("[OTA] Patch failed at %u: %u\n", received, status);
+                abort();
+                reply(OTA_RESULT, status == DeltaPatch::PATCH_ERR_WRITE ? OTA_ERR_WRITE : OTA_ERR_PATCH);
+                return;
+            }
+            reply(OTA_ACK, OTA_OK);
+            return;
+        }
+        case OTA_END:
+            if (active) {
+                OtaStatus status = finish();
+                reply(OTA_RESULT, status);
+            }
+            return;
+        case OTA_ABORT:
+            if (active) {
+                Serial.println("[OTA] Aborted by server");
+                abort();
+            }
+            return;
+    }
+}
+
+OtaStatus OtaUpdater::start(const uint8_t *payload, size_t bytes) {
+    sessions++;
+    if (!DeltaPatch::parseHeader(payload, bytes, header)) {
+        return OTA_ERR_HEADER;
+    }
+    // Xác thực trước mọi thao tác flash (kể cả băm phân vùng nguồn)
+    memcpy(signedHeader, payload, sizeof(signedHeader));
+    OtaStatus auth = authenticate();
+    if (auth != OTA_OK) {
+        Serial.println("[OTA] Rejected unauthenticated patch");
+        return auth;
+    }
+    if (header.version <= HOMEGUARD_FW_VERSION) {
+        Serial.printf("[OTA] Rejected version %u (running %u)\n", header.version, (unsigned)HOMEGUARD_FW_VERSION);
+        return OTA_ERR_VERSION;
+    }
+    running = esp_ota_get_running_partition();
+    target = esp_ota_get_next_update_partition(nullptr);
+    if (running == nullptr || target == nullptr || header.targetSize > target->size) {
+        return OTA_ERR_NO_PARTITION;
+    }
+    // Patch chỉ đúng với đúng ảnh nó được tạo ra từ: so từng byte qua SHA-256
+    uint8_t digest[32];
+    if (header.sourceSize > running->size || !hashSource(header.sourceSize, digest) ||
+        memcmp(digest, header.sourceSha, sizeof(digest)) != 0) {
+        return OTA_ERR_SOURCE;
+    }
+#ifdef OTA_WITH_SEQUENTIAL_WRITES
+    // Xoá từng sector khi tới lượt ghi thay vì xoá cả vùng ngay (block loop vài giây)
+    esp_err_t err = esp_ota_begin(target, OTA_WITH_SEQUENTIAL_WRITES, &handle);
+#else
+    esp_err_t err = esp_ota_begin(target, header.targetSize, &handle);
+#endif
+    if (err != ESP_OK) {
+        Serial.printf("[OTA] esp_ota_begin failed: %s\n", esp_err_to_name(err));
+        return OTA_ERR_WRITE;
+    }
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts(&sha, 0);
+    patch.begin(header,
+                [this](uint32_t offset, uint8_t *dst, size_t length) { return readSource(offset, dst, length); },
+                [this](const uint8_t *data, size_t length) { return writeTarget(data, length); });
+    active = true;
+    received = DeltaPatch::HEADER_SIZE;
+    Serial.printf("[OTA] Patching %s -> %s: %u -> %u bytes\n", running->label, target->label,
+                  header.sourceSize, header.targetSize);
+    return OTA_OK;
+}
+
+OtaStatus OtaUpdater::authenticate() const {
+#ifdef HOMEGUARD_OTA_PUBKEY
+    return verifySignature(signedHeader, sizeof(signedHeader), header.signature) ? OTA_OK : OTA_ERR_AUTH;
+#else
+    // Không có khoá: chỉ tin server đã xác thực bằng CA (wss://), ws:// thì ai chèn được frame cũng flash được
+    return ws.isSecure() ? OTA_OK : OTA_ERR_AUTH;
+#endif
+}
+
+OtaStatus OtaUpdater::finish() {
+    if (patch.status() != DeltaPatch::PATCH_DONE) {
+        abort();
+        return OTA_ERR_PATCH;
+    }
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&sha, digest);
+    mbedtls_sha256_free(&sha);
+    active = false;
+    if (memcmp(digest, header.targetSha, sizeof(digest)) != 0) {
+        esp_ota_abort(handle);
+        return OTA_ERR_VERIFY;
+    }
+    // esp_ota_end tự kiểm tra header và checksum của ảnh
+    if (esp_ota_end(handle) != ESP_OK) {
+        return OTA_ERR_VERIFY;
+    }
+    // Kiểm lại chữ ký ngay trước khi đổi phân vùng boot: targetSha vừa so nằm trong phần được ký
+    if (authenticate() != OTA_OK || memcmp(signedHeader + 44, header.targetSha, sizeof(header.targetSha)) != 0) {
+        Serial.println("[OTA] Signature check failed before boot switch");
+        return OTA_ERR_AUTH;
+    }
+    if (esp_ota_set_boot_partition(target) != ESP_OK) {
+        return OTA_ERR_VERIFY;
+    }
+    Serial.printf("[OTA] %s ready (%u patch bytes), rebooting\n", target->label, received);
+    rebootAtMs = millis() + REBOOT_DELAY_MS;
+    return OTA_OK;
+}
+
+void OtaUpdater::abort() {
+    if (!active) {
+        return;
+    }
+    esp_ota_abort(handle);
+    mbedtls_sha256_free(&sha);
+    active = false;
+}
+
+void OtaUpdater::reply(OtaOp op, OtaStatus status) {
+    if (op == OTA_RESULT) {
+        failures += status != OTA_OK && status != OTA_ERR_BUSY;
+        lastStatus = status;
+    }
+    ws.sendOtaFrame(op, status, received);
+}
+
+// ============================================
+// FLASH
+// ============================================
+
+bool OtaUpdater::hashSource(uint32_t size, uint8_t digest[32]) {
+    uint8_t buffer[HASH_CHUNK];
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+    bool ok = true;
+    for (uint32_t offset = 0; offset < size && ok; offset += HASH_CHUNK) {
+        size_t n = min<uint32_t>(HASH_CHUNK, size - offset);
+        ok = esp_partition_read(running, offset, buffer, n) == ESP_OK;
+        mbedtls_sha256_update(&ctx, buffer, n);
+    }
+    mbedtls_sha256_finish(&ctx, digest);
+    mbedtls_sha256_free(&ctx);
+    return ok;
+}
+
+bool OtaUpdater::readSource(uint32_t offset, uint8_t *dst, size_t length) {
+    return esp_partition_read(running, offset, dst, length) == ESP_OK;
+}
+
+bool OtaUpdater::writeTarget(const uint8_t *data, size_t length) {
+    mbedtls_sha256_update(&sha, data, length);
+    return esp_ota_write(handle, data, length) == ESP_OK;
+}
+
+// ============================================
+// XÁC NHẬN / ROLLBACK
+// ============================================
+
+void OtaUpdater::update() {
+    uint32_t now = millis();
+    if (rebootAtMs != 0 && (int32_t)(now - rebootAtMs) >= 0) {
+        ESP.restart();
+    }
+    if (active && now - lastFrameMs >= SESSION_TIMEOUT_MS) {
+        Serial.println("[OTA] Session timed out");
+        abort();
+        failures++;
+    }
+    if (!pendingVerify) {
+        return;
+    }
+    if (!ws.isConnectedToServer()) {
+        connectedSinceMs = 0;
+        if (now >= ROLLBACK_MS) {
+            Serial.println("[OTA] New image never reached the server, rolling back");
+            esp_ota_mark_app_invalid_rollback_and_reboot();
+        }
+        return;
+    }
+    if (connectedSinceMs == 0) {
+        connectedSinceMs = now;
+    } else if (now - connectedSinceMs >= CONFIRM_MS) {
+        esp_ota_mark_app_valid_cancel_rollback();
+        pendingVerify = false;
+        Serial.println("[OTA] New image confirmed");
+    }
+}
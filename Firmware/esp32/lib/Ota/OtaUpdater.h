@@ -0,0 +1,93 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_ota_ops.h>
+#include <mbedtls/sha256.h>
+#include "DeltaPatch.h"
+#include "WebSocketClient.h"
+#include "Metrics.h"
+
+#ifndef HOMEGUARD_FW_VERSION
+#define HOMEGUARD_FW_VERSION 0
+#endif
+
+// ======================================================
+// 📡 Cập nhật firmware bằng patch HGP1 qua WebSocket đang mở
+// ======================================================
+//
+// Server đẩy patch (tools/mkdelta.py) theo CHANNEL_OTA của BinaryFrame.h:
+//   BEGIN (header HGP1) -> DATA... -> END, robot ACK sau mỗi frame với số byte
+//   patch đã nhận. Frame lệch offset (mất / lặp sau khi reconnect) được trả
+//   OTA_ERR_RESYNC kèm offset đúng để server gửi lại từ đó, nên phiên sống qua
+//   được một lần rớt kết nối ngắn.
+//
+// Patch phải có chữ ký ECDSA P-256 (DeltaPatch.h) theo khoá công khai biên dịch
+// vào firmware: -DHOMEGUARD_OTA_PUBKEY="04..." (65 byte dạng hex, in bằng
+// tools/mkdelta.py --key priv.pem --print-pubkey). Chữ ký được kiểm trước
+// esp_ota_begin và lại lần nữa trước esp_ota_set_boot_partition; version phải
+// lớn hơn HOMEGUARD_FW_VERSION của build đang chạy. Build không có khoá chỉ nhận
+// OTA qua wss:// (WebSocketClient::setSecure), ws:// thì từ chối mọi phiên.
+//
+// Patch được áp ngay khi tới: nguồn là phân vùng đang chạy (đọc ngẫu nhiên),
+// đích ghi tuần tự vào phân vùng OTA còn lại, SHA-256 ảnh đích tính đồng thời.
+// Không cần RAM hay LittleFS chứa cả patch.
+//
+// Ảnh mới boot lên ở trạng thái ESP_OTA_IMG_PENDING_VERIFY (main.cpp giữ trạng
+// thái này qua verifyRollbackLater()). update() chỉ xác nhận sau khi giữ được
+// kết nối server CONFIRM_MS; không lên được server trong ROLLBACK_MS thì đánh
+// dấu ảnh hỏng và reboot về ảnh cũ. Cần bootloader bật
+// CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE, không thì ảnh mới được coi là hợp lệ ngay.
+
+class OtaUpdater {
+public:
+    static const uint32_t CONFIRM_MS = 30000;
+    static const uint32_t ROLLBACK_MS = 5UL * 60 * 1000;
+    static const uint32_t SESSION_TIMEOUT_MS = 60000;     // không có frame nào -> huỷ phiên
+    static const uint16_t REBOOT_DELAY_MS = 1000;         // cho RESULT kịp ra khỏi socket
+
+    explicit OtaUpdater(WebSocketClient &ws);
+
+    // Kiểm tra ảnh đang chạy có đang chờ xác nhận không (gọi sau khi boot)
+    void begin();
+    // Frame CHANNEL_OTA từ WebSocketClient (loop task)
+    void handleFrame(const OtaHeader &header, const uint8_t *payload, size_t bytes);
+    // Hẹn giờ reboot, xác nhận / rollback ảnh mới, timeout phiên
+    void update();
+
+    bool isActive() const;                 // đang nhận patch hoặc chờ reboot
+    bool isPendingVerify() const;
+    uint32_t getReceived() const;          // byte patch của phiên hiện tại
+    void printStats(Print &out = Serial) const;
+
+private:
+    OtaStatus start(const uint8_t *payload, size_t bytes);
+    OtaStatus authenticate() const;        // chữ ký trên signedHeader, hoặc kênh wss:// nếu không có khoá
+    OtaStatus finish();
+    void abort();
+    bool hashSource(uint32_t size, uint8_t digest[32]);
+    bool readSource(uint32_t offset, uint8_t *dst, size_t length);
+    bool writeTarget(const uint8_t *data, size_t length);
+    void reply(OtaOp op, OtaStatus status);
+
+    WebSocketClient &ws;
+    DeltaPatch patch;
+    DeltaPatch::Header header;
+    uint8_t signedHeader[DeltaPatch::SIGNED_SIZE];   // bản sao phần được ký, kiểm lại lúc finish()
+    const esp_partition_t *running;
+    const esp_partition_t *target;
+    esp_ota_handle_t handle;
+    mbedtls_sha256_context sha;
+
+    bool active;
+    bool pendingVerify;
+    uint32_t received;
+    uint32_t lastFrameMs;
+    uint32_t rebootAtMs;                   // 0 = không hẹn
+    uint32_t connectedSinceMs;             // 0 = chưa lên server từ lúc boot / mất kết nối
+
+    uint32_t sessions;
+    uint32_t failures;
+    uint32_t resyncs;
+    OtaStatus lastStatus;
+    Histogram *chunkHist;                  // áp + ghi flash một frame DATA (µs)
+};
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <Arduino.h>
+#include "SensorKind.h"
+
+// ======================================================
+// 📦 Khung nhị phân gửi bằng sendBIN (encoding "bin1")
+// ======================================================
+//
+// Dùng sau khi server chọn "bin1" trong ack của connection_init. Mọi trường
+// little-endian, không padding:
+//
+//   FrameHeader (8 byte)
+//     u8  version      BINARY_VERSION
+//     u8  channel      BinaryChannel
+//     u16 seq          tăng dần mỗi frame
+//     u32 timestamp    millis() lúc đóng frame
+//   CHANNEL_SENSOR_DATA / CHANNEL_SENSOR_ALERT:
+//     u8  count
+//     SensorRecord[count] (8 byte mỗi bản ghi)
+//       u8  sensor     SensorKind, đơn vị suy ra từ loại cảm biến
+//       u8  level      AlertLevel
+//       u16 ageMs      mẫu được lấy trước timestamp của header bao nhiêu ms
+//       f32 value
+//   CHANNEL_AUDIO_UP / CHANNEL_AUDIO_DOWN:
+//     AudioHeader (6 byte)
+//       u16 streamId   id phiên, trùng với voice_command start/end
+//       u8  codec      AudioCodec
+//       u8  flags      AUDIO_FLAG_*
+//       u16 samples    số mẫu PCM mà payload giải ra
+//     payload (tối đa AUDIO_MAX_PAYLOAD byte)
+//   CHANNEL_VIDEO (firmware esp32-cam, không giới hạn BINARY_MAX_FRAME):
+//     VideoHeader (8 byte)
+//       u16 width, u16 height
+//       u8  format     VIDEO_FORMAT_*
+//       u8  quality    chất lượng JPEG của sensor (thấp = đẹp hơn)
+//       u16 ageMs      từ lúc chụp xong tới lúc gửi
+//     ảnh JPEG nguyên vẹn từ camera_fb_t
+//   CHANNEL_OTA (cập nhật firmware, xem lib/Ota/OtaUpdater.h):
+//     OtaHeader (8 byte)
+//       u8  op         OtaOp
+//       u8  status     OtaStatus (chỉ có nghĩa ở ACK/RESULT)
+//       u16 reserved   0
+//       u32 offset     BEGIN/DATA: vị trí của payload trong file patch;
+//                      ACK: số byte patch robot đã nhận, server gửi tiếp từ đây
+//     payload: BEGIN = header HGP1 (76 byte), DATA = đoạn patch kế tiếp
+//   CHANNEL_JSON (sau khi thoả thuận "compression": "dict1", xem JsonPack.h):
+//     message JSON đã nén bằng từ điển, tối đa JSON_PACK_MAX byte
+//
+// Bên giải mã: homeguard-platform/apps/api/src/websocket/binary-frame.ts
+
+static const char BINARY_ENCODING[] = "bin1";
+static const uint8_t BINARY_VERSION = 1;
+static const uint16_t BINARY_MAX_FRAME = 256;
+
+enum BinaryChannel : uint8_t {
+  CHANNEL_SENSOR_DATA = 1,
+  CHANNEL_SENSOR_ALERT = 2,
+  CHANNEL_AUDIO_UP = 3,     // micro -> server
+  CHANNEL_AUDIO_DOWN = 4,   // server -> loa
+  CHANNEL_VIDEO = 5,        // camera -> server
+  CHANNEL_OTA = 6,          // patch firmware (hai chiều)
+  CHANNEL_JSON = 7          // message JSON nén "dict1" (robot -> server)
+};
+
+enum AudioCodec : uint8_t {
+  AUDIO_PCM16 = 0,          // PCM 16-bit little-endian, mono
+  AUDIO_IMA_ADPCM = 1,      // 4 byte trạng thái (i16 predictor, u8 index, u8 0) + 4 bit/mẫu
+  AUDIO_OPUS = 2,           // 1 packet Opus mỗi chunk (chunk phải là 10/20/40/60 ms)
+  AUDIO_CODEC_COUNT
+};
+
+// Tên codec dùng trong connection_init ("audioCodecs") và voice_command
+static const char* const AUDIO_CODEC_NAMES[AUDIO_CODEC_COUNT] = { "pcm16", "adpcm", "opus" };
+
+inline const char* audioCodecName(uint8_t codec) {
+  return codec < AUDIO_CODEC_COUNT ? AUDIO_CODEC_NAMES[codec] : "pcm16";
+}
+
+inline AudioCodec audioCodecFromName(const char* name) {
+  for (uint8_t i = 0; name != nullptr && i < AUDIO_CODEC_COUNT; i++) {
+    if (strcmp(name, AUDIO_CODEC_NAMES[i]) == 0) {
+      return (AudioCodec)i;
+    }
+  }
+  return AUDIO_PCM16;
+}
+
+static const uint8_t AUDIO_FLAG_START = 0x01;  // chunk đầu của phiên
+static const uint8_t AUDIO_FLAG_END = 0x02;    // chunk cuối của phiên
+static const uint16_t AUDIO_MAX_PAYLOAD = 1024;
+
+struct __attribute__((packed)) FrameHeader {
+  uint8_t version;
+  uint8_t channel;
+  uint16_t seq;
+  uint32_t timestamp;
+};
+
+static const uint8_t VIDEO_FORMAT_JPEG = 0;
+
+struct __attribute__((packed)) VideoHeader {
+  uint16_t width;
+  uint16_t height;
+  uint8_t format;
+  uint8_t quality;
+  uint16_t ageMs;
+};
+
+enum OtaOp : uint8_t {
+  OTA_BEGIN = 1,            // server -> robot
+  OTA_DATA = 2,
+  OTA_END = 3,
+  OTA_ABORT = 4,
+  OTA_ACK = 5,              // robot -> server
+  OTA_RESULT = 6
+};
+
+enum OtaStatus : uint8_t {
+  OTA_OK = 0,
+  OTA_ERR_BUSY,             // đang có phiên khác
+  OTA_ERR_HEADER,           // header HGP2 hỏng
+  OTA_ERR_SOURCE,           // patch không dành cho ảnh đang chạy
+  OTA_ERR_NO_PARTITION,     // không có phân vùng OTA / ảnh đích quá lớn
+  OTA_ERR_WRITE,            // lỗi ghi flash
+  OTA_ERR_PATCH,            // DeltaPatch báo lỗi
+  OTA_ERR_VERIFY,           // SHA-256 ảnh đích không khớp
+  OTA_ERR_RESYNC,           // offset lệch, gửi lại từ offset trong ACK
+  OTA_ERR_AUTH,             // chữ ký sai, hoặc firmware không có khoá và kết nối không phải wss://
+  OTA_ERR_VERSION           // version trong header không mới hơn build đang chạy
+};
+
+struct __attribute__((packed)) OtaHeader {
+  uint8_t op;
+  uint8_t status;
+  uint16_t reserved;
+  uint32_t offset;
+};
+
+struct __attribute__((packed)) SensorRecord {
+  uint8_t sensor;
+  uint8_t level;
+  uint16_t ageMs;
+  float value;
+};
+
+struct __attribute__((packed)) AudioHeader {
+  uint16_t streamId;
+  uint8_t codec;
+  uint8_t flags;
+  uint16_t samples;
+};
+
+static_assert(sizeof(FrameHeader) == 8, "FrameHeader must stay 8 bytes");
+static_assert(sizeof(AudioHeader) == 6, "AudioHeader must stay 6 bytes");
+static_assert(sizeof(VideoHeader) == 8, "VideoHeader must stay 8 bytes");
+static_assert(sizeof(OtaHeader) == 8, "OtaHeader must stay 8 bytes");
+static_assert(sizeof(SensorRecord) == 8, "SensorRecord must stay 8 bytes");
+
+static const uint8_t BINARY_MAX_RECORDS = (BINARY_MAX_FRAME - sizeof(FrameHeader) - 1) / sizeof(SensorRecord);
+
+// Ghi frame trực tiếp vào buffer có sẵn (ESP32 là little-endian nên memcpy struct là đủ)
+class BinaryFrameWriter {
+public:
+  BinaryFrameWriter(uint8_t* buffer, size_t capacity)
+    : buf(buffer), cap(capacity), len(0), countPos(0) {}
+
+  void begin(BinaryChannel channel, uint16_t seq, uint32_t timestamp) {
+    FrameHeader header = { BINARY_VERSION, channel, seq, timestamp };
+    len = 0;
+    write(&header, sizeof(header));
+    countPos = len;
+    buf[len++] = 0;
+  }
+
+  bool addRecord(SensorKind sensor, uint8_t level, uint16_t ageMs, float value) {
+    if (len + sizeof(SensorRecord) > cap) {
+      return false;
+    }
+    SensorRecord record = { sensor, level, ageMs, value };
+    write(&record, sizeof(record));
+    buf[countPos]++;
+    return true;
+  }
+
+  const uint8_t* data() const { return buf; }
+  size_t size() const { return len; }
+
+private:
+  void write(const void* src, size_t n) {
+    memcpy(buf + len, src, n);
+    len += n;
+  }
+
+  uint8_t* buf;
+  size_t cap;
+  size_t len;
+  size_t countPos;
+};
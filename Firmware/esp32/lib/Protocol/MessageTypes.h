@@ -0,0 +1,139 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ======================================================
+// 🏷️ Bảng tên message / kết nối / mức cảnh báo (compile-time)
+// ======================================================
+//
+// enum -> chuỗi là tra mảng constexpr theo chỉ số, không tạo String.
+// chuỗi -> MessageType dùng perfect hash: mỗi tên có một slot riêng trong
+// MESSAGE_TYPE_SLOTS, chỉ cần một strcmp để xác nhận. Thêm kiểu mới thì thêm
+// tên vào MESSAGE_TYPE_NAMES và slot của nó; static_assert bên dưới báo lỗi
+// nếu tên đặt sai slot hoặc hai tên trùng hash (khi đó tìm lại hằng số hash).
+
+// Message types enum
+//là kiểu liệt kê. Nó cho phép định nghĩa một tập hợp các hằng số có tên
+enum class MessageType : uint8_t {
+  CONNECTION_INIT,
+  SENSOR_DATA,
+  SENSOR_ALERT,
+  VOICE_COMMAND,
+  VOICE_TRANSCRIPTION,
+  AI_RESPONSE,
+  ACTUATOR_COMMAND,
+  BEHAVIOR_UPDATE,
+  EMOTION_UPDATE,
+  HEARTBEAT,
+  STATUS_UPDATE,
+  ERROR_MSG,
+  ACK
+};
+
+// Connection types enum
+enum class ConnectionType : uint8_t {
+  ESP32_TYPE,
+  AI_ENGINE,      // 🔄 RENAMED from LAPTOP_AI
+  WEB_CLIENT,
+  MOBILE
+};
+
+// Alert levels
+enum class AlertLevel : uint8_t {
+  NORMAL,
+  WARNING,
+  DANGER,
+  CRITICAL
+};
+
+static const uint8_t MESSAGE_TYPE_COUNT = (uint8_t)MessageType::ACK + 1;
+static const uint8_t CONNECTION_TYPE_COUNT = (uint8_t)ConnectionType::MOBILE + 1;
+static const uint8_t ALERT_LEVEL_COUNT = (uint8_t)AlertLevel::CRITICAL + 1;
+
+// Thứ tự khớp với enum
+constexpr const char* MESSAGE_TYPE_NAMES[MESSAGE_TYPE_COUNT] = {
+  "connection_init", "sensor_data", "sensor_alert", "voice_command", "voice_transcription",
+  "ai_response", "actuator_command", "behavior_update", "emotion_update", "heartbeat",
+  "status_update", "error", "ack"
+};
+constexpr const char* CONNECTION_TYPE_NAMES[CONNECTION_TYPE_COUNT] = {
+  "esp32", "ai_engine", "web_client", "mobile"
+};
+constexpr const char* ALERT_LEVEL_NAMES[ALERT_LEVEL_COUNT] = {
+  "normal", "warning", "danger", "critical"
+};
+
+// ============================================
+// PERFECT HASH chuỗi -> MessageType
+// ============================================
+
+static const uint8_t MESSAGE_HASH_SIZE = 32;
+static const uint8_t MESSAGE_SLOT_EMPTY = 0xFF;
+
+constexpr size_t messageNameLength(const char* s) {
+  return *s ? 1 + messageNameLength(s + 1) : 0;
+}
+
+// h = (len + đầu + 19 * cuối) mod 32: không trùng với 13 tên hiện có
+constexpr uint8_t messageNameHash(const char* s, size_t len) {
+  return (uint8_t)((len + (uint8_t)s[0] + 19u * (uint8_t)s[len - 1]) & (MESSAGE_HASH_SIZE - 1));
+}
+
+constexpr uint8_t MESSAGE_TYPE_SLOTS[MESSAGE_HASH_SIZE] = {
+  /* 0 */ (uint8_t)MessageType::ERROR_MSG, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  /* 8 */ 0xFF, 0xFF, 0xFF, (uint8_t)MessageType::AI_RESPONSE,
+  /* 12 */ 0xFF, (uint8_t)MessageType::HEARTBEAT, (uint8_t)MessageType::CONNECTION_INIT,
+  /* 15 */ (uint8_t)MessageType::VOICE_COMMAND, (uint8_t)MessageType::BEHAVIOR_UPDATE,
+  /* 17 */ (uint8_t)MessageType::SENSOR_DATA, (uint8_t)MessageType::EMOTION_UPDATE,
+  /* 19 */ (uint8_t)MessageType::VOICE_TRANSCRIPTION, 0xFF, (uint8_t)MessageType::ACK,
+  /* 22 */ 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, (uint8_t)MessageType::SENSOR_ALERT,
+  /* 28 */ 0xFF, (uint8_t)MessageType::ACTUATOR_COMMAND, 0xFF, (uint8_t)MessageType::STATUS_UPDATE
+};
+
+constexpr bool messageSlotsValid(uint8_t type) {
+  return type >= MESSAGE_TYPE_COUNT ||
+         (MESSAGE_TYPE_SLOTS[messageNameHash(MESSAGE_TYPE_NAMES[type],
+                                             messageNameLength(MESSAGE_TYPE_NAMES[type]))] == type &&
+          messageSlotsValid(type + 1));
+}
+static_assert(messageSlotsValid(0), "MESSAGE_TYPE_SLOTS out of sync with MESSAGE_TYPE_NAMES");
+
+// ============================================
+// TRA CỨU
+// ============================================
+
+inline const char* messageTypeName(MessageType type) {
+  return (uint8_t)type < MESSAGE_TYPE_COUNT ? MESSAGE_TYPE_NAMES[(uint8_t)type] : "unknown";
+}
+
+inline const char* connectionTypeName(ConnectionType type) {
+  return (uint8_t)type < CONNECTION_TYPE_COUNT ? CONNECTION_TYPE_NAMES[(uint8_t)type] : "unknown";
+}
+
+inline const char* alertLevelName(AlertLevel level) {
+  return (uint8_t)level < ALERT_LEVEL_COUNT ? ALERT_LEVEL_NAMES[(uint8_t)level] : "normal";
+}
+
+// Tên không biết thì trả về fallback
+inline AlertLevel alertLevelFromName(const char* name, AlertLevel fallback) {
+  for (uint8_t i = 0; name != nullptr && i < ALERT_LEVEL_COUNT; i++) {
+    if (strcmp(name, ALERT_LEVEL_NAMES[i]) == 0) {
+      return (AlertLevel)i;
+    }
+  }
+  return fallback;
+}
+
+// false khi không phải tên message đã biết
+inline bool messageTypeFromName(const char* name, MessageType& type) {
+  if (name == nullptr || name[0] == '\0') {
+    return false;
+  }
+  size_t len = strlen(name);
+  uint8_t slot = MESSAGE_TYPE_SLOTS[messageNameHash(name, len)];
+  if (slot == MESSAGE_SLOT_EMPTY || strcmp(name, MESSAGE_TYPE_NAMES[slot]) != 0) {
+    return false;
+  }
+  type = (MessageType)slot;
+  return true;
+}
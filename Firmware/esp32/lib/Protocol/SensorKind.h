@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Loại cảm biến: dùng chung cho Sensor, luật cảnh báo và frame "bin1"
+// (SensorRecord.sensor), nên giá trị số không được đổi
+enum SensorKind : uint8_t {
+    SENSOR_TEMPERATURE = 0,   // °C
+    SENSOR_HUMIDITY = 1,      // %
+    SENSOR_GAS = 2,           // ADC raw
+    SENSOR_DISTANCE = 3,      // cm
+    SENSOR_MOTION = 4,        // 0/1
+    SENSOR_FLAME = 5,         // 0/1
+    SENSOR_LIGHT = 6,
+    SENSOR_SOUND = 7,
+    SENSOR_UNKNOWN = 0xFF
+};
+
+static const uint8_t SENSOR_KIND_COUNT = SENSOR_SOUND + 1;
+
+// Tên cảm biến trong JSON (sensorType, luật cảnh báo), thứ tự khớp với enum
+static const char *const SENSOR_KIND_NAMES[SENSOR_KIND_COUNT] = {
+    "temperature", "humidity", "gas", "distance", "motion", "flame", "light", "sound"
+};
+
+inline const char *sensorKindName(uint8_t kind) {
+    return kind < SENSOR_KIND_COUNT ? SENSOR_KIND_NAMES[kind] : "unknown";
+}
+
+inline SensorKind sensorKindFromName(const char *name) {
+    for (uint8_t i = 0; name != nullptr && i < SENSOR_KIND_COUNT; i++) {
+        if (strcmp(name, SENSOR_KIND_NAMES[i]) == 0) {
+            return (SensorKind)i;
+        }
+    }
+    return SENSOR_UNKNOWN;
+}
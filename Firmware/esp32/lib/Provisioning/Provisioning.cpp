@@ -0,0 +1,93 @@
+#include "Provisioning.h"
+#include <Preferences.h>
+
+static const char* NAMESPACE = "provision";
+
+String Provisioning::defaultRobotId() {
+    // 3 byte cuối MAC (phần riêng của thiết bị, không phải OUI nhà sản xuất)
+    uint64_t mac = ESP.getEfuseMac();
+    char id[16];
+    snprintf(id, sizeof(id), "robot_%02x%02x%02x",
+             (unsigned)((mac >> 24) & 0xFF), (unsigned)((mac >> 32) & 0xFF), (unsigned)((mac >> 40) & 0xFF));
+    return String(id);
+}
+
+RobotProvision Provisioning::load(const RobotProvision& defaults) {
+    RobotProvision provision = defaults;
+    Preferences prefs;
+    if (prefs.begin(NAMESPACE, true)) {
+        provision.robotId = prefs.getString("robotId", defaults.robotId);
+        provision.host = prefs.getString("host", defaults.host);
+        provision.port = prefs.getUShort("port", defaults.port);
+        prefs.end();
+    }
+    if (provision.robotId.length() == 0) {
+        provision.robotId = defaultRobotId();
+    }
+    return provision;
+}
+
+bool Provisioning::save(const RobotProvision& provision) {
+    Preferences prefs;
+    if (!prefs.begin(NAMESPACE, false)) {
+        return false;
+    }
+    bool ok = true;
+    if (provision.robotId.length() > 0) {
+        ok &= prefs.putString("robotId", provision.robotId) > 0;
+    }
+    if (provision.host.length() > 0) {
+        ok &= prefs.putString("host", provision.host) > 0;
+    }
+    if (provision.port != 0) {
+        ok &= prefs.putUShort("port", provision.port) > 0;
+    }
+    prefs.end();
+    return ok;
+}
+
+void Provisioning::clear() {
+    Preferences prefs;
+    if (prefs.begin(NAMESPACE, false)) {
+        prefs.clear();
+        prefs.end();
+    }
+}
+
+bool Provisioning::parse(const String& line, RobotProvision& out) {
+    out.robotId = "";
+    out.host = "";
+    out.port = 0;
+    int pos = 0;
+    int length = line.length();
+    while (pos < length) {
+        while (pos < length && line[pos] == ' ') {
+            pos++;
+        }
+        if (pos >= length) {
+            break;
+        }
+        int end = line.indexOf(' ', pos);
+        if (end < 0) {
+            end = length;
+        }
+        String item = line.substring(pos, end);
+        pos = end;
+        int eq = item.indexOf('=');
+        if (eq <= 0) {
+            return false;
+        }
+        String key = item.substring(0, eq);
+        String value = item.substring(eq + 1);
+        if (key == "id" && value.length() > 0 && value.length() <= MAX_ID_LENGTH) {
+            out.robotId = value;
+        } else if (key == "host" && value.length() > 0 && value.length() <= MAX_HOST_LENGTH) {
+            out.host = value;
+        } else if (key == "port" && value.toInt() > 0 && value.toInt() <= 65535) {
+            out.port = (uint16_t)value.toInt();
+        } else {
+            return false;
+        }
+    }
+    return out.robotId.length() > 0 || out.host.length() > 0 || out.port != 0;
+}
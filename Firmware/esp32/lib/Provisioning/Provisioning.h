@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ======================================================
+// 🏷️ Định danh robot và địa chỉ server từ NVS (provisioning)
+// ======================================================
+//
+// Mỗi robot trong một toà nhà cần robotId riêng và có thể trỏ tới server khác
+// nhau mà không phải build lại firmware. Giá trị nằm trong namespace NVS
+// "provision" (còn sau OTA và mất điện); key nào chưa ghi thì dùng mặc định
+// biên dịch sẵn, robotId mặc định lấy theo MAC ("robot_a1b2c3") để hai robot
+// chưa provisioning không trùng nhau trên server.
+//
+// Ghi qua console Serial, ví dụ:
+//     p id=robot_017 host=homeguard.local port=8080
+// rồi khởi động lại để áp dụng.
+
+struct RobotProvision {
+    String robotId;
+    String host;
+    uint16_t port;
+};
+
+class Provisioning {
+public:
+    static const uint8_t MAX_ID_LENGTH = 32;
+    static const uint8_t MAX_HOST_LENGTH = 63;
+
+    // defaults: giá trị khi NVS chưa có key tương ứng (robotId rỗng = theo MAC)
+    static RobotProvision load(const RobotProvision& defaults);
+    // Chỉ ghi các trường khác rỗng / khác 0
+    static bool save(const RobotProvision& provision);
+    static void clear();
+    static String defaultRobotId();
+
+    // "id=... host=... port=..." (thứ tự tuỳ ý, bỏ trống được); false nếu sai cú pháp
+    static bool parse(const String& line, RobotProvision& out);
+};
@@ -0,0 +1,171 @@
+#include "BootProfiler.h"
+#include <esp_timer.h>
+
+BootProfiler::BootProfiler()
+    : count(0), jobCount(0), done(nullptr), running(0), joinWaitUs(0), lock(portMUX_INITIALIZER_UNLOCKED) {}
+
+uint32_t BootProfiler::nowUs() {
+    return (uint32_t)esp_timer_get_time();
+}
+
+int8_t BootProfiler::addRecord(const char *name, uint32_t startUs, uint32_t durationUs, int8_t core) {
+    int8_t index = -1;
+    portENTER_CRITICAL(&lock);
+    if (count < MAX_RECORDS) {
+        index = count;
+        records[index] = BootRecord{ name, startUs, durationUs, core };
+        count = count + 1;
+    }
+    portEXIT_CRITICAL(&lock);
+    return index;
+}
+
+// ============================================
+// CÁC BƯỚC KHỞI ĐỘNG
+// ============================================
+
+void BootProfiler::step(const char *name, BootStep fn) {
+    uint32_t start = nowUs();
+    fn();
+    addRecord(name, start, nowUs() - start, CORE_CALLER);
+}
+
+bool BootProfiler::spawn(const char *name, BootStep fn, BaseType_t core, UBaseType_t priority) {
+    if (done == nullptr) {
+        done = xSemaphoreCreateCounting(MAX_PARALLEL, 0);
+    }
+    if (done != nullptr && jobCount < MAX_PARALLEL) {
+        int8_t record = addRecord(name, nowUs(), 0, (int8_t)core);
+        if (record >= 0) {
+            Job &job = jobs[jobCount];
+            job.owner = this;
+            job.fn = fn;
+            job.record = (uint8_t)record;
+            job.finished = false;
+            if (xTaskCreatePinnedToCore(jobTask, name, SPAWN_STACK, &job, priority, nullptr, core) == pdPASS) {
+                jobCount++;
+                running++;
+                return true;
+            }
+            // Không tạo được task: chạy tuần tự, dùng lại bản ghi vừa thêm
+            job.fn = nullptr;
+            uint32_t start = nowUs();
+            fn();
+            records[record] = BootRecord{ name, start, nowUs() - start, CORE_CALLER };
+            return false;
+        }
+    }
+    step(name, fn);
+    return false;
+}
+
+void BootProfiler::jobTask(void *arg) {
+    Job *job = static_cast<Job *>(arg);
+    BootProfiler *self = job->owner;
+    BootRecord &record = self->records[job->record];
+    record.startUs = nowUs();
+    job->fn();
+    record.durationUs = nowUs() - record.startUs;
+    job->finished = true;
+    xSemaphoreGive(self->done);
+    vTaskDelete(nullptr);
+}
+
+bool BootProfiler::join(uint32_t timeoutMs, BootStep idle) {
+    uint32_t start = nowUs();
+    uint32_t deadlineMs = millis() + timeoutMs;
+    while (running > 0) {
+        // Chờ từng nhịp ngắn để idle (animation) vẫn chạy đều
+        if (xSemaphoreTake(done, pdMS_TO_TICKS(idle ? 5 : 50)) == pdTRUE) {
+            running--;
+            continue;
+        }
+        if ((int32_t)(millis() - deadlineMs) >= 0) {
+            Serial.printf("[Boot] join timeout, %u step(s) still running:", running);
+            for (uint8_t i = 0; i < jobCount; i++) {
+                if (!jobs[i].finished) {
+                    Serial.printf(" %s", records[jobs[i].record].name);
+                }
+            }
+            Serial.println();
+            joinWaitUs += nowUs() - start;
+            return false;
+        }
+        if (idle) {
+            idle();
+        }
+    }
+    joinWaitUs += nowUs() - start;
+    for (uint8_t i = 0; i < jobCount; i++) {
+        jobs[i].fn = nullptr;
+    }
+    jobCount = 0;
+    return true;
+}
+
+void BootProfiler::mark(const char *name) {
+    if (!hasMark(name)) {
+        addRecord(name, nowUs(), 0, CORE_MARK);
+    }
+}
+
+// ============================================
+// KẾT QUẢ
+// ============================================
+
+bool BootProfiler::hasMark(const char *name) const {
+    return getMarkUs(name) != 0;
+}
+
+uint8_t BootProfiler::getCount() const {
+    return count;
+}
+
+const BootRecord &BootProfiler::getRecord(uint8_t index) const {
+    return records[index < count ? index : 0];
+}
+
+uint32_t BootProfiler::getMarkUs(const char *name) const {
+    uint8_t n = count;
+    for (uint8_t i = 0; i < n; i++) {
+        if (records[i].core == CORE_MARK && strcmp(records[i].name, name) == 0) {
+            return records[i].startUs;
+        }
+    }
+    return 0;
+}
+
+uint32_t BootProfiler::getSerialUs() const {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (records[i].core == CORE_CALLER) {
+            total += records[i].durationUs;
+        }
+    }
+    return total;
+}
+
+uint32_t BootProfiler::getSavedUs() const {
+    uint32_t parallel = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (records[i].core >= 0) {
+            parallel += records[i].durationUs;
+        }
+    }
+    return parallel > joinWaitUs ? parallel - joinWaitUs : 0;
+}
+
+void BootProfiler::printReport(Print &out) const {
+    out.println("[Boot] step                 start_ms   dur_ms  core");
+    for (uint8_t i = 0; i < count; i++) {
+        const BootRecord &r = records[i];
+        if (r.core == CORE_MARK) {
+            out.printf("[Boot] * %-18s %8.1f\n", r.name, r.startUs / 1000.0f);
+        } else {
+            out.printf("[Boot]   %-18s %8.1f %8.1f  %s\n", r.name, r.startUs / 1000.0f, r.durationUs / 1000.0f,
+                       r.core == CORE_CALLER ? "-" : (r.core == 0 ? "0" : "1"));
+        }
+    }
+    out.printf("[Boot] serial=%.1fms join_wait=%.1fms saved_by_parallel=%.1fms\n",
+               getSerialUs() / 1000.0f, joinWaitUs / 1000.0f, getSavedUs() / 1000.0f);
+}
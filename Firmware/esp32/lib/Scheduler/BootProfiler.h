@@ -0,0 +1,77 @@
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+
+// ======================================================
+// 🚀 Đo thời gian khởi động và chạy song song các bước begin()
+// ======================================================
+//
+// step() chạy một bước ngay trong task gọi và ghi lại thời gian. spawn() chạy
+// bước trong một task FreeRTOS tạm (ghim core) để các subsystem độc lập khởi
+// động song song; join() chờ mọi task tạm xong, trong lúc chờ gọi idle (ví dụ
+// vẽ frame animation) thay vì đứng yên. mark() ghi các mốc như frame đầu tiên,
+// có IP, telemetry đầu tiên. Mọi thời điểm tính từ lúc chip reset
+// (esp_timer_get_time), nên gồm cả thời gian bootloader trước setup().
+//
+// Bước chạy trong spawn() không được đụng tới thứ mà bước khác đang khởi tạo,
+// và không gọi lại BootProfiler ngoài việc được đo.
+
+using BootStep = std::function<void()>;
+
+struct BootRecord {
+    const char *name;
+    uint32_t startUs;            // từ lúc reset
+    uint32_t durationUs;         // mốc (mark) thì bằng 0
+    int8_t core;                 // CORE_CALLER, CORE_MARK hoặc core của task tạm (0/1)
+};
+
+class BootProfiler {
+public:
+    static const uint8_t MAX_RECORDS = 24;
+    static const uint8_t MAX_PARALLEL = 4;
+    static const uint32_t SPAWN_STACK = 6144;
+    static const int8_t CORE_CALLER = -1;        // step(): chạy ngay trong task gọi
+    static const int8_t CORE_MARK = -2;          // mark(): chỉ là mốc thời gian
+
+    BootProfiler();
+
+    void step(const char *name, BootStep fn);
+    // false nếu không tạo được task: khi đó bước chạy tuần tự luôn
+    bool spawn(const char *name, BootStep fn, BaseType_t core, UBaseType_t priority = 2);
+    // Chờ các bước spawn() xong; false nếu hết timeoutMs mà còn bước đang chạy (in tên
+    // các bước đó). Gọi lại được: lần sau tiếp tục chờ đúng những bước còn dở
+    bool join(uint32_t timeoutMs, BootStep idle = nullptr);
+    // Ghi mốc một lần (lần gọi sau bỏ qua), gọi được từ task bất kỳ
+    void mark(const char *name);
+    bool hasMark(const char *name) const;
+
+    uint8_t getCount() const;
+    const BootRecord &getRecord(uint8_t index) const;
+    uint32_t getMarkUs(const char *name) const;   // 0 nếu chưa có
+    uint32_t getSerialUs() const;                 // tổng thời gian các bước tuần tự
+    uint32_t getSavedUs() const;                  // thời gian tiết kiệm được nhờ spawn()
+
+    void printReport(Print &out = Serial) const;
+
+private:
+    struct Job {
+        BootProfiler *owner;
+        BootStep fn;
+        uint8_t record;
+        volatile bool finished;  // task tạm ghi trước khi give, join() đọc để báo bước còn dở
+    };
+
+    static void jobTask(void *arg);
+    int8_t addRecord(const char *name, uint32_t startUs, uint32_t durationUs, int8_t core);
+    static uint32_t nowUs();
+
+    BootRecord records[MAX_RECORDS];
+    volatile uint8_t count;
+    Job jobs[MAX_PARALLEL];
+    uint8_t jobCount;
+    SemaphoreHandle_t done;      // mỗi task tạm give một lần khi xong
+    uint8_t running;
+    uint32_t joinWaitUs;
+    mutable portMUX_TYPE lock;
+};
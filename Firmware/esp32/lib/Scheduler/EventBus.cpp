@@ -0,0 +1,191 @@
+#include "EventBus.h"
+#include <esp_timer.h>
+
+static const char *const LANE_NAMES[(uint8_t)EventLane::COUNT] = { "alarm", "command", "normal" };
+
+EventBus::EventBus()
+    : routes{}, queues{}, task(nullptr),
+      latency{ Metrics::histogram("bus.alarm_us"), Metrics::histogram("bus.command_us"),
+               Metrics::histogram("bus.normal_us") },
+      dropped(Metrics::counter("bus.dropped")), dropLock(portMUX_INITIALIZER_UNLOCKED) {
+    for (uint8_t i = 0; i < MAX_KINDS; i++) {
+        routes[i].lane = EventLane::NORMAL;
+        routes[i].kind = i;
+        routes[i].owner = this;
+    }
+}
+
+bool EventBus::begin(uint8_t alarmSlots, uint8_t commandSlots, uint8_t normalSlots) {
+    const uint8_t slots[(uint8_t)EventLane::COUNT] = { alarmSlots, commandSlots, normalSlots };
+    bool ok = true;
+    for (uint8_t i = 0; i < (uint8_t)EventLane::COUNT; i++) {
+        if (queues[i] == nullptr) {
+            queues[i] = xQueueCreate(slots[i], sizeof(Event));
+        }
+        ok = ok && queues[i] != nullptr;
+    }
+    return ok;
+}
+
+bool EventBus::start(BaseType_t core, UBaseType_t priority, uint32_t stackBytes) {
+    if (task != nullptr) {
+        return true;
+    }
+    if (queues[(uint8_t)EventLane::ALARM] == nullptr || queues[(uint8_t)EventLane::COMMAND] == nullptr) {
+        return false;
+    }
+    if (xTaskCreatePinnedToCore(taskLoop, "event_bus", stackBytes, this, priority, &task, core) != pdPASS) {
+        task = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void EventBus::on(uint8_t kind, EventLane lane, EventHandler handler) {
+    if (kind < MAX_KINDS && lane < EventLane::COUNT) {
+        routes[kind].lane = lane;
+        routes[kind].handler = handler;
+    }
+}
+
+// ============================================
+// POST
+// ============================================
+
+bool EventBus::post(uint8_t kind, const void *data, size_t length, uint32_t postedUs, uint32_t arg) {
+    if (kind >= MAX_KINDS || length > Event::DATA_SIZE) {
+        countDrop();
+        return false;
+    }
+    Event event;
+    event.kind = kind;
+    event.lane = (uint8_t)routes[kind].lane;
+    event.length = (uint16_t)length;
+    event.postedUs = postedUs != 0 ? postedUs : (uint32_t)esp_timer_get_time();
+    event.arg = arg;
+    if (length > 0) {
+        memcpy(event.data, data, length);
+    }
+    return enqueue(event);
+}
+
+bool EventBus::enqueue(Event &event) {
+    QueueHandle_t queue = queues[event.lane];
+    if (queue == nullptr) {
+        dispatch(event);          // không có queue: đồng bộ
+        return true;
+    }
+    if (xQueueSend(queue, &event, 0) != pdTRUE) {
+        countDrop();
+        return false;
+    }
+    if (task != nullptr && event.lane != (uint8_t)EventLane::NORMAL) {
+        xTaskNotifyGive(task);
+    }
+    return true;
+}
+
+void *EventBus::isrHandle(uint8_t kind) {
+    return kind < MAX_KINDS ? &routes[kind] : nullptr;
+}
+
+void IRAM_ATTR EventBus::postFromISR(void *handle) {
+    Route *route = static_cast<Route *>(handle);
+    if (route == nullptr) {
+        return;
+    }
+    EventBus *bus = route->owner;
+    QueueHandle_t queue = bus->queues[(uint8_t)route->lane];
+    if (queue == nullptr) {
+        return;
+    }
+    Event event;
+    event.kind = route->kind;
+    event.lane = (uint8_t)route->lane;
+    event.length = 0;
+    event.postedUs = (uint32_t)esp_timer_get_time();
+    event.arg = 0;
+    BaseType_t woken = pdFALSE;
+    if (xQueueSendFromISR(queue, &event, &woken) != pdTRUE) {
+        portENTER_CRITICAL_ISR(&bus->dropLock);
+        bus->dropped->add();
+        portEXIT_CRITICAL_ISR(&bus->dropLock);
+    } else if (bus->task != nullptr && route->lane != EventLane::NORMAL) {
+        vTaskNotifyGiveFromISR(bus->task, &woken);
+    }
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+void EventBus::countDrop() {
+    portENTER_CRITICAL(&dropLock);
+    dropped->add();
+    portEXIT_CRITICAL(&dropLock);
+}
+
+// ============================================
+// DISPATCH
+// ============================================
+
+void EventBus::dispatch(const Event &event) {
+    const Route &route = routes[event.kind];
+    if (route.handler) {
+        route.handler(event);
+    }
+    latency[event.lane]->record((uint32_t)esp_timer_get_time() - event.postedUs);
+}
+
+uint8_t EventBus::dispatchPending(uint8_t max) {
+    uint8_t handled = 0;
+    Event event;
+    // Luôn thử làn cao nhất trước, sự kiện khẩn tới giữa chừng được xử lý trước phần còn lại
+    while (handled < max) {
+        bool got = false;
+        for (uint8_t lane = 0; lane < (uint8_t)EventLane::COUNT && !got; lane++) {
+            bool mine = task == nullptr || lane == (uint8_t)EventLane::NORMAL;
+            got = mine && queues[lane] != nullptr && xQueueReceive(queues[lane], &event, 0) == pdTRUE;
+        }
+        if (!got) {
+            break;
+        }
+        dispatch(event);
+        handled++;
+    }
+    return handled;
+}
+
+void EventBus::taskLoop(void *arg) {
+    EventBus *self = static_cast<EventBus *>(arg);
+    QueueHandle_t alarms = self->queues[(uint8_t)EventLane::ALARM];
+    QueueHandle_t commands = self->queues[(uint8_t)EventLane::COMMAND];
+    Event event;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (xQueueReceive(alarms, &event, 0) == pdTRUE || xQueueReceive(commands, &event, 0) == pdTRUE) {
+            self->dispatch(event);
+        }
+    }
+}
+
+// ============================================
+// THỐNG KÊ
+// ============================================
+
+uint32_t EventBus::getDropped() const {
+    return dropped->value;
+}
+
+const Histogram *EventBus::getLatency(EventLane lane) const {
+    return lane < EventLane::COUNT ? latency[(uint8_t)lane] : nullptr;
+}
+
+void EventBus::printStats(Print &out) const {
+    out.printf("[EventBus] dispatcher=%d dropped=%u", task != nullptr, dropped->value);
+    for (uint8_t i = 0; i < (uint8_t)EventLane::COUNT; i++) {
+        const Histogram *h = latency[i];
+        out.printf(" | %s n=%u p50=%uus p99=%uus max=%uus", LANE_NAMES[i], h->count, h->percentile(50),
+                   h->percentile(99), h->max);
+    }
+    out.println();
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+#include "Metrics.h"
+
+// ======================================================
+// 🚨 Hàng đợi sự kiện theo làn ưu tiên giữa các task
+// ======================================================
+//
+// Mỗi làn là một queue FreeRTOS với số slot cố định cấp một lần ở begin(),
+// slot chứa nguyên Event (không cấp phát lúc post). Lệnh điều khiển và báo
+// động không chờ sau loop():
+//   ALARM   lửa / gas: còi kêu trước mọi việc khác
+//   COMMAND actuator_command từ server
+//       -> task dispatcher ưu tiên cao (start()), rút ALARM trước rồi mới tới
+//          COMMAND, giành CPU của loop ngay khi có sự kiện
+//   NORMAL  việc chạm vào state của loop (mặt, màn hình...)
+//       -> dispatchPending() trong một task của Scheduler
+//
+// Handler của ALARM / COMMAND chạy trong task dispatcher nên chỉ được gọi
+// API an toàn đa task (lệnh loa qua queue, WebSocketClient có khoá).
+// Độ trễ từ postedUs tới khi handler xong được ghi vào histogram
+// bus.<làn>_us, gửi lên server cùng snapshot metrics.
+//
+// Không có queue (native) thì post() gọi handler ngay; không có dispatcher
+// thì dispatchPending() rút cả ba làn.
+
+enum class EventLane : uint8_t { ALARM = 0, COMMAND, NORMAL, COUNT };
+
+struct Event {
+    static const uint8_t DATA_SIZE = 116;
+
+    uint8_t kind;
+    uint8_t lane;
+    uint16_t length;
+    uint32_t postedUs;           // esp_timer 32 bit thấp: lúc sự kiện xảy ra (nhận frame, ISR...)
+    uint32_t arg;
+    uint8_t data[DATA_SIZE];     // payload tuỳ kind, ví dụ JSON đã serialize
+};
+
+static_assert(sizeof(Event) == 128, "Event slot must stay 128 bytes");
+
+using EventHandler = std::function<void(const Event &)>;
+
+class EventBus {
+public:
+    static const uint8_t MAX_KINDS = 16;
+
+    EventBus();
+
+    // Cấp slot cho từng làn
+    bool begin(uint8_t alarmSlots = 4, uint8_t commandSlots = 8, uint8_t normalSlots = 8);
+    // Task dispatcher cho ALARM / COMMAND, ưu tiên cao hơn loop (1) và task mạng
+    bool start(BaseType_t core = 1, UBaseType_t priority = 5, uint32_t stackBytes = 6144);
+
+    // Mỗi kind thuộc đúng một làn
+    void on(uint8_t kind, EventLane lane, EventHandler handler);
+    // false nếu làn đầy (đếm vào bus.dropped) hoặc payload quá DATA_SIZE
+    bool post(uint8_t kind, const void *data = nullptr, size_t length = 0, uint32_t postedUs = 0,
+              uint32_t arg = 0);
+    // Handle truyền cho postFromISR(), ví dụ làm arg của EdgeNotify
+    void *isrHandle(uint8_t kind);
+    static void IRAM_ATTR postFromISR(void *handle);
+
+    // Gọi trong loop: handler của NORMAL (và các làn khác nếu chưa start()), tối đa max sự kiện
+    uint8_t dispatchPending(uint8_t max = 8);
+
+    uint32_t getDropped() const;
+    const Histogram *getLatency(EventLane lane) const;
+    void printStats(Print &out = Serial) const;
+
+private:
+    struct Route {
+        EventHandler handler;
+        EventLane lane;
+        uint8_t kind;
+        EventBus *owner;
+    };
+
+    bool enqueue(Event &event);
+    void countDrop();            // post() từ task, cùng khoá với postFromISR()
+    void dispatch(const Event &event);
+    static void taskLoop(void *arg);
+
+    Route routes[MAX_KINDS];
+    QueueHandle_t queues[(uint8_t)EventLane::COUNT];
+    TaskHandle_t task;
+    Histogram *latency[(uint8_t)EventLane::COUNT];
+    Counter *dropped;
+    portMUX_TYPE dropLock;       // add() là read-modify-write, ISR và task (hai core) cùng tăng
+};
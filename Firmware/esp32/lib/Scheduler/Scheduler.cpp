@@ -0,0 +1,151 @@
+#include "Scheduler.h"
+#include <esp_timer.h>
+
+Scheduler::Scheduler()
+    : taskCount(0), statsSinceUs(0), waiter(nullptr), latenessHist(Metrics::histogram("loop.lateness_us")) {}
+
+int8_t Scheduler::addTask(const char *name, uint32_t periodMs, TaskCallback callback) {
+    if (taskCount >= MAX_TASKS || !callback) {
+        return -1;
+    }
+    Task &task = tasks[taskCount];
+    task.callback = callback;
+    task.stats = TaskStats{ name, periodMs, 0, 0, 0, 0, 0, 0 };
+    task.nextRunUs = esp_timer_get_time();
+    task.enabled = true;
+    task.triggered = false;
+    task.owner = this;
+    if (statsSinceUs == 0) {
+        statsSinceUs = task.nextRunUs;
+    }
+    return taskCount++;
+}
+
+void Scheduler::setPeriod(int8_t id, uint32_t periodMs) {
+    if (id >= 0 && id < taskCount) {
+        tasks[id].stats.periodMs = periodMs;
+    }
+}
+
+void Scheduler::setEnabled(int8_t id, bool enabled) {
+    if (id >= 0 && id < taskCount) {
+        if (enabled && !tasks[id].enabled) {
+            tasks[id].nextRunUs = esp_timer_get_time();
+        }
+        tasks[id].enabled = enabled;
+    }
+}
+
+void *Scheduler::triggerHandle(int8_t id) {
+    return (id >= 0 && id < taskCount) ? &tasks[id] : nullptr;
+}
+
+void IRAM_ATTR Scheduler::triggerFromISR(void *handle) {
+    Task *task = static_cast<Task *>(handle);
+    if (task == nullptr) {
+        return;
+    }
+    task->triggered = true;
+    TaskHandle_t waiter = task->owner->waiter;
+    if (waiter != nullptr) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(waiter, &woken);
+        if (woken) {
+            portYIELD_FROM_ISR();
+        }
+    }
+}
+
+uint32_t Scheduler::runPending() {
+    for (uint8_t i = 0; i < taskCount; i++) {
+        Task &task = tasks[i];
+        int64_t now = esp_timer_get_time();
+        bool triggered = task.triggered;
+        if (!task.enabled || (now < task.nextRunUs && !triggered)) {
+            continue;
+        }
+
+        task.triggered = false;
+        if (!triggered) {
+            latenessHist->record((uint32_t)(now - task.nextRunUs));
+        }
+        task.callback();
+
+        int64_t end = esp_timer_get_time();
+        uint32_t elapsed = (uint32_t)(end - now);
+        int64_t periodUs = (int64_t)task.stats.periodMs * 1000;
+        TaskStats &stats = task.stats;
+        stats.runs++;
+        stats.totalUs += elapsed;
+        stats.lastUs = elapsed;
+        stats.maxUs = max(stats.maxUs, elapsed);
+        if (elapsed > periodUs) {
+            stats.overruns++;
+        }
+
+        // Lần chạy do trigger không làm lệch nhịp chu kỳ
+        if (now < task.nextRunUs) {
+            continue;
+        }
+
+        // Giữ nhịp theo deadline cũ; nếu đã lỡ cả chu kỳ thì đếm và bắt nhịp lại
+        task.nextRunUs += periodUs;
+        if (task.nextRunUs <= end) {
+            if (periodUs > 0) {
+                stats.skipped += (uint32_t)((end - task.nextRunUs) / periodUs) + 1;
+            }
+            task.nextRunUs = end + periodUs;
+        }
+    }
+
+    int64_t now = esp_timer_get_time();
+    int64_t nearest = now + (int64_t)MAX_SLEEP_MS * 1000;
+    for (uint8_t i = 0; i < taskCount; i++) {
+        if (tasks[i].enabled && tasks[i].triggered) {
+            return 0;
+        }
+        if (tasks[i].enabled && tasks[i].nextRunUs < nearest) {
+            nearest = tasks[i].nextRunUs;
+        }
+    }
+    return nearest > now ? (uint32_t)((nearest - now) / 1000) : 0;
+}
+
+void Scheduler::run() {
+    if (waiter == nullptr) {
+        waiter = xTaskGetCurrentTaskHandle();
+    }
+    uint32_t sleepMs = runPending();
+    if (sleepMs > 0) {
+        // Ngủ tới deadline, hoặc dậy sớm khi ISR gọi triggerFromISR()
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(sleepMs));
+    }
+}
+
+uint8_t Scheduler::getTaskCount() const {
+    return taskCount;
+}
+
+const TaskStats &Scheduler::getStats(int8_t id) const {
+    return tasks[id].stats;
+}
+
+void Scheduler::resetStats() {
+    for (uint8_t i = 0; i < taskCount; i++) {
+        TaskStats &stats = tasks[i].stats;
+        stats = TaskStats{ stats.name, stats.periodMs, 0, 0, 0, 0, 0, 0 };
+    }
+    statsSinceUs = esp_timer_get_time();
+}
+
+void Scheduler::printStats(Print &out) const {
+    double windowUs = (double)(esp_timer_get_time() - statsSinceUs);
+    out.println("[Scheduler] task         period   runs  cpu%   avg_us   max_us  overrun  skipped");
+    for (uint8_t i = 0; i < taskCount; i++) {
+        const TaskStats &s = tasks[i].stats;
+        out.printf("[Scheduler] %-12s %5ums %6u %5.1f %8u %8u %8u %8u\n",
+                   s.name, s.periodMs, s.runs,
+                   windowUs > 0 ? 100.0 * s.totalUs / windowUs : 0.0,
+                   s.runs ? (uint32_t)(s.totalUs / s.runs) : 0, s.maxUs, s.overruns, s.skipped);
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+#include "Metrics.h"
+
+// ======================================================
+// ⏱️ Bộ lập lịch cooperative cho Robot::run()
+// ======================================================
+//
+// Mỗi subsystem đăng ký một callback với chu kỳ riêng. run() chạy các task
+// tới hạn rồi ngủ (vTaskDelay) đúng tới deadline gần nhất thay vì delay() cố định.
+// Callback phải ngắn và không block, vì task sau phải chờ task trước.
+// Task hướng sự kiện (ví dụ ngắt GPIO) gọi triggerFromISR() để chạy ngay ở
+// vòng kế tiếp thay vì chờ hết chu kỳ; chu kỳ khi đó chỉ là mức dự phòng.
+
+using TaskCallback = std::function<void()>;
+
+struct TaskStats {
+    const char *name;
+    uint32_t periodMs;
+    uint32_t runs;
+    uint32_t overruns;           // số lần chạy lâu hơn chu kỳ của chính nó
+    uint32_t skipped;            // số chu kỳ bị lỡ vì task khác chiếm CPU
+    uint64_t totalUs;            // tổng thời gian CPU
+    uint32_t maxUs;
+    uint32_t lastUs;
+};
+
+class Scheduler {
+public:
+    static const uint8_t MAX_TASKS = 16;
+    static const uint32_t MAX_SLEEP_MS = 50;
+
+    Scheduler();
+
+    // Trả về id task, -1 nếu đã đầy
+    int8_t addTask(const char *name, uint32_t periodMs, TaskCallback callback);
+    void setPeriod(int8_t id, uint32_t periodMs);
+    void setEnabled(int8_t id, bool enabled);
+
+    // Handle truyền cho triggerFromISR(), ví dụ làm arg của EdgeNotify
+    void *triggerHandle(int8_t id);
+    // Gọi được từ ISR: đánh dấu task tới hạn và đánh thức run() đang ngủ
+    static void IRAM_ATTR triggerFromISR(void *handle);
+
+    // Chạy các task tới hạn, trả về số ms tới deadline kế tiếp
+    uint32_t runPending();
+    // runPending() rồi ngủ tới deadline kế tiếp, gọi trong loop()
+    void run();
+
+    uint8_t getTaskCount() const;
+    const TaskStats &getStats(int8_t id) const;
+    void resetStats();
+    void printStats(Print &out = Serial) const;
+
+private:
+    struct Task {
+        TaskCallback callback;
+        TaskStats stats;
+        int64_t nextRunUs;
+        bool enabled;
+        volatile bool triggered;
+        Scheduler *owner;
+    };
+
+    Task tasks[MAX_TASKS];
+    uint8_t taskCount;
+    int64_t statsSinceUs;
+    TaskHandle_t waiter;         // task đang chạy run(), nhận notify từ ISR
+    Histogram *latenessHist;     // task chạy trễ so với deadline (µs), đo độ trễ loop
+};
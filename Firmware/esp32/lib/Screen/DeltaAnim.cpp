@@ -0,0 +1,114 @@
+#include "DeltaAnim.h"
+
+static inline uint16_t readU16(const uint8_t *p) {
+    return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+static inline uint32_t readU32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool DeltaAnim::parseHeader(const uint8_t *data, uint32_t size, DeltaAnimInfo &info) {
+    if (size < HEADER_SIZE || memcmp(data, "HGA1", 4) != 0) {
+        return false;
+    }
+    info.width = readU16(data + 4);
+    info.height = readU16(data + 6);
+    info.tile = data[8];
+    info.numFrames = readU16(data + 10);
+    info.size = size;
+    info.offsets = data + HEADER_SIZE;
+    if (info.width == 0 || info.width > MAX_DIMENSION || info.height == 0 || info.height > MAX_DIMENSION) {
+        return false;
+    }
+    if (info.tile == 0 || info.tile > MAX_TILE || info.numFrames == 0) {
+        return false;
+    }
+    // Bảng offset phải nằm trọn trong blob
+    return (uint32_t)HEADER_SIZE + ((uint32_t)info.numFrames + 1) * 4 <= size;
+}
+
+bool DeltaAnim::frameRange(const DeltaAnimInfo &info, uint16_t index, uint32_t &offset, uint32_t &length) {
+    if (index >= info.numFrames) {
+        return false;
+    }
+    offset = readU32(info.offsets + index * 4);
+    uint32_t end = readU32(info.offsets + (index + 1) * 4);
+    // Frame phải nằm sau bảng offset và trong blob (file cụt / offset rác)
+    uint32_t dataStart = HEADER_SIZE + ((uint32_t)info.numFrames + 1) * 4;
+    if (offset < dataStart || end < offset || end > info.size) {
+        return false;
+    }
+    length = end - offset;
+    return true;
+}
+
+bool DeltaAnim::decodeFrame(const DeltaAnimInfo &info, const uint8_t *frame, uint32_t length, TileCallback cb) {
+    if (length < 2) {
+        return false;
+    }
+    const uint8_t *p = frame;
+    const uint8_t *end = frame + length;
+    uint16_t numTiles = readU16(p);
+    p += 2;
+
+    if (info.tile == 0 || info.tile > MAX_TILE) {
+        return false;
+    }
+    const uint16_t tilesPerRow = (info.width + info.tile - 1) / info.tile;
+    const uint32_t gridTiles = (uint32_t)tilesPerRow * ((info.height + info.tile - 1) / info.tile);
+    uint16_t pixels[MAX_TILE * MAX_TILE];
+
+    for (uint16_t t = 0; t < numTiles; t++) {
+        if (end - p < 2) {
+            return false;
+        }
+        uint16_t tileIndex = readU16(p);
+        p += 2;
+        // Tile ngoài khung: w/h âm sẽ quấn thành số lớn và tràn pixels[]
+        if (tileIndex >= gridTiles) {
+            return false;
+        }
+
+        int16_t x = (tileIndex % tilesPerRow) * info.tile;
+        int16_t y = (tileIndex / tilesPerRow) * info.tile;
+        uint16_t w = min<int32_t>(info.tile, info.width - x);
+        uint16_t h = min<int32_t>(info.tile, info.height - y);
+        uint16_t count = w * h;
+
+        uint16_t filled = 0;
+        while (filled < count) {
+            if (p >= end) {
+                return false;
+            }
+            uint8_t op = *p++;
+            uint16_t n = (op & 0x7F) + 1;
+            if (filled + n > count) {
+                return false;
+            }
+            if (op & 0x80) {
+                if (end - p < 2) {
+                    return false;
+                }
+                uint16_t color;
+                memcpy(&color, p, 2);    // giữ nguyên thứ tự byte SPI
+                p += 2;
+                for (uint16_t i = 0; i < n; i++) {
+                    pixels[filled + i] = color;
+                }
+            } else {
+                if (end - p < n * 2) {
+                    return false;
+                }
+                memcpy(pixels + filled, p, n * 2);
+                p += n * 2;
+            }
+            filled += n;
+        }
+
+        if (!cb(x, y, w, h, pixels)) {
+            break;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ======================================================
+// 🎞️ HGA1 - định dạng animation delta-tile RGB565
+// ======================================================
+//
+// Sinh offline bằng tools/video2delta.py. Mọi số nguyên là little-endian.
+//
+//   "HGA1" | u16 width | u16 height | u8 tile | u8 flags | u16 numFrames
+//   u32 offsets[numFrames + 1]          // tính từ đầu blob, phần tử cuối = kích thước blob
+//   frame[i] = u16 numTiles, rồi numTiles lần: u16 tileIndex + dữ liệu RLE của tile
+//
+// RLE: byte op, op & 0x80 → lặp (op & 0x7F) + 1 lần pixel 16-bit theo sau,
+// ngược lại → op + 1 pixel literal. Pixel lưu sẵn thứ tự byte gửi SPI
+// (giống TJpgDec.setSwapBytes(true)) nên đẩy thẳng ra màn hình.
+// Frame 0 chứa mọi tile, các frame sau chỉ chứa tile thay đổi.
+
+struct DeltaAnimInfo {
+    uint16_t width;
+    uint16_t height;
+    uint8_t tile;
+    uint16_t numFrames;
+    uint32_t size;               // kích thước cả blob / file, mọi offset phải nằm trong đó
+    const uint8_t *offsets;      // bảng offset trong blob (có thể chưa căn lề)
+};
+
+class DeltaAnim {
+public:
+    static const uint8_t MAX_TILE = 16;
+    static const uint8_t HEADER_SIZE = 12;
+    static const uint16_t MAX_DIMENSION = 1024;
+
+    // Cùng chữ ký với callback của TJpg_Decoder để dùng chung đường xuất block
+    typedef bool (*TileCallback)(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *pixels);
+
+    // Đọc header từ một vùng nhớ chứa ít nhất HEADER_SIZE byte; size là kích thước
+    // cả blob (với file: file.size()), phải đủ chứa header và bảng offset
+    static bool parseHeader(const uint8_t *data, uint32_t size, DeltaAnimInfo &info);
+
+    // Vị trí và độ dài frame `index` trong một blob nằm trọn trong bộ nhớ
+    static bool frameRange(const DeltaAnimInfo &info, uint16_t index, uint32_t &offset, uint32_t &length);
+
+    // Giải mã một frame, gọi cb cho mỗi tile thay đổi; false nếu dữ liệu hỏng
+    static bool decodeFrame(const DeltaAnimInfo &info, const uint8_t *frame, uint32_t length, TileCallback cb);
+};
@@ -0,0 +1,203 @@
+#include "FaceAnimator.h"
+
+//                              eyeOpen squint pupil browH  browTilt curve  open  width
+const FaceParams EMOTION_FACES[EMOTION_COUNT] = {
+    /* neutral   */ {  1.00f,  0.0f, 1.00f,  0.0f,  0.0f,  0.15f, 0.00f, 1.00f, 0, 0 },
+    /* happy     */ {  0.85f,  0.6f, 1.05f,  0.3f, -0.1f,  1.00f, 0.25f, 1.10f, 0, 0 },
+    /* sad       */ {  0.70f,  0.0f, 0.95f, -0.2f, -0.9f, -0.80f, 0.00f, 0.80f, 0, 0 },
+    /* excited   */ {  1.15f,  0.3f, 1.20f,  0.7f, -0.2f,  1.00f, 0.70f, 1.15f, 0, 0 },
+    /* curious   */ {  1.05f,  0.0f, 1.15f,  0.6f, -0.3f,  0.20f, 0.10f, 0.70f, 0, 0 },
+    /* confused  */ {  0.90f,  0.1f, 1.00f,  0.2f,  0.5f, -0.20f, 0.05f, 0.70f, 0, 0 },
+    /* surprised */ {  1.30f,  0.0f, 0.80f,  1.0f, -0.3f,  0.00f, 0.90f, 0.60f, 0, 0 },
+    /* angry     */ {  0.75f,  0.2f, 0.90f, -0.6f,  1.0f, -0.50f, 0.15f, 0.90f, 0, 0 },
+    /* afraid    */ {  1.20f,  0.0f, 0.70f,  0.8f, -0.8f, -0.40f, 0.40f, 0.80f, 0, 0 },
+};
+
+// lerp() và update() duyệt FaceParams như một mảng float
+static_assert(sizeof(FaceParams) == 10 * sizeof(float), "FaceParams must only hold floats");
+
+static const float CHANGE_EPSILON = 0.004f;      // ~1 px trên mắt cao 64 px
+static const float GAZE_TAU_MS = 40.0f;          // mắt người liếc ~30-50 ms
+static const uint16_t BLINK_CLOSE_MS = 60;
+static const uint16_t BLINK_HOLD_MS = 20;
+
+FaceParams FaceParams::lerp(const FaceParams &a, const FaceParams &b, float t) {
+    FaceParams out;
+    const float *pa = &a.eyeOpen;
+    const float *pb = &b.eyeOpen;
+    float *po = &out.eyeOpen;
+    for (uint8_t i = 0; i < sizeof(FaceParams) / sizeof(float); i++) {
+        po[i] = pa[i] + (pb[i] - pa[i]) * t;
+    }
+    return out;
+}
+
+FaceAnimator::FaceAnimator()
+: currentEmotion(EMOTION_NEUTRAL), currentIntensity(1.0f),
+  from(EMOTION_FACES[EMOTION_NEUTRAL]), to(EMOTION_FACES[EMOTION_NEUTRAL]),
+  transitionStartMs(0), transitionMs(1),
+  idleMotion(true), nextBlinkMs(2000), blinkStartMs(0), blinking(false),
+  gazeX(0), gazeY(0), gazeTargetX(0), gazeTargetY(0), nextSaccadeMs(1000), gazeHoldUntilMs(0), lastUpdateMs(0),
+  shown(EMOTION_FACES[EMOTION_NEUTRAL]), lastReported(EMOTION_FACES[EMOTION_NEUTRAL]),
+  started(false), rng(0x9E3779B9) {
+}
+
+void FaceAnimator::seed(uint32_t value) {
+    rng = value != 0 ? value : 1;
+}
+
+// xorshift32: đủ cho nhịp chớp mắt, không tốn entropy của esp_random
+uint32_t FaceAnimator::random(uint32_t lo, uint32_t hi) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return lo + rng % (hi - lo + 1);
+}
+
+// ============================================
+// ĐIỀU KHIỂN
+// ============================================
+
+void FaceAnimator::setEmotion(Emotion emotion, float intensity, uint16_t ms, uint32_t nowMs) {
+    if (emotion >= EMOTION_COUNT) {
+        emotion = EMOTION_NEUTRAL;
+    }
+    intensity = constrain(intensity, 0.0f, 1.0f);
+    // Bắt đầu từ mặt đang hiển thị (có thể đang giữa một lần chuyển khác)
+    from = FaceParams::lerp(from, to, emotionBlend(nowMs));
+    to = FaceParams::lerp(EMOTION_FACES[EMOTION_NEUTRAL], EMOTION_FACES[emotion], intensity);
+    transitionStartMs = nowMs;
+    transitionMs = ms == 0 ? 1 : ms;
+    currentEmotion = emotion;
+    currentIntensity = intensity;
+}
+
+void FaceAnimator::setGaze(float x, float y, uint32_t holdMs, uint32_t nowMs) {
+    gazeTargetX = constrain(x, -1.0f, 1.0f);
+    gazeTargetY = constrain(y, -1.0f, 1.0f);
+    gazeHoldUntilMs = nowMs + holdMs;
+    nextSaccadeMs = gazeHoldUntilMs;
+}
+
+void FaceAnimator::blink(uint32_t nowMs) {
+    if (!blinking) {
+        blinking = true;
+        blinkStartMs = nowMs;
+    }
+}
+
+void FaceAnimator::setIdleMotion(bool enabled) {
+    idleMotion = enabled;
+}
+
+bool FaceAnimator::apply(JsonVariantConst payload, uint32_t nowMs) {
+    bool used = false;
+    const char *name = payload["emotion"].as<const char *>();
+    if (name == nullptr) {
+        name = payload["current_emotion"].as<const char *>();   // EmotionChangedMessage của Ai-Engine
+    }
+    if (name != nullptr) {
+        setEmotion(emotionFromName(name, currentEmotion), payload["intensity"] | 1.0f,
+                   payload["transitionMs"] | DEFAULT_TRANSITION_MS, nowMs);
+        used = true;
+    }
+    JsonVariantConst gaze = payload["gaze"];
+    if (gaze.is<JsonObjectConst>()) {
+        setGaze(gaze["x"] | 0.0f, gaze["y"] | 0.0f, gaze["holdMs"] | 2000, nowMs);
+        used = true;
+    }
+    if (payload["blink"] | false) {
+        blink(nowMs);
+        used = true;
+    }
+    return used;
+}
+
+// ============================================
+// CẬP NHẬT
+// ============================================
+
+float FaceAnimator::emotionBlend(uint32_t nowMs) const {
+    uint32_t elapsed = nowMs - transitionStartMs;
+    if (elapsed >= transitionMs) {
+        return 1.0f;
+    }
+    float t = (float)elapsed / transitionMs;
+    return t * t * (3.0f - 2.0f * t);          // smoothstep: nhanh ở giữa, êm ở hai đầu
+}
+
+// Nhắm nhanh, giữ một chút, mở chậm hơn
+float FaceAnimator::blinkFactor(uint32_t nowMs) const {
+    if (!blinking) {
+        return 1.0f;
+    }
+    uint32_t elapsed = nowMs - blinkStartMs;
+    if (elapsed < BLINK_CLOSE_MS) {
+        return 1.0f - (float)elapsed / BLINK_CLOSE_MS;
+    }
+    if (elapsed < BLINK_CLOSE_MS + BLINK_HOLD_MS) {
+        return 0.0f;
+    }
+    float open = (float)(elapsed - BLINK_CLOSE_MS - BLINK_HOLD_MS) / (BLINK_MS - BLINK_CLOSE_MS - BLINK_HOLD_MS);
+    return min(open, 1.0f);
+}
+
+bool FaceAnimator::update(uint32_t nowMs) {
+    if (blinking && nowMs - blinkStartMs >= BLINK_MS) {
+        blinking = false;
+        nextBlinkMs = nowMs + random(2000, 6000);
+    }
+    if (idleMotion && !blinking && (int32_t)(nowMs - nextBlinkMs) >= 0) {
+        blink(nowMs);
+    }
+
+    if (idleMotion && (int32_t)(nowMs - gazeHoldUntilMs) >= 0 && (int32_t)(nowMs - nextSaccadeMs) >= 0) {
+        // Phần lớn thời gian nhìn thẳng, thỉnh thoảng liếc sang một điểm gần
+        if (random(0, 9) < 3) {
+            gazeTargetX = 0;
+            gazeTargetY = 0;
+        } else {
+            gazeTargetX = ((int32_t)random(0, 120) - 60) / 100.0f;
+            gazeTargetY = ((int32_t)random(0, 80) - 40) / 100.0f;
+        }
+        nextSaccadeMs = nowMs + random(800, 3000);
+    }
+    float dt = started ? (float)(nowMs - lastUpdateMs) : 1e6f;
+    float alpha = dt / (GAZE_TAU_MS + dt);
+    gazeX += (gazeTargetX - gazeX) * alpha;
+    gazeY += (gazeTargetY - gazeY) * alpha;
+    lastUpdateMs = nowMs;
+
+    shown = FaceParams::lerp(from, to, emotionBlend(nowMs));
+    shown.eyeOpen *= blinkFactor(nowMs);
+    shown.gazeX = gazeX;
+    shown.gazeY = gazeY;
+
+    bool changed = !started;
+    const float *a = &shown.eyeOpen;
+    const float *b = &lastReported.eyeOpen;
+    for (uint8_t i = 0; !changed && i < sizeof(FaceParams) / sizeof(float); i++) {
+        changed = fabsf(a[i] - b[i]) > CHANGE_EPSILON;
+    }
+    if (changed) {
+        lastReported = shown;
+    }
+    started = true;
+    return changed;
+}
+
+const FaceParams &FaceAnimator::params() const {
+    return lastReported;
+}
+
+Emotion FaceAnimator::emotion() const {
+    return currentEmotion;
+}
+
+float FaceAnimator::intensity() const {
+    return currentIntensity;
+}
+
+bool FaceAnimator::isTransitioning(uint32_t nowMs) const {
+    return nowMs - transitionStartMs < transitionMs;
+}
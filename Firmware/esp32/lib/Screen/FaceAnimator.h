@@ -0,0 +1,124 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// ======================================================
+// 🙂 Tham số khuôn mặt: cảm xúc, chớp mắt, hướng nhìn
+// ======================================================
+//
+// Khuôn mặt là một bộ tham số chuẩn hoá (FaceParams), không phụ thuộc kích
+// thước màn hình; FaceCompositor vẽ từ đó. Mỗi cảm xúc là một preset, cường
+// độ nội suy từ NEUTRAL tới preset. Đổi cảm xúc thì nội suy smoothstep từ mặt
+// đang hiển thị sang mặt mới trong transitionMs, nên không có cảnh cắt cứng.
+//
+// Chớp mắt và liếc mắt (saccade) tự chạy với khoảng ngẫu nhiên; EMOTION_UPDATE
+// có thể đặt hướng nhìn cố định trong một khoảng hoặc yêu cầu chớp ngay.
+// update() trả về true chỉ khi mặt đổi đủ để phải vẽ lại.
+
+// Giống Emotion của Ai-Engine (src/utils/constants.py), thứ tự khớp với EMOTION_NAMES
+enum Emotion : uint8_t {
+    EMOTION_NEUTRAL = 0,
+    EMOTION_HAPPY,
+    EMOTION_SAD,
+    EMOTION_EXCITED,
+    EMOTION_CURIOUS,
+    EMOTION_CONFUSED,
+    EMOTION_SURPRISED,
+    EMOTION_ANGRY,
+    EMOTION_AFRAID,
+    EMOTION_COUNT
+};
+
+static const char *const EMOTION_NAMES[EMOTION_COUNT] = {
+    "neutral", "happy", "sad", "excited", "curious", "confused", "surprised", "angry", "afraid"
+};
+
+inline const char *emotionName(uint8_t emotion) {
+    return emotion < EMOTION_COUNT ? EMOTION_NAMES[emotion] : "neutral";
+}
+
+// Tên không biết thì trả về fallback
+inline Emotion emotionFromName(const char *name, Emotion fallback) {
+    for (uint8_t i = 0; name != nullptr && i < EMOTION_COUNT; i++) {
+        if (strcmp(name, EMOTION_NAMES[i]) == 0) {
+            return (Emotion)i;
+        }
+    }
+    return fallback;
+}
+
+struct FaceParams {
+    float eyeOpen;        // 0 nhắm .. 1 mở bình thường (>1 mở to)
+    float eyeSquint;      // 0 .. 1 mí dưới nâng lên (mắt cười)
+    float pupilScale;     // 1 = bình thường
+    float browHeight;     // -1 hạ thấp .. 1 nhướng cao
+    float browTilt;       // -1 đầu trong nhướng (buồn) .. 1 đầu trong cụp (giận)
+    float mouthCurve;     // -1 mếu .. 1 cười
+    float mouthOpen;      // 0 .. 1
+    float mouthWidth;     // 1 = bình thường
+    float gazeX;          // -1 trái .. 1 phải
+    float gazeY;          // -1 lên .. 1 xuống
+
+    static FaceParams lerp(const FaceParams &a, const FaceParams &b, float t);
+};
+
+// Preset của từng cảm xúc ở cường độ 1 (hướng nhìn = 0)
+extern const FaceParams EMOTION_FACES[EMOTION_COUNT];
+
+class FaceAnimator {
+public:
+    static const uint16_t DEFAULT_TRANSITION_MS = 300;
+    static const uint16_t BLINK_MS = 160;
+
+    FaceAnimator();
+
+    void setEmotion(Emotion emotion, float intensity, uint16_t transitionMs, uint32_t nowMs);
+    // Nhìn cố định về (x, y) trong holdMs, sau đó saccade tự do trở lại
+    void setGaze(float x, float y, uint32_t holdMs, uint32_t nowMs);
+    void blink(uint32_t nowMs);
+    // Chớp mắt và liếc tự động (mặc định bật)
+    void setIdleMotion(bool enabled);
+    void seed(uint32_t value);             // cho test: chuỗi ngẫu nhiên lặp lại được
+
+    // payload của EMOTION_UPDATE:
+    //   {"emotion"|"current_emotion": "happy", "intensity": 0..1, "transitionMs": 300,
+    //    "gaze": {"x": -1..1, "y": -1..1, "holdMs": 2000}, "blink": true}
+    // false nếu payload không có trường nào dùng được
+    bool apply(JsonVariantConst payload, uint32_t nowMs);
+
+    // Tính mặt tại nowMs; true nếu khác lần trả về trước đủ để vẽ lại
+    bool update(uint32_t nowMs);
+    const FaceParams &params() const;
+    Emotion emotion() const;
+    float intensity() const;
+    bool isTransitioning(uint32_t nowMs) const;
+
+private:
+    uint32_t random(uint32_t lo, uint32_t hi);
+    float blinkFactor(uint32_t nowMs) const;
+    float emotionBlend(uint32_t nowMs) const;
+
+    Emotion currentEmotion;
+    float currentIntensity;
+    FaceParams from;                       // mặt lúc bắt đầu chuyển
+    FaceParams to;
+    uint32_t transitionStartMs;
+    uint16_t transitionMs;
+
+    bool idleMotion;
+    uint32_t nextBlinkMs;
+    uint32_t blinkStartMs;
+    bool blinking;
+
+    float gazeX, gazeY;                    // vị trí mắt đang nhìn (đã làm mượt)
+    float gazeTargetX, gazeTargetY;
+    uint32_t nextSaccadeMs;
+    uint32_t gazeHoldUntilMs;
+    uint32_t lastUpdateMs;
+
+    FaceParams shown;                      // kết quả update(), kể cả chớp mắt
+    FaceParams lastReported;
+    bool started;
+    uint32_t rng;
+};
@@ -0,0 +1,214 @@
+#include "FaceCompositor.h"
+
+// Bố cục cho màn 240x240; lớp nằm gọn trong dải hàng của nhóm mình
+static const int16_t EYE_Y = 98;
+static const int16_t EYE_DX = 52;            // tâm mắt cách giữa màn hình
+static const int16_t EYE_RX = 30;
+static const int16_t EYE_RY = 34;
+static const int16_t PUPIL_R = 13;
+static const int16_t BROW_HALF = 26;
+static const int16_t BROW_THICK = 7;
+static const int16_t MOUTH_Y = 180;
+static const int16_t MOUTH_HALF = 40;
+static const int16_t EYE_TOP = 24;           // lông mày nhướng cao nhất
+static const int16_t EYE_BOTTOM = 146;       // mắt mở to nhất (eyeOpen 1.3)
+static const int16_t MOUTH_TOP = 150;
+static const int16_t MOUTH_BOTTOM = 228;
+
+static const float EYE_EPSILON = 0.004f;
+
+FaceCompositor::FaceCompositor(TFT_eSPI &display)
+: tft(display), strips{ TFT_eSprite(&display), TFT_eSprite(&display) },
+  ready(false), dma(false), fullRedraw(true), nextFrameMs(0),
+  drawn(EMOTION_FACES[EMOTION_NEUTRAL]), faceColor(TFT_CYAN), bgColor(TFT_BLACK),
+  renderedFrames(0), renderedStrips(0), frameHist(Metrics::histogram("face.frame_us")) {
+}
+
+bool FaceCompositor::begin(bool useDma) {
+    if (ready) {
+        return true;
+    }
+    for (uint8_t i = 0; i < 2; i++) {
+        strips[i].setColorDepth(16);
+        strips[i].setAttribute(PSRAM_ENABLE, false);        // DMA SPI chỉ đọc được RAM nội
+        if (strips[i].createSprite(tft.width(), STRIP_H) == nullptr) {
+            strips[0].deleteSprite();
+            Serial.println("[Face] Not enough RAM for strip sprites");
+            return false;
+        }
+    }
+    dma = useDma;
+    ready = true;
+    fullRedraw = true;
+    return true;
+}
+
+void FaceCompositor::invalidate() {
+    fullRedraw = true;
+    nextFrameMs = millis();
+}
+
+uint32_t FaceCompositor::msUntilNextFrame() const {
+    int32_t remaining = (int32_t)(nextFrameMs - millis());
+    return remaining > 0 ? (uint32_t)remaining : 0;
+}
+
+FaceAnimator &FaceCompositor::animator() {
+    return anim;
+}
+
+void FaceCompositor::setColors(uint16_t face, uint16_t background) {
+    faceColor = face;
+    bgColor = background;
+    fullRedraw = true;
+}
+
+uint32_t FaceCompositor::getRenderedFrames() const {
+    return renderedFrames;
+}
+
+uint32_t FaceCompositor::getRenderedStrips() const {
+    return renderedStrips;
+}
+
+// ============================================
+// FRAME
+// ============================================
+
+void FaceCompositor::tick() {
+    uint32_t now = millis();
+    if (!ready || (int32_t)(now - nextFrameMs) < 0) {
+        return;
+    }
+    nextFrameMs = now + FRAME_MS;
+    if (!anim.update(now) && !fullRedraw) {
+        return;
+    }
+    const FaceParams &p = anim.params();
+    render(p, eyesDiffer(p, drawn), mouthDiffers(p, drawn));
+    drawn = p;
+    fullRedraw = false;
+}
+
+bool FaceCompositor::eyesDiffer(const FaceParams &a, const FaceParams &b) {
+    const float *pa = &a.eyeOpen;
+    const float *pb = &b.eyeOpen;
+    // eyeOpen .. browTilt, rồi gazeX, gazeY
+    for (uint8_t i = 0; i < 5; i++) {
+        if (fabsf(pa[i] - pb[i]) > EYE_EPSILON) {
+            return true;
+        }
+    }
+    return fabsf(a.gazeX - b.gazeX) > EYE_EPSILON || fabsf(a.gazeY - b.gazeY) > EYE_EPSILON;
+}
+
+bool FaceCompositor::mouthDiffers(const FaceParams &a, const FaceParams &b) {
+    return fabsf(a.mouthCurve - b.mouthCurve) > EYE_EPSILON || fabsf(a.mouthOpen - b.mouthOpen) > EYE_EPSILON ||
+           fabsf(a.mouthWidth - b.mouthWidth) > EYE_EPSILON;
+}
+
+void FaceCompositor::render(const FaceParams &p, bool eyesDirty, bool mouthDirty) {
+    CycleTimer timer(frameHist);
+    int16_t height = tft.height();
+    uint8_t next = 0;
+    bool writing = false;
+
+    for (int16_t y = 0; y < height; y += STRIP_H) {
+        int16_t bottom = y + STRIP_H;
+        bool dirty = fullRedraw ||
+                     (eyesDirty && bottom > EYE_TOP && y < EYE_BOTTOM) ||
+                     (mouthDirty && bottom > MOUTH_TOP && y < MOUTH_BOTTOM);
+        if (!dirty) {
+            continue;
+        }
+        // Dải trước đó ở sprite này đã đẩy xong: pushImageDMA chờ DMA cũ trước khi bắt đầu DMA mới
+        TFT_eSprite &strip = strips[next];
+        next ^= 1;
+        drawStrip(strip, y, p);
+        uint16_t rows = min<int16_t>(STRIP_H, height - y);
+        if (dma) {
+            if (!writing) {
+                tft.startWrite();
+                writing = true;
+            }
+            // Sprite 16 bit đã lưu sẵn thứ tự byte SPI: tft không được bật swapBytes
+            tft.pushImageDMA(0, y, tft.width(), rows, (uint16_t *)strip.getPointer());
+        } else {
+            strip.pushSprite(0, y);
+        }
+        renderedStrips++;
+    }
+    if (writing) {
+        tft.dmaWait();
+        tft.endWrite();
+    }
+    renderedFrames++;
+}
+
+// ============================================
+// CÁC LỚP
+// ============================================
+
+void FaceCompositor::drawStrip(TFT_eSprite &s, int16_t y, const FaceParams &p) {
+    s.fillSprite(bgColor);
+    int16_t bottom = y + STRIP_H;
+    int16_t cx = tft.width() / 2;
+    if (bottom > EYE_TOP && y < EYE_BOTTOM) {
+        drawEye(s, cx - EYE_DX, EYE_Y - y, p);
+        drawEye(s, cx + EYE_DX, EYE_Y - y, p);
+        drawBrow(s, cx - EYE_DX, EYE_Y - y, p, -1);
+        drawBrow(s, cx + EYE_DX, EYE_Y - y, p, 1);
+    }
+    if (bottom > MOUTH_TOP && y < MOUTH_BOTTOM) {
+        drawMouth(s, MOUTH_Y - y, p);
+    }
+}
+
+// Lòng mắt -> con ngươi -> mí dưới (mắt cười); cy đã trừ toạ độ dải, sprite tự cắt phần ngoài dải
+void FaceCompositor::drawEye(TFT_eSprite &s, int16_t cx, int16_t cy, const FaceParams &p) {
+    int16_t ry = (int16_t)(EYE_RY * constrain(p.eyeOpen, 0.0f, 1.3f));
+    int16_t rx = (int16_t)(EYE_RX * (1.0f + (p.eyeOpen - 1.0f) * 0.3f));
+    if (ry < 3) {
+        s.fillRect(cx - rx, cy - 1, 2 * rx, 3, faceColor);      // nhắm: một vạch
+        return;
+    }
+    s.fillEllipse(cx, cy, rx, ry, faceColor);
+
+    int16_t r = (int16_t)(PUPIL_R * p.pupilScale);
+    if (ry > r + 2) {
+        int16_t px = cx + (int16_t)(p.gazeX * (rx - r - 2));
+        int16_t py = cy + (int16_t)(p.gazeY * (ry - r - 2));
+        s.fillCircle(px, py, r, bgColor);
+        s.fillCircle(px - r / 3, py - r / 3, max<int16_t>(r / 4, 1), faceColor);   // đốm sáng
+    }
+
+    if (p.eyeSquint > 0.02f) {
+        // Mí dưới là elip nền có đỉnh nâng lên theo squint, tạo mắt hình "^"
+        int16_t lidR = (int16_t)(rx * 1.2f);
+        int16_t lidTop = cy + ry - (int16_t)(2 * ry * p.eyeSquint * 0.6f);
+        s.fillEllipse(cx, lidTop + lidR, (int16_t)(rx * 1.4f), lidR, bgColor);
+    }
+}
+
+// Thanh nghiêng: đầu trong (phía giữa mặt) hạ xuống khi browTilt > 0
+void FaceCompositor::drawBrow(TFT_eSprite &s, int16_t cx, int16_t cy, const FaceParams &p, int8_t side) {
+    int16_t base = cy - EYE_RY - 16 - (int16_t)(p.browHeight * 12);
+    for (int16_t dx = -BROW_HALF; dx <= BROW_HALF; dx++) {
+        float u = (float)(-side * dx) / BROW_HALF;               // +1 ở đầu trong
+        int16_t top = base + (int16_t)(p.browTilt * 10 * u);
+        s.drawFastVLine(cx + dx, top, BROW_THICK, faceColor);
+    }
+}
+
+// Đường cong parabol; mở miệng = cột dày dần về giữa
+void FaceCompositor::drawMouth(TFT_eSprite &s, int16_t cy, const FaceParams &p) {
+    int16_t half = (int16_t)(MOUTH_HALF * p.mouthWidth);
+    int16_t cx = tft.width() / 2;
+    for (int16_t dx = -half; dx <= half; dx++) {
+        float u = (float)dx / half;
+        float shape = 1.0f - u * u;
+        int16_t top = cy + (int16_t)(p.mouthCurve * 14 * (shape - 0.5f));
+        int16_t thick = 5 + (int16_t)(p.mouthOpen * 28 * shape);
+        s.drawFastVLine(cx + dx, top, thick, faceColor);
+    }
+}
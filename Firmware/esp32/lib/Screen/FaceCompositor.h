@@ -0,0 +1,64 @@
+#pragma once
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include "FaceAnimator.h"
+#include "Metrics.h"
+
+// ======================================================
+// 🎭 Vẽ khuôn mặt bằng các lớp tham số vào sprite theo dải
+// ======================================================
+//
+// Thay cho clip vẽ sẵn: mỗi frame, các lớp mắt -> con ngươi -> mí -> lông
+// mày -> miệng được vẽ từ FaceParams bằng primitive của TFT_eSprite vào một
+// dải STRIP_H hàng, rồi đẩy dải đó bằng DMA. Hai sprite dải ping-pong nhau:
+// trong lúc DMA đẩy dải này thì CPU vẽ dải kế tiếp. Không cần asset nào
+// trong flash, nên số biểu cảm không bị giới hạn.
+//
+// Chỉ vẽ lại dải cắt qua lớp đã đổi (chớp mắt chỉ vẽ vùng mắt, nói chỉ vẽ
+// vùng miệng); frame mà FaceAnimator báo không đổi thì bỏ hẳn.
+
+class FaceCompositor {
+public:
+    static const uint16_t STRIP_H = 24;                // 240 x 24 x 2 B = 11.25 KB mỗi dải
+    static const uint16_t FRAME_MS = 33;               // ~30 fps
+
+    explicit FaceCompositor(TFT_eSPI &tft);
+
+    // Cấp 2 sprite dải trong RAM nội (DMA không đọc được PSRAM); useDma = tft.initDMA() đã thành công
+    bool begin(bool useDma);
+    // Vẽ frame kế tiếp nếu tới hạn và mặt có thay đổi
+    void tick();
+    // Vẽ lại toàn bộ ở frame kế tiếp (sau khi video/khác vẽ đè lên màn hình)
+    void invalidate();
+    uint32_t msUntilNextFrame() const;
+
+    FaceAnimator &animator();
+    void setColors(uint16_t face, uint16_t background);
+    uint32_t getRenderedFrames() const;
+    uint32_t getRenderedStrips() const;
+
+private:
+    void render(const FaceParams &p, bool eyesDirty, bool mouthDirty);
+    void drawStrip(TFT_eSprite &strip, int16_t y, const FaceParams &p);
+    void drawEye(TFT_eSprite &s, int16_t cx, int16_t cy, const FaceParams &p);
+    void drawBrow(TFT_eSprite &s, int16_t cx, int16_t cy, const FaceParams &p, int8_t side);
+    void drawMouth(TFT_eSprite &s, int16_t cy, const FaceParams &p);
+    static bool eyesDiffer(const FaceParams &a, const FaceParams &b);
+    static bool mouthDiffers(const FaceParams &a, const FaceParams &b);
+
+    TFT_eSPI &tft;
+    TFT_eSprite strips[2];
+    bool ready;
+    bool dma;
+    bool fullRedraw;
+    uint32_t nextFrameMs;
+    FaceAnimator anim;
+    FaceParams drawn;                // mặt đang hiển thị
+    uint16_t faceColor;
+    uint16_t bgColor;
+
+    uint32_t renderedFrames;
+    uint32_t renderedStrips;
+    Histogram *frameHist;            // vẽ + đẩy một frame (µs)
+};
@@ -0,0 +1,140 @@
+#include "FrameCache.h"
+#include <esp_heap_caps.h>
+
+FrameCache::FrameCache()
+: numSlots(0), width(0), height(0), useCounter(0), pending(-1), pendingClip(nullptr), hits(0), misses(0), evictions(0) {}
+
+bool FrameCache::begin(uint16_t w, uint16_t h, size_t maxBytes) {
+    width = w;
+    height = h;
+    size_t frameBytes = (size_t)w * h * sizeof(uint16_t);
+
+    size_t freePsram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    if (maxBytes == 0) {
+        maxBytes = freePsram / 2;
+    }
+    maxBytes = min(maxBytes, freePsram);
+
+    numSlots = 0;
+    while (numSlots < MAX_SLOTS && (numSlots + 1) * frameBytes <= maxBytes) {
+        uint16_t *pixels = (uint16_t *)heap_caps_malloc(frameBytes, MALLOC_CAP_SPIRAM);
+        if (!pixels) {
+            break;
+        }
+        slots[numSlots++] = { pixels, nullptr, 0, 0 };
+    }
+
+    // Cần ít nhất 2 slot: frame đang hiển thị làm nền cho frame kế tiếp
+    if (numSlots < 2) {
+        for (uint8_t i = 0; i < numSlots; i++) {
+            heap_caps_free(slots[i].pixels);
+        }
+        numSlots = 0;
+        return false;
+    }
+    Serial.printf("[FrameCache] %u slots (%u KB PSRAM)\n", numSlots, (unsigned)(numSlots * frameBytes / 1024));
+    return true;
+}
+
+bool FrameCache::isEnabled() const {
+    return numSlots > 0;
+}
+
+const uint16_t *FrameCache::lookup(const void *clip, uint16_t frame) {
+    for (uint8_t i = 0; i < numSlots; i++) {
+        if (slots[i].clip == clip && slots[i].frame == frame) {
+            slots[i].lastUse = ++useCounter;
+            hits++;
+            return slots[i].pixels;
+        }
+    }
+    misses++;
+    return nullptr;
+}
+
+uint16_t *FrameCache::beginInsert(const void *clip, uint16_t frame, const uint16_t *base) {
+    if (!isEnabled()) {
+        return nullptr;
+    }
+    uint8_t victim = 0;
+    for (uint8_t i = 1; i < numSlots; i++) {
+        if (slots[i].lastUse < slots[victim].lastUse) {
+            victim = i;
+        }
+    }
+    Slot &slot = slots[victim];
+    if (slot.clip != nullptr) {
+        evictions++;
+    }
+
+    size_t frameBytes = (size_t)width * height * sizeof(uint16_t);
+    if (base == nullptr) {
+        memset(slot.pixels, 0, frameBytes);
+    } else if (base != slot.pixels) {
+        memcpy(slot.pixels, base, frameBytes);
+    }
+    slot.clip = nullptr;         // chỉ hợp lệ sau commitInsert()
+    slot.frame = frame;
+    slot.lastUse = ++useCounter;
+    pending = victim;
+    pendingClip = clip;
+    return slot.pixels;
+}
+
+void FrameCache::record(int16_t x, int16_t y, uint16_t w, uint16_t h, const uint16_t *bitmap) {
+    if (pending < 0 || x >= width || y >= height) {
+        return;
+    }
+    uint16_t visW = min<int32_t>(w, width - x);
+    uint16_t visH = min<int32_t>(h, height - y);
+    uint16_t *dst = slots[pending].pixels + (size_t)y * width + x;
+    for (uint16_t row = 0; row < visH; row++) {
+        memcpy(dst + (size_t)row * width, bitmap + row * w, visW * sizeof(uint16_t));
+    }
+}
+
+const uint16_t *FrameCache::commitInsert(bool complete) {
+    if (pending < 0) {
+        return nullptr;
+    }
+    Slot &slot = slots[pending];
+    pending = -1;
+    if (!complete) {
+        slot.lastUse = 0;        // slot rác, dùng lại đầu tiên
+        return nullptr;
+    }
+    slot.clip = pendingClip;
+    return slot.pixels;
+}
+
+bool FrameCache::isRecording() const {
+    return pending >= 0;
+}
+
+void FrameCache::clear() {
+    for (uint8_t i = 0; i < numSlots; i++) {
+        slots[i].clip = nullptr;
+        slots[i].lastUse = 0;
+    }
+    pending = -1;
+}
+
+uint8_t FrameCache::getSlots() const {
+    return numSlots;
+}
+
+uint32_t FrameCache::getHits() const {
+    return hits;
+}
+
+uint32_t FrameCache::getMisses() const {
+    return misses;
+}
+
+uint32_t FrameCache::getEvictions() const {
+    return evictions;
+}
+
+void FrameCache::resetStats() {
+    hits = misses = evictions = 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ======================================================
+// 🧠 Cache LRU các frame RGB565 đã decode (PSRAM)
+// ======================================================
+//
+// Mỗi slot giữ nguyên một frame width x height (row-major, thứ tự byte SPI).
+// Khoá = (clip, số frame). Khi hit, Screen chỉ việc chép tile từ PSRAM sang
+// buffer DMA, không decode lại JPEG/HGA1.
+
+class FrameCache {
+public:
+    static const uint8_t MAX_SLOTS = 32;
+
+    FrameCache();
+
+    // maxBytes = 0: tự dùng một nửa PSRAM còn trống. Trả về false nếu không có PSRAM
+    bool begin(uint16_t width, uint16_t height, size_t maxBytes = 0);
+    bool isEnabled() const;
+
+    // Hit → con trỏ tới frame, đồng thời đánh dấu vừa dùng
+    const uint16_t *lookup(const void *clip, uint16_t frame);
+
+    // Lấy slot LRU cho frame sắp decode, khởi tạo từ `base` (nội dung màn hình) hoặc đen
+    uint16_t *beginInsert(const void *clip, uint16_t frame, const uint16_t *base);
+    void record(int16_t x, int16_t y, uint16_t w, uint16_t h, const uint16_t *bitmap);
+    // complete = false khi slot không chắc đúng nội dung (ví dụ delta chưa có nền) → huỷ
+    const uint16_t *commitInsert(bool complete);
+    bool isRecording() const;
+
+    void clear();
+
+    uint8_t getSlots() const;
+    uint32_t getHits() const;
+    uint32_t getMisses() const;
+    uint32_t getEvictions() const;
+    void resetStats();
+
+private:
+    struct Slot {
+        uint16_t *pixels;
+        const void *clip;        // nullptr = trống
+        uint16_t frame;
+        uint32_t lastUse;
+    };
+
+    Slot slots[MAX_SLOTS];
+    uint8_t numSlots;
+    uint16_t width;
+    uint16_t height;
+    uint32_t useCounter;
+    int8_t pending;              // slot đang ghi, -1 = không
+    const void *pendingClip;     // khoá của slot đang ghi, gắn vào khi commit
+
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+};
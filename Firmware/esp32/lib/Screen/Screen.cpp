@@ -1,8 +1,11 @@
 #include "Screen.h"
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
 #include "video11.h"
 //#include "video10.h"
+// Clip HGA1 nhỏ hơn nhiều: sinh bằng tools/video2delta.py rồi #include "videoNN_delta.h"
 
-VideoInfo * const videoList[] = { 
+VideoInfo * const videoList[] = {
 &video11,
 //&video10
 };
@@ -11,30 +14,32 @@ const uint8_t NUM_VIDEOS = sizeof(videoList) / sizeof(videoList[0]);
 Screen *globalPlayerInstance = nullptr;
 
 Screen::Screen()
-: tft(TFT_eSPI()), videoList(::videoList), numVideos(NUM_VIDEOS) {}
+: tft(TFT_eSPI()), videoList(::videoList), numVideos(NUM_VIDEOS),
+  current{nullptr, 0, false}, frameCount(0), frameIndex(0), playing(false), paused(false), asleep(false), nextFrameUs(0),
+  frameHist(Metrics::histogram("screen.frame_us")), lateFrames(Metrics::counter("screen.late_frames")),
+  queueHead(0), queueCount(0),
+  freeBatches(nullptr), readyBatches(nullptr), fillIndex(-1), pipelineEnabled(false),
+  dirtyTilesEnabled(true), pushedTiles(0), skippedTiles(0), shownFrame(nullptr),
+  faceLayer(tft), faceReady(false), faceMode(false) {
+    batches[0].pixels = nullptr;
+    batches[1].pixels = nullptr;
+    invalidate();
+}
 
 // ✅ Kiểu callback trùng khớp hoàn toàn với TJpg_Decoder
 bool Screen::tft_output(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap) {
-    static TFT_eSPI *tftPtr = nullptr;
-
-    if (!tftPtr) {
-        extern Screen *globalPlayerInstance;
-        if (globalPlayerInstance) {
-            tftPtr = &(globalPlayerInstance->tft);
-        } else {
-            return false;
-        }
+    extern Screen *globalPlayerInstance;
+    if (!globalPlayerInstance) {
+        return false;
     }
-
-    if (y >= tftPtr->height()) return false;
-    tftPtr->pushImage(x, y, w, h, bitmap);
-    return true;
+    return globalPlayerInstance->emitBlock(x, y, w, h, bitmap);
 }
 
 void Screen::begin() {
     tft.begin();
     tft.setRotation(4);
     tft.fillScreen(TFT_BLACK);
+    invalidate();
 
     extern Screen *globalPlayerInstance;
     globalPlayerInstance = this;
@@ -42,20 +47,510 @@ void Screen::begin() {
     TJpgDec.setJpgScale(1);
     TJpgDec.setSwapBytes(true);
     TJpgDec.setCallback(tft_output);  // ✅ không còn lỗi
+
+#if SCREEN_FRAME_CACHE
+    frameCache.begin(tft.width(), tft.height());
+#endif
+
+#if SCREEN_DMA_PIPELINE
+    pipelineEnabled = beginPipeline();
+    if (!pipelineEnabled) {
+        Serial.println("[Screen] DMA pipeline unavailable, using blocking pushImage");
+    }
+#endif
+    faceReady = faceLayer.begin(pipelineEnabled);
 }
 
-void Screen::playVideo(const VideoInfo &video, uint16_t delay_ms, bool loop_forever) {
-    do {
-        for (uint16_t i = 0; i < video.num_frames; i++) {
-            const uint8_t *jpg_data = (const uint8_t *)pgm_read_ptr(&video.frames[i]);
-            uint16_t jpg_size = pgm_read_word(&video.frame_sizes[i]);
+// ============================================
+// DECODE → DMA PIPELINE
+// ============================================
+
+bool Screen::beginPipeline() {
+    if (!tft.initDMA()) {
+        return false;
+    }
+    for (uint8_t i = 0; i < 2; i++) {
+        batches[i].pixels = (uint16_t *)heap_caps_malloc(BATCH_PIXELS * sizeof(uint16_t), MALLOC_CAP_DMA);
+        if (!batches[i].pixels) {
+            releasePipeline();
+            return false;
+        }
+    }
+
+    freeBatches = xQueueCreate(2, sizeof(uint8_t));
+    readyBatches = xQueueCreate(2, sizeof(uint8_t));
+    if (!freeBatches || !readyBatches) {
+        releasePipeline();
+        return false;
+    }
+    for (uint8_t i = 0; i < 2; i++) {
+        xQueueSend(freeBatches, &i, 0);
+    }
+
+    // Core push là core không chạy decode (loop() của Arduino chạy ở core 1)
+    BaseType_t pushCore = 1 - xPortGetCoreID();
+    if (xTaskCreatePinnedToCore(pushTask, "screen_push", 3072, this, 2, nullptr, pushCore) != pdPASS) {
+        releasePipeline();
+        return false;
+    }
+    return true;
+}
+
+void Screen::releasePipeline() {
+    // Chỉ gọi khi chưa có task push: không ai còn giữ buffer hay chờ trên queue
+    for (uint8_t i = 0; i < 2; i++) {
+        heap_caps_free(batches[i].pixels);
+        batches[i].pixels = nullptr;
+    }
+    if (freeBatches) {
+        vQueueDelete(freeBatches);
+        freeBatches = nullptr;
+    }
+    if (readyBatches) {
+        vQueueDelete(readyBatches);
+        readyBatches = nullptr;
+    }
+    tft.deInitDMA();
+}
+
+bool Screen::emitBlock(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap) {
+    if (y >= tft.height()) return false;   // phần còn lại nằm ngoài màn hình, dừng decode
+    if (x >= tft.width()) return true;
+
+    frameCache.record(x, y, w, h, bitmap);
+
+    if (dirtyTilesEnabled && isUnchanged(x, y, w, h, bitmap)) {
+        skippedTiles++;
+        return true;
+    }
+    pushedTiles++;
 
-            if (!TJpgDec.drawJpg(0, 0, jpg_data, jpg_size)) {
-                //Serial.printf("❌ Decode failed at frame %u\n", i);
+    if (!pipelineEnabled) {
+        tft.pushImage(x, y, w, h, bitmap);
+        return true;
+    }
+
+    uint16_t visW = min<int32_t>(w, tft.width() - x);
+    uint16_t visH = min<int32_t>(h, tft.height() - y);
+    uint16_t pixels = visW * visH;
+    if (pixels > BATCH_PIXELS) {
+        flushPipeline();
+        tft.pushImage(x, y, w, h, bitmap);
+        return true;
+    }
+
+    if (fillIndex >= 0) {
+        BlockBatch &full = batches[fillIndex];
+        if (full.count >= BATCH_MAX_BLOCKS || full.used + pixels > BATCH_PIXELS) {
+            submitBatch();
+        }
+    }
+    if (fillIndex < 0) {
+        uint8_t idx;
+        xQueueReceive(freeBatches, &idx, portMAX_DELAY);   // chờ core push trả buffer
+        fillIndex = idx;
+        batches[idx].count = 0;
+        batches[idx].used = 0;
+    }
+
+    // Chép block sang buffer DMA (cắt phần tràn màn hình), bitmap của TJpgDec được tái sử dụng ngay
+    BlockBatch &batch = batches[fillIndex];
+    uint16_t *dst = batch.pixels + batch.used;
+    for (uint16_t row = 0; row < visH; row++) {
+        memcpy(dst + row * visW, bitmap + row * w, visW * sizeof(uint16_t));
+    }
+    batch.blocks[batch.count++] = { x, y, visW, visH, batch.used };
+    batch.used += pixels;
+    return true;
+}
+
+void Screen::submitBatch() {
+    if (fillIndex < 0) {
+        return;
+    }
+    uint8_t idx = fillIndex;
+    fillIndex = -1;
+    if (batches[idx].count == 0) {
+        xQueueSend(freeBatches, &idx, 0);
+        return;
+    }
+    xQueueSend(readyBatches, &idx, portMAX_DELAY);
+}
+
+void Screen::flushPipeline() {
+    if (!pipelineEnabled) {
+        return;
+    }
+    submitBatch();
+    // Lấy lại cả 2 buffer = core push đã đẩy xong mọi thứ
+    uint8_t idx[2];
+    for (uint8_t i = 0; i < 2; i++) {
+        xQueueReceive(freeBatches, &idx[i], portMAX_DELAY);
+    }
+    for (uint8_t i = 0; i < 2; i++) {
+        xQueueSend(freeBatches, &idx[i], 0);
+    }
+}
+
+void Screen::pushTask(void *arg) {
+    Screen *self = static_cast<Screen *>(arg);
+    uint8_t idx;
+
+    for (;;) {
+        if (xQueueReceive(self->readyBatches, &idx, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        BlockBatch &batch = self->batches[idx];
+
+        self->tft.startWrite();
+        for (uint8_t i = 0; i < batch.count; i++) {
+            const BlockDesc &b = batch.blocks[i];
+            // pushImageDMA tự chờ DMA trước đó xong rồi mới bắt đầu block mới
+            self->tft.pushImageDMA(b.x, b.y, b.w, b.h, batch.pixels + b.offset);
+        }
+        self->tft.dmaWait();
+        self->tft.endWrite();
+
+        xQueueSend(self->freeBatches, &idx, portMAX_DELAY);
+    }
+}
+
+// ============================================
+// DIRTY TILES
+// ============================================
+
+bool Screen::isUnchanged(int16_t x, int16_t y, uint16_t w, uint16_t h, const uint16_t *bitmap) {
+    // Chỉ theo dõi block căn lưới 16 (MCU 4:2:0 và tile HGA1), block khác luôn được vẽ
+    if (x % DIRTY_TILE || y % DIRTY_TILE || w > DIRTY_TILE || h > DIRTY_TILE) {
+        return false;
+    }
+    uint16_t cell = (y / DIRTY_TILE) * DIRTY_GRID + (x / DIRTY_TILE);
+    if (x / DIRTY_TILE >= DIRTY_GRID || cell >= DIRTY_GRID * DIRTY_GRID) {
+        return false;
+    }
+
+    // FNV-1a trên từng cặp pixel, kích thước block góp vào hash
+    uint32_t hash = 2166136261u ^ ((uint32_t)w << 8 | h);
+    uint32_t count = (uint32_t)w * h;
+    const uint16_t *p = bitmap;
+    for (uint32_t i = 0; i + 1 < count; i += 2, p += 2) {
+        hash = (hash ^ ((uint32_t)p[0] << 16 | p[1])) * 16777619u;
+    }
+    if (count & 1) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    hash |= 1;                   // 0 dành cho "chưa biết"
+
+    if (tileHash[cell] == hash) {
+        return true;
+    }
+    tileHash[cell] = hash;
+    return false;
+}
+
+void Screen::setDirtyTiles(bool enable) {
+    dirtyTilesEnabled = enable;
+    invalidate();
+}
+
+void Screen::invalidate() {
+    memset(tileHash, 0, sizeof(tileHash));
+    shownFrame = nullptr;
+}
+
+uint32_t Screen::getPushedTiles() const {
+    return pushedTiles;
+}
+
+uint32_t Screen::getSkippedTiles() const {
+    return skippedTiles;
+}
+
+const FrameCache &Screen::getFrameCache() const {
+    return frameCache;
+}
+
+// ============================================
+// FRAME SCHEDULER
+// ============================================
+
+void Screen::play(const VideoInfo &video, uint16_t frame_ms, bool loop) {
+    if (faceMode) {
+        // Mặt vẽ trực tiếp lên tft, video không biết nội dung đó
+        faceMode = false;
+        invalidate();
+    }
+    PlayRequest req = { &video, (uint32_t)frame_ms * 1000, loop };
+    startRequest(req);
+    nextFrameUs = esp_timer_get_time();   // frame đầu tiên phát ngay ở tick() kế tiếp
+}
+
+bool Screen::queue(const VideoInfo &video, uint16_t frame_ms, bool loop) {
+    if (!playing) {
+        play(video, frame_ms, loop);
+        return true;
+    }
+    if (queueCount >= QUEUE_SIZE) {
+        return false;
+    }
+    uint8_t tail = (queueHead + queueCount) % QUEUE_SIZE;
+    pending[tail] = { &video, (uint32_t)frame_ms * 1000, loop };
+    queueCount++;
+    return true;
+}
+
+void Screen::pause() {
+    paused = true;
+}
+
+void Screen::resume() {
+    if (paused) {
+        paused = false;
+        nextFrameUs = esp_timer_get_time();
+    }
+}
+
+void Screen::stop() {
+    playing = false;
+    paused = false;
+    queueCount = 0;
+}
+
+bool Screen::showFace() {
+    if (!faceReady) {
+        return false;
+    }
+    stop();
+    flushPipeline();
+    faceMode = true;
+    faceLayer.invalidate();
+    return true;
+}
+
+bool Screen::isFaceMode() const {
+    return faceMode;
+}
+
+FaceAnimator &Screen::face() {
+    return faceLayer.animator();
+}
+
+void Screen::sleep() {
+    if (asleep) {
+        return;
+    }
+    flushPipeline();
+    // Panel giữ nguyên RAM hình khi SLPIN nên lúc dậy không cần vẽ lại
+    tft.writecommand(TFT_DISPOFF);
+    tft.writecommand(TFT_SLPIN);
+#ifdef TFT_BL
+    digitalWrite(TFT_BL, !TFT_BACKLIGHT_ON);
+#endif
+    asleep = true;
+}
+
+void Screen::wake() {
+    if (!asleep) {
+        return;
+    }
+    tft.writecommand(TFT_SLPOUT);
+    delay(5);                    // ST7789: chờ 5 ms sau SLPOUT trước lệnh kế tiếp
+    tft.writecommand(TFT_DISPON);
+#ifdef TFT_BL
+    digitalWrite(TFT_BL, TFT_BACKLIGHT_ON);
+#endif
+    asleep = false;
+    nextFrameUs = esp_timer_get_time();
+}
+
+bool Screen::isAsleep() const {
+    return asleep;
+}
+
+bool Screen::isPlaying() const {
+    return playing;
+}
+
+bool Screen::isPaused() const {
+    return paused;
+}
+
+uint32_t Screen::msUntilNextFrame() const {
+    if (asleep) {
+        return UINT32_MAX;
+    }
+    if (faceMode) {
+        return faceLayer.msUntilNextFrame();
+    }
+    if (!playing || paused) {
+        return UINT32_MAX;
+    }
+    int64_t remaining = nextFrameUs - esp_timer_get_time();
+    return remaining > 0 ? (uint32_t)(remaining / 1000) : 0;
+}
+
+void Screen::tick() {
+    if (asleep) {
+        return;
+    }
+    if (faceMode) {
+        faceLayer.tick();
+        return;
+    }
+    if (!playing || paused) {
+        return;
+    }
+    if (esp_timer_get_time() < nextFrameUs) {
+        return;
+    }
+
+    {
+        CycleTimer timer(frameHist);
+        drawFrame(*current.video, frameIndex);
+    }
+
+    // Mốc frame sau tính từ mốc cũ, không tính từ lúc decode xong,
+    // nên thời gian decode được trừ vào chu kỳ thay vì cộng thêm.
+    nextFrameUs += current.frame_us;
+    int64_t now = esp_timer_get_time();
+    if (nextFrameUs < now) {
+        nextFrameUs = now;   // decode chậm hơn chu kỳ: bắt nhịp lại, không phát dồn
+        lateFrames->add();
+    }
+
+    if (++frameIndex >= frameCount) {
+        PlayRequest next;
+        if (popQueue(next)) {
+            startRequest(next);           // video lặp cũng nhường chỗ khi hết một vòng
+        } else if (current.loop) {
+            frameIndex = 0;
+        } else {
+            playing = false;
+        }
+    }
+}
+
+void Screen::startRequest(const PlayRequest &req) {
+    current = req;
+    frameIndex = 0;
+    frameCount = 0;
+    paused = false;
+
+    file.close();
+    if (req.video != nullptr) {
+        if (req.video->format == VIDEO_FILE) {
+            if (file.open(req.video->path)) {
+                frameCount = file.numFrames();
             }
-            delay(delay_ms);
+        } else {
+            frameCount = req.video->num_frames;
         }
-    } while (loop_forever);
+    }
+    playing = frameCount > 0;
+}
+
+bool Screen::popQueue(PlayRequest &req) {
+    if (queueCount == 0) {
+        return false;
+    }
+    req = pending[queueHead];
+    queueHead = (queueHead + 1) % QUEUE_SIZE;
+    queueCount--;
+    return true;
+}
+
+void Screen::drawFrame(const VideoInfo &video, uint16_t index) {
+    if (!frameCache.isEnabled()) {
+        decodeFrame(video, index);
+        return;
+    }
+
+    const uint16_t *cached = frameCache.lookup(&video, index);
+    if (cached) {
+        drawCachedFrame(cached);
+        shownFrame = cached;
+        return;
+    }
+
+    // Chỉ nạp cache cho clip lặp (idle, listening...), clip chạy 1 lần không đẩy chúng ra
+    if (!current.loop) {
+        decodeFrame(video, index);
+        shownFrame = nullptr;
+        return;
+    }
+
+    // Frame delta chỉ đúng khi có nền là frame trước; JPEG và frame 0 tự đầy đủ
+    bool delta = video.format == VIDEO_DELTA || (video.format == VIDEO_FILE && file.isDelta());
+    bool selfContained = !delta || index == 0;
+
+    frameCache.beginInsert(&video, index, shownFrame);
+    decodeFrame(video, index);
+    shownFrame = frameCache.commitInsert(selfContained || shownFrame != nullptr);
+}
+
+void Screen::drawCachedFrame(const uint16_t *pixels) {
+    // Chép từng tile 16x16 ra RAM trong rồi đi qua đường xuất chung (dirty-tile + DMA)
+    uint16_t tile[DIRTY_TILE * DIRTY_TILE];
+    int16_t width = tft.width();
+    int16_t height = tft.height();
+
+    for (int16_t y = 0; y < height; y += DIRTY_TILE) {
+        uint16_t h = min<int32_t>(DIRTY_TILE, height - y);
+        for (int16_t x = 0; x < width; x += DIRTY_TILE) {
+            uint16_t w = min<int32_t>(DIRTY_TILE, width - x);
+            for (uint16_t row = 0; row < h; row++) {
+                memcpy(tile + row * w, pixels + (size_t)(y + row) * width + x, w * sizeof(uint16_t));
+            }
+            emitBlock(x, y, w, h, tile);
+        }
+    }
+    submitBatch();
+}
+
+void Screen::decodeFrame(const VideoInfo &video, uint16_t index) {
+    if (video.format == VIDEO_DELTA) {
+        DeltaAnimInfo info;
+        uint32_t offset, length;
+        if (DeltaAnim::parseHeader(video.data, video.data_size, info) &&
+            DeltaAnim::frameRange(info, index, offset, length) &&
+            offset + length <= video.data_size) {
+            DeltaAnim::decodeFrame(info, video.data + offset, length, tft_output);
+        }
+    } else if (video.format == VIDEO_FILE) {
+        const uint8_t *frame;
+        uint32_t length;
+        if (file.readFrame(index, frame, length)) {
+            if (file.isDelta()) {
+                DeltaAnim::decodeFrame(file.deltaInfo(), frame, length, tft_output);
+            } else {
+                TJpgDec.drawJpg(0, 0, frame, length);
+            }
+        }
+    } else {
+        const uint8_t *jpg_data = (const uint8_t *)pgm_read_ptr(&video.frames[index]);
+        uint16_t jpg_size = pgm_read_word(&video.frame_sizes[index]);
+
+        if (TJpgDec.drawJpg(0, 0, jpg_data, jpg_size) != JDR_OK) {
+            //Serial.printf("❌ Decode failed at frame %u\n", index);
+        }
+    }
+    // Giao phần cuối frame cho core push, không chờ: frame sau được decode song song
+    submitBatch();
+}
+
+// ============================================
+// BLOCKING HELPERS
+// ============================================
+
+void Screen::playVideo(const VideoInfo &video, uint16_t delay_ms, bool loop_forever) {
+    play(video, delay_ms, loop_forever);
+    while (isPlaying()) {
+        tick();
+        uint32_t wait = msUntilNextFrame();
+        if (wait > 0 && wait != UINT32_MAX) {
+            delay(wait);
+        }
+    }
 }
 
 void Screen::playAll() {
@@ -3,31 +3,172 @@
 #include <Arduino.h>
 #include <TFT_eSPI.h>
 #include <TJpg_Decoder.h>
+#include "DeltaAnim.h"
+#include "VideoFile.h"
+#include "FrameCache.h"
+#include "FaceCompositor.h"
+#include "Metrics.h"
+
+// Pipeline 2 core: decode JPEG ở core gọi tick(), đẩy SPI bằng DMA ở core còn lại.
+// Đặt -DSCREEN_DMA_PIPELINE=0 trong build_flags để quay về pushImage đồng bộ.
+#ifndef SCREEN_DMA_PIPELINE
+#define SCREEN_DMA_PIPELINE 1
+#endif
+
+// Cache frame đã decode trong PSRAM cho clip lặp (tự tắt nếu board không có PSRAM)
+#ifndef SCREEN_FRAME_CACHE
+#define SCREEN_FRAME_CACHE 1
+#endif
+
+// Định dạng dữ liệu của VideoInfo
+enum VideoFormat : uint8_t {
+    VIDEO_JPEG = 0,              // mảng frame JPEG PROGMEM (các header video*.h)
+    VIDEO_DELTA = 1,             // blob HGA1 sinh bởi tools/video2delta.py
+    VIDEO_FILE = 2               // file HGA1/HGJ1 trên LittleFS, đọc dần khi phát
+};
 
 struct VideoInfo {
     const uint8_t * const * frames;
     const uint16_t * frame_sizes;
     uint16_t num_frames;
+    uint8_t format;              // VideoFormat, bỏ trống = VIDEO_JPEG
+    const uint8_t * data;        // VIDEO_DELTA: blob HGA1 trong PROGMEM
+    uint32_t data_size;
+    const char * path;           // VIDEO_FILE: đường dẫn trên LittleFS, num_frames lấy từ file
 };
 
+// Khai báo clip nằm trên LittleFS, ví dụ: VideoInfo idle = fileVideo("/video11.hgj");
+inline VideoInfo fileVideo(const char *path) {
+    return VideoInfo{ nullptr, nullptr, 0, VIDEO_FILE, nullptr, 0, path };
+}
+
 class Screen {
 public:
     Screen();
     void begin();
+
+    // Phát video kiểu blocking (giữ tương thích), delay_ms = chu kỳ mỗi frame
     void playVideo(const VideoInfo &video, uint16_t delay_ms = 40, bool loop_forever = false);
     void playAll();
-    
+
+    // ▶ API non-blocking: chỉ lên lịch, việc decode nằm trong tick()
+    void play(const VideoInfo &video, uint16_t frame_ms = 40, bool loop = false);  // thay video hiện tại
+    bool queue(const VideoInfo &video, uint16_t frame_ms = 40, bool loop = false); // xếp hàng sau video hiện tại
+    void pause();
+    void resume();
+    void stop();                 // dừng và xoá hàng đợi
+    bool isPlaying() const;
+    bool isPaused() const;
+    // Tắt panel (SLPIN) và đèn nền, tick() không vẽ; wake() hiện lại đúng nội dung cũ
+    void sleep();
+    void wake();
+    bool isAsleep() const;
+
+    // Gọi thường xuyên trong loop: decode tối đa 1 frame khi tới hạn
+    void tick();
+    // Thời gian (ms) còn lại tới frame kế tiếp, dùng để ngủ trong loop
+    uint32_t msUntilNextFrame() const;
+
+    // 🧩 Dirty-tile: bỏ qua tile 16x16 giống hệt nội dung đang hiển thị
+    void setDirtyTiles(bool enable);
+    void invalidate();           // gọi sau khi vẽ trực tiếp lên tft để lần sau vẽ lại toàn bộ
+    uint32_t getPushedTiles() const;
+    uint32_t getSkippedTiles() const;
+
+    // Thống kê hit/miss của cache frame PSRAM
+    const FrameCache &getFrameCache() const;
+
+    // 🎭 Mặt vẽ tham số thay cho video: dừng clip đang phát, tick() vẽ mặt tới khi play() lại
+    bool showFace();
+    bool isFaceMode() const;
+    FaceAnimator &face();        // setEmotion/apply(EMOTION_UPDATE), có hiệu lực cả khi đang phát video
+
 private:
     // ⚙️ callback phải đúng với định nghĩa của TJpg_Decoder
     static bool tft_output(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap);
 
+    struct PlayRequest {
+        const VideoInfo *video;
+        uint32_t frame_us;
+        bool loop;
+    };
+
+    static const uint8_t QUEUE_SIZE = 4;
+
+    void startRequest(const PlayRequest &req);
+    bool popQueue(PlayRequest &req);
+    void drawFrame(const VideoInfo &video, uint16_t index);
+    void decodeFrame(const VideoInfo &video, uint16_t index);
+    void drawCachedFrame(const uint16_t *pixels);
+
+    // Một batch gom nhiều block MCU (16x16) đã decode, đẩy 1 lần bằng DMA
+    struct BlockDesc {
+        int16_t x, y;
+        uint16_t w, h;
+        uint16_t offset;         // vị trí pixel đầu tiên trong batch
+    };
+    static const uint8_t BATCH_MAX_BLOCKS = 16;
+    static const uint16_t BATCH_PIXELS = 16 * 16 * BATCH_MAX_BLOCKS;
+    struct BlockBatch {
+        uint16_t *pixels;        // bộ nhớ DMA-capable
+        BlockDesc blocks[BATCH_MAX_BLOCKS];
+        uint8_t count;
+        uint16_t used;
+    };
+
+    static const uint8_t DIRTY_TILE = 16;
+    static const uint8_t DIRTY_GRID = (240 + DIRTY_TILE - 1) / DIRTY_TILE;
+    bool isUnchanged(int16_t x, int16_t y, uint16_t w, uint16_t h, const uint16_t *bitmap);
+
+    bool beginPipeline();
+    void releasePipeline();      // trả buffer/queue/DMA khi beginPipeline() hỏng giữa chừng
+    bool emitBlock(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap);
+    void submitBatch();          // chuyển batch đang ghi sang core push
+    void flushPipeline();        // đẩy batch dở dang và chờ SPI rảnh (trước khi vẽ trực tiếp lên tft)
+    static void pushTask(void *arg);
+
 private:
     TFT_eSPI tft;
     VideoInfo * const * videoList;
     uint8_t numVideos;
+
+    // Trạng thái bộ lập lịch frame
+    PlayRequest current;
+    uint16_t frameCount;         // số frame của clip hiện tại (VIDEO_FILE đọc từ header)
+    uint16_t frameIndex;
+    bool playing;
+    bool paused;
+    bool asleep;
+    int64_t nextFrameUs;         // mốc esp_timer của frame kế tiếp
+    Histogram *frameHist;        // decode + đẩy 1 frame (µs)
+    Counter *lateFrames;         // frame vẽ xong sau mốc frame kế tiếp
+
+    PlayRequest pending[QUEUE_SIZE];
+    uint8_t queueHead;
+    uint8_t queueCount;
+
+    VideoFile file;              // backend cho clip VIDEO_FILE đang phát
+
+    // Ping-pong buffer giữa core decode và core push
+    BlockBatch batches[2];
+    QueueHandle_t freeBatches;   // index batch trống
+    QueueHandle_t readyBatches;  // index batch chờ đẩy SPI
+    int8_t fillIndex;            // batch đang ghi, -1 = chưa lấy
+    bool pipelineEnabled;
+
+    // Hash nội dung từng tile đang hiển thị (0 = chưa biết)
+    uint32_t tileHash[DIRTY_GRID * DIRTY_GRID];
+    bool dirtyTilesEnabled;
+    uint32_t pushedTiles;
+    uint32_t skippedTiles;
+
+    FrameCache frameCache;
+    const uint16_t *shownFrame;  // slot cache trùng với nội dung màn hình, nullptr = không có
+
+    FaceCompositor faceLayer;
+    bool faceReady;
+    bool faceMode;
 };
 
 extern VideoInfo * const videoList[];
 extern const uint8_t NUM_VIDEOS;
-
-
@@ -0,0 +1,132 @@
+#include "VideoFile.h"
+#include <LittleFS.h>
+
+VideoFile::VideoFile()
+: delta(false), info(), offsets(nullptr), buffer(nullptr), bufferSize(0), bufferStart(0), bufferLength(0) {}
+
+VideoFile::~VideoFile() {
+    close();
+    free(buffer);
+}
+
+bool VideoFile::open(const char *path) {
+    close();
+
+    if (!LittleFS.begin(false)) {
+        Serial.println("[VideoFile] LittleFS mount failed");
+        return false;
+    }
+    file = LittleFS.open(path, "r");
+    if (!file) {
+        Serial.printf("[VideoFile] Cannot open %s\n", path);
+        return false;
+    }
+
+    uint8_t header[DeltaAnim::HEADER_SIZE];
+    if (file.read(header, sizeof(header)) != sizeof(header)) {
+        close();
+        return false;
+    }
+    bool jpeg = memcmp(header, "HGJ1", 4) == 0;
+    if (jpeg) {
+        memcpy(header, "HGA1", 4);   // cùng bố cục header, chỉ khác kiểu frame
+        header[8] = DeltaAnim::MAX_TILE;
+    }
+    if (!DeltaAnim::parseHeader(header, file.size(), info)) {
+        Serial.printf("[VideoFile] %s is not an HGA1/HGJ1 pack\n", path);
+        close();
+        return false;
+    }
+    delta = !jpeg;
+
+    size_t indexBytes = (info.numFrames + 1) * sizeof(uint32_t);
+    offsets = (uint32_t *)malloc(indexBytes);
+    if (!offsets || file.read((uint8_t *)offsets, indexBytes) != indexBytes) {
+        close();
+        return false;
+    }
+    info.offsets = (const uint8_t *)offsets;   // giữ cho frameRange() dùng chung
+
+    // File cụt / bảng offset rác: offset phải tăng dần, nằm sau bảng và trong file
+    uint32_t fileSize = file.size();
+    uint32_t previous = DeltaAnim::HEADER_SIZE + indexBytes;
+    for (uint16_t i = 0; i <= info.numFrames; i++) {
+        uint32_t offset = offsets[i];
+        if (offset < previous || offset > fileSize) {
+            Serial.printf("[VideoFile] %s has a bad frame index (frame %u)\n", path, i);
+            close();
+            return false;
+        }
+        previous = offset;
+    }
+    return true;
+}
+
+void VideoFile::close() {
+    if (file) {
+        file.close();
+    }
+    free(offsets);
+    offsets = nullptr;
+    bufferLength = 0;
+    info.numFrames = 0;
+}
+
+bool VideoFile::isOpen() const {
+    return offsets != nullptr;
+}
+
+uint16_t VideoFile::numFrames() const {
+    return isOpen() ? info.numFrames : 0;
+}
+
+bool VideoFile::isDelta() const {
+    return delta;
+}
+
+const DeltaAnimInfo &VideoFile::deltaInfo() const {
+    return info;
+}
+
+bool VideoFile::ensureBuffer(uint32_t size) {
+    if (size <= bufferSize) {
+        return true;
+    }
+    uint8_t *grown = (uint8_t *)realloc(buffer, size);
+    if (!grown) {
+        return false;
+    }
+    buffer = grown;
+    bufferSize = size;
+    return true;
+}
+
+bool VideoFile::readFrame(uint16_t index, const uint8_t *&data, uint32_t &length) {
+    uint32_t offset;
+    if (!isOpen() || !DeltaAnim::frameRange(info, index, offset, length)) {
+        return false;
+    }
+
+    // Frame đã nằm trong buffer read-ahead → không đọc flash
+    if (offset >= bufferStart && offset + length <= bufferStart + bufferLength) {
+        data = buffer + (offset - bufferStart);
+        return true;
+    }
+
+    if (!ensureBuffer(length > READ_AHEAD ? length : READ_AHEAD)) {
+        return false;
+    }
+    uint32_t fileEnd = min<uint32_t>(offsets[info.numFrames], file.size());
+    if (offset + length > fileEnd) {
+        return false;
+    }
+    uint32_t toRead = min(bufferSize, fileEnd - offset);
+    if (!file.seek(offset) || file.read(buffer, toRead) != toRead) {
+        bufferLength = 0;
+        return false;
+    }
+    bufferStart = offset;
+    bufferLength = toRead;
+    data = buffer;
+    return true;
+}
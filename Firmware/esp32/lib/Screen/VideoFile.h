@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include "DeltaAnim.h"
+
+// ======================================================
+// 📂 Đọc clip đóng gói từ LittleFS
+// ======================================================
+//
+// File dùng chung header 12 byte + bảng offset của HGA1 (xem DeltaAnim.h):
+//   "HGA1" → frame delta-tile,  "HGJ1" → frame JPEG nguyên bản.
+// Bảng offset được nạp vào RAM khi mở file, dữ liệu frame đọc qua một
+// buffer read-ahead nên khi phát tuần tự nhiều frame nhỏ chỉ tốn một lần đọc flash.
+
+class VideoFile {
+public:
+    VideoFile();
+    ~VideoFile();
+
+    bool open(const char *path);
+    void close();
+    bool isOpen() const;
+
+    uint16_t numFrames() const;
+    bool isDelta() const;
+    const DeltaAnimInfo &deltaInfo() const;
+
+    // Trả về con trỏ tới dữ liệu frame trong buffer nội bộ (hợp lệ tới lần đọc kế tiếp)
+    bool readFrame(uint16_t index, const uint8_t *&data, uint32_t &length);
+
+private:
+    static const uint32_t READ_AHEAD = 8192;
+
+    bool ensureBuffer(uint32_t size);
+
+    File file;
+    bool delta;
+    DeltaAnimInfo info;
+    uint32_t *offsets;           // numFrames + 1 phần tử
+    uint8_t *buffer;
+    uint32_t bufferSize;
+    uint32_t bufferStart;        // offset trong file của byte đầu buffer
+    uint32_t bufferLength;       // số byte hợp lệ trong buffer
+};
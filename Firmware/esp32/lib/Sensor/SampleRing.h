@@ -0,0 +1,93 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ======================================================
+// 🧮 Lịch sử mẫu cảm biến: ring cố định, không cấp phát
+// ======================================================
+//
+// push() O(1), ghi đè mẫu cũ nhất khi đầy. stats() duyệt từ mẫu mới nhất về
+// trước tới khi ra khỏi cửa sổ thời gian, nên tốn tối đa N bước. Mẫu
+// SAMPLE_BAD vẫn được giữ (để biết cảm biến lỗi lúc nào) nhưng không tính vào
+// thống kê. Không khoá: một task ghi và đọc, hoặc nơi gọi tự đồng bộ.
+
+enum SampleQuality : uint8_t {
+    SAMPLE_GOOD = 0,
+    SAMPLE_DEGRADED = 1,      // dùng được nhưng kém tin cậy (ngoài tầm đo, fallback...)
+    SAMPLE_BAD = 2            // đọc lỗi, value không có nghĩa
+};
+
+template <typename T>
+struct Sample {
+    int64_t timestampUs;      // esp_timer_get_time() lúc lấy mẫu
+    T value;
+    SampleQuality quality;
+};
+
+template <typename T>
+struct SampleStats {
+    uint16_t count;           // số mẫu không BAD trong cửa sổ
+    T min;
+    T max;
+    float mean;
+};
+
+template <typename T, uint16_t N>
+class SampleRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SampleRing size must be a power of two");
+
+public:
+    SampleRing() : head(0), count(0) {}
+
+    void push(int64_t timestampUs, T value, SampleQuality quality = SAMPLE_GOOD) {
+        items[head & (N - 1)] = Sample<T>{ timestampUs, value, quality };
+        head++;
+        if (count < N) {
+            count++;
+        }
+    }
+
+    void clear() {
+        head = 0;
+        count = 0;
+    }
+
+    uint16_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    static constexpr uint16_t capacity() { return N; }
+
+    // age = 0 là mẫu mới nhất; nơi gọi kiểm tra age < size()
+    const Sample<T> &back(uint16_t age = 0) const {
+        return items[(uint16_t)(head - 1 - age) & (N - 1)];
+    }
+
+    // Mẫu có timestamp trong (nowUs - windowUs, nowUs]; windowUs <= 0 = toàn bộ ring
+    SampleStats<T> stats(int64_t windowUs = 0, int64_t nowUs = 0) const {
+        SampleStats<T> out = { 0, T(), T(), 0.0f };
+        float sum = 0.0f;
+        for (uint16_t age = 0; age < count; age++) {
+            const Sample<T> &s = back(age);
+            if (windowUs > 0 && nowUs - s.timestampUs >= windowUs) {
+                break;
+            }
+            if (s.quality == SAMPLE_BAD) {
+                continue;
+            }
+            if (out.count == 0 || s.value < out.min) {
+                out.min = s.value;
+            }
+            if (out.count == 0 || s.value > out.max) {
+                out.max = s.value;
+            }
+            sum += (float)s.value;
+            out.count++;
+        }
+        out.mean = out.count > 0 ? sum / out.count : 0.0f;
+        return out;
+    }
+
+private:
+    Sample<T> items[N];
+    uint16_t head;            // tràn 65536 vẫn đúng vì N là ước của 65536
+    uint16_t count;
+};
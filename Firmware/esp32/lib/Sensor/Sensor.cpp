@@ -0,0 +1,28 @@
+#include "Sensor.h"
+#include <esp_timer.h>
+
+bool Sensor::sample() {
+    float value = NAN;
+    SampleQuality quality = read(value);
+    samples.push(esp_timer_get_time(), value, quality);
+    return quality != SAMPLE_BAD;
+}
+
+bool Sensor::latest(float &value) const {
+    if (samples.empty() || samples.back().quality == SAMPLE_BAD) {
+        return false;
+    }
+    value = samples.back().value;
+    return true;
+}
+
+void Sensor::print(Print &out) const {
+    float value;
+    if (!latest(value)) {
+        out.printf("%s: no reading\n", name());
+        return;
+    }
+    SampleStats<float> s = samples.stats();
+    out.printf("%s: %.2f (min %.2f, max %.2f, mean %.2f over %u samples)\n",
+               name(), value, s.min, s.max, s.mean, s.count);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Arduino.h>
+#include "SampleRing.h"
+#include "SensorKind.h"
+
+// ======================================================
+// 🔌 Giao diện chung cho cảm biến một giá trị
+// ======================================================
+//
+// Lớp con chỉ cài read(): đọc giá trị hiện tại (không chặn lâu, thường là giá
+// trị đã có sẵn từ ngắt/task nền) và trả về chất lượng. sample() gọi read() và
+// ghi vào history() kèm timestamp µs, để lọc, gom lô và luật cảnh báo cùng
+// đọc từ một chỗ. Cảm biến nhiều giá trị (DHT) có một Sensor cho mỗi giá trị.
+
+class Sensor {
+public:
+    static const uint16_t HISTORY = 16;
+
+    explicit Sensor(SensorKind kind) : sensorKind(kind) {}
+    virtual ~Sensor() {}
+
+    // Đọc một mẫu vào history; false nếu mẫu lỗi (vẫn được ghi với SAMPLE_BAD)
+    bool sample();
+    // Mẫu mới nhất dùng được (không BAD); false nếu chưa có
+    bool latest(float &value) const;
+
+    SensorKind kind() const { return sensorKind; }
+    virtual const char *name() const = 0;
+    const SampleRing<float, HISTORY> &history() const { return samples; }
+
+    // Tên, mẫu mới nhất và min/max/mean của history
+    void print(Print &out = Serial) const;
+
+protected:
+    virtual SampleQuality read(float &value) = 0;
+
+private:
+    SensorKind sensorKind;
+    SampleRing<float, HISTORY> samples;
+};
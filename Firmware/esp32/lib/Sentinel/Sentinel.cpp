@@ -0,0 +1,313 @@
+#include "Sentinel.h"
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <driver/adc.h>
+#include <driver/gpio.h>
+#include <driver/rtc_io.h>
+#include <esp32/ulp.h>
+#include <soc/rtc_cntl_reg.h>
+#include <soc/rtc_io_reg.h>
+
+#ifndef RTC_SLOW_MEM
+#define RTC_SLOW_MEM ((uint32_t *)0x50000000)
+#endif
+
+// RTC slow mem: biến của ULP ở đầu vùng dành riêng, chương trình ngay sau.
+// ULP chỉ đọc/ghi 16 bit thấp của mỗi word.
+enum : uint8_t { VAR_GAS = 0, VAR_TRIPPED, VAR_SAMPLES, VAR_COUNT };
+static const uint32_t PROG_START = 8;                 // word
+static const uint16_t TRIP_GAS = 1;
+static const uint16_t TRIP_FLAME = 2;
+static const uint16_t GAS_DISABLED = 0xFFFF;          // trung bình 12 bit không bao giờ tới
+
+#ifdef CONFIG_ULP_COPROC_RESERVE_MEM
+static const size_t ULP_RESERVE_WORDS = CONFIG_ULP_COPROC_RESERVE_MEM / sizeof(uint32_t);
+#else
+static const size_t ULP_RESERVE_WORDS = 512 / sizeof(uint32_t);
+#endif
+
+Sentinel::Sentinel()
+: gasChannel(-1), gasThreshold(GAS_DISABLED), flamePin(0), flameRtcIo(-1), flameActiveLow(true),
+  motionPin(-1), motionActiveHigh(true), samplePeriodMs(DEFAULT_SAMPLE_MS), heartbeatMs(DEFAULT_HEARTBEAT_MS),
+  armed(false), useUlp(false), nextHeartbeatUs(0), sleptUs(0), wakeups{} {
+}
+
+// ============================================
+// CẤU HÌNH
+// ============================================
+
+bool Sentinel::setGas(uint8_t pin, uint16_t thresholdRaw) {
+    int8_t channel = digitalPinToAnalogChannel(pin);
+    if (channel < 0 || channel >= ADC1_CHANNEL_MAX) {
+        Serial.printf("[Sentinel] Gas pin %u is not on ADC1\n", pin);
+        return false;
+    }
+    gasChannel = channel;
+    gasThreshold = min<uint16_t>(thresholdRaw, 4095);
+    return true;
+}
+
+bool Sentinel::setFlame(uint8_t pin, bool activeLow) {
+    if (!rtc_gpio_is_valid_gpio((gpio_num_t)pin)) {
+        Serial.printf("[Sentinel] Flame pin %u is not an RTC GPIO\n", pin);
+        return false;
+    }
+    flamePin = pin;
+    flameRtcIo = rtc_io_number_get((gpio_num_t)pin);
+    flameActiveLow = activeLow;
+    return true;
+}
+
+bool Sentinel::setMotion(uint8_t pin, bool activeHigh) {
+    if (!GPIO_IS_VALID_GPIO(pin)) {
+        return false;
+    }
+    motionPin = pin;
+    motionActiveHigh = activeHigh;
+    return true;
+}
+
+void Sentinel::setSamplePeriod(uint32_t ms) {
+    samplePeriodMs = ms == 0 ? 1 : ms;
+}
+
+void Sentinel::setHeartbeat(uint32_t ms) {
+    heartbeatMs = ms == 0 ? DEFAULT_HEARTBEAT_MS : ms;
+}
+
+// ============================================
+// ULP
+// ============================================
+
+bool Sentinel::loadProgram() {
+    enum { LBL_GAS = 1, LBL_FLAME, LBL_WAKE, LBL_HALT };
+    const uint32_t gasPad = gasChannel >= 0 ? gasChannel : 0;
+    const uint16_t threshold = gasChannel >= 0 ? gasThreshold : GAS_DISABLED;
+    const uint32_t flameBit = RTC_GPIO_IN_NEXT_S + (flameRtcIo >= 0 ? flameRtcIo : 0);
+
+    const ulp_insn_t program[] = {
+        I_MOVI(R3, 0),                                    // R3 = gốc vùng biến
+        I_LD(R0, R3, VAR_SAMPLES),
+        I_ADDI(R0, R0, 1),
+        I_ST(R0, R3, VAR_SAMPLES),
+
+        // Gas: trung bình 4 lần đọc SAR ADC1
+        I_ADC(R1, 0, gasPad),
+        I_MOVR(R2, R1),
+        I_ADC(R1, 0, gasPad),
+        I_ADDR(R2, R2, R1),
+        I_ADC(R1, 0, gasPad),
+        I_ADDR(R2, R2, R1),
+        I_ADC(R1, 0, gasPad),
+        I_ADDR(R2, R2, R1),
+        I_RSHI(R0, R2, 2),
+        I_ST(R0, R3, VAR_GAS),
+        M_BGE(LBL_GAS, threshold),
+
+        // Lửa: R0 = activeLow - bit (16 bit không dấu) >= 1 đúng khi chân ở mức tích cực
+        I_MOVI(R0, flameRtcIo >= 0 ? 0 : 1),
+        M_BGE(LBL_HALT, 1),
+        I_RD_REG(RTC_GPIO_IN_REG, flameBit, flameBit),
+        I_MOVI(R1, flameActiveLow ? 1 : 0),
+        I_SUBR(R0, R1, R0),
+        M_BGE(LBL_FLAME, 1),
+        I_HALT(),
+
+        M_LABEL(LBL_GAS),
+        I_MOVI(R1, TRIP_GAS),
+        M_BX(LBL_WAKE),
+        M_LABEL(LBL_FLAME),
+        I_MOVI(R1, TRIP_FLAME),
+        M_LABEL(LBL_WAKE),
+        I_LD(R0, R3, VAR_TRIPPED),
+        M_BGE(LBL_HALT, 1),                               // đã báo, chờ arm() lần sau
+        I_ST(R1, R3, VAR_TRIPPED),
+        I_WAKE(),
+        M_LABEL(LBL_HALT),
+        I_HALT(),
+    };
+
+    size_t size = sizeof(program) / sizeof(ulp_insn_t);
+    if (PROG_START + size > ULP_RESERVE_WORDS) {
+        Serial.println("[Sentinel] ULP program does not fit the reserved RTC memory");
+        return false;
+    }
+    for (uint8_t i = 0; i < VAR_COUNT; i++) {
+        RTC_SLOW_MEM[i] = 0;
+    }
+    esp_err_t err = ulp_process_macros_and_load(PROG_START, program, &size);
+    if (err != ESP_OK) {
+        Serial.printf("[Sentinel] ULP load failed: %d\n", err);
+        return false;
+    }
+    return true;
+}
+
+// ============================================
+// ARM / SLEEP
+// ============================================
+
+bool Sentinel::arm() {
+    if (armed) {
+        return true;
+    }
+    useUlp = gasChannel >= 0 || flameRtcIo >= 0;
+    if (!useUlp && motionPin < 0) {
+        return false;
+    }
+
+    if (useUlp) {
+        if (gasChannel >= 0) {
+            adc1_config_width(ADC_WIDTH_BIT_12);
+            adc1_config_channel_atten((adc1_channel_t)gasChannel, ADC_ATTEN_DB_11);
+            adc1_ulp_enable();
+        }
+        if (flameRtcIo >= 0) {
+            // Chân chuyển sang RTC mux: digitalRead/attachInterrupt không còn chạy tới disarm()
+            rtc_gpio_init((gpio_num_t)flamePin);
+            rtc_gpio_set_direction((gpio_num_t)flamePin, RTC_GPIO_MODE_INPUT_ONLY);
+        }
+        if (!loadProgram()) {
+            if (flameRtcIo >= 0) {
+                rtc_gpio_deinit((gpio_num_t)flamePin);
+            }
+            return false;
+        }
+        ulp_set_wakeup_period(0, samplePeriodMs * 1000);
+        if (ulp_run(PROG_START) != ESP_OK) {
+            return false;
+        }
+        // ADC của ULP cần nguồn RTC peripheral trong lúc ngủ
+        esp_sleep_pd_config(ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_OPTION_ON);
+        esp_sleep_enable_ulp_wakeup();
+    }
+    if (motionPin >= 0) {
+        gpio_wakeup_enable((gpio_num_t)motionPin, motionActiveHigh ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+        esp_sleep_enable_gpio_wakeup();
+    }
+
+    nextHeartbeatUs = esp_timer_get_time() + (int64_t)heartbeatMs * 1000;
+    armed = true;
+    Serial.printf("[Sentinel] Armed: ULP every %u ms, heartbeat %u s\n", samplePeriodMs, heartbeatMs / 1000);
+    return true;
+}
+
+WakeCause Sentinel::pendingCause() const {
+    if (useUlp) {
+        uint16_t tripped = RTC_SLOW_MEM[VAR_TRIPPED] & 0xFFFF;
+        if (tripped == TRIP_GAS) {
+            return WakeCause::GAS;
+        }
+        if (tripped == TRIP_FLAME) {
+            return WakeCause::FLAME;
+        }
+    }
+    if (motionPin >= 0 && digitalRead(motionPin) == (motionActiveHigh ? HIGH : LOW)) {
+        return WakeCause::MOTION;
+    }
+    return WakeCause::NONE;
+}
+
+WakeCause Sentinel::sleep() {
+    if (!armed) {
+        return WakeCause::NONE;
+    }
+    // ULP có thể đã gọi WAKE trong lúc CPU còn thức (ví dụ giữa heartbeat)
+    WakeCause cause = pendingCause();
+    int64_t now = esp_timer_get_time();
+    if (cause == WakeCause::NONE && now >= nextHeartbeatUs) {
+        cause = WakeCause::HEARTBEAT;
+    }
+    if (cause == WakeCause::NONE) {
+        esp_sleep_enable_timer_wakeup(nextHeartbeatUs - now);
+        Serial.flush();
+        if (esp_light_sleep_start() != ESP_OK) {
+            return WakeCause::NONE;
+        }
+        int64_t woke = esp_timer_get_time();
+        sleptUs += woke - now;
+        switch (esp_sleep_get_wakeup_cause()) {
+            case ESP_SLEEP_WAKEUP_ULP:
+                cause = pendingCause();
+                break;
+            case ESP_SLEEP_WAKEUP_GPIO:
+                cause = WakeCause::MOTION;
+                break;
+            case ESP_SLEEP_WAKEUP_TIMER:
+                cause = WakeCause::HEARTBEAT;
+                break;
+            default:
+                break;
+        }
+        if (cause == WakeCause::NONE) {
+            cause = WakeCause::OTHER;
+        }
+    }
+    if (cause == WakeCause::HEARTBEAT) {
+        nextHeartbeatUs = esp_timer_get_time() + (int64_t)heartbeatMs * 1000;
+    }
+    wakeups[(uint8_t)cause]++;
+    return cause;
+}
+
+void Sentinel::disarm() {
+    if (!armed) {
+        return;
+    }
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+    if (useUlp) {
+        // FSM ULP không có hàm dừng: tắt timer, lượt đang chạy tự HALT
+        CLEAR_PERI_REG_MASK(RTC_CNTL_STATE0_REG, RTC_CNTL_ULP_CP_SLP_TIMER_EN);
+        esp_sleep_pd_config(ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_OPTION_AUTO);
+        if (flameRtcIo >= 0) {
+            rtc_gpio_deinit((gpio_num_t)flamePin);
+        }
+        // ADC1 về lại controller RTC ở lần adc1_get_raw / AnalogSampler::begin() kế tiếp
+    }
+    if (motionPin >= 0) {
+        gpio_wakeup_disable((gpio_num_t)motionPin);
+    }
+    armed = false;
+}
+
+bool Sentinel::isArmed() const {
+    return armed;
+}
+
+// ============================================
+// THỐNG KÊ
+// ============================================
+
+uint16_t Sentinel::getLastGasRaw() const {
+    return useUlp && gasChannel >= 0 ? RTC_SLOW_MEM[VAR_GAS] & 0xFFFF : 0;
+}
+
+uint16_t Sentinel::getUlpSamples() const {
+    return useUlp ? RTC_SLOW_MEM[VAR_SAMPLES] & 0xFFFF : 0;
+}
+
+uint64_t Sentinel::getSleptUs() const {
+    return sleptUs;
+}
+
+uint32_t Sentinel::getWakeups(WakeCause cause) const {
+    return (uint8_t)cause < (uint8_t)WakeCause::COUNT ? wakeups[(uint8_t)cause] : 0;
+}
+
+const char *Sentinel::causeName(WakeCause cause) {
+    switch (cause) {
+        case WakeCause::HEARTBEAT: return "heartbeat";
+        case WakeCause::GAS: return "gas";
+        case WakeCause::FLAME: return "flame";
+        case WakeCause::MOTION: return "motion";
+        case WakeCause::OTHER: return "other";
+        default: return "none";
+    }
+}
+
+void Sentinel::printStats(Print &out) const {
+    out.printf("[Sentinel] armed=%d slept=%llus | heartbeat=%u gas=%u flame=%u motion=%u other=%u | gas_raw=%u\n",
+               armed, sleptUs / 1000000, wakeups[(uint8_t)WakeCause::HEARTBEAT], wakeups[(uint8_t)WakeCause::GAS],
+               wakeups[(uint8_t)WakeCause::FLAME], wakeups[(uint8_t)WakeCause::MOTION],
+               wakeups[(uint8_t)WakeCause::OTHER], getLastGasRaw());
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ======================================================
+// 🛡️ Chế độ canh gác: CPU ngủ, ULP trông gas/lửa, PIR đánh thức
+// ======================================================
+//
+// Lúc nhà không có gì xảy ra, hai core, WiFi và TFT không cần chạy. arm()
+// nạp một chương trình nhỏ cho ULP coprocessor (FSM, dựng bằng macro của
+// esp32/ulp.h) chạy mỗi samplePeriodMs ngay cả khi CPU đang light sleep:
+//   - đọc ADC1 của cảm biến gas 4 lần, lấy trung bình, ghi ra RTC slow mem;
+//     vượt ngưỡng -> WAKE
+//   - đọc mức chân lửa qua RTC IO; đúng mức tích cực -> WAKE
+// Sau khi đã báo, ULP không gọi WAKE lại cho tới lần arm() sau.
+//
+// PIR nằm trên GPIO21, không phải chân RTC nên ULP không đọc được: dùng
+// GPIO wakeup của light sleep (chân bất kỳ, theo mức). Timer đánh thức mỗi
+// heartbeatMs để báo về server. Dùng light sleep chứ không dùng deep sleep:
+// RAM và các task còn nguyên, dậy mất vài ms thay vì boot lại từ đầu, nên còi
+// báo cháy/gas kêu ngay khi ULP thấy ngưỡng; cái giá là dòng ngủ ~0.8 mA thay
+// vì ~0.15 mA, vẫn đủ chạy pin nhiều ngày.
+//
+// Nơi gọi phải tự tắt WiFi (light sleep bị từ chối khi WiFi còn bật), dừng
+// AnalogSampler (ULP giữ ADC1) và gỡ ngắt của chân PIR/lửa trước arm(), rồi
+// làm ngược lại sau disarm().
+
+enum class WakeCause : uint8_t {
+    NONE = 0,            // không ngủ được (còn nguồn đánh thức đang bật / lỗi)
+    HEARTBEAT,
+    GAS,
+    FLAME,
+    MOTION,
+    OTHER,
+    COUNT
+};
+
+class Sentinel {
+public:
+    static const uint32_t DEFAULT_SAMPLE_MS = 100;              // độ trễ phát hiện gas/lửa tối đa
+    static const uint32_t DEFAULT_HEARTBEAT_MS = 15UL * 60 * 1000;
+
+    Sentinel();
+
+    // Chân ADC1 (GPIO32-39); ngưỡng theo raw 12 bit, cùng thang với GasSensor::readRaw()
+    bool setGas(uint8_t pin, uint16_t thresholdRaw);
+    // Chân RTC IO mà ULP đọc được; activeLow như module lửa của FlameSensor
+    bool setFlame(uint8_t pin, bool activeLow = true);
+    // Chân bất kỳ, đánh thức khi ở mức tích cực
+    bool setMotion(uint8_t pin, bool activeHigh = true);
+    void setSamplePeriod(uint32_t ms);
+    void setHeartbeat(uint32_t ms);
+
+    // Nạp và chạy chương trình ULP, bật các nguồn đánh thức
+    bool arm();
+    // Light sleep tới khi có nguồn đánh thức; trả về ngay nếu sự kiện đã có sẵn
+    WakeCause sleep();
+    // Dừng ULP, trả ADC1 và chân lửa về driver thường, tắt các nguồn đánh thức
+    void disarm();
+    bool isArmed() const;
+
+    uint16_t getLastGasRaw() const;      // mẫu gas gần nhất của ULP
+    uint16_t getUlpSamples() const;      // số lượt ULP đã chạy từ lần arm() (16 bit, quay vòng)
+    uint64_t getSleptUs() const;
+    uint32_t getWakeups(WakeCause cause) const;
+    void printStats(Print &out = Serial) const;
+    static const char *causeName(WakeCause cause);
+
+private:
+    bool loadProgram();
+    WakeCause pendingCause() const;
+
+    int8_t gasChannel;                   // ADC1_CHANNEL_x, -1 = không dùng
+    uint16_t gasThreshold;
+    uint8_t flamePin;
+    int8_t flameRtcIo;                   // -1 = không dùng
+    bool flameActiveLow;
+    int8_t motionPin;                    // -1 = không dùng
+    bool motionActiveHigh;
+    uint32_t samplePeriodMs;
+    uint32_t heartbeatMs;
+
+    bool armed;
+    bool useUlp;
+    int64_t nextHeartbeatUs;
+    uint64_t sleptUs;
+    uint32_t wakeups[(uint8_t)WakeCause::COUNT];
+};
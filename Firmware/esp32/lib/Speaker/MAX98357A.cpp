@@ -6,14 +6,40 @@ MAX98357A::MAX98357A(int bclk, int lrc, int din, String spkName)
 void MAX98357A::begin() {
     audio.setPinout(bclkPin, lrcPin, dinPin);
     audio.setVolume(15); // mặc định volume
+    clips.begin(bclkPin, lrcPin, dinPin);
 }
 
 void MAX98357A::playURL(const char* url) {
+    clips.stopAll();
     audio.connecttohost(url);
 }
 
 void MAX98357A::loop() {
-    audio.loop();
+    if (!clips.isPlaying()) {
+        audio.loop();
+    }
+}
+
+bool MAX98357A::playClip(int8_t clip, uint8_t priority, uint16_t gain, bool loop) {
+    if (audio.isRunning()) {
+        audio.stopSong();
+    }
+    return clips.play(clip, priority, gain, loop);
+}
+
+bool MAX98357A::openStream(PcmRing* ring, uint32_t prebufferSamples) {
+    if (audio.isRunning()) {
+        audio.stopSong();
+    }
+    return clips.openStream(ring, SpeakerI2S::PRIORITY_VOICE, prebufferSamples);
+}
+
+void MAX98357A::stopClips() {
+    clips.stopAll();
+}
+
+SpeakerI2S& MAX98357A::getClips() {
+    return clips;
 }
 
 void MAX98357A::setVolume(int volume) {
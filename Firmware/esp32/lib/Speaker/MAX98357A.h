@@ -2,11 +2,13 @@
 
 #include <Arduino.h>
 #include "Audio.h"  // Thư viện ESP32 Audio
+#include "SpeakerI2S.h"
 
 class MAX98357A {
 private:
     int bclkPin, lrcPin, dinPin;
     Audio audio;
+    SpeakerI2S clips;   // Clip nạp sẵn phát thẳng ra I2S, dùng chung I2S0 với audio
     String name;
 
 public:
@@ -16,6 +18,13 @@ public:
     void loop();
     void setVolume(int volume);
     void playVolume(int volume, const char* url);
+    // Phát clip nạp sẵn (độ trễ vài ms), dừng stream HTTP đang phát
+    bool playClip(int8_t clip, uint8_t priority = SpeakerI2S::PRIORITY_NORMAL,
+                  uint16_t gain = SpeakerI2S::GAIN_UNITY, bool loop = false);
+    void stopClips();
+    // Mở luồng PCM (TTS) qua SpeakerI2S, cũng dừng stream HTTP
+    bool openStream(PcmRing* ring, uint32_t prebufferSamples);
+    SpeakerI2S& getClips();
     String getName();
     void displayInfo();
 };
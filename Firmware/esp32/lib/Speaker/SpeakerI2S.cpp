@@ -1,30 +1,476 @@
-// #include "SpeakerI2S.h"
-
-// SpeakerI2S::SpeakerI2S(i2s_port_t port) : i2s_num(port) {}
-
-// void SpeakerI2S::begin(int bclk, int lrc, int din) {
-//     i2s_config_t config = {
-//         .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX),
-//         .sample_rate = 16000,
-//         .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
-//         .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,
-//         .communication_format = I2S_COMM_FORMAT_STAND_I2S,
-//         .intr_alloc_flags = 0,
-//         .dma_buf_count = 4,
-//         .dma_buf_len = 1024,
-//         .use_apll = false
-//     };
-//     i2s_pin_config_t pinConfig = {
-//         .bck_io_num = bclk,
-//         .ws_io_num = lrc,
-//         .data_out_num = din,
-//         .data_in_num = I2S_PIN_NO_CHANGE
-//     };
-//     i2s_driver_install(i2s_num, &config, 0, NULL);
-//     i2s_set_pin(i2s_num, &pinConfig);
-// }
-
-// void SpeakerI2S::playBuffer(int16_t *buffer, size_t samples) {
-//     size_t bytesWritten;
-//     i2s_write(i2s_num, buffer, samples * sizeof(int16_t), &bytesWritten, portMAX_DELAY);
-// }
+#include "SpeakerI2S.h"
+#include <esp_timer.h>
+#include <LittleFS.h>
+
+SpeakerI2S::SpeakerI2S(i2s_port_t port, uint32_t sampleRate)
+    : port(port), sampleRate(sampleRate), commands(nullptr), task(nullptr),
+      clipCount(0), activeVoices(0), masterGain(GAIN_UNITY), clockSet(false),
+      stream(nullptr), streamOpen(false), streamEnding(false), streamPlaying(false),
+      streamPriority(PRIORITY_VOICE), streamPrebuffer(0), streamStartAt(0), streamRequestedUs(0),
+      streamUnderruns(0), streamStartLatencyUs(0),
+      clipsStarted(0), preempted(0), rejected(0), lastStartLatencyUs(0), maxStartLatencyUs(0) {
+    for (uint8_t i = 0; i < MAX_VOICES; i++) {
+        voices[i].clip = -1;
+    }
+}
+
+bool SpeakerI2S::begin(int bclk, int lrc, int din, BaseType_t core, UBaseType_t priority) {
+    if (task != nullptr) {
+        return true;
+    }
+
+    // Cùng định dạng với thư viện Audio (16 bit, stereo) để hai bên dùng chung driver
+    i2s_config_t config = {
+        .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX),
+        .sample_rate = sampleRate,
+        .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
+        .channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT,
+        .communication_format = I2S_COMM_FORMAT_STAND_I2S,
+        .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
+        .dma_buf_count = 4,
+        .dma_buf_len = BLOCK_FRAMES,
+        .use_apll = false,
+        .tx_desc_auto_clear = true
+    };
+    esp_err_t err = i2s_driver_install(port, &config, 0, NULL);
+    if (err == ESP_OK) {
+        i2s_pin_config_t pinConfig = {
+            .bck_io_num = bclk,
+            .ws_io_num = lrc,
+            .data_out_num = din,
+            .data_in_num = I2S_PIN_NO_CHANGE
+        };
+        i2s_set_pin(port, &pinConfig);
+    } else if (err != ESP_ERR_INVALID_STATE) {
+        Serial.printf("[SpeakerI2S] i2s_driver_install failed: %d\n", err);
+        return false;
+    }
+
+    commands = xQueueCreate(8, sizeof(Command));
+    if (commands == nullptr) {
+        return false;
+    }
+    if (xTaskCreatePinnedToCore(taskLoop, "clip_mixer", 3072, this, priority, &task, core) != pdPASS) {
+        task = nullptr;
+        return false;
+    }
+    return true;
+}
+
+// ============================================
+// CLIP
+// ============================================
+
+int8_t SpeakerI2S::registerClip(const uint8_t *data, uint32_t samples, AudioCodec codec) {
+    if (data == nullptr || samples == 0 || clipCount >= MAX_CLIPS) {
+        return -1;
+    }
+    clips[clipCount] = { data, samples, codec };
+    return (int8_t)clipCount++;
+}
+
+int8_t SpeakerI2S::addClip(const int16_t *pcm, uint32_t samples) {
+    return registerClip((const uint8_t *)pcm, samples, AUDIO_PCM16);
+}
+
+int8_t SpeakerI2S::addAdpcmClip(const uint8_t *data, size_t bytes) {
+    if (bytes <= IMA_HEADER_BYTES) {
+        return -1;
+    }
+    return registerClip(data, (bytes - IMA_HEADER_BYTES) * 2, AUDIO_IMA_ADPCM);
+}
+
+int8_t SpeakerI2S::addTone(uint16_t freqHz, uint16_t ms, int16_t amplitude) {
+    uint32_t samples = (uint32_t)ms * sampleRate / 1000;
+    int16_t *pcm = (int16_t *)malloc(samples * sizeof(int16_t));
+    if (pcm == nullptr) {
+        return -1;
+    }
+    // Fade 5 ms hai đầu để không nghe tiếng "bụp"
+    uint32_t fade = sampleRate / 200;
+    for (uint32_t i = 0; i < samples; i++) {
+        float env = 1.0f;
+        if (i < fade) env = (float)i / fade;
+        else if (samples - i < fade) env = (float)(samples - i) / fade;
+        pcm[i] = (int16_t)(amplitude * env * sinf(2.0f * PI * freqHz * i / sampleRate));
+    }
+    int8_t id = addClip(pcm, samples);
+    if (id < 0) {
+        free(pcm);
+    }
+    return id;
+}
+
+int8_t SpeakerI2S::loadClip(const char *path) {
+    if (!LittleFS.begin(false) || !LittleFS.exists(path)) {
+        return -1;
+    }
+    File f = LittleFS.open(path, "r");
+    size_t bytes = f ? f.size() : 0;
+    uint8_t *data = bytes ? (uint8_t *)malloc(bytes) : nullptr;
+    if (data == nullptr) {
+        return -1;
+    }
+    bool ok = f.read(data, bytes) == bytes;
+    f.close();
+
+    const char *ext = strrchr(path, '.');
+    int8_t id = -1;
+    if (ok && ext != nullptr && strcmp(ext, ".adp") == 0) {
+        id = addAdpcmClip(data, bytes);
+    } else if (ok) {
+        id = addClip((const int16_t *)data, bytes / sizeof(int16_t));
+    }
+    if (id < 0) {
+        free(data);
+    } else {
+        Serial.printf("[SpeakerI2S] Clip %d loaded: %s (%u bytes)\n", id, path, (unsigned)bytes);
+    }
+    return id;
+}
+
+// ============================================
+// ĐIỀU KHIỂN (gọi từ task bất kỳ)
+// ============================================
+
+bool SpeakerI2S::play(int8_t clip, uint8_t priority, uint16_t gain, bool loop) {
+    if (commands == nullptr || clip < 0 || clip >= clipCount) {
+        return false;
+    }
+    Command cmd = { CMD_PLAY, clip, priority, gain, loop, esp_timer_get_time(), nullptr, 0, 0 };
+    // Báo động chen lên đầu hàng đợi
+    if (priority >= PRIORITY_ALARM) {
+        return xQueueSendToFront(commands, &cmd, 0) == pdTRUE;
+    }
+    return xQueueSend(commands, &cmd, 0) == pdTRUE;
+}
+
+void SpeakerI2S::stop(int8_t clip) {
+    Command cmd = { CMD_STOP, clip, 0, 0, false, 0, nullptr, 0, 0 };
+    if (commands != nullptr) {
+        xQueueSend(commands, &cmd, 0);
+    }
+}
+
+void SpeakerI2S::stopAll() {
+    Command cmd = { CMD_STOP_ALL, -1, 0, 0, false, 0, nullptr, 0, 0 };
+    if (commands != nullptr) {
+        xQueueSendToFront(commands, &cmd, 0);
+    }
+}
+
+bool SpeakerI2S::isPlaying() const {
+    return activeVoices > 0 || streamOpen || (commands != nullptr && uxQueueMessagesWaiting(commands) > 0);
+}
+
+void SpeakerI2S::setMasterGain(uint16_t gain) {
+    masterGain = gain;
+}
+
+bool SpeakerI2S::openStream(PcmRing *ring, uint8_t priority, uint32_t prebufferSamples) {
+    if (commands == nullptr || ring == nullptr) {
+        return false;
+    }
+    Command cmd = { CMD_STREAM_OPEN, -1, priority, GAIN_UNITY, false, esp_timer_get_time(),
+                    ring, ring->totalWritten(), prebufferSamples };
+    if (xQueueSend(commands, &cmd, 0) != pdTRUE) {
+        return false;
+    }
+    streamOpen = true;   // đặt ngay để producer ghi được trước khi mixer xử lý lệnh
+    return true;
+}
+
+void SpeakerI2S::endStream() {
+    Command cmd = { CMD_STREAM_END, -1, 0, 0, false, 0, nullptr, 0, 0 };
+    if (commands != nullptr) {
+        xQueueSend(commands, &cmd, 0);
+    }
+}
+
+void SpeakerI2S::closeStream() {
+    Command cmd = { CMD_STREAM_CLOSE, -1, 0, 0, false, 0, nullptr, 0, 0 };
+    if (commands != nullptr) {
+        xQueueSend(commands, &cmd, 0);
+    }
+}
+
+bool SpeakerI2S::isStreamOpen() const {
+    return streamOpen;
+}
+
+// ============================================
+// TASK MIXER
+// ============================================
+
+void SpeakerI2S::taskLoop(void *arg) {
+    SpeakerI2S *self = static_cast<SpeakerI2S *>(arg);
+    Command cmd;
+    for (;;) {
+        // Rảnh thì ngủ tới lệnh kế tiếp; đang chờ prebuffer thì hỏi lại mỗi tick
+        bool busy = self->activeVoices > 0 || self->streamPlaying;
+        TickType_t wait = busy ? 0 : (self->stream != nullptr ? 1 : portMAX_DELAY);
+        while (xQueueReceive(self->commands, &cmd, wait) == pdTRUE) {
+            self->apply(cmd);
+            wait = 0;
+        }
+        self->pollStream();
+        if (self->activeVoices == 0 && !self->streamPlaying) {
+            if (self->clockSet) {
+                i2s_zero_dma_buffer(self->port);
+                self->clockSet = false;
+            }
+            continue;
+        }
+        if (!self->clockSet) {
+            i2s_set_clk(self->port, self->sampleRate, I2S_BITS_PER_SAMPLE_16BIT, I2S_CHANNEL_STEREO);
+            self->clockSet = true;
+        }
+
+        self->mixBlock();
+        size_t written = 0;
+        i2s_write(self->port, self->out, sizeof(self->out), &written, portMAX_DELAY);
+
+        int64_t now = esp_timer_get_time();
+        if (self->playbackTap) {
+            self->playbackTap(self->mono, BLOCK_FRAMES, now);
+        }
+        for (uint8_t i = 0; i < MAX_VOICES; i++) {
+            Voice &v = self->voices[i];
+            if (v.requestedUs > 0) {
+                self->lastStartLatencyUs = (uint32_t)(now - v.requestedUs);
+                self->maxStartLatencyUs = max(self->maxStartLatencyUs, self->lastStartLatencyUs);
+                v.requestedUs = 0;
+            }
+        }
+        if (self->streamRequestedUs > 0 && self->streamPlaying) {
+            self->streamStartLatencyUs = (uint32_t)(now - self->streamRequestedUs);
+            self->streamRequestedUs = 0;
+        }
+    }
+}
+
+void SpeakerI2S::apply(const Command &cmd) {
+    switch (cmd.op) {
+        case CMD_PLAY:
+            startVoice(cmd);
+            break;
+        case CMD_STREAM_OPEN:
+            if (stream != nullptr && stream != cmd.ring) {
+                dropStream();
+            }
+            stream = cmd.ring;
+            streamOpen = true;
+            streamEnding = false;
+            streamPlaying = false;
+            streamPriority = cmd.priority;
+            streamPrebuffer = max<uint32_t>(cmd.prebuffer, BLOCK_FRAMES);
+            streamStartAt = cmd.startAt;
+            streamRequestedUs = cmd.requestedUs;
+            break;
+        case CMD_STREAM_END:
+            streamEnding = true;
+            break;
+        case CMD_STREAM_CLOSE:
+            dropStream();
+            break;
+        case CMD_STOP:
+        case CMD_STOP_ALL:
+            for (uint8_t i = 0; i < MAX_VOICES; i++) {
+                if (voices[i].clip >= 0 && (cmd.op == CMD_STOP_ALL || voices[i].clip == cmd.clip)) {
+                    voices[i].clip = -1;
+                    activeVoices--;
+                }
+            }
+            break;
+    }
+}
+
+void SpeakerI2S::startVoice(const Command &cmd) {
+    if (cmd.priority >= PRIORITY_ALARM) {
+        // Báo động: bỏ mọi clip thấp hơn và xả audio đang chờ trong DMA
+        bool dropped = false;
+        for (uint8_t i = 0; i < MAX_VOICES; i++) {
+            if (voices[i].clip >= 0 && voices[i].priority < cmd.priority) {
+                voices[i].clip = -1;
+                activeVoices--;
+                preempted++;
+                dropped = true;
+            }
+        }
+        if (stream != nullptr && streamPriority < cmd.priority) {
+            dropStream();
+            preempted++;
+            dropped = true;
+        }
+        if (dropped || activeVoices == 0) {
+            flushDma();
+        }
+    }
+
+    // Slot trống, hết thì lấy slot ưu tiên thấp nhất (không cao hơn clip mới)
+    int8_t slot = -1;
+    for (uint8_t i = 0; i < MAX_VOICES && slot < 0; i++) {
+        if (voices[i].clip < 0) {
+            slot = i;
+        }
+    }
+    if (slot < 0) {
+        for (uint8_t i = 0; i < MAX_VOICES; i++) {
+            if (voices[i].priority <= cmd.priority && (slot < 0 || voices[i].priority < voices[slot].priority)) {
+                slot = i;
+            }
+        }
+        if (slot < 0) {
+            rejected++;
+            return;
+        }
+        voices[slot].clip = -1;
+        activeVoices--;
+        preempted++;
+    }
+
+    Voice &v = voices[slot];
+    const Clip &clip = clips[cmd.clip];
+    v.pos = 0;
+    v.priority = cmd.priority;
+    v.gain = cmd.gain;
+    v.loop = cmd.loop;
+    v.requestedUs = cmd.requestedUs;
+    if (clip.codec == AUDIO_IMA_ADPCM) {
+        v.state = imaReadHeader(clip.data);
+    }
+    v.clip = cmd.clip;
+    activeVoices++;
+    clipsStarted++;
+}
+
+void SpeakerI2S::pollStream() {
+    if (stream == nullptr) {
+        return;
+    }
+    // Bỏ phần của phiên trước còn trong ring
+    size_t read = stream->totalRead();
+    if ((ptrdiff_t)(streamStartAt - read) > 0) {
+        stream->skip(streamStartAt - read);
+    }
+    size_t available = stream->available();
+    if (!streamPlaying && (available >= streamPrebuffer || (streamEnding && available > 0))) {
+        streamPlaying = true;
+    } else if (!streamPlaying && streamEnding && available == 0) {
+        dropStream();
+    }
+}
+
+void SpeakerI2S::dropStream() {
+    if (stream != nullptr) {
+        stream->skip(stream->available());
+    }
+    stream = nullptr;
+    streamOpen = false;
+    streamEnding = false;
+    streamPlaying = false;
+    streamRequestedUs = 0;
+}
+
+void SpeakerI2S::flushDma() {
+    if (clockSet) {
+        i2s_stop(port);
+        i2s_zero_dma_buffer(port);
+        i2s_start(port);
+    }
+}
+
+void SpeakerI2S::mixBlock() {
+    memset(mix, 0, sizeof(mix));
+
+    for (uint8_t i = 0; i < MAX_VOICES; i++) {
+        Voice &v = voices[i];
+        if (v.clip < 0) {
+            continue;
+        }
+        const Clip &clip = clips[v.clip];
+        int32_t gain = (int32_t)v.gain;
+        for (uint16_t n = 0; n < BLOCK_FRAMES; n++) {
+            if (v.pos >= clip.samples) {
+                if (!v.loop) {
+                    v.clip = -1;
+                    activeVoices--;
+                    break;
+                }
+                v.pos = 0;
+                if (clip.codec == AUDIO_IMA_ADPCM) {
+                    v.state = imaReadHeader(clip.data);
+                }
+            }
+            int16_t sample;
+            if (clip.codec == AUDIO_IMA_ADPCM) {
+                uint8_t byte = clip.data[IMA_HEADER_BYTES + (v.pos >> 1)];
+                sample = imaDecodeSample(v.state, (v.pos & 1) ? byte >> 4 : byte & 0x0F);
+            } else {
+                sample = ((const int16_t *)clip.data)[v.pos];
+            }
+            mix[n] += (sample * gain) >> 8;
+            v.pos++;
+        }
+    }
+
+    if (streamPlaying) {
+        size_t n = stream->read(streamBlock, BLOCK_FRAMES);
+        for (size_t i = 0; i < n; i++) {
+            mix[i] += streamBlock[i];
+        }
+        if (n < BLOCK_FRAMES) {
+            if (streamEnding) {
+                dropStream();
+            } else {
+                // Underrun: phần thiếu là im lặng, chờ đủ prebuffer rồi phát tiếp
+                streamPlaying = false;
+                streamUnderruns++;
+            }
+        }
+    }
+
+    int32_t master = masterGain;
+    for (uint16_t n = 0; n < BLOCK_FRAMES; n++) {
+        int16_t s = (int16_t)constrain((mix[n] * master) >> 8, -32768, 32767);
+        out[2 * n] = s;
+        out[2 * n + 1] = s;
+        mono[n] = s;
+    }
+}
+
+void SpeakerI2S::setPlaybackTap(PlaybackTap tap) {
+    playbackTap = tap;
+}
+
+// ============================================
+// GETTERS
+// ============================================
+
+uint32_t SpeakerI2S::getStreamUnderruns() const {
+    return streamUnderruns;
+}
+
+uint32_t SpeakerI2S::getStreamStartLatencyUs() const {
+    return streamStartLatencyUs;
+}
+
+uint32_t SpeakerI2S::getClipsStarted() const {
+    return clipsStarted;
+}
+
+uint32_t SpeakerI2S::getPreempted() const {
+    return preempted;
+}
+
+uint32_t SpeakerI2S::getRejected() const {
+    return rejected;
+}
+
+uint32_t SpeakerI2S::getLastStartLatencyUs() const {
+    return lastStartLatencyUs;
+}
+
+uint32_t SpeakerI2S::getMaxStartLatencyUs() const {
+    return maxStartLatencyUs;
+}
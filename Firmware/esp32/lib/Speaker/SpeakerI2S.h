@@ -1,15 +1,149 @@
-// #pragma once
+#pragma once
 
-// #include <Arduino.h>
-// #include <driver/i2s.h>
+#include <Arduino.h>
+#include <driver/i2s.h>
+#include <functional>
+#include "BinaryFrame.h"
+#include "ImaAdpcm.h"
+#include "PcmRing.h"
 
-// class SpeakerI2S {
-// private:
-//     i2s_port_t i2s_num;
-// public:
-//     SpeakerI2S(i2s_port_t port = I2S_NUM_0);
-//     void begin(int bclk, int lrc, int din);
-//     void playBuffer(int16_t *buffer, size_t samples);
-// };
+// ======================================================
+// 🔔 Phát clip PCM/ADPCM nạp sẵn thẳng ra I2S (không HTTP, không MP3)
+// ======================================================
+//
+// Clip nằm trong flash (mảng const) hoặc được nạp từ LittleFS vào RAM lúc
+// khởi động. Task mixer trộn tối đa MAX_VOICES clip theo block BLOCK_FRAMES
+// (8 ms) rồi i2s_write, nên lệnh play() có hiệu lực ở block kế tiếp.
+//
+// Clip ưu tiên >= PRIORITY_ALARM chiếm loa: dừng mọi clip thấp hơn và xả DMA
+// để còi báo động không phải chờ audio cũ phát hết.
+//
+// Ngoài clip còn một luồng PCM (openStream) đọc từ PcmRing, dùng cho TTS:
+// chỉ bắt đầu phát khi ring có đủ prebuffer (jitter buffer), thiếu mẫu giữa
+// chừng thì chèn im lặng và buffer lại. Báo động cũng chiếm quyền luồng này.
+//
+// Dùng chung I2S0 với thư viện Audio: nếu driver đã được cài thì chỉ đặt lại
+// clock 16 kHz stereo khi bắt đầu phát. Người gọi (MAX98357A) phải dừng stream
+// HTTP trước khi phát clip.
 
+class SpeakerI2S {
+public:
+    // Block mono vừa ghi vào DMA + thời điểm ghi xong (cho AEC), gọi trong task mixer
+    using PlaybackTap = std::function<void(const int16_t *pcm, size_t count, int64_t playoutUs)>;
 
+    static const uint8_t MAX_CLIPS = 8;
+    static const uint8_t MAX_VOICES = 4;
+    static const uint16_t BLOCK_FRAMES = 128;
+    static const uint8_t PRIORITY_NORMAL = 0;
+    static const uint8_t PRIORITY_VOICE = 100;
+    static const uint8_t PRIORITY_ALARM = 200;
+    static const uint16_t GAIN_UNITY = 256;
+
+    SpeakerI2S(i2s_port_t port = I2S_NUM_0, uint32_t sampleRate = 16000);
+
+    bool begin(int bclk, int lrc, int din, BaseType_t core = 1, UBaseType_t priority = 15);
+
+    // Đăng ký clip, trả về id (>= 0) hoặc -1. Dữ liệu flash không bị copy.
+    int8_t addClip(const int16_t *pcm, uint32_t samples);
+    int8_t addAdpcmClip(const uint8_t *data, size_t bytes);     // header IMA + mã 4 bit
+    int8_t addTone(uint16_t freqHz, uint16_t ms, int16_t amplitude = 12000);
+    int8_t loadClip(const char *path);                          // ".pcm" (s16le) hoặc ".adp"
+
+    // gain: GAIN_UNITY = 1.0; loop: lặp tới khi stop()
+    bool play(int8_t clip, uint8_t priority = PRIORITY_NORMAL, uint16_t gain = GAIN_UNITY, bool loop = false);
+    void stop(int8_t clip);
+    void stopAll();
+    bool isPlaying() const;
+    void setMasterGain(uint16_t gain);
+
+    // Luồng PCM (một producer ghi ring, mixer đọc). Mẫu ghi trước openStream() bị bỏ.
+    bool openStream(PcmRing *ring, uint8_t priority = PRIORITY_VOICE, uint32_t prebufferSamples = 960);
+    void endStream();             // phát nốt phần còn trong ring rồi đóng
+    void closeStream();           // đóng ngay, bỏ phần còn lại
+    bool isStreamOpen() const;    // false khi đã đóng hoặc bị báo động chiếm
+    uint32_t getStreamUnderruns() const;
+    uint32_t getStreamStartLatencyUs() const;   // openStream() -> block đầu tiên vào DMA
+
+    void setPlaybackTap(PlaybackTap tap);   // gọi trước begin()
+
+    uint32_t getClipsStarted() const;
+    uint32_t getPreempted() const;
+    uint32_t getRejected() const;
+    uint32_t getLastStartLatencyUs() const;   // play() -> block đầu tiên vào DMA
+    uint32_t getMaxStartLatencyUs() const;
+
+private:
+    struct Clip {
+        const uint8_t *data;
+        uint32_t samples;
+        AudioCodec codec;
+    };
+
+    struct Voice {
+        int8_t clip;             // -1 = trống
+        uint32_t pos;
+        ImaAdpcmState state;
+        uint8_t priority;
+        uint16_t gain;
+        bool loop;
+        int64_t requestedUs;     // > 0 cho tới khi block đầu tiên được ghi
+    };
+
+    enum CommandOp : uint8_t { CMD_PLAY, CMD_STOP, CMD_STOP_ALL, CMD_STREAM_OPEN, CMD_STREAM_END, CMD_STREAM_CLOSE };
+
+    struct Command {
+        CommandOp op;
+        int8_t clip;
+        uint8_t priority;
+        uint16_t gain;
+        bool loop;
+        int64_t requestedUs;
+        PcmRing *ring;           // CMD_STREAM_OPEN
+        size_t startAt;          // vị trí ring lúc mở, mẫu cũ hơn bị bỏ
+        uint32_t prebuffer;
+    };
+
+    static void taskLoop(void *arg);
+    void apply(const Command &cmd);
+    void startVoice(const Command &cmd);
+    void mixBlock();
+    void pollStream();
+    void dropStream();
+    void flushDma();
+    int8_t registerClip(const uint8_t *data, uint32_t samples, AudioCodec codec);
+
+    i2s_port_t port;
+    uint32_t sampleRate;
+    QueueHandle_t commands;
+    TaskHandle_t task;
+
+    Clip clips[MAX_CLIPS];
+    uint8_t clipCount;
+    Voice voices[MAX_VOICES];
+    volatile uint8_t activeVoices;
+    uint16_t masterGain;
+    bool clockSet;               // đã đặt clock cho đợt phát hiện tại
+
+    PcmRing *stream;
+    volatile bool streamOpen;
+    bool streamEnding;
+    bool streamPlaying;
+    uint8_t streamPriority;
+    uint32_t streamPrebuffer;
+    size_t streamStartAt;
+    int64_t streamRequestedUs;
+    int16_t streamBlock[BLOCK_FRAMES];
+    uint32_t streamUnderruns;
+    uint32_t streamStartLatencyUs;
+
+    int32_t mix[BLOCK_FRAMES];
+    int16_t out[BLOCK_FRAMES * 2];   // stereo xen kẽ L/R
+    int16_t mono[BLOCK_FRAMES];      // bản mono của out cho playbackTap
+    PlaybackTap playbackTap;
+
+    uint32_t clipsStarted;
+    uint32_t preempted;
+    uint32_t rejected;
+    uint32_t lastStartLatencyUs;
+    uint32_t maxStartLatencyUs;
+};
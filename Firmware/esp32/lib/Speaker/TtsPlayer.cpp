@@ -0,0 +1,191 @@
+#include "TtsPlayer.h"
+#include "ImaAdpcm.h"
+#include <esp_timer.h>
+
+TtsPlayer::TtsPlayer(MAX98357A &speaker, uint32_t sampleRate)
+    : speaker(speaker), sampleRate(sampleRate), prebufferSamples(0),
+      active(false), streamId(0), expectedSeq(0), sessionStartUs(0),
+      mutex(xSemaphoreCreateMutex()), pendingSpans{}, pendingSpanCount(0),
+#ifdef HOMEGUARD_OPUS
+      opus(nullptr),
+#endif
+      frames(0), seqGaps(0), droppedFrames(0), overflowSamples(0) {}
+
+bool TtsPlayer::begin(uint16_t bufferMs, uint16_t prebufferMs) {
+    prebufferSamples = (uint32_t)prebufferMs * sampleRate / 1000;
+#ifdef HOMEGUARD_OPUS
+    int error = OPUS_OK;
+    opus = opus_decoder_create(sampleRate, 1, &error);
+    if (error != OPUS_OK) {
+        opus = nullptr;
+    }
+#endif
+    return ring.begin((size_t)bufferMs * sampleRate / 1000);
+}
+
+void TtsPlayer::lock() const {
+    if (mutex != nullptr) {
+        xSemaphoreTake(mutex, portMAX_DELAY);
+    }
+}
+
+void TtsPlayer::unlock() const {
+    if (mutex != nullptr) {
+        xSemaphoreGive(mutex);
+    }
+}
+
+void TtsPlayer::unlockAndReport() {
+    Span spans[2];
+    uint8_t count = pendingSpanCount;
+    memcpy(spans, pendingSpans, count * sizeof(Span));
+    pendingSpanCount = 0;
+    unlock();
+    for (uint8_t i = 0; i < count && spanSink; i++) {
+        spanSink("tts.playback", spans[i].startUs, spans[i].endUs);
+    }
+}
+
+bool TtsPlayer::startSession(uint16_t id) {
+    if (active) {
+        speaker.getClips().closeStream();
+        reportSpan(esp_timer_get_time());
+    }
+    streamId = id;
+    sessionStartUs = esp_timer_get_time();
+    active = speaker.openStream(&ring, prebufferSamples);
+#ifdef HOMEGUARD_OPUS
+    if (opus != nullptr) {
+        opus_decoder_ctl(opus, OPUS_RESET_STATE);
+    }
+#endif
+    return active;
+}
+
+void TtsPlayer::handleFrame(const FrameHeader &header, const AudioHeader &audio,
+                            const uint8_t *payload, size_t bytes) {
+    lock();
+    if ((audio.flags & AUDIO_FLAG_START) || !active || audio.streamId != streamId) {
+        // Chunk giữa phiên của một phiên đã bị bỏ thì không mở lại
+        if (!(audio.flags & AUDIO_FLAG_START) && audio.streamId == streamId) {
+            droppedFrames++;
+            unlockAndReport();
+            return;
+        }
+        startSession(audio.streamId);
+    } else if (header.seq != expectedSeq) {
+        seqGaps += (uint16_t)(header.seq - expectedSeq);
+    }
+    expectedSeq = header.seq + 1;
+
+    // Báo động đã chiếm loa: bỏ phần còn lại của phiên
+    if (!active || !speaker.getClips().isStreamOpen()) {
+        if (active) {
+            reportSpan(esp_timer_get_time());
+        }
+        active = false;
+        droppedFrames++;
+        unlockAndReport();
+        return;
+    }
+
+    size_t samples = decode(audio, payload, bytes);
+    if (samples == 0 && bytes > 0) {
+        droppedFrames++;
+    } else {
+        frames++;
+        overflowSamples += samples - ring.write(pcm, samples);
+    }
+
+    if (audio.flags & AUDIO_FLAG_END) {
+        speaker.getClips().endStream();
+        active = false;
+        reportSpan(esp_timer_get_time() + (int64_t)ring.available() * 1000000 / sampleRate);
+    }
+    unlockAndReport();
+}
+
+size_t TtsPlayer::decode(const AudioHeader &audio, const uint8_t *payload, size_t bytes) {
+    size_t samples = min<size_t>(audio.samples, MAX_CHUNK_SAMPLES);
+    switch (audio.codec) {
+        case AUDIO_PCM16:
+            // payload không căn chỉnh 2 byte, copy thay vì ép kiểu
+            samples = min(samples, bytes / sizeof(int16_t));
+            memcpy(pcm, payload, samples * sizeof(int16_t));
+            return samples;
+        case AUDIO_IMA_ADPCM: {
+            if (bytes < IMA_HEADER_BYTES) {
+                return 0;
+            }
+            samples = min(samples, (bytes - IMA_HEADER_BYTES) * 2);
+            ImaAdpcmState state = imaReadHeader(payload);
+            const uint8_t *codes = payload + IMA_HEADER_BYTES;
+            for (size_t i = 0; i < samples; i++) {
+                uint8_t byte = codes[i >> 1];
+                pcm[i] = imaDecodeSample(state, (i & 1) ? byte >> 4 : byte & 0x0F);
+            }
+            return samples;
+        }
+#ifdef HOMEGUARD_OPUS
+        case AUDIO_OPUS: {
+            if (opus == nullptr) {
+                return 0;
+            }
+            int decoded = opus_decode(opus, payload, (opus_int32)bytes, pcm, MAX_CHUNK_SAMPLES, 0);
+            return decoded > 0 ? (size_t)decoded : 0;
+        }
+#endif
+        default:
+            return 0;
+    }
+}
+
+void TtsPlayer::stop() {
+    lock();
+    if (active) {
+        speaker.getClips().closeStream();
+        active = false;
+        reportSpan(esp_timer_get_time());
+    }
+    unlockAndReport();
+}
+
+bool TtsPlayer::isActive() const {
+    lock();
+    bool playing = active;
+    unlock();
+    return playing;
+}
+
+void TtsPlayer::setSpanSink(SpanSink sink) {
+    spanSink = sink;
+}
+
+void TtsPlayer::reportSpan(int64_t endUs) {
+    if (pendingSpanCount < 2) {
+        pendingSpans[pendingSpanCount++] = { sessionStartUs, endUs };
+    }
+}
+
+uint32_t TtsPlayer::getFrames() const {
+    return frames;
+}
+
+uint32_t TtsPlayer::getSeqGaps() const {
+    return seqGaps;
+}
+
+uint32_t TtsPlayer::getDroppedFrames() const {
+    return droppedFrames;
+}
+
+uint32_t TtsPlayer::getOverflowSamples() const {
+    return overflowSamples;
+}
+
+void TtsPlayer::printStats(Print &out) const {
+    SpeakerI2S &clips = speaker.getClips();
+    out.printf("[TTS] frames=%u gaps=%u dropped=%u overflow=%u underruns=%u start_latency=%uus\n",
+               frames, seqGaps, droppedFrames, overflowSamples,
+               clips.getStreamUnderruns(), clips.getStreamStartLatencyUs());
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+#include "MAX98357A.h"
+#include "PcmRing.h"
+#include "BinaryFrame.h"
+#ifdef HOMEGUARD_OPUS
+#include <opus.h>
+#endif
+
+// ======================================================
+// 🗣️ Phát TTS từ frame CHANNEL_AUDIO_DOWN ngay khi chunk đầu tới
+// ======================================================
+//
+// WebSocketClient (task mạng, core 0) gọi handleFrame() cho từng chunk; chunk
+// được giải mã (pcm16 / adpcm / opus nếu bật HOMEGUARD_OPUS) vào ring làm jitter
+// buffer, SpeakerI2S đọc ring trong task mixer. Phát bắt đầu khi ring có
+// prebufferMs, không chờ tải hết câu trả lời. Downlink phải là 16 kHz mono.
+//
+// stop() / isActive() được gọi từ task voice của loop (barge-in, core 1): trạng
+// thái phiên đi qua một mutex. Span được báo sau khi nhả mutex vì sink
+// (WebSocketClient::recordSpan) lấy khoá của task mạng.
+//
+// Phiên mới (streamId khác hoặc AUDIO_FLAG_START) thay phiên cũ; báo động
+// chiếm loa thì phần còn lại của phiên bị bỏ.
+//
+// setSpanSink(): mỗi phiên báo một span "tts.playback" (esp_timer) từ chunk
+// đầu tới lúc mẫu cuối ra loa (ước lượng theo phần còn trong ring khi nhận
+// AUDIO_FLAG_END), hoặc tới lúc bị ngắt.
+
+using SpanSink = std::function<void(const char *name, int64_t startUs, int64_t endUs)>;
+
+class TtsPlayer {
+public:
+    static const uint16_t MAX_CHUNK_SAMPLES = AUDIO_MAX_PAYLOAD * 2;   // adpcm 4 bit/mẫu
+
+    TtsPlayer(MAX98357A &speaker, uint32_t sampleRate = 16000);
+
+    bool begin(uint16_t bufferMs = 1000, uint16_t prebufferMs = 60);
+    void handleFrame(const FrameHeader &header, const AudioHeader &audio,
+                     const uint8_t *payload, size_t bytes);
+    void stop();
+    bool isActive() const;
+    void setSpanSink(SpanSink sink);
+
+    uint32_t getFrames() const;
+    uint32_t getSeqGaps() const;          // frame thiếu theo seq
+    uint32_t getDroppedFrames() const;    // ngoài phiên / bị báo động chiếm / lỗi giải mã
+    uint32_t getOverflowSamples() const;  // ring đầy, server gửi nhanh hơn phát
+    void printStats(Print &out = Serial) const;
+
+private:
+    struct Span {
+        int64_t startUs;
+        int64_t endUs;
+    };
+
+    size_t decode(const AudioHeader &audio, const uint8_t *payload, size_t bytes);
+    bool startSession(uint16_t streamId);
+    void reportSpan(int64_t endUs);      // ghi lại, báo ở unlockAndReport()
+    void lock() const;
+    void unlock() const;
+    void unlockAndReport();              // nhả mutex rồi mới gọi spanSink
+
+    MAX98357A &speaker;
+    uint32_t sampleRate;
+    uint32_t prebufferSamples;
+    PcmRing ring;
+    int16_t pcm[MAX_CHUNK_SAMPLES];
+
+    bool active;
+    uint16_t streamId;
+    uint16_t expectedSeq;
+    int64_t sessionStartUs;      // esp_timer lúc nhận chunk đầu của phiên
+    SpanSink spanSink;
+    mutable SemaphoreHandle_t mutex;
+    Span pendingSpans[2];        // một handleFrame() đóng tối đa phiên cũ và phiên mới
+    uint8_t pendingSpanCount;
+#ifdef HOMEGUARD_OPUS
+    OpusDecoder *opus;
+#endif
+
+    uint32_t frames;
+    uint32_t seqGaps;
+    uint32_t droppedFrames;
+    uint32_t overflowSamples;
+};
@@ -0,0 +1,155 @@
+#include "AlertRules.h"
+#include <math.h>
+
+// Tương đương ngưỡng cũ của getAlertLevel, thêm trễ/dwell/tốc độ đổi và send-on-delta
+static const AlertRule DEFAULT_RULES[SENSOR_KIND_COUNT] = {
+  //  high {warn, danger, crit}   low {warn, danger, crit}    hyst  dwell  rate/s rateLevel             delta heartbeat
+  { { NAN, 35.0f, 40.0f }, { 15.0f, NAN, NAN }, 0.5f, 2000, 0.05f, AlertLevel::WARNING, 0.5f, 60000 },   // temperature
+  { { 85.0f, NAN, NAN },   { 20.0f, NAN, NAN }, 2.0f, 5000, 0.0f,  AlertLevel::WARNING, 2.0f, 60000 },   // humidity
+  { { 100.0f, 200.0f, 300.0f }, { NAN, NAN, NAN }, 10.0f, 1000, 50.0f, AlertLevel::WARNING, 10.0f, 60000 }, // gas
+  { { NAN, NAN, NAN },     { NAN, NAN, NAN },   0.0f, 0,    0.0f,  AlertLevel::WARNING, 5.0f, 30000 },   // distance
+  { { NAN, NAN, NAN },     { NAN, NAN, NAN },   0.0f, 0,    0.0f,  AlertLevel::WARNING, 0.0f, 0 },       // motion
+  { { NAN, NAN, NAN },     { NAN, NAN, NAN },   0.0f, 0,    0.0f,  AlertLevel::WARNING, 0.0f, 0 },       // flame
+  { { NAN, NAN, NAN },     { NAN, NAN, NAN },   0.0f, 0,    0.0f,  AlertLevel::WARNING, 0.0f, 0 },       // light
+  { { NAN, NAN, NAN },     { NAN, NAN, NAN },   0.0f, 0,    0.0f,  AlertLevel::WARNING, 0.0f, 0 },       // sound
+};
+
+AlertRules::AlertRules() : reported(0), suppressed(0) {
+  loadDefaults();
+}
+
+void AlertRules::loadDefaults() {
+  memcpy(table, DEFAULT_RULES, sizeof(table));
+  memset(states, 0, sizeof(states));
+}
+
+AlertLevel AlertRules::levelFor(const AlertRule& rule, float value, float shift) {
+  // NAN so sánh luôn false nên ngưỡng tắt tự bị bỏ qua
+  AlertLevel level = AlertLevel::NORMAL;
+  for (uint8_t i = 0; i < 3; i++) {
+    if (value > rule.high[i] - shift || value < rule.low[i] + shift) {
+      level = (AlertLevel)(i + 1);
+    }
+  }
+  return level;
+}
+
+AlertLevel AlertRules::classify(SensorKind sensor, float value) const {
+  return sensor < SENSOR_KIND_COUNT ? levelFor(table[sensor], value, 0.0f) : AlertLevel::NORMAL;
+}
+
+AlertLevel AlertRules::currentLevel(SensorKind sensor) const {
+  return sensor < SENSOR_KIND_COUNT ? states[sensor].level : AlertLevel::NORMAL;
+}
+
+AlertDecision AlertRules::evaluate(SensorKind sensor, float value, uint32_t nowMs) {
+  if (sensor >= SENSOR_KIND_COUNT) {
+    reported++;
+    return AlertDecision{ AlertLevel::NORMAL, true, false };
+  }
+  const AlertRule& r = table[sensor];
+  State& s = states[sensor];
+
+  // Hysteresis: chỉ hạ mức khi giá trị đã lùi qua ngưỡng thêm r.hysteresis
+  AlertLevel target = levelFor(r, value, 0.0f);
+  if (target < s.level) {
+    AlertLevel held = levelFor(r, value, r.hysteresis);
+    target = max(target, min(held, s.level));
+  }
+
+  if (r.ratePerSec > 0 && s.seen && nowMs != s.lastMs) {
+    float rate = fabsf(value - s.lastValue) * 1000.0f / (float)(nowMs - s.lastMs);
+    if (rate >= r.ratePerSec && target < r.rateLevel) {
+      target = r.rateLevel;
+    }
+  }
+  s.lastValue = value;
+  s.lastMs = nowMs;
+  s.seen = true;
+
+  // Dwell: mức mới phải đứng yên đủ lâu, dao động qua lại ngưỡng thì bắt đầu đếm lại
+  bool changed = false;
+  if (target == s.level) {
+    s.pending = s.level;
+  } else {
+    if (target != s.pending) {
+      s.pending = target;
+      s.pendingSince = nowMs;
+    }
+    if (nowMs - s.pendingSince >= r.dwellMs) {
+      s.level = target;
+      changed = true;
+    }
+  }
+
+  bool report = !s.reported || changed || r.delta <= 0 ||
+                fabsf(value - s.reportedValue) >= r.delta ||
+                (r.heartbeatMs > 0 && nowMs - s.reportedMs >= r.heartbeatMs);
+  if (report) {
+    s.reportedValue = value;
+    s.reportedMs = nowMs;
+    s.reported = true;
+    reported++;
+  } else {
+    suppressed++;
+  }
+  return AlertDecision{ s.level, report, changed };
+}
+
+// ============================================
+// CẬP NHẬT TỪ SERVER
+// ============================================
+
+// Vắng mặt và null đều ra isNull(), nên phải dò key để phân biệt "giữ nguyên" với "tắt"
+static void readThresholds(JsonObjectConst rule, const char* key, float* dst) {
+  for (JsonPairConst field : rule) {
+    if (strcmp(field.key().c_str(), key) != 0) {
+      continue;
+    }
+    JsonVariantConst value = field.value();
+    if (!value.isNull() && !value.is<JsonArrayConst>()) {
+      return;                                   // sai kiểu: giữ nguyên
+    }
+    JsonArrayConst values = value.as<JsonArrayConst>();   // null: mảng rỗng, tắt cả ba mức
+    for (uint8_t i = 0; i < 3; i++) {
+      dst[i] = i < values.size() && values[i].is<float>() ? values[i].as<float>() : NAN;
+    }
+    return;
+  }
+}
+
+uint8_t AlertRules::apply(JsonArrayConst rules) {
+  uint8_t updated = 0;
+  for (JsonObjectConst src : rules) {
+    SensorKind sensor = sensorKindFromName(src["sensor"] | "");
+    if (sensor >= SENSOR_KIND_COUNT) {
+      continue;
+    }
+    AlertRule& r = table[sensor];
+    readThresholds(src, "high", r.high);
+    readThresholds(src, "low", r.low);
+    r.hysteresis = src["hysteresis"] | r.hysteresis;
+    r.dwellMs = src["dwellMs"] | r.dwellMs;
+    r.ratePerSec = src["rate"] | r.ratePerSec;
+    r.rateLevel = alertLevelFromName(src["rateLevel"] | "", r.rateLevel);
+    r.delta = src["delta"] | r.delta;
+    r.heartbeatMs = src["heartbeatMs"] | r.heartbeatMs;
+
+    // Mẫu kế tiếp luôn được gửi để server thấy kết quả theo luật mới
+    states[sensor].reported = false;
+    updated++;
+  }
+  return updated;
+}
+
+AlertRule* AlertRules::rule(SensorKind sensor) {
+  return sensor < SENSOR_KIND_COUNT ? &table[sensor] : nullptr;
+}
+
+uint32_t AlertRules::getReported() const {
+  return reported;
+}
+
+uint32_t AlertRules::getSuppressed() const {
+  return suppressed;
+}
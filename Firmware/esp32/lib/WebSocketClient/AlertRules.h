@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "BinaryFrame.h"
+#include "MessageTypes.h"
+
+// ======================================================
+// 🚨 Luật cảnh báo tại robot: ngưỡng, trễ (hysteresis), dwell, tốc độ đổi
+// ======================================================
+//
+// Mỗi SensorKind có một luật trong bảng cố định, đánh giá ngay lúc lấy mẫu:
+//   - high[i] / low[i]: vượt lên trên / xuống dưới thì ít nhất mức WARNING,
+//     DANGER, CRITICAL (i = 0, 1, 2); NAN = tắt ngưỡng đó
+//   - hysteresis: muốn hạ mức phải lùi qua ngưỡng thêm chừng này
+//   - dwellMs: mức mới phải giữ liên tục chừng này mới được nhận
+//   - ratePerSec: |Δgiá trị|/s giữa hai mẫu vượt ngưỡng thì ít nhất rateLevel
+//   - delta / heartbeatMs: send-on-delta, chỉ gửi khi đổi mức, lệch so với
+//     lần gửi trước >= delta, hoặc đã im lặng heartbeatMs
+//
+// Server đổi luật qua BEHAVIOR_UPDATE:
+//   {"type":"behavior_update","payload":{"alertRules":[
+//     {"sensor":"gas","high":[120,220,320],"hysteresis":15,"dwellMs":2000,
+//      "rate":40,"rateLevel":"warning","delta":10,"heartbeatMs":60000}]}}
+// Trường vắng mặt giữ nguyên giá trị cũ; "high"/"low" thay cả mảng (phần tử null
+// = tắt mức đó, "high":null = tắt cả ba mức).
+
+struct AlertRule {
+  float high[3];
+  float low[3];
+  float hysteresis;
+  uint32_t dwellMs;
+  float ratePerSec;             // 0 = tắt
+  AlertLevel rateLevel;
+  float delta;                  // 0 = gửi mọi mẫu
+  uint32_t heartbeatMs;         // 0 = không gửi lại khi giá trị đứng yên
+};
+
+struct AlertDecision {
+  AlertLevel level;             // mức sau hysteresis/dwell
+  bool report;                  // nên gửi mẫu này lên server
+  bool changed;                 // mức vừa đổi ở mẫu này
+};
+
+class AlertRules {
+public:
+  AlertRules();
+
+  void loadDefaults();                                   // bảng biên dịch sẵn, xoá trạng thái
+  // Có trạng thái: gọi mỗi khi lấy một mẫu mới của cảm biến
+  AlertDecision evaluate(SensorKind sensor, float value, uint32_t nowMs);
+  // Chỉ so ngưỡng, không hysteresis/dwell/trạng thái
+  AlertLevel classify(SensorKind sensor, float value) const;
+  AlertLevel currentLevel(SensorKind sensor) const;
+
+  // Mảng "alertRules" của BEHAVIOR_UPDATE, trả về số luật đã đổi
+  uint8_t apply(JsonArrayConst rules);
+  AlertRule* rule(SensorKind sensor);                   // nullptr nếu không có luật
+
+  uint32_t getReported() const;
+  uint32_t getSuppressed() const;                       // mẫu bỏ nhờ send-on-delta
+
+private:
+  struct State {
+    AlertLevel level;
+    AlertLevel pending;         // mức đang chờ đủ dwell
+    uint32_t pendingSince;
+    float lastValue;
+    uint32_t lastMs;
+    float reportedValue;
+    uint32_t reportedMs;
+    bool seen;
+    bool reported;
+  };
+
+  AlertRule table[SENSOR_KIND_COUNT];
+  State states[SENSOR_KIND_COUNT];
+  uint32_t reported;
+  uint32_t suppressed;
+
+  static AlertLevel levelFor(const AlertRule& rule, float value, float shift);
+};
@@ -0,0 +1,168 @@
+#include "JsonArena.h"
+
+// ============================================
+// JSON ARENA
+// ============================================
+
+JsonArena::JsonArena(uint8_t* buffer, size_t capacity)
+    : buffer(buffer), size(capacity), top(0), last(SIZE_MAX), peakUsed(0), failures(0) {}
+
+size_t JsonArena::alignUp(size_t size) {
+  return (size + ALIGN - 1) & ~(ALIGN - 1);
+}
+
+size_t JsonArena::blockSize(const void* ptr) const {
+  size_t bytes;
+  memcpy(&bytes, (const uint8_t*)ptr - HEADER, sizeof(bytes));
+  return bytes;
+}
+
+void* JsonArena::allocate(size_t bytes) {
+  size_t need = HEADER + alignUp(bytes);
+  if (need > size - top) {
+    failures++;
+    return nullptr;
+  }
+  uint8_t* block = buffer + top;
+  memcpy(block, &bytes, sizeof(bytes));
+  last = top;
+  top += need;
+  peakUsed = max(peakUsed, top);
+  return block + HEADER;
+}
+
+void JsonArena::deallocate(void* ptr) {
+  // Chỉ khối trên cùng được trả ngay (chuỗi tạm của parser); còn lại chờ reset()
+  if (ptr != nullptr && (uint8_t*)ptr - HEADER == buffer + last) {
+    top = last;
+    last = SIZE_MAX;
+  }
+}
+
+void* JsonArena::reallocate(void* ptr, size_t newSize) {
+  if (ptr == nullptr) {
+    return allocate(newSize);
+  }
+  uint8_t* block = (uint8_t*)ptr - HEADER;
+  if (block == buffer + last) {
+    // Khối trên cùng: nới hoặc thu tại chỗ
+    size_t need = HEADER + alignUp(newSize);
+    if (need > size - last) {
+      failures++;
+      return nullptr;
+    }
+    memcpy(block, &newSize, sizeof(newSize));
+    top = last + need;
+    peakUsed = max(peakUsed, top);
+    return ptr;
+  }
+  size_t oldSize = blockSize(ptr);
+  if (newSize <= oldSize) {
+    return ptr;
+  }
+  void* moved = allocate(newSize);
+  if (moved != nullptr) {
+    memcpy(moved, ptr, oldSize);
+  }
+  return moved;
+}
+
+void JsonArena::reset() {
+  top = 0;
+  last = SIZE_MAX;
+}
+
+size_t JsonArena::used() const {
+  return top;
+}
+
+size_t JsonArena::peak() const {
+  return peakUsed;
+}
+
+size_t JsonArena::capacity() const {
+  return size;
+}
+
+uint32_t JsonArena::getFailures() const {
+  return failures;
+}
+
+// ============================================
+// DOCUMENT POOL
+// ============================================
+
+JsonDocPool::Slot::Slot() : arena(buffer, ARENA_BYTES), doc(&arena), inUse(false) {}
+
+JsonDocPool::JsonDocPool() : exhausted(0), lock(portMUX_INITIALIZER_UNLOCKED) {}
+
+JsonDocument* JsonDocPool::acquire() {
+  JsonDocument* doc = nullptr;
+  portENTER_CRITICAL(&lock);
+  for (uint8_t i = 0; i < SLOTS; i++) {
+    if (!slots[i].inUse) {
+      slots[i].inUse = true;
+      doc = &slots[i].doc;
+      break;
+    }
+  }
+  if (doc == nullptr) {
+    exhausted++;
+  }
+  portEXIT_CRITICAL(&lock);
+  return doc;
+}
+
+void JsonDocPool::release(JsonDocument* doc) {
+  for (uint8_t i = 0; i < SLOTS; i++) {
+    if (&slots[i].doc == doc) {
+      // Slot vẫn thuộc người gọi tới khi inUse = false, chỉ cờ cần nằm trong khoá
+      slots[i].doc.clear();
+      slots[i].arena.reset();
+      portENTER_CRITICAL(&lock);
+      slots[i].inUse = false;
+      portEXIT_CRITICAL(&lock);
+      return;
+    }
+  }
+}
+
+size_t JsonDocPool::peakUsed() const {
+  size_t peak = 0;
+  for (uint8_t i = 0; i < SLOTS; i++) {
+    peak = max(peak, slots[i].arena.peak());
+  }
+  return peak;
+}
+
+uint32_t JsonDocPool::getFailures() const {
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < SLOTS; i++) {
+    total += slots[i].arena.getFailures();
+  }
+  return total;
+}
+
+uint32_t JsonDocPool::getExhausted() const {
+  return exhausted;
+}
+
+// ============================================
+// LEASE
+// ============================================
+
+JsonDocLease::JsonDocLease(JsonDocPool& pool) : pool(pool), doc(pool.acquire()) {}
+
+JsonDocLease::~JsonDocLease() {
+  if (doc != nullptr) {
+    pool.release(doc);
+  }
+}
+
+JsonDocument* JsonDocLease::get() const {
+  return doc;
+}
+
+JsonDocLease::operator bool() const {
+  return doc != nullptr;
+}
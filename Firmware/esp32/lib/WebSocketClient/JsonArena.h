@@ -0,0 +1,92 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// ======================================================
+// 🧱 Arena cấp phát cho ArduinoJson, không đụng tới heap
+// ======================================================
+//
+// ArduinoJson 7 luôn cấp phát (kể cả StaticJsonDocument), nên mỗi message
+// nhận được từng tạo và trả nhiều khối nhỏ trên heap; chạy nhiều ngày thì heap
+// phân mảnh tới mức không cấp nổi buffer WebSocket. JsonArena là bump
+// allocator trên một buffer cố định: khối cuối cùng được nới/thu tại chỗ,
+// các khối khác chỉ được thu hồi khi reset() sau mỗi message.
+//
+// JsonDocPool giữ vài JsonDocument gắn sẵn arena riêng để dùng lại cho mọi
+// message; JsonDocLease mượn một document và trả lại (clear + reset) khi ra
+// khỏi scope. acquire()/release() khoá ngắn nên một pool dùng chung được cho
+// nhiều task (ví dụ task EventBus và loop()).
+
+class JsonArena : public ArduinoJson::Allocator {
+public:
+  JsonArena(uint8_t* buffer, size_t capacity);
+
+  void* allocate(size_t size) override;
+  void deallocate(void* ptr) override;
+  void* reallocate(void* ptr, size_t newSize) override;
+
+  void reset();                   // Thu hồi toàn bộ, chỉ gọi khi document đã clear()
+  size_t used() const;
+  size_t peak() const;            // Mức dùng cao nhất từ lúc khởi động
+  size_t capacity() const;
+  uint32_t getFailures() const;   // Số lần hết chỗ (deserializeJson trả NoMemory)
+
+private:
+  static const size_t ALIGN = 8;
+  static const size_t HEADER = ALIGN;   // lưu kích thước khối ngay trước dữ liệu
+
+  static size_t alignUp(size_t size);
+  size_t blockSize(const void* ptr) const;
+
+  uint8_t* buffer;
+  size_t size;
+  size_t top;
+  size_t last;                    // offset khối cuối cùng (để nới tại chỗ)
+  size_t peakUsed;
+  uint32_t failures;
+};
+
+class JsonDocPool {
+public:
+  static const uint8_t SLOTS = 2;          // 1 cho message đang xử lý + 1 dự phòng khi handler lồng nhau
+  static const size_t ARENA_BYTES = 6144;
+
+  JsonDocPool();
+
+  JsonDocument* acquire();        // nullptr khi mọi slot đang bận
+  void release(JsonDocument* doc);
+
+  size_t peakUsed() const;        // Arena dùng nhiều nhất trong các slot
+  uint32_t getFailures() const;   // Tổng số lần hết arena
+  uint32_t getExhausted() const;  // Số lần acquire() không còn slot
+
+private:
+  struct Slot {
+    JsonArena arena;
+    JsonDocument doc;
+    bool inUse;
+    alignas(8) uint8_t buffer[ARENA_BYTES];
+    Slot();
+  };
+
+  Slot slots[SLOTS];
+  uint32_t exhausted;
+  portMUX_TYPE lock;
+};
+
+class JsonDocLease {
+public:
+  explicit JsonDocLease(JsonDocPool& pool);
+  ~JsonDocLease();
+
+  JsonDocument* get() const;
+  explicit operator bool() const;
+
+private:
+  JsonDocLease(const JsonDocLease&) = delete;
+  JsonDocLease& operator=(const JsonDocLease&) = delete;
+
+  JsonDocPool& pool;
+  JsonDocument* doc;
+};
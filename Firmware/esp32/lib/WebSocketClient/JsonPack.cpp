@@ -0,0 +1,115 @@
+#include "JsonPack.h"
+
+// Thứ tự là định dạng ("dict1"): chỉ thêm vào cuối khi đổi tên, không sắp xếp lại.
+// Khoá theo đúng thứ tự ArduinoJson serialize trong stampEnvelope() và các hàm send*.
+static const char* const JSON_PACK_DICT[] = {
+  // Envelope
+  "{\"id\":\"", "\",\"type\":\"", "\",\"source\":\"esp32\",\"robotId\":\"", "\",\"timestamp\":",
+  ",\"timeUs\":", ",\"traceId\":\"", "\",\"payload\":{", ",\"payload\":{", ",\"seq\":",
+  ",\"requiresAck\":true", "\",\"target\":\"ai_engine\"",
+  // Kiểu message
+  "connection_init", "sensor_data", "sensor_alert", "voice_command", "heartbeat", "status_update",
+  "error", "ack",
+  // Cảm biến
+  "\"sensorType\":\"", "\",\"sensorName\":\"", ",\"value\":", ",\"unit\":\"", "\",\"alertLevel\":\"",
+  ",\"location\":\"robot_main\"}", "\"readings\":[{", "},{", ",\"active\":", ",\"latencyUs\":",
+  ",\"restored\":true", "temperature", "humidity", "distance", "motion", "flame", "light", "sound",
+  "normal\"", "warning\"", "danger\"", "critical\"",
+  // Voice / status / trace
+  "\"status\":\"", "\"action\":\"", ",\"streamId\":", ",\"sampleRate\":16000", ",\"codec\":\"",
+  "pcm16", "adpcm", "opus", ",\"durationMs\":", "\"messageId\":\"", "\"error\":\"",
+  "\"clientSentUs\":", ",\"bootEpochUs\":", ",\"clock\":\"server\"", "\"clock\":\"",
+  ",\"clockRttUs\":", ",\"dropped\":", ",\"spans\":[{", "\"traceId\":\"", "\",\"name\":\"",
+  "\",\"startUs\":", ",\"durUs\":", "voice.capture", "voice.upload", "tts.playback", "screen.emotion",
+  // connection_init
+  "\"userId\":null", ",\"ipAddress\":\"", "\",\"resumeSeq\":", ",\"clientSentUs\":",
+  ",\"encodings\":[\"bin1\",\"json\"]", ",\"audioCodecs\":[\"", ",\"compression\":[\"dict1\"]",
+  // Chung
+  "true", "false", "}}", "\",\"", "\":\"", "\":"
+};
+
+static const uint8_t JSON_PACK_COUNT = sizeof(JSON_PACK_DICT) / sizeof(JSON_PACK_DICT[0]);
+static_assert(sizeof(JSON_PACK_DICT) / sizeof(JSON_PACK_DICT[0]) <= 127, "dict1 codes are 0x80..0xFE");
+
+static const uint8_t ESCAPE = 0xFF;
+
+JsonPacker::JsonPacker() : order{}, bucketStart{}, lengths{} {
+  // Counting sort theo ký tự đầu: pack() chỉ so các mục cùng ký tự đầu
+  uint8_t counts[FIRST_COUNT] = {};
+  for (uint8_t i = 0; i < JSON_PACK_COUNT; i++) {
+    lengths[i] = (uint8_t)strlen(JSON_PACK_DICT[i]);
+    counts[(uint8_t)JSON_PACK_DICT[i][0] - FIRST_MIN]++;
+  }
+  for (uint8_t c = 0; c < FIRST_COUNT; c++) {
+    bucketStart[c + 1] = bucketStart[c] + counts[c];
+  }
+  uint8_t fill[FIRST_COUNT];
+  memcpy(fill, bucketStart, sizeof(fill));
+  for (uint8_t i = 0; i < JSON_PACK_COUNT; i++) {
+    order[fill[(uint8_t)JSON_PACK_DICT[i][0] - FIRST_MIN]++] = i;
+  }
+}
+
+size_t JsonPacker::pack(const char* json, size_t length, uint8_t* out, size_t capacity) const {
+  size_t used = 0;
+  size_t pos = 0;
+  while (pos < length) {
+    uint8_t c = (uint8_t)json[pos];
+    int16_t best = -1;
+    uint8_t bestLength = 1;
+    if (c >= FIRST_MIN && c < 0x80) {
+      uint8_t bucket = c - FIRST_MIN;
+      for (uint8_t k = bucketStart[bucket]; k < bucketStart[bucket + 1]; k++) {
+        uint8_t i = order[k];
+        if (lengths[i] > bestLength && lengths[i] <= length - pos &&
+            memcmp(json + pos, JSON_PACK_DICT[i], lengths[i]) == 0) {
+          best = i;
+          bestLength = lengths[i];
+        }
+      }
+    }
+
+    size_t need = best >= 0 ? 1 : (c >= 0x80 ? 2 : 1);
+    if (used + need > capacity) {
+      return 0;
+    }
+    if (best >= 0) {
+      out[used++] = 0x80 + (uint8_t)best;
+      pos += bestLength;
+    } else {
+      if (c >= 0x80) {
+        out[used++] = ESCAPE;
+      }
+      out[used++] = c;
+      pos++;
+    }
+  }
+  return used;
+}
+
+size_t JsonPacker::unpack(const uint8_t* data, size_t length, char* out, size_t capacity) {
+  size_t used = 0;
+  for (size_t pos = 0; pos < length; pos++) {
+    uint8_t b = data[pos];
+    const char* text = (const char*)&data[pos];
+    size_t n = 1;
+    if (b == ESCAPE) {
+      if (++pos >= length) {
+        return 0;
+      }
+      text = (const char*)&data[pos];
+    } else if (b >= 0x80) {
+      if (b - 0x80 >= JSON_PACK_COUNT) {
+        return 0;
+      }
+      text = JSON_PACK_DICT[b - 0x80];
+      n = strlen(text);
+    }
+    if (used + n > capacity) {
+      return 0;
+    }
+    memcpy(out + used, text, n);
+    used += n;
+  }
+  return used;
+}
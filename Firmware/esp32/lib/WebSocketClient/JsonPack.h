@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ======================================================
+// 🗜️ Nén JSON bằng từ điển cố định theo schema message ("dict1")
+// ======================================================
+//
+// Thư viện WebSockets không có permessage-deflate, và deflate (kể cả miniz
+// trong ROM) cần hàng chục KB RAM cho bộ nén. Message JSON của robot
+// lặp lại cùng một bộ khoá/giá trị ("\",\"source\":\"esp32\",\"robotId\":\"",
+// tên message, tên cảm biến...), nên thay mỗi chuỗi trong JSON_PACK_DICT bằng
+// một byte là message còn ~40-55% kích thước, không cần RAM làm việc:
+//
+//   byte < 0x80          ký tự ASCII giữ nguyên
+//   0x80 + i (i < 127)   JSON_PACK_DICT[i]
+//   0xFF b               byte b >= 0x80 nguyên văn (UTF-8 trong chuỗi)
+//
+// Mỗi vị trí chọn mục dài nhất khớp (tham lam). Thoả thuận trong
+// connection_init ("compression": ["dict1"]) / ack ("compression": "dict1"),
+// sau đó message JSON gửi lên đi bằng frame CHANNEL_JSON. Từ điển là một phần
+// của định dạng: sửa thì phải đổi tên (dict2) và sửa cùng lúc với
+// homeguard-platform/apps/api/src/websocket/json-pack.ts.
+
+static const char JSON_PACK_NAME[] = "dict1";
+static const uint16_t JSON_PACK_MAX = 1024;          // payload tối đa, dài hơn thì gửi text
+
+class JsonPacker {
+public:
+  JsonPacker();
+
+  // 0 nếu out không đủ chỗ
+  size_t pack(const char* json, size_t length, uint8_t* out, size_t capacity) const;
+  // Giải nén (test, bench); 0 nếu dữ liệu hỏng hoặc out không đủ chỗ
+  static size_t unpack(const uint8_t* data, size_t length, char* out, size_t capacity);
+
+private:
+  static const uint8_t FIRST_MIN = 0x20;             // mục từ điển bắt đầu bằng ký tự in được
+  static const uint8_t FIRST_COUNT = 0x80 - FIRST_MIN;
+
+  uint8_t order[128];                                // chỉ số mục, nhóm theo ký tự đầu
+  uint8_t bucketStart[FIRST_COUNT + 1];
+  uint8_t lengths[128];
+};
@@ -0,0 +1,283 @@
+#include "OutboundQueue.h"
+#include <LittleFS.h>
+
+static const char SPILL_MAGIC[4] = { 'H', 'G', 'O', '1' };
+
+// min() nhận tham chiếu: build không tối ưu (env:native) cần định nghĩa ngoài lớp
+const uint32_t OutboundQueue::RTO_MAX_MS;
+
+OutboundQueue::OutboundQueue()
+    : head(0), count(0), inflight(0), nextSeq((uint16_t)random(0x10000)), rtoMs(RTO_MIN_MS),
+      online(false), spillPath(nullptr), spillCapacity(0), spillHeader(), bootId(0),
+      acked(0), retransmits(0), evicted(0), dropped(0) {}
+
+// ============================================
+// HÀNG ĐỢI
+// ============================================
+
+bool OutboundQueue::seqNotAfter(uint16_t a, uint16_t b) {
+  return (int16_t)(a - b) <= 0;
+}
+
+OutboundEntry& OutboundQueue::at(uint8_t index) {
+  return entries[(head + index) % CAPACITY];
+}
+
+const OutboundEntry& OutboundQueue::at(uint8_t index) const {
+  return entries[(head + index) % CAPACITY];
+}
+
+bool OutboundQueue::push(OutboundKind kind, SensorKind sensor, AlertLevel level, float value,
+                         uint32_t timestamp, uint32_t latencyUs) {
+  OutboundEntry entry = { timestamp, latencyUs, 0, value, 0, (uint8_t)kind, 0, sensor, level };
+
+  // Offline: cảnh báo ghi flash trước để không mất khi mất điện
+  if (kind == OUTBOUND_ALERT && !online && spill(entry)) {
+    return true;
+  }
+  if (count == CAPACITY && !makeRoom()) {
+    if (kind == OUTBOUND_ALERT) {
+      if (spill(entry)) {
+        return true;
+      }
+      dropped++;
+    } else {
+      evicted++;
+    }
+    return false;
+  }
+
+  entry.seq = nextSeq++;
+  at(count) = entry;
+  count++;
+  return true;
+}
+
+bool OutboundQueue::makeRoom() {
+  // Bỏ mẫu dữ liệu cũ nhất chưa gửi; cảnh báo đã vào hàng đợi thì giữ. Mục đang
+  // chờ ack không bị bỏ để message gửi lại giữ nguyên dãy seq liên tục.
+  for (uint8_t i = inflight; i < count; i++) {
+    if (at(i).kind == OUTBOUND_DATA) {
+      removeAt(i);
+      evicted++;
+      return true;
+    }
+  }
+  return false;
+}
+
+void OutboundQueue::removeAt(uint8_t index) {
+  for (uint8_t i = index; i + 1 < count; i++) {
+    at(i) = at(i + 1);
+  }
+  if (index < inflight) {
+    inflight--;
+  }
+  count--;
+}
+
+void OutboundQueue::ack(uint16_t seq) {
+  bool progressed = false;
+  while (count > 0 && seqNotAfter(at(0).seq, seq)) {
+    head = (head + 1) % CAPACITY;
+    count--;
+    if (inflight > 0) {
+      inflight--;
+    }
+    acked++;
+    progressed = true;
+  }
+  if (progressed) {
+    rtoMs = RTO_MIN_MS;
+  }
+}
+
+bool OutboundQueue::checkTimeout(uint32_t nowMs) {
+  if (inflight == 0 || nowMs - at(0).sentMs < rtoMs) {
+    return false;
+  }
+  inflight = 0;
+  retransmits++;
+  rtoMs = min(rtoMs * 2, RTO_MAX_MS);
+  return true;
+}
+
+void OutboundQueue::rewind() {
+  inflight = 0;
+  rtoMs = RTO_MIN_MS;
+}
+
+void OutboundQueue::setOnline(bool isOnline) {
+  online = isOnline;
+}
+
+// ============================================
+// GỬI
+// ============================================
+
+uint8_t OutboundQueue::unsentCount() const {
+  return count - inflight;
+}
+
+const OutboundEntry& OutboundQueue::unsent(uint8_t index) const {
+  return at(inflight + index);
+}
+
+uint8_t OutboundQueue::nextBatch(uint8_t maxEntries) const {
+  uint8_t limit = min<uint8_t>(min<uint8_t>(maxEntries, unsentCount()), WINDOW - inflight);
+  if (limit == 0) {
+    return 0;
+  }
+  // Cảnh báo đi riêng từng message; mẫu dữ liệu liên tiếp gom chung. Lô phải có
+  // seq liên tục: server suy ra seq từng bản ghi từ seq của message để bỏ bản trùng.
+  if (unsent(0).kind == OUTBOUND_ALERT) {
+    return 1;
+  }
+  uint8_t n = 1;
+  while (n < limit && unsent(n).kind == OUTBOUND_DATA && unsent(n).seq == (uint16_t)(unsent(n - 1).seq + 1)) {
+    n++;
+  }
+  return n;
+}
+
+void OutboundQueue::markSent(uint8_t n, uint32_t nowMs) {
+  for (uint8_t i = 0; i < n; i++) {
+    at(inflight + i).sentMs = nowMs;
+  }
+  inflight += n;
+}
+
+bool OutboundQueue::canSend() const {
+  return unsentCount() > 0 && inflight < WINDOW;
+}
+
+uint8_t OutboundQueue::pending() const {
+  return count;
+}
+
+uint16_t OutboundQueue::firstPendingSeq() const {
+  return count > 0 ? at(0).seq : nextSeq;
+}
+
+// ============================================
+// SPILL RA FLASH
+// ============================================
+
+bool OutboundQueue::enableSpill(const char* path, uint16_t maxRecords) {
+  bootId = (uint32_t)random(1, 0x7FFFFFFF);
+  File f = LittleFS.open(path, "r");
+  bool valid = f && f.read((uint8_t*)&spillHeader, sizeof(spillHeader)) == sizeof(spillHeader)
+               && memcmp(spillHeader.magic, SPILL_MAGIC, sizeof(SPILL_MAGIC)) == 0
+               && f.size() == sizeof(SpillHeader) + (size_t)maxRecords * sizeof(SpillRecord)
+               && spillHeader.count <= maxRecords && spillHeader.head < maxRecords;
+  if (f) {
+    f.close();
+  }
+
+  if (!valid) {
+    // Tạo file kích thước cố định để các lần ghi sau chỉ ghi đè tại chỗ
+    f = LittleFS.open(path, "w");
+    if (!f) {
+      return false;
+    }
+    memcpy(spillHeader.magic, SPILL_MAGIC, sizeof(SPILL_MAGIC));
+    spillHeader.head = 0;
+    spillHeader.count = 0;
+    f.write((const uint8_t*)&spillHeader, sizeof(spillHeader));
+    SpillRecord empty = {};
+    for (uint16_t i = 0; i < maxRecords; i++) {
+      f.write((const uint8_t*)&empty, sizeof(empty));
+    }
+    f.close();
+  }
+
+  spillPath = path;
+  spillCapacity = maxRecords;
+  if (spillHeader.count > 0) {
+    Serial.printf("[Outbox] %u alert(s) waiting in %s\n", spillHeader.count, path);
+  }
+  return true;
+}
+
+bool OutboundQueue::spill(const OutboundEntry& entry) {
+  if (spillPath == nullptr || spillCapacity == 0) {
+    return false;
+  }
+  File f = LittleFS.open(spillPath, "r+");
+  if (!f) {
+    return false;
+  }
+  if (spillHeader.count == spillCapacity) {
+    // Ring đầy: ghi đè cảnh báo cũ nhất
+    spillHeader.head = (spillHeader.head + 1) % spillCapacity;
+    spillHeader.count--;
+    dropped++;
+  }
+  SpillRecord record = { bootId, entry.timestamp, entry.latencyUs, entry.value, entry.sensor, entry.level, { 0, 0 } };
+  uint16_t slot = (spillHeader.head + spillHeader.count) % spillCapacity;
+  f.seek(sizeof(SpillHeader) + (size_t)slot * sizeof(SpillRecord));
+  f.write((const uint8_t*)&record, sizeof(record));
+  spillHeader.count++;
+  f.seek(0);
+  f.write((const uint8_t*)&spillHeader, sizeof(spillHeader));
+  f.close();
+  return true;
+}
+
+void OutboundQueue::refillFromSpill() {
+  if (spillPath == nullptr || spillHeader.count == 0 || count == CAPACITY) {
+    return;
+  }
+  File f = LittleFS.open(spillPath, "r+");
+  if (!f) {
+    return;
+  }
+  while (spillHeader.count > 0 && count < CAPACITY) {
+    SpillRecord record;
+    f.seek(sizeof(SpillHeader) + (size_t)spillHeader.head * sizeof(SpillRecord));
+    if (f.read((uint8_t*)&record, sizeof(record)) != sizeof(record)) {
+      break;
+    }
+    // Bản ghi của lần boot trước: millis() cũ vô nghĩa, đánh dấu để server biết
+    bool restored = record.bootId != bootId;
+    OutboundEntry entry = { restored ? (uint32_t)millis() : record.timestamp, record.latencyUs, 0,
+                            record.value, nextSeq++, OUTBOUND_ALERT,
+                            (uint8_t)(restored ? OUTBOUND_RESTORED : 0), record.sensor, record.level };
+    at(count) = entry;
+    count++;
+    spillHeader.head = (spillHeader.head + 1) % spillCapacity;
+    spillHeader.count--;
+  }
+  f.seek(0);
+  f.write((const uint8_t*)&spillHeader, sizeof(spillHeader));
+  f.close();
+}
+
+uint16_t OutboundQueue::spilled() const {
+  return spillHeader.count;
+}
+
+// ============================================
+// THỐNG KÊ
+// ============================================
+
+uint32_t OutboundQueue::getAcked() const {
+  return acked;
+}
+
+uint32_t OutboundQueue::getRetransmits() const {
+  return retransmits;
+}
+
+uint32_t OutboundQueue::getEvicted() const {
+  return evicted;
+}
+
+uint32_t OutboundQueue::getDropped() const {
+  return dropped;
+}
+
+void OutboundQueue::printStats(Print& out) const {
+  out.printf("[Outbox] pending=%u inflight=%u spilled=%u | acked=%u retransmits=%u evicted=%u dropped=%u rto=%ums\n",
+             count, inflight, spillHeader.count, acked, retransmits, evicted, dropped, rtoMs);
+}
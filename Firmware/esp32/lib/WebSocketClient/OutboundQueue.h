@@ -0,0 +1,120 @@
+#pragma once
+
+#include <Arduino.h>
+#include "BinaryFrame.h"
+#include "MessageTypes.h"
+
+// ======================================================
+// 📬 Hàng đợi gửi tin cậy: seq, ack cộng dồn, gửi lại khi hết hạn
+// ======================================================
+//
+// Mỗi mẫu/cảnh báo cảm biến nhận một seq 16 bit khi vào hàng đợi (FIFO theo
+// seq). WebSocketClient gom các mục chưa gửi thành message (seq của message =
+// seq mục cuối) và đánh dấu đã gửi; server trả ack cộng dồn "ackSeq" = seq
+// cao nhất đã nhận, mọi mục <= ackSeq được bỏ. Mục đầu hàng chờ quá rto mà
+// chưa được ack thì gửi lại từ đầu (go-back-N), rto tăng gấp đôi tới 16 s.
+// Mất kết nối thì mọi mục đang chờ ack được gửi lại sau khi kết nối lại.
+//
+// Hàng đợi đầy: bỏ mẫu dữ liệu cũ nhất chưa gửi, cảnh báo chỉ bị bỏ khi không còn mẫu
+// dữ liệu nào. Bật spill (enableSpill) thì cảnh báo phát sinh lúc offline được
+// ghi vào ring cố định trên LittleFS, sống qua reboot, và được nạp lại vào
+// hàng đợi khi có chỗ sau khi kết nối lại.
+
+enum OutboundKind : uint8_t {
+  OUTBOUND_DATA = 0,
+  OUTBOUND_ALERT = 1
+};
+
+static const uint8_t OUTBOUND_RESTORED = 0x01;   // nạp lại từ flash của lần boot trước, không biết tuổi mẫu
+
+struct OutboundEntry {
+  uint32_t timestamp;    // millis() lúc lấy mẫu
+  uint32_t latencyUs;    // cảnh báo: ISR -> vào hàng đợi
+  uint32_t sentMs;       // lần gửi gần nhất
+  float value;
+  uint16_t seq;
+  uint8_t kind;          // OutboundKind
+  uint8_t flags;
+  SensorKind sensor;
+  AlertLevel level;
+};
+
+class OutboundQueue {
+public:
+  static const uint8_t CAPACITY = 48;
+  static const uint8_t WINDOW = 32;          // số mục tối đa đang chờ ack
+  static const uint32_t RTO_MIN_MS = 2000;
+  static const uint32_t RTO_MAX_MS = 16000;
+
+  OutboundQueue();
+
+  // Ring cảnh báo trên flash, gọi sau LittleFS.begin()
+  bool enableSpill(const char* path = "/outbox.bin", uint16_t maxRecords = 64);
+  void setOnline(bool online);               // offline: cảnh báo đi thẳng vào spill (nếu bật)
+
+  bool push(OutboundKind kind, SensorKind sensor, AlertLevel level, float value,
+            uint32_t timestamp, uint32_t latencyUs = 0);
+  void ack(uint16_t seq);                    // ack cộng dồn
+  bool checkTimeout(uint32_t nowMs);         // true nếu vừa tua lại để gửi lại
+  void rewind();                             // gửi lại mọi mục chưa ack (mất kết nối)
+  void refillFromSpill();                    // chuyển cảnh báo từ flash vào hàng đợi khi có chỗ
+
+  // Gửi: các mục chưa gửi bắt đầu từ unsent(0)
+  uint8_t unsentCount() const;
+  const OutboundEntry& unsent(uint8_t index) const;
+  uint8_t nextBatch(uint8_t maxEntries) const;   // số mục liên tiếp cùng loại gửi được trong 1 message
+  void markSent(uint8_t n, uint32_t nowMs);
+  bool canSend() const;
+
+  uint8_t pending() const;                   // trong RAM, kể cả đang chờ ack
+  uint16_t spilled() const;                  // đang nằm trên flash
+  uint16_t firstPendingSeq() const;          // seq nhỏ nhất chưa được ack (resumeSeq)
+
+  uint32_t getAcked() const;
+  uint32_t getRetransmits() const;
+  uint32_t getEvicted() const;               // mẫu dữ liệu bị bỏ do đầy
+  uint32_t getDropped() const;               // cảnh báo bị bỏ (đầy + spill đầy/tắt)
+  void printStats(Print& out = Serial) const;
+
+private:
+  struct SpillRecord {
+    uint32_t bootId;
+    uint32_t timestamp;
+    uint32_t latencyUs;
+    float value;
+    SensorKind sensor;
+    AlertLevel level;
+    uint8_t reserved[2];
+  };
+
+  struct SpillHeader {
+    char magic[4];
+    uint16_t head;
+    uint16_t count;
+  };
+
+  static bool seqNotAfter(uint16_t a, uint16_t b);
+  OutboundEntry& at(uint8_t index);
+  const OutboundEntry& at(uint8_t index) const;
+  bool makeRoom();
+  void removeAt(uint8_t index);
+  bool spill(const OutboundEntry& entry);
+
+  OutboundEntry entries[CAPACITY];
+  uint8_t head;
+  uint8_t count;
+  uint8_t inflight;                          // số mục đầu hàng đã gửi, chờ ack
+  uint16_t nextSeq;
+  uint32_t rtoMs;
+  bool online;
+
+  const char* spillPath;
+  uint16_t spillCapacity;
+  SpillHeader spillHeader;
+  uint32_t bootId;                           // phân biệt bản ghi spill của lần boot trước
+
+  uint32_t acked;
+  uint32_t retransmits;
+  uint32_t evicted;
+  uint32_t dropped;
+};
@@ -0,0 +1,70 @@
+#include "RateBudget.h"
+
+RateBudget::RateBudget()
+    : limited(false),
+      perSec(0),
+      capMilli(0),
+      tokensMilli(0),
+      lastMs(0) {}
+
+void RateBudget::configure(uint32_t rate, uint32_t burst, uint32_t nowMs) {
+  perSec = rate;
+  if (burst == 0) {
+    burst = rate;
+  }
+  capMilli = burst > 0 ? (uint64_t)burst * 1000 : UINT64_MAX;
+  // Lần đầu bị giới hạn: bucket đầy; đổi hạn mức giữa chừng: giữ số dư trong trần mới
+  if (!limited) {
+    tokensMilli = rate > 0 ? capMilli : 0;
+  }
+  tokensMilli = min(tokensMilli, capMilli);
+  lastMs = nowMs;
+  limited = true;
+}
+
+void RateBudget::unlimit() {
+  limited = false;
+  tokensMilli = 0;
+}
+
+void RateBudget::grant(uint32_t credits) {
+  uint64_t add = (uint64_t)credits * 1000;
+  tokensMilli = capMilli - tokensMilli < add ? capMilli : tokensMilli + add;
+}
+
+void RateBudget::refill(uint32_t nowMs) {
+  uint32_t elapsed = nowMs - lastMs;
+  lastMs = nowMs;
+  if (perSec == 0 || elapsed == 0) {
+    return;
+  }
+  // perSec token mỗi giây = perSec phần nghìn token mỗi ms
+  uint64_t add = (uint64_t)perSec * elapsed;
+  tokensMilli = capMilli - tokensMilli < add ? capMilli : tokensMilli + add;
+}
+
+bool RateBudget::tryConsume(uint32_t amount, uint32_t nowMs) {
+  if (!limited) {
+    return true;
+  }
+  refill(nowMs);
+  uint64_t need = (uint64_t)amount * 1000;
+  if (tokensMilli < need) {
+    return false;
+  }
+  tokensMilli -= need;
+  return true;
+}
+
+bool RateBudget::isLimited() const {
+  return limited;
+}
+
+uint32_t RateBudget::available(uint32_t nowMs) {
+  if (!limited) {
+    return UINT32_MAX;
+  }
+  refill(nowMs);
+  uint64_t tokens = tokensMilli / 1000;
+  return tokens > UINT32_MAX ? UINT32_MAX : (uint32_t)tokens;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ======================================================
+// 🚦 Hạn mức gửi do server cấp (token bucket + credit)
+// ======================================================
+//
+// Server giới hạn từng robot qua "rateLimit" trong ack / behavior_update:
+//
+//   "rateLimit": {
+//     "telemetry": { "perSec": 1, "burst": 4 },       // message sensor_data
+//     "audio": { "perSec": 16000, "burst": 8192, "credits": 32000 }   // byte audio
+//   }
+//
+// perSec nạp lại đều, burst là trần của bucket; credits cộng thêm một lần
+// (perSec = 0 là chế độ chỉ-credit: server cấp dần theo sức chịu). "false"
+// thay cho một mục thì bỏ giới hạn. Mặc định và sau mỗi lần mất kết nối là
+// không giới hạn; server gửi lại hạn mức trong ack kết nối.
+
+class RateBudget {
+public:
+  RateBudget();
+
+  // burst = 0: bằng perSec (1 s); perSec = 0 và burst = 0: credit không có trần
+  void configure(uint32_t perSec, uint32_t burst, uint32_t nowMs);
+  void unlimit();
+  void grant(uint32_t credits);
+
+  // Trừ amount nếu đủ, không thì giữ nguyên và trả về false
+  bool tryConsume(uint32_t amount, uint32_t nowMs);
+  bool isLimited() const;
+  uint32_t available(uint32_t nowMs);
+
+private:
+  void refill(uint32_t nowMs);
+
+  bool limited;
+  uint32_t perSec;
+  uint64_t capMilli;                     // trần, đơn vị 1/1000 token
+  uint64_t tokensMilli;                  // giữ phần lẻ khi nạp theo ms
+  uint32_t lastMs;
+};
@@ -0,0 +1,106 @@
+#include "TelemetryBatcher.h"
+
+TelemetryBatcher::TelemetryBatcher(WebSocketClient& client, uint32_t flushMs, uint8_t maxSamples)
+    : client(client), head(0), count(0), flushMs(flushMs), maxSamples(1),
+      sentBatches(0), sentSamples(0), droppedSamples(0), suppressedSamples(0)
+{
+  setMaxSamples(maxSamples);
+}
+
+AlertLevel TelemetryBatcher::add(SensorKind sensor, float value) {
+  AlertDecision decision;
+  {
+    WsLock guard(client);              // BEHAVIOR_UPDATE đổi bảng luật trong task mạng
+    decision = client.getAlertRules().evaluate(sensor, value, millis());
+  }
+  if (decision.report) {
+    add(sensor, value, decision.level);
+  } else {
+    suppressedSamples++;
+  }
+  return decision.level;
+}
+
+AlertLevel TelemetryBatcher::add(const Sensor& sensor) {
+  float value;
+  if (!sensor.latest(value)) {
+    WsLock guard(client);
+    return client.getAlertRules().currentLevel(sensor.kind());
+  }
+  return add(sensor.kind(), value);
+}
+
+void TelemetryBatcher::add(SensorKind sensor, float value, AlertLevel level) {
+  if (level >= AlertLevel::DANGER) {
+    client.sendSensorData(sensor, value, level);
+    return;
+  }
+
+  if (count == CAPACITY) {
+    // Ring đầy (thường do mất kết nối): bỏ mẫu cũ nhất
+    head = (head + 1) % CAPACITY;
+    count--;
+    droppedSamples++;
+  }
+  ring[(head + count) % CAPACITY] = SensorSample{ (uint32_t)millis(), value, sensor, level };
+  count++;
+
+  if (count >= maxSamples) {
+    flush();
+  }
+}
+
+void TelemetryBatcher::update() {
+  if (count > 0 && millis() - ring[head].timestamp >= flushMs) {
+    flush();
+  }
+}
+
+bool TelemetryBatcher::flush() {
+  if (count == 0) {
+    return true;
+  }
+
+  // sendSensorBatch cần mảng liên tục: ghép 2 đoạn của ring vào buffer tạm
+  SensorSample batch[CAPACITY];
+  for (uint8_t i = 0; i < count; i++) {
+    batch[i] = ring[(head + i) % CAPACITY];
+  }
+  if (!client.sendSensorBatch(batch, count)) {
+    return false;
+  }
+
+  sentBatches++;
+  sentSamples += count;
+  head = 0;
+  count = 0;
+  return true;
+}
+
+void TelemetryBatcher::setFlushInterval(uint32_t ms) {
+  flushMs = ms;
+}
+
+void TelemetryBatcher::setMaxSamples(uint8_t n) {
+  maxSamples = n == 0 ? 1 : (n > CAPACITY ? (uint8_t)CAPACITY : n);
+}
+
+uint8_t TelemetryBatcher::pending() const {
+  return count;
+}
+
+uint32_t TelemetryBatcher::getSentBatches() const {
+  return sentBatches;
+}
+
+uint32_t TelemetryBatcher::getSentSamples() const {
+  return sentSamples;
+}
+
+uint32_t TelemetryBatcher::getDroppedSamples() const {
+  return droppedSamples;
+}
+
+uint32_t TelemetryBatcher::getSuppressedSamples() const {
+  return suppressedSamples;
+}
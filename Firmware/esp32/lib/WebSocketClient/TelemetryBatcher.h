@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Arduino.h>
+#include "Sensor.h"
+#include "WebSocketClient.h"
+
+// ======================================================
+// 📨 Gom mẫu cảm biến thành lô trước khi gửi
+// ======================================================
+//
+// Mẫu được ghi vào ring buffer cố định kèm timestamp riêng, rồi gửi một
+// message duy nhất (sendSensorBatch) khi đủ maxSamples hoặc mẫu cũ nhất đã
+// chờ quá flushMs. Mẫu có mức DANGER trở lên không chờ: gửi ngay qua
+// sendSensorData. Lô được chuyển vào hàng đợi tin cậy của WebSocketClient
+// (OutboundQueue), kể cả khi mất kết nối; hàng đợi lo seq/ack và gửi lại.
+//
+// add(sensor, value) tính mức bằng AlertRules của client và bỏ mẫu không đổi
+// (send-on-delta); add(sensor, value, level) giữ mức nơi gọi đưa vào, luôn gửi.
+// add(sensor) lấy mẫu mới nhất trong history của Sensor, bỏ qua nếu mẫu lỗi.
+
+class TelemetryBatcher {
+public:
+  static const uint8_t CAPACITY = 24;
+
+  TelemetryBatcher(WebSocketClient& client, uint32_t flushMs = 5000, uint8_t maxSamples = 16);
+
+  AlertLevel add(SensorKind sensor, float value);            // trả về mức theo luật
+  AlertLevel add(const Sensor& sensor);
+  void add(SensorKind sensor, float value, AlertLevel level);
+  // Gọi định kỳ: flush khi tới hạn thời gian
+  void update();
+  // Gửi tất cả mẫu đang chờ, trả về false nếu chưa gửi được (giữ lại cho lần sau)
+  bool flush();
+
+  void setFlushInterval(uint32_t ms);
+  void setMaxSamples(uint8_t n);
+
+  uint8_t pending() const;
+  uint32_t getSentBatches() const;
+  uint32_t getSentSamples() const;
+  uint32_t getDroppedSamples() const;
+  uint32_t getSuppressedSamples() const;      // không đổi đủ delta, không gửi
+
+private:
+  WebSocketClient& client;
+  SensorSample ring[CAPACITY];
+  uint8_t head;                 // vị trí mẫu cũ nhất
+  uint8_t count;
+  uint32_t flushMs;
+  uint8_t maxSamples;
+
+  uint32_t sentBatches;
+  uint32_t sentSamples;
+  uint32_t droppedSamples;
+  uint32_t suppressedSamples;
+};
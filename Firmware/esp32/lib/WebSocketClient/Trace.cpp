@@ -0,0 +1,117 @@
+#include "Trace.h"
+#include <esp_timer.h>
+
+// ============================================
+// CLOCK SYNC
+// ============================================
+
+ClockSync::ClockSync()
+    : samples{},
+      count(0),
+      next(0),
+      offsetUs(0),
+      rttUs(0),
+      source(CLOCK_NONE) {}
+
+bool ClockSync::addSample(int64_t t0, int64_t t1, int64_t t2, int64_t t3) {
+  int64_t rtt = (t3 - t0) - (t2 - t1);
+  if (t3 < t0 || t2 < t1 || rtt < 0) {
+    return false;
+  }
+  samples[next].offsetUs = ((t1 - t0) + (t2 - t3)) / 2;
+  samples[next].rttUs = rtt > (int64_t)UINT32_MAX ? UINT32_MAX : (uint32_t)rtt;
+  next = (next + 1) % WINDOW;
+  if (count < WINDOW) {
+    count++;
+  }
+
+  const Sample* best = &samples[0];
+  for (uint8_t i = 1; i < count; i++) {
+    if (samples[i].rttUs < best->rttUs) {
+      best = &samples[i];
+    }
+  }
+  offsetUs = best->offsetUs;
+  rttUs = best->rttUs;
+  source = CLOCK_SERVER;
+  return true;
+}
+
+void ClockSync::setSntp(int64_t wallUs, int64_t localUs) {
+  if (source == CLOCK_SERVER) {
+    return;
+  }
+  offsetUs = wallUs - localUs;
+  source = CLOCK_SNTP;
+}
+
+bool ClockSync::isSynced() const {
+  return source != CLOCK_NONE;
+}
+
+ClockSync::Source ClockSync::getSource() const {
+  return source;
+}
+
+const char* ClockSync::getSourceName() const {
+  switch (source) {
+    case CLOCK_SNTP:   return "sntp";
+    case CLOCK_SERVER: return "server";
+    default:           return "none";
+  }
+}
+
+int64_t ClockSync::toWallUs(int64_t localUs) const {
+  return isSynced() ? localUs + offsetUs : 0;
+}
+
+int64_t ClockSync::nowUs() const {
+  return toWallUs(esp_timer_get_time());
+}
+
+int64_t ClockSync::getBootEpochUs() const {
+  return toWallUs(0);
+}
+
+uint32_t ClockSync::getRttUs() const {
+  return rttUs;
+}
+
+// ============================================
+// SPAN LOG
+// ============================================
+
+SpanLog::SpanLog() : spans{}, head(0), count(0), dropped(0) {}
+
+void SpanLog::record(const char* traceId, const char* name, int64_t startUs, int64_t endUs) {
+  TraceSpan& span = spans[(head + count) % CAPACITY];
+  if (count == CAPACITY) {
+    head = (head + 1) % CAPACITY;       // đè span cũ nhất
+    dropped++;
+  } else {
+    count++;
+  }
+  strncpy(span.traceId, traceId != nullptr ? traceId : "", TRACE_ID_LEN);
+  span.traceId[TRACE_ID_LEN] = '\0';
+  span.name = name;
+  span.startUs = startUs;
+  int64_t dur = endUs - startUs;
+  span.durUs = dur < 0 ? 0 : (dur > (int64_t)UINT32_MAX ? UINT32_MAX : (uint32_t)dur);
+}
+
+uint8_t SpanLog::size() const {
+  return count;
+}
+
+const TraceSpan& SpanLog::at(uint8_t i) const {
+  return spans[(head + i) % CAPACITY];
+}
+
+void SpanLog::clear() {
+  head = 0;
+  count = 0;
+}
+
+uint32_t SpanLog::getDropped() const {
+  return dropped;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ======================================================
+// ⏱️ Đồng bộ đồng hồ với server và ghi span cho trace đầu-cuối
+// ======================================================
+//
+// ClockSync đổi esp_timer (µs từ lúc boot) sang giờ thực (µs từ epoch Unix).
+// Nguồn chính là server: connection_init / heartbeat mang clientSentUs (t0,
+// esp_timer), ack / heartbeat_ack trả lại clock {clientSentUs, serverRecvUs
+// (t1), serverSendUs (t2)}, lúc nhận là t3. Kiểu NTP:
+//   offset = ((t1 - t0) + (t2 - t3)) / 2     rtt = (t3 - t0) - (t2 - t1)
+// Giữ WINDOW mẫu gần nhất, lấy offset của mẫu có rtt nhỏ nhất (ít bị xếp hàng
+// trên WiFi nhất). Chưa có mẫu từ server thì dùng SNTP (setSntp) nếu đã có giờ.
+// Sai số cỡ rtt/2 của mẫu tốt nhất, đủ để so span giữa robot, platform và AI.
+//
+// SpanLog là ring span cố định {traceId, tên, bắt đầu, độ dài}, thời điểm giữ
+// theo esp_timer và chỉ đổi sang giờ thực lúc gửi đi (STATUS_UPDATE "trace"),
+// nên span ghi trước khi đồng bộ vẫn dùng được. Đầy thì đè span cũ nhất.
+
+static const uint8_t TRACE_ID_LEN = 16;              // 64 bit dạng hex
+
+class ClockSync {
+public:
+  enum Source : uint8_t { CLOCK_NONE = 0, CLOCK_SNTP, CLOCK_SERVER };
+  static const uint8_t WINDOW = 8;                   // ~4 phút heartbeat, theo kịp trôi thạch anh
+
+  ClockSync();
+
+  // t0, t3: esp_timer; t1, t2: giờ server. false nếu mẫu vô lý (rtt âm)
+  bool addSample(int64_t t0, int64_t t1, int64_t t2, int64_t t3);
+  // Giờ thực từ SNTP tại localUs; bỏ qua khi đã có mẫu từ server
+  void setSntp(int64_t wallUs, int64_t localUs);
+
+  bool isSynced() const;
+  Source getSource() const;
+  const char* getSourceName() const;
+  int64_t toWallUs(int64_t localUs) const;           // 0 nếu chưa đồng bộ
+  int64_t nowUs() const;                             // giờ thực hiện tại, 0 nếu chưa đồng bộ
+  int64_t getBootEpochUs() const;                    // giờ thực lúc esp_timer = 0
+  uint32_t getRttUs() const;                         // rtt của mẫu đang dùng
+
+private:
+  struct Sample {
+    int64_t offsetUs;
+    uint32_t rttUs;
+  };
+
+  Sample samples[WINDOW];
+  uint8_t count;
+  uint8_t next;
+  int64_t offsetUs;
+  uint32_t rttUs;
+  Source source;
+};
+
+struct TraceSpan {
+  char traceId[TRACE_ID_LEN + 1];
+  const char* name;            // chuỗi hằng, ví dụ "voice.capture"
+  int64_t startUs;             // esp_timer
+  uint32_t durUs;
+};
+
+class SpanLog {
+public:
+  static const uint8_t CAPACITY = 16;
+
+  SpanLog();
+
+  void record(const char* traceId, const char* name, int64_t startUs, int64_t endUs);
+  uint8_t size() const;
+  const TraceSpan& at(uint8_t i) const;              // 0 = cũ nhất
+  void clear();
+  uint32_t getDropped() const;                       // span bị đè trước khi gửi
+
+private:
+  TraceSpan spans[CAPACITY];
+  uint8_t head;
+  uint8_t count;
+  uint32_t dropped;
+};
@@ -1,5 +1,7 @@
 
 #include "WebSocketClient.h"
+#include <esp_timer.h>
+#include <sys/time.h>
 
 // Static member initialization
 WebSocketClient* WebSocketClient::instance = nullptr;
@@ -27,9 +29,54 @@ WebSocketClient::WebSocketClient(const String& server, uint16_t port, const Stri
       lastHeartbeat(0),
       lastReconnectAttempt(0),
       reconnectInterval(5000),
-      heartbeatInterval(30000) 
+      heartbeatInterval(30000),
+      reconnectMaxMs(60000),
+      reconnectAttempts(0),
+      nextAttemptAtMs(0),
+      attemptUntilMs(0),
+      connectedAtMs(0),
+      connectStarted(false),
+      reconnectCounter(Metrics::counter("ws.reconnect")),
+      telemetryHeld(false),
+      throttledBatches(0),
+      throttledAudioChunks(0),
+      throttledCounter(Metrics::counter("ws.throttled")),
+      binaryEnabled(true),
+      binaryMode(false),
+      binarySeq(0),
+      compressionEnabled(true),
+      compressionMode(false),
+      txJsonBytes(0),
+      txWireBytes(0),
+      caCert(nullptr),
+      audioOfferCount(0),
+      audioCodec(AUDIO_PCM16),
+      logMessageChars(96),
+      rxMessages(0),
+      rxParseErrors(0),
+      sendHist(Metrics::histogram("ws.send_us")),
+      parseHist(Metrics::histogram("ws.parse_us")),
+      outboxDepth(Metrics::gauge("ws.outbox")),
+      sendFailures(Metrics::counter("ws.send_fail")),
+      rttHist(Metrics::histogram("ws.rtt_us")),
+      pingSentUs(0),
+      lastRttUs(0),
+      traceId{},
+      traceAtMs(0),
+      lastSpanFlushMs(0),
+      rxAtUs(0),
+      sntpStarted(false),
+      wsMutex(xSemaphoreCreateRecursiveMutex()),
+      pendingAlerts{},
+      pendingAlertCount(0),
+      pendingLock(portMUX_INITIALIZER_UNLOCKED)
 {  
   instance = this;
+  // Handler mặc định; kiểu khác chưa đăng ký thì rơi về onMessage
+  messageHandlers[(uint8_t)MessageType::ACK] = [this](const JsonDocument& doc) { handleConnectionAck(doc); };
+  messageHandlers[(uint8_t)MessageType::ACTUATOR_COMMAND] = [this](const JsonDocument& doc) { handleActuatorCommandMessage(doc); };
+  messageHandlers[(uint8_t)MessageType::AI_RESPONSE] = [this](const JsonDocument& doc) { handleAIResponse(doc); };
+  messageHandlers[(uint8_t)MessageType::BEHAVIOR_UPDATE] = [this](const JsonDocument& doc) { handleBehaviorUpdate(doc); };
 }
 
 WebSocketClient::~WebSocketClient() {
@@ -37,25 +84,60 @@ WebSocketClient::~WebSocketClient() {
   instance = nullptr;
 }
 
+void WebSocketClient::lock() const {
+  if (wsMutex != nullptr) {
+    xSemaphoreTakeRecursive(wsMutex, portMAX_DELAY);
+  }
+}
+
+void WebSocketClient::unlock() const {
+  if (wsMutex != nullptr) {
+    xSemaphoreGiveRecursive(wsMutex);
+  }
+}
+
+bool WebSocketClient::tryLock() const {
+  return wsMutex == nullptr || xSemaphoreTakeRecursive(wsMutex, 0) == pdTRUE;
+}
+
 // ============================================
 // CONNECTION MANAGEMENT
 // ============================================
 
 void WebSocketClient::connect() {
+  WsLock guard(*this);
   if (isConnected) {
     return;
   }
   
   Serial.println("[WebSocket] Initiating connection...");
+  // SNTP chạy nền, chỉ là nguồn dự phòng khi server chưa trả mẫu clock
+  if (!sntpStarted) {
+    configTime(0, 0, "pool.ntp.org", "time.google.com");
+    sntpStarted = true;
+  }
   // Setup WebSocket with server
-    webSocket.begin(wsServer, wsPort, "/");
+    if (caCert != nullptr) {
+      webSocket.beginSslWithCA(wsServer.c_str(), wsPort, "/", caCert);
+    } else {
+      webSocket.begin(wsServer, wsPort, "/");
+    }
     webSocket.onEvent(webSocketEventWrapper);
-    webSocket.setReconnectInterval(reconnectInterval);
+    // Thư viện thử lại tối đa 2 lần trong một cửa sổ; khoảng cách giữa các cửa sổ do backoff quyết định
+    webSocket.setReconnectInterval(CONNECT_WINDOW_MS / 2);
+    
+    // Lần đầu sau boot lệch ngẫu nhiên: cả toà nhà có điện lại cùng lúc
+    uint32_t now = millis();
+    nextAttemptAtMs = connectStarted ? now : now + (uint32_t)random(BOOT_JITTER_MS);
+    attemptUntilMs = 0;
+    reconnectAttempts = 0;
+    connectStarted = true;
     
     Serial.println("[WebSocket] Client initialized");
 }
 
 void WebSocketClient::disconnect() {
+  WsLock guard(*this);
   if (isConnected) {
     webSocket.disconnect();
     isConnected = false;
@@ -65,21 +147,82 @@ void WebSocketClient::disconnect() {
 }
 
 void WebSocketClient::update() {
-  webSocket.loop();
-  
+  WsLock guard(*this);                   // callback của message chạy bên trong, vẫn giữ khoá
   unsigned long currentTime = millis();
+  drainPendingAlerts();
+  if (webSocket.isConnected() || reconnectDue(currentTime)) {
+    webSocket.loop();
+    drainPendingAlerts();                // cảnh báo tới trong lúc loop() giữ khoá
+  }
+  pumpOutbox();
+  
+  // Kết nối giữ được lâu thì lần rớt sau lại bắt đầu từ backoff nhỏ nhất
+  if (isConnected && reconnectAttempts > 0 && (uint32_t)currentTime - connectedAtMs > BACKOFF_RESET_MS) {
+    reconnectAttempts = 0;
+  }
   
   // Send heartbeat
   if (isConnected && (currentTime - lastHeartbeat) > heartbeatInterval) {
     sendHeartbeat();
+    sendPing();                          // RTT mức transport, không phụ thuộc server trả ack
+    pollSntp();
     lastHeartbeat = currentTime;
   }
+  
+  // Trace không ai dùng tiếp (không có câu trả lời...) thì tự đóng
+  if (traceId[0] != '\0' && (uint32_t)currentTime - traceAtMs > TRACE_IDLE_MS) {
+    endTrace();
+  }
+  if (isConnected && spans.size() > 0 &&
+      (spans.size() >= SpanLog::CAPACITY / 2 || (uint32_t)currentTime - lastSpanFlushMs > SPAN_FLUSH_MS)) {
+    flushSpans();
+  }
+}
+
+bool WebSocketClient::reconnectDue(uint32_t now) {
+  if (!connectStarted || (int32_t)(now - nextAttemptAtMs) < 0) {
+    return false;
+  }
+  if (attemptUntilMs == 0) {
+    attemptUntilMs = now + CONNECT_WINDOW_MS;
+    reconnectCounter->add();
+  } else if ((int32_t)(now - attemptUntilMs) >= 0) {
+    scheduleReconnect(now);
+    return false;
+  }
+  return true;
+}
+
+void WebSocketClient::scheduleReconnect(uint32_t now) {
+  // "Equal jitter": nửa cố định giữ khoảng cách tối thiểu, nửa ngẫu nhiên tách các robot
+  uint32_t ceiling = min<uint32_t>(reconnectMaxMs, (uint32_t)reconnectInterval << min<uint8_t>(reconnectAttempts, 10));
+  uint32_t delayMs = ceiling / 2 + (uint32_t)random(ceiling / 2 + 1);
+  if (reconnectAttempts < 255) {
+    reconnectAttempts++;
+  }
+  nextAttemptAtMs = now + delayMs;
+  attemptUntilMs = 0;
+  Serial.printf("[WebSocket] Reconnect in %u ms (attempt %u)\n", delayMs, reconnectAttempts);
+}
+
+void WebSocketClient::reconnectNow() {
+  WsLock guard(*this);
+  // Lần rớt do tắt radio trước khi ngủ không phải lỗi server: không tính vào backoff
+  reconnectAttempts = 0;
+  if (connectStarted && !webSocket.isConnected()) {
+    nextAttemptAtMs = millis();
+    attemptUntilMs = 0;                  // cửa sổ thử mới, đủ CONNECT_WINDOW_MS
+  }
 }
 
 bool WebSocketClient::isConnectedToServer() const {
   return isConnected;
 }
 
+bool WebSocketClient::isTransportConnected() {
+  return webSocket.isConnected();
+}
+
 // ============================================
 // CALLBACK SETTERS
 // ============================================
@@ -104,35 +247,65 @@ void WebSocketClient::setOnActuatorCommand(OnActuatorCommandCallback callback) {
   onActuatorCommand = callback;
 }
 
+void WebSocketClient::setOnAudioFrame(OnAudioFrameCallback callback) {
+  onAudioFrame = callback;
+}
+
+void WebSocketClient::setOnOtaFrame(OnOtaFrameCallback callback) {
+  onOtaFrame = callback;
+}
+
+void WebSocketClient::setMessageHandler(MessageType type, OnMessageCallback handler) {
+  if ((uint8_t)type < MESSAGE_TYPE_COUNT) {
+    messageHandlers[(uint8_t)type] = handler;
+  }
+}
+
 // ============================================
 // CONFIGURATION SETTERS
 // ============================================
 
 void WebSocketClient::setReconnectInterval(uint16_t interval) {
   reconnectInterval = interval;
-  webSocket.setReconnectInterval(interval);
+}
+
+void WebSocketClient::setReconnectBackoff(uint16_t minMs, uint32_t maxMs) {
+  reconnectInterval = minMs;
+  reconnectMaxMs = max<uint32_t>(maxMs, minMs);
+}
+
+void WebSocketClient::setServer(const String& server, uint16_t port) {
+  WsLock guard(*this);
+  wsServer = server;
+  wsPort = port;
+}
+
+void WebSocketClient::setRobotId(const String& id) {
+  WsLock guard(*this);
+  robotId = id;
 }
 
 void WebSocketClient::setHeartbeatInterval(uint16_t interval) {
   heartbeatInterval = interval;
 }
 
+void WebSocketClient::setLogMessages(uint16_t maxChars) {
+  logMessageChars = maxChars;
+}
+
 // ============================================
 // MESSAGE SENDING METHODS
 // ============================================
 
 void WebSocketClient::sendMessage(MessageType type, const char* target) {
+  WsLock guard(*this);
   if (!isConnected) {
     Serial.println("[WebSocket] Not connected, cannot send message");
     return;
   }
   
   StaticJsonDocument<512> doc;
-  doc["id"] = generateUUID();
-  doc["type"] = messageTypeToString(type);
-  doc["source"] = connectionTypeToString(ConnectionType::ESP32_TYPE);
-  doc["robotId"] = robotId;
-  doc["timestamp"] = getCurrentTimestamp();
+  stampEnvelope(doc, type);
   
   if (target != nullptr) {
     doc["target"] = target;
@@ -140,23 +313,26 @@ void WebSocketClient::sendMessage(MessageType type, const char* target) {
   
   String output;
   serializeJson(doc, output);
-  webSocket.sendTXT(output);
+  sendJson(output);
 }
 
 void WebSocketClient::sendSensorData(const char* sensorType, float value,
                                      const char* unit, AlertLevel alertLevel) {
+  WsLock guard(*this);
+  SensorKind kind = sensorKindFromString(sensorType);
+  if (kind != SENSOR_UNKNOWN) {
+    sendSensorData(kind, value, alertLevel);
+    return;
+  }
+  
+  // Loại cảm biến ngoài SensorKind: gửi thẳng, không qua hàng đợi
   if (!isConnected) {
     Serial.println("[WebSocket] Not connected, cannot send sensor data");
     return;
   }
   
   StaticJsonDocument<512> doc;
-  doc["id"] = generateUUID();
-  doc["type"] = messageTypeToString(MessageType::SENSOR_DATA);
-  doc["source"] = connectionTypeToString(ConnectionType::ESP32_TYPE);
-  doc["robotId"] = robotId;
-  doc["timestamp"] = getCurrentTimestamp();
-  doc["requiresAck"] = true;
+  stampEnvelope(doc, MessageType::SENSOR_DATA);
   
   JsonObject payload = doc.createNestedObject("payload");
   payload["sensorType"] = sensorType;
@@ -168,151 +344,424 @@ void WebSocketClient::sendSensorData(const char* sensorType, float value,
   
   String output;
   serializeJson(doc, output);
-  webSocket.sendTXT(output);
+  sendJson(output);
   
   Serial.printf("[WebSocket] Sensor data sent: %s = %.2f %s\n", sensorType, value, unit);
 }
 
+void WebSocketClient::sendSensorData(SensorKind sensor, float value, AlertLevel alertLevel) {
+  WsLock guard(*this);
+  outbox.push(OUTBOUND_DATA, sensor, alertLevel, value, getCurrentTimestamp());
+  pumpOutbox();
+}
+
+bool WebSocketClient::sendSensorBatch(const SensorSample* samples, uint8_t count) {
+  WsLock guard(*this);
+  // Hàng đợi nhận cả khi offline; đầy thì tự bỏ mẫu cũ nhất nên batcher không cần giữ lại
+  for (uint8_t i = 0; i < count; i++) {
+    outbox.push(OUTBOUND_DATA, samples[i].sensor, samples[i].level, samples[i].value, samples[i].timestamp);
+  }
+  pumpOutbox();
+  return true;
+}
+
+void WebSocketClient::sendSensorAlert(const char* sensorType, bool active,
+                                      AlertLevel alertLevel, uint32_t latencyUs) {
+  SensorKind kind = sensorKindFromString(sensorType);
+  if (kind != SENSOR_UNKNOWN) {
+    // Gọi từ task dispatcher (làn ALARM): không chờ sau một lần kết nối lại / OTA của task mạng
+    PendingAlert alert = { (uint32_t)getCurrentTimestamp(), latencyUs, kind, alertLevel, active };
+    const char* state;
+    if (tryLock()) {
+      bool queued = outbox.push(OUTBOUND_ALERT, kind, alertLevel, active ? 1.0f : 0.0f,
+                                alert.timestamp, latencyUs);
+      pumpOutbox();
+      unlock();
+      state = queued ? "queued" : "dropped";
+    } else {
+      state = stashAlert(alert) ? "deferred" : "dropped";
+    }
+    Serial.printf("[WebSocket] Sensor alert %s: %s (%s)\n", state, sensorType, alertLevelToString(alertLevel));
+    return;
+  }
+  
+  WsLock guard(*this);
+  if (!isConnected) {
+    Serial.println("[WebSocket] Not connected, cannot send sensor alert");
+    return;
+  }
+  
+  StaticJsonDocument<384> doc;
+  stampEnvelope(doc, MessageType::SENSOR_ALERT);
+  
+  JsonObject payload = doc.createNestedObject("payload");
+  payload["sensorType"] = sensorType;
+  payload["active"] = active;
+  payload["alertLevel"] = alertLevelToString(alertLevel);
+  payload["latencyUs"] = latencyUs;        // ISR -> gửi đi, để server theo dõi độ trễ
+  payload["location"] = "robot_main";
+  
+  String output;
+  serializeJson(doc, output);
+  sendJson(output);
+  
+  Serial.printf("[WebSocket] Sensor alert sent: %s (%s)\n", sensorType, alertLevelToString(alertLevel));
+}
+
+// ============================================
+// OUTBOUND QUEUE
+// ============================================
+
+bool WebSocketClient::stashAlert(const PendingAlert& alert) {
+  bool stored = false;
+  portENTER_CRITICAL(&pendingLock);
+  if (pendingAlertCount < PENDING_ALERTS) {
+    pendingAlerts[pendingAlertCount++] = alert;
+    stored = true;
+  }
+  portEXIT_CRITICAL(&pendingLock);
+  return stored;
+}
+
+void WebSocketClient::drainPendingAlerts() {
+  PendingAlert drained[PENDING_ALERTS];
+  uint8_t count;
+  portENTER_CRITICAL(&pendingLock);
+  count = pendingAlertCount;
+  memcpy(drained, pendingAlerts, count * sizeof(PendingAlert));
+  pendingAlertCount = 0;
+  portEXIT_CRITICAL(&pendingLock);
+  // Giữ timestamp lúc phát hiện: latencyUs gửi đi gồm cả thời gian nằm trong hộp chờ
+  for (uint8_t i = 0; i < count; i++) {
+    const PendingAlert& a = drained[i];
+    outbox.push(OUTBOUND_ALERT, a.sensor, a.level, a.active ? 1.0f : 0.0f, a.timestamp, a.latencyUs);
+  }
+}
+
+void WebSocketClient::pumpOutbox() {
+  if (!isConnected) {
+    return;
+  }
+  uint32_t now = getCurrentTimestamp();
+  if (outbox.checkTimeout(now)) {
+    Serial.printf("[WebSocket] Ack timeout, resending from seq %u\n", outbox.firstPendingSeq());
+  }
+  outbox.refillFromSpill();
+  outboxDepth->set(outbox.pending() + outbox.spilled());
+  
+  // Xả theo từng đợt ngắn để update() không bị giữ lâu khi vừa kết nối lại
+  for (uint8_t i = 0; i < OUTBOX_BURST && outbox.canSend(); i++) {
+    uint8_t n = outbox.nextBatch(OUTBOX_BATCH);
+    if (n == 0) {
+      break;
+    }
+    // Hết hạn mức telemetry: mẫu nằm lại hàng đợi và gom thành lô lớn hơn ở lần sau.
+    // Cảnh báo không bị giới hạn, kể cả khi đang xếp sau một lô dữ liệu
+    if (outbox.unsent(0).kind == OUTBOUND_DATA && !telemetryBudget.tryConsume(1, now)) {
+      bool alertWaiting = false;
+      for (uint8_t k = n; k < outbox.unsentCount() && !alertWaiting; k++) {
+        alertWaiting = outbox.unsent(k).kind == OUTBOUND_ALERT;
+      }
+      if (!alertWaiting) {
+        if (!telemetryHeld) {
+          telemetryHeld = true;
+          throttledBatches++;
+          throttledCounter->add();
+        }
+        break;
+      }
+    }
+    telemetryHeld = false;
+    bool sent;
+    {
+      CycleTimer timer(sendHist);
+      sent = sendOutboundBatch(n);
+    }
+    if (!sent) {
+      sendFailures->add();
+      break;
+    }
+    outbox.markSent(n, now);
+  }
+}
+
+size_t WebSocketClient::encodeOutboundBatch(uint8_t n, bool binary, String& output) {
+  const OutboundEntry& first = outbox.unsent(0);
+  uint16_t seq = outbox.unsent(n - 1).seq;      // seq của message = seq mục cuối, ack cộng dồn theo nó
+  bool alert = first.kind == OUTBOUND_ALERT;
+  uint32_t now = getCurrentTimestamp();
+  
+  if (binary) {
+    BinaryFrameWriter frame(txBuffer, sizeof(txBuffer));
+    frame.begin(alert ? CHANNEL_SENSOR_ALERT : CHANNEL_SENSOR_DATA, seq, now);
+    for (uint8_t i = 0; i < n; i++) {
+      const OutboundEntry& e = outbox.unsent(i);
+      // Cảnh báo: ageMs = ISR -> lúc gửi (gồm cả thời gian chờ trong hàng đợi)
+      uint32_t age = now - e.timestamp + (alert ? e.latencyUs / 1000 : 0);
+      if (e.flags & OUTBOUND_RESTORED) {
+        age = 0xFFFF;
+      }
+      frame.addRecord(e.sensor, (uint8_t)e.level, age > 0xFFFF ? 0xFFFF : (uint16_t)age, e.value);
+    }
+    return frame.size();
+  }
+  
+  JsonDocLease lease(jsonDocs);
+  if (!lease) {
+    return 0;
+  }
+  JsonDocument& doc = *lease.get();
+  stampEnvelope(doc, alert ? MessageType::SENSOR_ALERT : MessageType::SENSOR_DATA);
+  doc["seq"] = seq;
+  doc["requiresAck"] = true;
+  
+  JsonObject payload = doc.createNestedObject("payload");
+  if (alert) {
+    payload["sensorType"] = sensorKindToString(first.sensor);
+    payload["active"] = first.value != 0.0f;
+    payload["alertLevel"] = alertLevelToString(first.level);
+    payload["latencyUs"] = first.latencyUs + (now - first.timestamp) * 1000;
+    if (first.flags & OUTBOUND_RESTORED) {
+      payload["restored"] = true;      // từ flash của lần boot trước, thời điểm không rõ
+    }
+  } else {
+    // JSON: một id/ack cho cả lô, mỗi mẫu giữ timestamp riêng
+    JsonArray readings = payload.createNestedArray("readings");
+    for (uint8_t i = 0; i < n; i++) {
+      const OutboundEntry& e = outbox.unsent(i);
+      JsonObject reading = readings.createNestedObject();
+      reading["sensorType"] = sensorKindToString(e.sensor);
+      reading["value"] = e.value;
+      reading["unit"] = sensorKindUnit(e.sensor);
+      reading["alertLevel"] = alertLevelToString(e.level);
+      reading["timestamp"] = e.timestamp;
+    }
+  }
+  payload["location"] = "robot_main";
+  
+  return serializeJson(doc, output);
+}
+
+bool WebSocketClient::sendOutboundBatch(uint8_t n) {
+  String output;
+  size_t bytes = encodeOutboundBatch(n, binaryMode, output);
+  if (bytes == 0) {
+    return false;
+  }
+  return binaryMode ? webSocket.sendBIN(txBuffer, bytes) : sendJson(output);
+}
+
+bool WebSocketClient::sendJson(const String& json) {
+  txJsonBytes += json.length();
+  if (compressionMode) {
+    size_t packed = packer.pack(json.c_str(), json.length(), packTxBuffer + sizeof(FrameHeader), JSON_PACK_MAX);
+    if (packed > 0) {
+      FrameHeader header = { BINARY_VERSION, CHANNEL_JSON, binarySeq++, (uint32_t)getCurrentTimestamp() };
+      memcpy(packTxBuffer, &header, sizeof(header));
+      txWireBytes += sizeof(header) + packed;
+      return webSocket.sendBIN(packTxBuffer, sizeof(header) + packed);
+    }
+    // Dài quá JSON_PACK_MAX: gửi text, server nhận được cả hai
+  }
+  txWireBytes += json.length();
+  return webSocket.sendTXT(json.c_str(), json.length());
+}
+
+void WebSocketClient::sendVoiceCommand(const char* action, uint16_t streamId,
+                                       uint32_t sampleRate, const char* codec,
+                                       uint32_t durationMs) {
+  WsLock guard(*this);
+  if (!isConnected) {
+    return;
+  }
+  
+  StaticJsonDocument<384> doc;
+  stampEnvelope(doc, MessageType::VOICE_COMMAND);
+  doc["target"] = connectionTypeToString(ConnectionType::AI_ENGINE);
+  
+  JsonObject payload = doc.createNestedObject("payload");
+  payload["action"] = action;
+  payload["streamId"] = streamId;
+  payload["sampleRate"] = sampleRate;
+  payload["codec"] = codec;
+  if (durationMs > 0) {
+    payload["durationMs"] = durationMs;   // "end": độ dài đoạn nói, sẵn sàng cho transcription
+  }
+  
+  String output;
+  serializeJson(doc, output);
+  sendJson(output);
+}
+
+bool WebSocketClient::sendAudioFrame(uint16_t streamId, uint8_t codec, uint8_t flags,
+                                     uint16_t samples, const uint8_t* data, size_t bytes) {
+  WsLock guard(*this);
+  if (!isConnected || !binaryMode || bytes > AUDIO_MAX_PAYLOAD) {
+    return false;
+  }
+  if (!audioBudget.tryConsume(bytes, millis())) {
+    throttledAudioChunks++;
+    throttledCounter->add();
+    return false;
+  }
+  
+  FrameHeader header = { BINARY_VERSION, CHANNEL_AUDIO_UP, binarySeq++, (uint32_t)getCurrentTimestamp() };
+  AudioHeader audio = { streamId, codec, flags, samples };
+  memcpy(audioTxBuffer, &header, sizeof(header));
+  memcpy(audioTxBuffer + sizeof(header), &audio, sizeof(audio));
+  memcpy(audioTxBuffer + sizeof(header) + sizeof(audio), data, bytes);
+  return webSocket.sendBIN(audioTxBuffer, sizeof(header) + sizeof(audio) + bytes);
+}
+
+bool WebSocketClient::sendOtaFrame(OtaOp op, OtaStatus status, uint32_t offset) {
+  WsLock guard(*this);
+  if (!isConnected) {
+    return false;
+  }
+  
+  uint8_t frame[sizeof(FrameHeader) + sizeof(OtaHeader)];
+  FrameHeader header = { BINARY_VERSION, CHANNEL_OTA, binarySeq++, (uint32_t)getCurrentTimestamp() };
+  OtaHeader ota = { op, status, 0, offset };
+  memcpy(frame, &header, sizeof(header));
+  memcpy(frame + sizeof(header), &ota, sizeof(ota));
+  return webSocket.sendBIN(frame, sizeof(frame));
+}
+
 void WebSocketClient::sendAcknowledgment(const String& messageId) {
+  WsLock guard(*this);
   if (!isConnected) {
     return;
   }
   
   StaticJsonDocument<256> doc;
-  doc["id"] = generateUUID();
-  doc["type"] = messageTypeToString(MessageType::ACK);
-  doc["source"] = connectionTypeToString(ConnectionType::ESP32_TYPE);
-  doc["robotId"] = robotId;
-  doc["timestamp"] = getCurrentTimestamp();
+  stampEnvelope(doc, MessageType::ACK);
   doc["payload"]["messageId"] = messageId;
   
   String output;
   serializeJson(doc, output);
-  webSocket.sendTXT(output);
+  sendJson(output);
 }
 
 void WebSocketClient::sendError(const String& errorMessage) {
+  WsLock guard(*this);
   if (!isConnected) {
     return;
   }
   
   StaticJsonDocument<256> doc;
-  doc["id"] = generateUUID();
-  doc["type"] = messageTypeToString(MessageType::ERROR_MSG);
-  doc["source"] = connectionTypeToString(ConnectionType::ESP32_TYPE);
-  doc["robotId"] = robotId;
-  doc["timestamp"] = getCurrentTimestamp();
+  stampEnvelope(doc, MessageType::ERROR_MSG);
   doc["payload"]["error"] = errorMessage;
   
   String output;
   serializeJson(doc, output);
-  webSocket.sendTXT(output);
+  sendJson(output);
 }
 
 void WebSocketClient::sendHeartbeat() {
+  WsLock guard(*this);
   if (!isConnected) {
     return;
   }
   
   StaticJsonDocument<256> doc;
-  doc["id"] = generateUUID();
-  doc["type"] = messageTypeToString(MessageType::HEARTBEAT);
-  doc["source"] = connectionTypeToString(ConnectionType::ESP32_TYPE);
-  doc["robotId"] = robotId;
-  doc["timestamp"] = getCurrentTimestamp();
+  stampEnvelope(doc, MessageType::HEARTBEAT);
+  // Server trả lại clientSentUs trong heartbeat_ack.clock -> một mẫu cho ClockSync
+  JsonObject payload = doc.createNestedObject("payload");
+  payload["clientSentUs"] = esp_timer_get_time();
+  if (clockSync.isSynced()) {
+    payload["bootEpochUs"] = clockSync.getBootEpochUs();   // frame bin1 mang millis(): giờ thực = bootEpochUs + ms * 1000
+    payload["clock"] = clockSync.getSourceName();
+  }
+  
+  String output;
+  serializeJson(doc, output);
+  sendJson(output);
+}
+
+bool WebSocketClient::sendStatusUpdate(const char* status, StatusWriter write) {
+  WsLock guard(*this);
+  if (!isConnected) {
+    return false;
+  }
+  
+  JsonDocLease lease(jsonDocs);
+  if (!lease) {
+    return false;
+  }
+  JsonDocument& doc = *lease.get();
+  stampEnvelope(doc, MessageType::STATUS_UPDATE);
+  
+  JsonObject payload = doc.createNestedObject("payload");
+  payload["status"] = status;
+  if (write) {
+    write(payload);
+  }
   
   String output;
   serializeJson(doc, output);
-  webSocket.sendTXT(output);
+  return sendJson(output);
+}
+
+bool WebSocketClient::sendPing() {
+  WsLock guard(*this);
+  if (!webSocket.isConnected()) {
+    return false;
+  }
+  // Chỉ một ping chờ pong tại một thời điểm; pong không có số thứ tự
+  pingSentUs = (uint32_t)esp_timer_get_time();
+  if (pingSentUs == 0) {
+    pingSentUs = 1;
+  }
+  return webSocket.sendPing();
 }
 
 // ============================================
 // HELPER METHODS
 // ============================================
 
-String WebSocketClient::messageTypeToString(MessageType type) const {
-  switch (type) {
-    case MessageType::CONNECTION_INIT:
-      return "connection_init";
-    case MessageType::SENSOR_DATA:
-      return "sensor_data";
-    case MessageType::SENSOR_ALERT:
-      return "sensor_alert";
-    case MessageType::VOICE_COMMAND:
-      return "voice_command";
-    case MessageType::VOICE_TRANSCRIPTION:
-      return "voice_transcription";
-    case MessageType::AI_RESPONSE:
-      return "ai_response";
-    case MessageType::ACTUATOR_COMMAND:
-      return "actuator_command";
-    case MessageType::BEHAVIOR_UPDATE:
-      return "behavior_update";
-    case MessageType::EMOTION_UPDATE:
-      return "emotion_update";
-    case MessageType::HEARTBEAT:
-      return "heartbeat";
-    case MessageType::STATUS_UPDATE:
-      return "status_update";
-    case MessageType::ERROR_MSG:
-      return "error";
-    case MessageType::ACK:
-      return "ack";
-    default:
-      return "unknown";
-  }
+const char* WebSocketClient::messageTypeToString(MessageType type) const {
+  return messageTypeName(type);
 }
 
-MessageType WebSocketClient::stringToMessageType(const char* typeStr) const {
-  if (strcmp(typeStr, "actuator_command") == 0) return MessageType::ACTUATOR_COMMAND;
-  if (strcmp(typeStr, "ai_response") == 0) return MessageType::AI_RESPONSE;
-  if (strcmp(typeStr, "ack") == 0) return MessageType::ACK;
-  return MessageType::HEARTBEAT;
+bool WebSocketClient::stringToMessageType(const char* typeStr, MessageType& type) const {
+  return messageTypeFromName(typeStr, type);
 }
 
-String WebSocketClient::connectionTypeToString(ConnectionType type) const {
-  switch (type) {
-    case ConnectionType::ESP32_TYPE:
-      return "esp32";
-    case ConnectionType::AI_ENGINE:
-      return "ai_engine";
-    case ConnectionType::WEB_CLIENT:
-      return "web_client";
-    case ConnectionType::MOBILE:
-      return "mobile";
-    default:
-      return "unknown";
-  }
+const char* WebSocketClient::connectionTypeToString(ConnectionType type) const {
+  return connectionTypeName(type);
 }
 
-String WebSocketClient::alertLevelToString(AlertLevel level) const {
-  switch (level) {
-    case AlertLevel::NORMAL:
-      return "normal";
-    case AlertLevel::WARNING:
-      return "warning";
-    case AlertLevel::DANGER:
-      return "danger";
-    case AlertLevel::CRITICAL:
-      return "critical";
-    default:
-      return "normal";
-  }
+const char* WebSocketClient::alertLevelToString(AlertLevel level) const {
+  return alertLevelName(level);
 }
 
 AlertLevel WebSocketClient::getAlertLevel(const char* sensorType, float value) const {
-  if (strcmp(sensorType, "temperature") == 0) {
-    if (value > 40) return AlertLevel::CRITICAL;
-    if (value > 35) return AlertLevel::DANGER;
-    if (value < 15) return AlertLevel::WARNING;
-  } else if (strcmp(sensorType, "humidity") == 0) {
-    if (value > 85 || value < 20) return AlertLevel::WARNING;
-  } else if (strcmp(sensorType, "gas") == 0) {
-    if (value > 300) return AlertLevel::CRITICAL;
-    if (value > 200) return AlertLevel::DANGER;
-    if (value > 100) return AlertLevel::WARNING;
+  WsLock guard(*this);
+  return alertRules.classify(sensorKindFromString(sensorType), value);
+}
+
+AlertRules& WebSocketClient::getAlertRules() {
+  return alertRules;
+}
+
+SensorKind WebSocketClient::sensorKindFromString(const char* sensorType) const {
+  return sensorKindFromName(sensorType);
+}
+
+const char* WebSocketClient::sensorKindToString(SensorKind kind) const {
+  return sensorKindName(kind);
+}
+
+const char* WebSocketClient::sensorKindUnit(SensorKind kind) const {
+  switch (kind) {
+    case SENSOR_TEMPERATURE: return "C";
+    case SENSOR_HUMIDITY:    return "%";
+    case SENSOR_GAS:         return "raw";
+    case SENSOR_DISTANCE:    return "cm";
+    case SENSOR_LIGHT:       return "lux";
+    case SENSOR_SOUND:       return "dB";
+    default:                 return "";
   }
-  return AlertLevel::NORMAL;
 }
 
 String WebSocketClient::generateUUID() const {
@@ -330,15 +779,82 @@ unsigned long WebSocketClient::getCurrentTimestamp() const {
   return millis();
 }
 
+void WebSocketClient::stampEnvelope(JsonDocument& doc, MessageType type) {
+  doc["id"] = generateUUID();
+  doc["type"] = messageTypeToString(type);
+  doc["source"] = connectionTypeToString(ConnectionType::ESP32_TYPE);
+  doc["robotId"] = robotId;
+  doc["timestamp"] = getCurrentTimestamp();
+  if (clockSync.isSynced()) {
+    doc["timeUs"] = clockSync.nowUs();
+  }
+  if (traceId[0] != '\0') {
+    doc["traceId"] = (const char*)traceId;
+  } else {
+    char own[TRACE_ID_LEN + 1];          // ngoài trace: mỗi message là một trace riêng
+    makeTraceId(own);
+    doc["traceId"] = (const char*)own;
+  }
+}
+
+void WebSocketClient::makeTraceId(char* out) const {
+  snprintf(out, TRACE_ID_LEN + 1, "%08x%08x", (unsigned)random(0xFFFFFFFF), (unsigned)random(0xFFFFFFFF));
+}
+
+void WebSocketClient::pollSntp() {
+  if (clockSync.getSource() == ClockSync::CLOCK_SERVER) {
+    return;
+  }
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  if (tv.tv_sec > 1700000000) {          // trước đó là giờ mặc định lúc boot, SNTP chưa trả lời
+    clockSync.setSntp((int64_t)tv.tv_sec * 1000000 + tv.tv_usec, esp_timer_get_time());
+  }
+}
+
 // ============================================
 // MESSAGE HANDLERS
 // ============================================
 
 void WebSocketClient::handleConnectionAck(const JsonDocument& doc) {
+  // Mẫu đồng hồ: ack của connection_init / heartbeat trả lại clientSentUs kèm giờ server
+  JsonObjectConst sample = doc["payload"]["clock"];
+  if (!sample.isNull() && !clockSync.addSample(sample["clientSentUs"].as<int64_t>(), sample["serverRecvUs"].as<int64_t>(),
+                                               sample["serverSendUs"].as<int64_t>(), rxAtUs)) {
+    Serial.println("[WebSocket] Clock sample rejected");
+  }
+  
+  // Hạn mức / credit mới (ack kết nối, ack heartbeat)
+  applyRateLimit(doc["payload"]["rateLimit"]);
+  
+  // Ack cộng dồn của hàng đợi gửi (có thể đi kèm ack kết nối)
+  if (!doc["payload"]["ackSeq"].isNull()) {
+    outbox.ack(doc["payload"]["ackSeq"].as<uint16_t>());
+  }
+  
   if (doc["payload"]["connectionId"]) {
     connectionId = doc["payload"]["connectionId"].as<String>();
     isConnected = true;
-    Serial.println("[WebSocket] Connection established with ID: " + connectionId);
+    connectedAtMs = millis();
+    
+    // Server chọn encoding trong danh sách đã quảng bá, không có thì giữ JSON
+    const char* encoding = doc["payload"]["encoding"] | "json";
+    binaryMode = binaryEnabled && strcmp(encoding, BINARY_ENCODING) == 0;
+    compressionMode = compressionEnabled && strcmp(doc["payload"]["compression"] | "", JSON_PACK_NAME) == 0;
+    
+    // Codec audio chỉ nhận nếu nằm trong danh sách đã quảng bá
+    audioCodec = audioCodecFromName(doc["payload"]["audioCodec"] | "pcm16");
+    if (memchr(audioOffers, audioCodec, audioOfferCount) == nullptr) {
+      audioCodec = AUDIO_PCM16;
+    }
+    Serial.println("[WebSocket] Connection established with ID: " + connectionId +
+                   " (encoding: " + (binaryMode ? BINARY_ENCODING : "json") +
+                   ", audio: " + audioCodecName(audioCodec) +
+                   ", compression: " + (compressionMode ? JSON_PACK_NAME : "none") + ")");
+    
+    // Gửi lại mọi thứ chưa được ack từ kết nối trước
+    outbox.setOnline(true);
+    outbox.rewind();
     
     if (onConnect) {
       onConnect();
@@ -367,6 +883,101 @@ void WebSocketClient::handleAIResponse(const JsonDocument& doc) {
   }
 }
 
+void WebSocketClient::handleBehaviorUpdate(const JsonDocument& doc) {
+  applyRateLimit(doc["payload"]["rateLimit"]);
+  
+  JsonArrayConst rules = doc["payload"]["alertRules"];
+  if (!rules.isNull()) {
+    uint8_t updated = alertRules.apply(rules);
+    Serial.printf("[WebSocket] Alert rules updated: %u of %u\n", updated, (unsigned)rules.size());
+    if (doc["id"]) {
+      sendAcknowledgment(doc["id"].as<String>());
+    }
+  }
+  
+  if (onMessage) {
+    onMessage(doc);
+  }
+}
+
+// Mục "false" bỏ giới hạn; perSec/burst đổi hạn mức; credits cộng thêm
+static void applyBudget(RateBudget& budget, JsonVariantConst spec, uint32_t now) {
+  if (spec.isNull()) {
+    return;
+  }
+  if (spec.is<bool>()) {
+    if (!spec.as<bool>()) {
+      budget.unlimit();
+    }
+    return;
+  }
+  if (!spec["perSec"].isNull() || !spec["burst"].isNull()) {
+    budget.configure(spec["perSec"] | 0u, spec["burst"] | 0u, now);
+  }
+  if (!spec["credits"].isNull()) {
+    budget.grant(spec["credits"].as<uint32_t>());
+  }
+}
+
+void WebSocketClient::applyRateLimit(JsonVariantConst limits) {
+  if (limits.isNull()) {
+    return;
+  }
+  uint32_t now = millis();
+  applyBudget(telemetryBudget, limits["telemetry"], now);
+  applyBudget(audioBudget, limits["audio"], now);
+}
+
+void WebSocketClient::dispatchMessage(const JsonDocument& doc) {
+  MessageType type;
+  bool known = stringToMessageType(doc["type"] | "", type);
+  if (!known || type != MessageType::ACK) {
+    adoptTrace(doc);
+  }
+  if (known && messageHandlers[(uint8_t)type]) {
+    messageHandlers[(uint8_t)type](doc);
+  } else if (onMessage) {
+    onMessage(doc);
+  }
+}
+
+void WebSocketClient::adoptTrace(const JsonDocument& doc) {
+  const char* id = doc["traceId"] | "";
+  if (strlen(id) != TRACE_ID_LEN) {
+    return;
+  }
+  memcpy(traceId, id, TRACE_ID_LEN + 1);
+  traceAtMs = millis();
+}
+
+void WebSocketClient::handleBinaryFrame(const uint8_t* payload, size_t length) {
+  if (length < sizeof(FrameHeader)) {
+    return;
+  }
+  FrameHeader header;
+  memcpy(&header, payload, sizeof(header));   // payload không căn chỉnh, không ép kiểu trực tiếp
+  if (header.version != BINARY_VERSION) {
+    Serial.printf("[WebSocket] Unsupported binary frame version %u\n", header.version);
+    return;
+  }
+  
+  if (header.channel == CHANNEL_AUDIO_DOWN && length >= sizeof(FrameHeader) + sizeof(AudioHeader)) {
+    AudioHeader audio;
+    memcpy(&audio, payload + sizeof(FrameHeader), sizeof(audio));
+    if (onAudioFrame) {
+      size_t offset = sizeof(FrameHeader) + sizeof(AudioHeader);
+      onAudioFrame(header, audio, payload + offset, length - offset);
+    }
+  } else if (header.channel == CHANNEL_OTA && length >= sizeof(FrameHeader) + sizeof(OtaHeader)) {
+    OtaHeader ota;
+    memcpy(&ota, payload + sizeof(FrameHeader), sizeof(ota));
+    if (onOtaFrame) {
+      size_t offset = sizeof(FrameHeader) + sizeof(OtaHeader);
+      onOtaFrame(ota, payload + offset, length - offset);
+    }
+  }
+}
+
 // ============================================
 // WEBSOCKET EVENT HANDLER
 // ============================================
@@ -375,7 +986,16 @@ void WebSocketClient::handleWebSocketEvent(WStype_t type, uint8_t* payload, size
   switch (type) {
     case WStype_DISCONNECTED: {
       isConnected = false;
+      binaryMode = false;
+      compressionMode = false;
+      audioCodec = AUDIO_PCM16;
       connectionId = "";
+      outbox.setOnline(false);
+      outbox.rewind();
+      // Hạn mức theo kết nối: server gửi lại trong ack lần sau
+      telemetryBudget.unlimit();
+      audioBudget.unlimit();
+      scheduleReconnect(millis());
       Serial.println("[WebSocket] Disconnected from server");
       
       if (onDisconnect) {
@@ -389,15 +1009,33 @@ void WebSocketClient::handleWebSocketEvent(WStype_t type, uint8_t* payload, size
       
       // Send connection initialization
       StaticJsonDocument<512> doc;
-      doc["id"] = generateUUID();
-      doc["type"] = messageTypeToString(MessageType::CONNECTION_INIT);
-      doc["source"] = connectionTypeToString(ConnectionType::ESP32_TYPE);
-      doc["robotId"] = robotId;
-      doc["timestamp"] = getCurrentTimestamp();
+      stampEnvelope(doc, MessageType::CONNECTION_INIT);
       
       JsonObject payloadObj = doc.createNestedObject("payload");
       payloadObj["userId"] = nullptr;
       payloadObj["ipAddress"] = "0.0.0.0"; // Can be enhanced with actual IP
+      payloadObj["resumeSeq"] = outbox.firstPendingSeq(); // server bỏ bản trùng và trả ackSeq trong ack
+      payloadObj["clientSentUs"] = esp_timer_get_time();  // mẫu clock đầu tiên đi cùng ack kết nối
+      
+      // Danh sách encoding theo thứ tự ưu tiên, server trả lại lựa chọn trong ack
+      JsonArray encodings = payloadObj.createNestedArray("encodings");
+      if (binaryEnabled) {
+        encodings.add(BINARY_ENCODING);
+      }
+      encodings.add("json");
+      
+      // Nén uplink bằng từ điển; connection_init luôn là text
+      if (compressionEnabled) {
+        payloadObj.createNestedArray("compression").add(JSON_PACK_NAME);
+      }
+      
+      JsonArray audioCodecs = payloadObj.createNestedArray("audioCodecs");
+      for (uint8_t i = 0; i < audioOfferCount; i++) {
+        audioCodecs.add(audioCodecName(audioOffers[i]));
+      }
+      if (memchr(audioOffers, AUDIO_PCM16, audioOfferCount) == nullptr) {
+        audioCodecs.add(audioCodecName(AUDIO_PCM16));
+      }
       
       String output;
       serializeJson(doc, output);
@@ -408,33 +1046,52 @@ void WebSocketClient::handleWebSocketEvent(WStype_t type, uint8_t* payload, size
     }
     
     case WStype_TEXT: {
-      String message = String((char*)payload).substring(0, length);
-      Serial.println("[WebSocket] Message received: " + message);
+      rxMessages++;
+      rxAtUs = esp_timer_get_time();
+      if (logMessageChars > 0) {
+        int shown = (int)min<size_t>(length, logMessageChars);
+        Serial.printf("[WebSocket] Message received (%u B): %.*s%s\n",
+                      (unsigned)length, shown, (const char*)payload, length > (size_t)shown ? "..." : "");
+      }
       
-      StaticJsonDocument<1024> doc;
-      DeserializationError error = deserializeJson(doc, message);
+      // Parse trực tiếp từ payload/length, không copy sang String
+      JsonDocLease lease(jsonDocs);
+      if (!lease) {
+        rxParseErrors++;
+        Serial.println("[WebSocket] No free JSON document, message dropped");
+        break;
+      }
+      JsonDocument& doc = *lease.get();
+      DeserializationError error;
+      {
+        CycleTimer timer(parseHist);
+        error = deserializeJson(doc, (const char*)payload, length);
+      }
       
       if (error) {
-        Serial.println("[WebSocket] JSON parse failed");
+        rxParseErrors++;
+        Serial.printf("[WebSocket] JSON parse failed: %s\n", error.c_str());
         if (onError) {
           onError("JSON parse error");
         }
         break;
       }
       
-      const char* msgType = doc["type"];
-      
-      // Handle different message types
-      if (strcmp(msgType, "ack") == 0) {
-        handleConnectionAck(doc);
-      } else if (strcmp(msgType, "actuator_command") == 0) {
-        handleActuatorCommandMessage(doc);
-      } else if (strcmp(msgType, "ai_response") == 0) {
-        handleAIResponse(doc);
-      } else {
-        if (onMessage) {
-          onMessage(doc);
-        }
+      dispatchMessage(doc);
+      break;
+    }
+    
+    case WStype_BIN: {
+      // Không log từng frame: TTS đến ~50 frame/s
+      handleBinaryFrame(payload, length);
+      break;
+    }
+    
+    case WStype_PONG: {
+      if (pingSentUs != 0) {
+        lastRttUs = (uint32_t)esp_timer_get_time() - pingSentUs;
+        rttHist->record(lastRttUs);
+        pingSentUs = 0;
       }
       break;
     }
@@ -452,6 +1109,52 @@ void WebSocketClient::handleWebSocketEvent(WStype_t type, uint8_t* payload, size
   }
 }
 
+// ============================================
+// BINARY ENCODING
+// ============================================
+
+void WebSocketClient::setBinaryEnabled(bool enabled) {
+  binaryEnabled = enabled;
+  if (!enabled) {
+    binaryMode = false;
+  }
+}
+
+bool WebSocketClient::isBinaryMode() const {
+  return binaryMode;
+}
+
+void WebSocketClient::setCompressionEnabled(bool enabled) {
+  compressionEnabled = enabled;
+  if (!enabled) {
+    compressionMode = false;
+  }
+}
+
+bool WebSocketClient::isCompressionMode() const {
+  return compressionMode;
+}
+
+void WebSocketClient::setSecure(const char* caCertPem) {
+  caCert = caCertPem;
+}
+
+bool WebSocketClient::isSecure() const {
+  return caCert != nullptr;
+}
+
+void WebSocketClient::offerAudioCodec(AudioCodec codec) {
+  if (codec >= AUDIO_CODEC_COUNT || audioOfferCount >= AUDIO_CODEC_COUNT ||
+      memchr(audioOffers, codec, audioOfferCount) != nullptr) {
+    return;
+  }
+  audioOffers[audioOfferCount++] = codec;
+}
+
+AudioCodec WebSocketClient::getAudioCodec() const {
+  return audioCodec;
+}
+
 // ============================================
 // GETTERS
 // ============================================
@@ -460,6 +1163,100 @@ String WebSocketClient::getConnectionId() const {
   return connectionId;
 }
 
+bool WebSocketClient::enableOfflineSpill(const char* path) {
+  return outbox.enableSpill(path);
+}
+
+OutboundQueue& WebSocketClient::getOutbox() {
+  return outbox;
+}
+
+void WebSocketClient::printRxStats(Print& out) const {
+  out.printf("[WebSocket] rx=%u parse_errors=%u | json arena peak=%u/%u B no_memory=%u pool_exhausted=%u"
+             " | tx json=%u B wire=%u B | throttled telemetry=%u audio=%u | reconnect attempts=%u\n",
+             rxMessages, rxParseErrors, (unsigned)jsonDocs.peakUsed(), (unsigned)JsonDocPool::ARENA_BYTES,
+             jsonDocs.getFailures(), jsonDocs.getExhausted(), txJsonBytes, txWireBytes,
+             throttledBatches, throttledAudioChunks, reconnectAttempts);
+}
+
+uint32_t WebSocketClient::getLastRttUs() const {
+  return lastRttUs;
+}
+
+uint32_t WebSocketClient::getReconnectDelayMs() const {
+  int32_t left = (int32_t)(nextAttemptAtMs - millis());
+  return left > 0 ? (uint32_t)left : 0;
+}
+
+uint8_t WebSocketClient::getReconnectAttempts() const {
+  return reconnectAttempts;
+}
+
+const RateBudget& WebSocketClient::getTelemetryBudget() const {
+  return telemetryBudget;
+}
+
+const RateBudget& WebSocketClient::getAudioBudget() const {
+  return audioBudget;
+}
+
+const ClockSync& WebSocketClient::getClock() const {
+  return clockSync;
+}
+
+// ============================================
+// TRACE
+// ============================================
+
+const char* WebSocketClient::beginTrace() {
+  WsLock guard(*this);
+  makeTraceId(traceId);
+  traceAtMs = millis();
+  return traceId;
+}
+
+void WebSocketClient::endTrace() {
+  WsLock guard(*this);
+  traceId[0] = '\0';
+  if (isConnected && spans.size() > 0) {
+    flushSpans();
+  }
+}
+
+const char* WebSocketClient::getTraceId() const {
+  return traceId;
+}
+
+void WebSocketClient::recordSpan(const char* name, int64_t startUs, int64_t endUs) {
+  WsLock guard(*this);
+  spans.record(traceId, name, startUs, endUs);
+  if (traceId[0] != '\0') {
+    traceAtMs = millis();
+  }
+}
+
+void WebSocketClient::flushSpans() {
+  // Đổi sang giờ thực lúc gửi: span ghi trước khi đồng bộ vẫn đặt đúng chỗ
+  bool sent = sendStatusUpdate("trace", [this](JsonObject payload) {
+    payload["clock"] = clockSync.getSourceName();
+    payload["clockRttUs"] = clockSync.getRttUs();
+    payload["dropped"] = spans.getDropped();
+    JsonArray list = payload.createNestedArray("spans");
+    for (uint8_t i = 0; i < spans.size(); i++) {
+      const TraceSpan& span = spans.at(i);
+      JsonObject item = list.createNestedObject();
+      item["traceId"] = (const char*)span.traceId;
+      item["name"] = span.name;
+      item["startUs"] = clockSync.isSynced() ? clockSync.toWallUs(span.startUs) : span.startUs;
+      item["durUs"] = span.durUs;
+    }
+  });
+  if (sent) {
+    spans.clear();
+  }
+  lastSpanFlushMs = millis();
+}
+
 String WebSocketClient::getRobotId() const {
   return robotId;
 }
\ No newline at end of file
@@ -3,39 +3,22 @@
 #include <WebSocketsClient.h>
 #include <ArduinoJson.h>
 #include <functional>
+#include "AlertRules.h"
+#include "BinaryFrame.h"
+#include "JsonArena.h"
+#include "JsonPack.h"
+#include "MessageTypes.h"
+#include "OutboundQueue.h"
+#include "RateBudget.h"
+#include "Metrics.h"
+#include "Trace.h"
 
-// Message types enum
-//là kiểu liệt kê. Nó cho phép định nghĩa một tập hợp các hằng số có tên
-enum class MessageType {
-  CONNECTION_INIT,
-  SENSOR_DATA,
-  SENSOR_ALERT,
-  VOICE_COMMAND,
-  VOICE_TRANSCRIPTION,
-  AI_RESPONSE,
-  ACTUATOR_COMMAND,
-  BEHAVIOR_UPDATE,
-  EMOTION_UPDATE,
-  HEARTBEAT,
-  STATUS_UPDATE,
-  ERROR_MSG,
-  ACK
-};
-
-// Connection types enum
-enum class ConnectionType {
-  ESP32_TYPE,
-  AI_ENGINE,      // 🔄 RENAMED from LAPTOP_AI
-  WEB_CLIENT,
-  MOBILE
-};
-
-// Alert levels
-enum class AlertLevel {
-  NORMAL,
-  WARNING,
-  DANGER,
-  CRITICAL
+// Một mẫu cảm biến chờ gửi theo lô (TelemetryBatcher)
+struct SensorSample {
+  uint32_t timestamp;   // millis() lúc lấy mẫu
+  float value;
+  SensorKind sensor;
+  AlertLevel level;
 };
 
 // Callback function types
@@ -45,7 +28,11 @@ using OnConnectCallback = std::function<void()>;
 using OnDisconnectCallback = std::function<void()>;
 using OnMessageCallback = std::function<void(const JsonDocument&)>;
 using OnErrorCallback = std::function<void(const String&)>;
+using StatusWriter = std::function<void(JsonObject payload)>;   // Điền payload cho STATUS_UPDATE
 using OnActuatorCommandCallback = std::function<void(const JsonDocument&)>;
+using OnAudioFrameCallback = std::function<void(const FrameHeader&, const AudioHeader&,
+                                                const uint8_t* payload, size_t bytes)>;
+using OnOtaFrameCallback = std::function<void(const OtaHeader&, const uint8_t* payload, size_t bytes)>;
 
 class WebSocketClient {
 private:
@@ -65,6 +52,102 @@ private:
   uint16_t reconnectInterval;
   uint16_t heartbeatInterval;
   
+  // Kết nối lại bằng backoff mũ có jitter: cả fleet mất điện cùng lúc cũng không
+  // dồn vào server cùng một nhịp. Thư viện tự thử lại trong loop(), nên update()
+  // chỉ gọi loop() khi đã kết nối hoặc trong cửa sổ thử; hết cửa sổ mà chưa lên
+  // thì chờ lâu gấp đôi (tối đa reconnectMaxMs), mỗi lần lệch ngẫu nhiên.
+  uint32_t reconnectMaxMs;
+  uint8_t reconnectAttempts;                                          // số lần thất bại liên tiếp
+  uint32_t nextAttemptAtMs;                                           // hết chờ backoff
+  uint32_t attemptUntilMs;                                            // 0 = chưa mở cửa sổ thử
+  uint32_t connectedAtMs;
+  bool connectStarted;                                                // connect() đã gọi ít nhất một lần
+  Counter* reconnectCounter;
+  static const uint32_t CONNECT_WINDOW_MS = 4000;                     // TCP + bắt tay WebSocket
+  static const uint32_t BOOT_JITTER_MS = 2000;                        // lệch lần kết nối đầu sau boot
+  static const uint32_t BACKOFF_RESET_MS = 60000;                     // kết nối ổn định lâu vậy mới hạ backoff
+  
+  // Hạn mức server cấp cho robot này (RateBudget.h): telemetry theo message, audio theo byte
+  RateBudget telemetryBudget;
+  RateBudget audioBudget;
+  bool telemetryHeld;                                                 // lô dữ liệu đầu hàng đợi đang chờ hạn mức
+  uint32_t throttledBatches;                                          // số lần telemetry phải chờ hạn mức
+  uint32_t throttledAudioChunks;                                      // chunk audio bị bỏ vì hết hạn mức
+  Counter* throttledCounter;
+  
+  // Encoding nhị phân "bin1" (xem BinaryFrame.h), bật khi server chấp nhận trong ack
+  bool binaryEnabled;                                                 // có quảng bá "bin1" trong connection_init không
+  bool binaryMode;                                                    // server đã chọn "bin1"
+  uint16_t binarySeq;                                                 // seq frame audio; telemetry dùng seq của outbox
+  uint8_t txBuffer[BINARY_MAX_FRAME];                                 // buffer tĩnh cho frame nhị phân, không cấp phát heap
+  uint8_t audioTxBuffer[sizeof(FrameHeader) + sizeof(AudioHeader) + AUDIO_MAX_PAYLOAD];
+  
+  // Nén message JSON gửi lên bằng từ điển "dict1" (JsonPack.h), bật khi server chấp nhận trong ack
+  JsonPacker packer;
+  bool compressionEnabled;                                            // có quảng bá "dict1" trong connection_init không
+  bool compressionMode;                                               // server đã chọn "dict1"
+  uint8_t packTxBuffer[sizeof(FrameHeader) + JSON_PACK_MAX];
+  uint32_t txJsonBytes;                                               // JSON trước khi nén
+  uint32_t txWireBytes;                                               // thực gửi (frame nén hoặc text)
+  
+  // wss:// (setSecure): CA của server, nullptr = ws://
+  const char* caCert;
+  
+  // Codec audio uplink: quảng bá theo thứ tự ưu tiên, server chọn trong ack
+  uint8_t audioOffers[AUDIO_CODEC_COUNT];
+  uint8_t audioOfferCount;
+  AudioCodec audioCodec;                                              // codec server đã chọn cho kết nối hiện tại
+  
+  // Gửi tin cậy: mẫu và cảnh báo cảm biến đi qua hàng đợi có seq/ack (OutboundQueue.h)
+  OutboundQueue outbox;
+  AlertRules alertRules;                                              // luật cảnh báo cục bộ, server đổi qua BEHAVIOR_UPDATE
+  static const uint8_t OUTBOX_BURST = 4;                              // message tối đa mỗi lần update()
+  static const uint8_t OUTBOX_BATCH = 16;                             // mẫu tối đa mỗi message
+  
+  // Nhận JSON: parse thẳng từ payload vào document của pool (arena tĩnh, không heap)
+  JsonDocPool jsonDocs;                                               // dùng chung cho message gửi từ hàng đợi
+  uint16_t logMessageChars;                                           // 0 = không log nội dung message
+  uint32_t rxMessages;
+  uint32_t rxParseErrors;
+  
+  // Metrics (Metrics.h): thời gian gửi/parse, độ sâu hàng đợi gửi
+  Histogram* sendHist;
+  Histogram* parseHist;
+  Gauge* outboxDepth;
+  Counter* sendFailures;
+  Histogram* rttHist;                                                 // ping -> pong (µs)
+  uint32_t pingSentUs;                                                // 0 = không có ping đang chờ
+  uint32_t lastRttUs;
+  
+  // Trace đầu-cuối (Trace.h): giờ thực đồng bộ với server, traceId trong mọi message
+  ClockSync clockSync;
+  SpanLog spans;
+  char traceId[TRACE_ID_LEN + 1];                                     // "" = không có trace đang mở
+  uint32_t traceAtMs;                                                 // lần cuối trace được dùng
+  uint32_t lastSpanFlushMs;
+  int64_t rxAtUs;                                                     // esp_timer lúc nhận message đang xử lý (t3)
+  bool sntpStarted;
+  static const uint32_t TRACE_IDLE_MS = 30000;                        // trace không ai dùng thì tự đóng
+  static const uint32_t SPAN_FLUSH_MS = 2000;                         // span chờ tối đa trước khi gửi
+  
+  // Đa task: update() chạy trong task mạng, loop / task dispatcher gửi song song
+  SemaphoreHandle_t wsMutex;                                          // khoá đệ quy: callback trong update() gửi tiếp được
+  
+  // update() giữ wsMutex cả trong webSocket.loop() (connect TCP/TLS, ota.start() băm
+  // cả phân vùng). Cảnh báo từ task khác không chờ khoá: khoá bận thì vào hộp chờ,
+  // task mạng chuyển sang outbox ở lượt update() kế tiếp
+  struct PendingAlert {
+    uint32_t timestamp;
+    uint32_t latencyUs;
+    SensorKind sensor;
+    AlertLevel level;
+    bool active;
+  };
+  static const uint8_t PENDING_ALERTS = 4;
+  PendingAlert pendingAlerts[PENDING_ALERTS];
+  uint8_t pendingAlertCount;
+  portMUX_TYPE pendingLock;
+  
   // Các hàm callback
                                                                 // Ví dụ sử dụng std::function:
                                                                 // std::function<void()> f;   // Khai báo một std::function<void()>
@@ -79,20 +162,42 @@ private:
   OnMessageCallback onMessage;
   OnErrorCallback onError;
   OnActuatorCommandCallback onActuatorCommand;
+  OnAudioFrameCallback onAudioFrame;
+  OnOtaFrameCallback onOtaFrame;
+  OnMessageCallback messageHandlers[MESSAGE_TYPE_COUNT];              // dispatch theo MessageType, trống thì rơi về onMessage
   
   // Các hàm hỗ trợ
-  String messageTypeToString(MessageType type) const;                 // Chuyển kiểu MessageType sang chuỗi
-  MessageType stringToMessageType(const char* typeStr) const;         // Chuyển chuỗi sang kiểu MessageType
-  String connectionTypeToString(ConnectionType type) const;           // Chuyển kiểu ConnectionType sang chuỗi
-  String alertLevelToString(AlertLevel level) const;                  // Chuyển mức cảnh báo sang chuỗi
-  AlertLevel getAlertLevel(const char* sensorType, float value) const;// Xác định mức cảnh báo dựa trên loại cảm biến và giá trị
+  const char* messageTypeToString(MessageType type) const;            // Chuyển kiểu MessageType sang chuỗi (bảng MessageTypes.h)
+  bool stringToMessageType(const char* typeStr, MessageType& type) const; // Chuyển chuỗi sang MessageType, false nếu không biết
+  const char* connectionTypeToString(ConnectionType type) const;      // Chuyển kiểu ConnectionType sang chuỗi
+  const char* alertLevelToString(AlertLevel level) const;             // Chuyển mức cảnh báo sang chuỗi
+  SensorKind sensorKindFromString(const char* sensorType) const;      // Chuyển tên cảm biến sang SensorKind
+  const char* sensorKindToString(SensorKind kind) const;              // Tên cảm biến cho JSON
+  const char* sensorKindUnit(SensorKind kind) const;                  // Đơn vị mặc định của từng loại
+  void pumpOutbox();                                                  // Gửi tối đa OUTBOX_BURST message từ hàng đợi, không chờ
+  bool sendOutboundBatch(uint8_t n);                                  // n mục đầu chưa gửi -> 1 message (bin1 hoặc JSON)
+  bool sendJson(const String& json);                                  // frame CHANNEL_JSON nếu đã thoả thuận "dict1", không thì text
   String generateUUID() const;                                        // Sinh UUID ngẫu nhiên
-  unsigned long getCurrentTimestamp() const;                          // Lấy timestamp hiện tại
+  unsigned long getCurrentTimestamp() const;                          // millis() của robot (frame bin1, hàng đợi); giờ thực ở "timeUs"
+  void stampEnvelope(JsonDocument& doc, MessageType type);            // id, type, source, robotId, timestamp, timeUs, traceId
+  void makeTraceId(char* out) const;                                  // TRACE_ID_LEN ký tự hex ngẫu nhiên
+  void adoptTrace(const JsonDocument& doc);                           // message server có "traceId" -> trace hiện tại
+  void pollSntp();                                                    // SNTP đã có giờ thì dùng tạm khi server chưa trả clock
+  void flushSpans();                                                  // span trong log -> STATUS_UPDATE "trace"
+  bool reconnectDue(uint32_t now);                                    // được gọi loop() khi chưa có socket không
+  void scheduleReconnect(uint32_t now);                               // lần thử vừa rồi hỏng -> chờ backoff kế tiếp
+  void applyRateLimit(JsonVariantConst limits);                       // "rateLimit" trong ack / behavior_update
+  bool tryLock() const;                                               // lấy wsMutex nếu đang rảnh, không chờ
+  bool stashAlert(const PendingAlert& alert);                         // vào hộp chờ, false nếu đầy
+  void drainPendingAlerts();                                          // hộp chờ -> outbox (đang giữ wsMutex)
   
   // Xử lý các loại tin nhắn
   void handleConnectionAck(const JsonDocument& doc);                  // Xử lý phản hồi xác nhận kết nối
   void handleActuatorCommandMessage(const JsonDocument& doc);         // Xử lý lệnh điều khiển từ server
   void handleAIResponse(const JsonDocument& doc);                     // Xử lý phản hồi từ AI
+  void handleBehaviorUpdate(const JsonDocument& doc);                 // "alertRules" vào bảng luật, phần còn lại cho onMessage
+  void handleBinaryFrame(const uint8_t* payload, size_t length);      // Frame nhị phân từ server (audio TTS, OTA)
+  void dispatchMessage(const JsonDocument& doc);                      // Tra bảng handler theo "type"
   
   // Hàm callback tĩnh dùng cho thư viện WebSocket
   static void webSocketEventWrapper(WStype_t type, uint8_t* payload, size_t length);
@@ -112,6 +217,8 @@ public:
   void disconnect();                  // Ngắt kết nối
   void update();                      // Cập nhật trạng thái WebSocket
   bool isConnectedToServer() const;   // Kiểm tra trạng thái kết nối với server
+  bool isTransportConnected();        // Socket đã mở (có thể chưa nhận connection ack)
+  void reconnectNow();                // Bỏ backoff, thử ngay (radio vừa bật lại có chủ đích)
   
   // Thiết lập callback
   void setOnConnect(OnConnectCallback callback);                      // Thiết lập callback khi kết nối
@@ -119,20 +226,85 @@ public:
   void setOnMessage(OnMessageCallback callback);                      // Thiết lập callback khi nhận tin nhắn
   void setOnError(OnErrorCallback callback);                          // Thiết lập callback khi có lỗi
   void setOnActuatorCommand(OnActuatorCommandCallback callback);      // Thiết lập callback khi nhận lệnh điều khiển
+  void setOnAudioFrame(OnAudioFrameCallback callback);                // Chunk audio CHANNEL_AUDIO_DOWN (TTS)
+  void setOnOtaFrame(OnOtaFrameCallback callback);                    // Frame CHANNEL_OTA từ server
+  void setMessageHandler(MessageType type, OnMessageCallback handler); // Handler cho một kiểu message (thay handler mặc định nếu có)
   
   // Thiết lập cấu hình
-  void setReconnectInterval(uint16_t interval);                       // Đặt khoảng thời gian thử kết nối lại
+  void setReconnectInterval(uint16_t interval);                       // Backoff nhỏ nhất giữa hai lần thử kết nối lại
+  void setReconnectBackoff(uint16_t minMs, uint32_t maxMs);           // Backoff mũ từ minMs tới maxMs (có jitter)
+  void setServer(const String& server, uint16_t port);                // Đổi server (provisioning), gọi trước connect()
+  void setRobotId(const String& id);                                  // Đổi robotId (provisioning), gọi trước connect()
   void setHeartbeatInterval(uint16_t interval);                       // Đặt khoảng thời gian gửi heartbeat
+  void setLogMessages(uint16_t maxChars);                             // Log tối đa maxChars ký tự mỗi message nhận, 0 = tắt
+  void setCompressionEnabled(bool enabled);                           // Quảng bá "dict1" ở lần connection_init kế tiếp
+  bool isCompressionMode() const;                                     // Server đã chọn "dict1"
+  void setSecure(const char* caCertPem);                              // wss:// với CA này, gọi trước connect(); chuỗi phải sống suốt chương trình
+  bool isSecure() const;                                              // đã setSecure(): server được xác thực bằng CA
   
   // Gửi tin nhắn
   void sendMessage(MessageType type, const char* target = nullptr);   // Gửi tin nhắn loại cụ thể
   void sendSensorData(const char* sensorType, float value, 
                       const char* unit, AlertLevel alertLevel);       // Gửi dữ liệu cảm biến
+  void sendSensorData(SensorKind sensor, float value, AlertLevel alertLevel); // Như trên, frame nhị phân nếu đã thoả thuận
+  void sendSensorAlert(const char* sensorType, bool active,
+                       AlertLevel alertLevel, uint32_t latencyUs = 0); // Gửi cảnh báo sự kiện (lửa, xâm nhập) ngay lập tức
+  bool sendSensorBatch(const SensorSample* samples, uint8_t count);   // Đưa nhiều mẫu vào hàng đợi, false nếu có mẫu bị bỏ
+  void sendVoiceCommand(const char* action, uint16_t streamId,
+                        uint32_t sampleRate, const char* codec,
+                        uint32_t durationMs = 0);                     // Điều khiển phiên audio (start/end)
+  bool sendAudioFrame(uint16_t streamId, uint8_t codec, uint8_t flags,
+                      uint16_t samples, const uint8_t* data, size_t bytes); // Gửi 1 chunk audio qua sendBIN (cần "bin1")
+  bool sendOtaFrame(OtaOp op, OtaStatus status, uint32_t offset);     // ACK/RESULT của phiên OTA
   void sendAcknowledgment(const String& messageId);                   // Gửi xác nhận đã nhận tin nhắn
   void sendError(const String& errorMessage);                         // Gửi thông báo lỗi
   void sendHeartbeat();                                               // Gửi heartbeat để duy trì kết nối
+  bool sendStatusUpdate(const char* status, StatusWriter write);      // STATUS_UPDATE, payload do write điền
+  bool sendPing();                                                    // Ping WebSocket, pong ghi RTT vào ws.rtt_us
+  // Mã hoá n mục chưa gửi đầu hàng đợi thành 1 message: bin1 vào buffer gửi
+  // (trả về số byte), JSON vào output. Không gửi, không đánh dấu; bench dùng để đo
+  size_t encodeOutboundBatch(uint8_t n, bool binary, String& output);
+  
+  // Encoding nhị phân
+  void setBinaryEnabled(bool enabled);                                // Quảng bá "bin1" ở lần connection_init kế tiếp
+  bool isBinaryMode() const;                                          // Server đã chọn "bin1"
+  void offerAudioCodec(AudioCodec codec);                             // Thêm codec vào "audioCodecs" (gọi theo thứ tự ưu tiên)
+  AudioCodec getAudioCodec() const;                                   // Codec audio server đã chọn, mặc định pcm16
+  bool enableOfflineSpill(const char* path = "/outbox.bin");          // Lưu cảnh báo lúc offline ra LittleFS
+  OutboundQueue& getOutbox();
+  void lock() const;                                                  // giữ khoá socket/hàng đợi/bảng luật (xem WsLock)
+  void unlock() const;
+  AlertLevel getAlertLevel(const char* sensorType, float value) const;// Mức theo ngưỡng của bảng luật (không hysteresis/dwell)
+  AlertRules& getAlertRules();
   
   // Các hàm getter
   String getConnectionId() const;                                     // Lấy ID kết nối hiện tại
   String getRobotId() const;                                          // Lấy ID robot
+  void printRxStats(Print& out = Serial) const;                       // Số message, lỗi parse, mức dùng arena JSON, tỉ lệ nén
+  uint32_t getLastRttUs() const;                                      // RTT của pong gần nhất, 0 nếu chưa có
+  uint32_t getReconnectDelayMs() const;                               // chờ còn lại tới lần thử kế tiếp, 0 nếu được thử
+  uint8_t getReconnectAttempts() const;
+  const RateBudget& getTelemetryBudget() const;
+  const RateBudget& getAudioBudget() const;
+  
+  // Trace đầu-cuối: span theo esp_timer, gửi kèm traceId hiện tại
+  const char* beginTrace();                                           // mở trace mới (đầu một lượt hỏi giọng nói)
+  void endTrace();                                                    // đóng trace và gửi các span còn lại
+  const char* getTraceId() const;                                     // "" nếu không có trace đang mở
+  void recordSpan(const char* name, int64_t startUs, int64_t endUs);  // name phải là chuỗi hằng
+  const ClockSync& getClock() const;
+};
+
+// Giữ khoá của WebSocketClient trong một scope. Mọi hàm public gửi đi đã tự
+// khoá (sendSensorAlert() thì không chờ khoá); chỉ cần khi dùng trực tiếp
+// getAlertRules() / getOutbox() từ task khác task mạng.
+class WsLock {
+public:
+  explicit WsLock(const WebSocketClient& client) : client(client) { client.lock(); }
+  ~WsLock() { client.unlock(); }
+  WsLock(const WsLock&) = delete;
+  WsLock& operator=(const WsLock&) = delete;
+
+private:
+  const WebSocketClient& client;
 };
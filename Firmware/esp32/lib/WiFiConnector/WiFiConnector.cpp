@@ -1,33 +1,255 @@
 #include "WiFiConnector.h"
+#include <Preferences.h>
+
+static const uint32_t CACHE_MAGIC = 0x48475731;   // "HGW1"
+static const uint8_t REASON_ASSOC_LEAVE = 8;      // WiFi.disconnect() của chính mình
+
+// Còn nguyên sau reset mềm / deep sleep, mất khi mất điện (khi đó đọc NVS)
+RTC_DATA_ATTR static uint8_t rtcCache[48];
 
 WiFiConnector::WiFiConnector(const char* ssid, const char* password, unsigned long timeout)
-    : ssid(ssid), password(password), timeout(timeout), connected(false) {}
+    : ssid(ssid), password(password), timeout(timeout), connected(false),
+      useStaticIP(false), reuseLease(true), cache(), cacheValid(false), cacheDirty(false),
+      state(IDLE), attemptFailed(false), attemptStartMs(0), retryAtMs(0), retryDelayMs(RETRY_MIN_MS),
+      eventsRegistered(false), lastConnectMs(0), onlineAtMs(0), lastConnectFast(false),
+      fastConnects(0), fullConnects(0), fallbacks(0), reconnects(0) {}
+
+void WiFiConnector::setStaticIP(IPAddress ip, IPAddress gateway, IPAddress subnet, IPAddress dns) {
+    useStaticIP = true;
+    staticIP = ip;
+    staticGateway = gateway;
+    staticSubnet = subnet;
+    staticDns = dns;
+}
+
+void WiFiConnector::setReuseLease(bool reuse) {
+    reuseLease = reuse;
+}
+
+// ============================================
+// KẾT NỐI
+// ============================================
 
 void WiFiConnector::connect() {
     Serial.print("🔌 Connecting to WiFi: ");
     Serial.println(ssid);
 
+    if (!eventsRegistered) {
+        // Không để core tự ghi cấu hình vào flash / tự kết nối lại: tự quản lý trong update()
+        WiFi.persistent(false);
+        WiFi.mode(WIFI_STA);
+        WiFi.setAutoReconnect(false);
+        WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info) { onWiFiEvent(event, info); });
+        eventsRegistered = true;
+    }
+
+    cacheValid = loadCache();
+    if (cacheValid) {
+        beginFast();
+    } else {
+        beginFull();
+    }
+}
+
+void WiFiConnector::beginFast() {
+    // Biết BSSID + kênh: bỏ qua scan; có IP (tĩnh hoặc lease cũ): bỏ qua DHCP
+    if (useStaticIP) {
+        WiFi.config(staticIP, staticGateway, staticSubnet, staticDns);
+    } else if (reuseLease && cache.ip != 0) {
+        WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.subnet), IPAddress(cache.dns));
+    }
+    attemptFailed = false;
+    attemptStartMs = millis();
+    state = CONNECTING_FAST;
+    fastConnects++;
+    WiFi.begin(ssid, password, cache.channel, cache.bssid, true);
+}
+
+void WiFiConnector::beginFull() {
+    WiFi.disconnect();
+    if (useStaticIP) {
+        WiFi.config(staticIP, staticGateway, staticSubnet, staticDns);
+    } else {
+        WiFi.config(IPAddress(0, 0, 0, 0), IPAddress(0, 0, 0, 0), IPAddress(0, 0, 0, 0));   // bật lại DHCP
+    }
+    attemptFailed = false;
+    attemptStartMs = millis();
+    state = CONNECTING_FULL;
+    fullConnects++;
     WiFi.begin(ssid, password);
-    unsigned long startAttemptTime = millis();
+}
 
-    // Đợi kết nối
-    while (WiFi.status() != WL_CONNECTED && millis() - startAttemptTime < timeout) {
-        Serial.print(".");
-        delay(500);
+// Chạy trong task sự kiện WiFi: chỉ ghi trạng thái, việc nặng để update() làm
+void WiFiConnector::onWiFiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+    switch (event) {
+        case ARDUINO_EVENT_WIFI_STA_CONNECTED:
+            memcpy(cache.bssid, info.wifi_sta_connected.bssid, sizeof(cache.bssid));
+            cache.channel = info.wifi_sta_connected.channel;
+            break;
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+            cache.ip = info.got_ip.ip_info.ip.addr;
+            cache.gateway = info.got_ip.ip_info.gw.addr;
+            cache.subnet = info.got_ip.ip_info.netmask.addr;
+            lastConnectMs = millis() - attemptStartMs;
+            lastConnectFast = state == CONNECTING_FAST;
+            if (onlineAtMs == 0) {
+                onlineAtMs = millis();
+            }
+            connected = true;
+            state = ONLINE;
+            cacheDirty = true;
+            break;
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+            if (info.wifi_sta_disconnected.reason == REASON_ASSOC_LEAVE) {
+                break;
+            }
+            connected = false;
+            attemptFailed = true;
+            break;
+        case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+            connected = false;
+            attemptFailed = true;
+            break;
+        default:
+            break;
     }
+}
+
+void WiFiConnector::update() {
+    uint32_t now = millis();
 
-    if (WiFi.status() == WL_CONNECTED) {
-        connected = true;
-        Serial.println("\n✅ WiFi Connected!");
+    if (cacheDirty) {
+        cacheDirty = false;
+        cache.dns = (uint32_t)WiFi.dnsIP();
+        saveCache();
+        retryDelayMs = RETRY_MIN_MS;
+        Serial.printf("✅ WiFi Connected in %u ms (%s)\n", lastConnectMs,
+                      lastConnectFast ? "cached BSSID" : "full scan");
         printInfo();
-    } else {
-        connected = false;
-        Serial.println("\n❌ Connection Failed!");
+    }
+
+    switch (state) {
+        case CONNECTING_FAST:
+            if (attemptFailed || now - attemptStartMs > FAST_TIMEOUT_MS) {
+                // AP đổi kênh hoặc lease không còn dùng được: quay về scan + DHCP
+                fallbacks++;
+                invalidateCache();
+                beginFull();
+            }
+            break;
+        case CONNECTING_FULL:
+            if (attemptFailed || now - attemptStartMs > timeout) {
+                Serial.printf("❌ Connection Failed! Retry in %u ms\n", retryDelayMs);
+                WiFi.disconnect();
+                retryAtMs = now + retryDelayMs;
+                retryDelayMs = min(retryDelayMs * 2, RETRY_MAX_MS);
+                state = WAIT_RETRY;
+            }
+            break;
+        case ONLINE:
+            if (attemptFailed) {
+                Serial.println("⚠️ WiFi lost, reconnecting...");
+                reconnects++;
+                retryAtMs = now;
+                state = WAIT_RETRY;
+            }
+            break;
+        case WAIT_RETRY:
+            if ((int32_t)(now - retryAtMs) >= 0) {
+                if (cacheValid) {
+                    beginFast();
+                } else {
+                    beginFull();
+                }
+            }
+            break;
+        case IDLE:
+            break;
     }
 }
 
+bool WiFiConnector::waitConnected(uint32_t ms) {
+    uint32_t start = millis();
+    while (!connected && millis() - start < ms) {
+        update();
+        delay(10);
+    }
+    update();
+    return connected;
+}
+
+// ============================================
+// CACHE (RTC + NVS)
+// ============================================
+
+uint32_t WiFiConnector::hashSsid() const {
+    uint32_t h = 2166136261u;   // FNV-1a
+    for (const char* p = ssid; *p; p++) {
+        h = (h ^ (uint8_t)*p) * 16777619u;
+    }
+    return h;
+}
+
+uint32_t WiFiConnector::checksum(const Cache& c) const {
+    uint32_t h = 2166136261u;
+    const uint8_t* bytes = (const uint8_t*)&c;
+    for (size_t i = 0; i < offsetof(Cache, checksum); i++) {
+        h = (h ^ bytes[i]) * 16777619u;
+    }
+    return h;
+}
+
+bool WiFiConnector::loadCache() {
+    static_assert(sizeof(Cache) <= sizeof(rtcCache), "rtcCache too small");
+    Cache candidate;
+    memcpy(&candidate, rtcCache, sizeof(candidate));
+    bool valid = candidate.magic == CACHE_MAGIC && candidate.checksum == checksum(candidate);
+    if (!valid) {
+        Preferences prefs;
+        prefs.begin("wifi", true);
+        valid = prefs.getBytes("cache", &candidate, sizeof(candidate)) == sizeof(candidate)
+                && candidate.magic == CACHE_MAGIC && candidate.checksum == checksum(candidate);
+        prefs.end();
+    }
+    if (!valid || candidate.ssidHash != hashSsid() || candidate.channel == 0) {
+        return false;
+    }
+    cache = candidate;
+    return true;
+}
+
+void WiFiConnector::saveCache() {
+    cache.magic = CACHE_MAGIC;
+    cache.ssidHash = hashSsid();
+    cache.checksum = checksum(cache);
+    memcpy(rtcCache, &cache, sizeof(cache));
+    cacheValid = true;
+
+    // NVS chỉ ghi khi khác bản đã lưu (DHCP thường cấp lại cùng IP) để đỡ mòn flash
+    Preferences prefs;
+    prefs.begin("wifi", false);
+    Cache stored;
+    if (prefs.getBytes("cache", &stored, sizeof(stored)) != sizeof(stored)
+        || memcmp(&stored, &cache, sizeof(cache)) != 0) {
+        prefs.putBytes("cache", &cache, sizeof(cache));
+    }
+    prefs.end();
+}
+
+void WiFiConnector::invalidateCache() {
+    cacheValid = false;
+    memset(rtcCache, 0, sizeof(rtcCache));
+    Preferences prefs;
+    prefs.begin("wifi", false);
+    prefs.remove("cache");
+    prefs.end();
+}
+
+// ============================================
+// TRẠNG THÁI
+// ============================================
+
 bool WiFiConnector::isConnected() {
-    connected = (WiFi.status() == WL_CONNECTED);
     return connected;
 }
 
@@ -44,10 +266,32 @@ void WiFiConnector::printInfo() {
     }
 }
 
+void WiFiConnector::printStats(Print& out) const {
+    out.printf("[WiFi] online_at=%ums last_connect=%ums | fast=%u full=%u fallbacks=%u reconnects=%u\n",
+               onlineAtMs, lastConnectMs, fastConnects, fullConnects, fallbacks, reconnects);
+}
+
+uint32_t WiFiConnector::getLastConnectMs() const {
+    return lastConnectMs;
+}
+
+uint32_t WiFiConnector::getOnlineAtMs() const {
+    return onlineAtMs;
+}
+
 void WiFiConnector::disconnect() {
     if (isConnected()) {
         WiFi.disconnect(true);
         connected = false;
+        state = IDLE;
         Serial.println("🔌 Disconnected from WiFi.");
     }
 }
+
+void WiFiConnector::powerDown() {
+    // Kể cả khi đang kết nối dở: không để update() thử lại trong lúc radio tắt
+    state = IDLE;
+    connected = false;
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_OFF);
+}
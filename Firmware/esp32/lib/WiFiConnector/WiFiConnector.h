@@ -2,28 +2,105 @@
 
 #include <WiFi.h>
 
-class WiFiConnector {
-private:
-    const char* ssid;         // Tên mạng WiFi
-    const char* password;     // Mật khẩu WiFi
-    unsigned long timeout;    // Thời gian chờ kết nối (ms)
-    bool connected;           // Trạng thái kết nối
+// ======================================================
+// 📶 Kết nối WiFi nhanh, theo sự kiện, không block loop
+// ======================================================
+//
+// connect() chỉ khởi động lần kết nối rồi trả về ngay; WiFi.onEvent báo kết
+// quả. Sau lần kết nối thành công, BSSID, kênh và lease DHCP được lưu vào RTC
+// (còn sau reset mềm / deep sleep) và NVS (còn sau mất điện / brownout). Lần
+// boot sau dùng lại: bỏ qua scan (biết BSSID + kênh) và DHCP (cấu hình IP
+// tĩnh bằng lease cũ hoặc setStaticIP), online dưới 1 s thay vì vài giây.
+//
+// Thử nhanh không được trong FAST_TIMEOUT_MS (AP đổi kênh, lease bị cấp cho
+// máy khác...) thì xoá cache và kết nối đầy đủ (scan + DHCP). Mất kết nối thì
+// update() thử lại với backoff, không chờ trong loop.
 
+class WiFiConnector {
 public:
-    // Hàm khởi tạo
+    static const uint32_t FAST_TIMEOUT_MS = 1500;
+    static const uint32_t RETRY_MIN_MS = 1000;
+    static const uint32_t RETRY_MAX_MS = 30000;
+
+    // Hàm khởi tạo; timeout = thời gian tối đa của một lần kết nối đầy đủ
     WiFiConnector(const char* ssid, const char* password, unsigned long timeout = 10000);
 
-    // Hàm bắt đầu kết nối
+    // IP tĩnh (bỏ qua DHCP kể cả lần đầu); gọi trước connect()
+    void setStaticIP(IPAddress ip, IPAddress gateway, IPAddress subnet, IPAddress dns);
+    // Dùng lại lease DHCP đã lưu làm IP tĩnh ở lần boot sau (mặc định bật)
+    void setReuseLease(bool reuse);
+
+    // Hàm bắt đầu kết nối (không block)
     void connect();
+    // Gọi định kỳ trong loop: thử lại khi mất kết nối, lưu cache vào NVS
+    void update();
+    // Chờ tối đa ms tới khi có IP (chỉ dùng khi thật sự cần mạng ngay)
+    bool waitConnected(uint32_t ms);
 
     // Kiểm tra trạng thái
     bool isConnected();
 
     // In thông tin mạng ra Serial
     void printInfo();
+    // Thời gian kết nối, số lần dùng cache / phải kết nối đầy đủ
+    void printStats(Print& out = Serial) const;
+    uint32_t getLastConnectMs() const;   // connect() -> có IP
+    uint32_t getOnlineAtMs() const;      // millis() lúc có IP lần đầu sau boot
 
     // Ngắt kết nối
     void disconnect();
-};
+    // Tắt hẳn radio (trước light sleep); connect() bật lại bằng đường nhanh nếu còn cache
+    void powerDown();
 
+private:
+    struct Cache {
+        uint32_t magic;
+        uint32_t ssidHash;
+        uint8_t bssid[6];
+        uint8_t channel;
+        uint8_t reserved;
+        uint32_t ip;
+        uint32_t gateway;
+        uint32_t subnet;
+        uint32_t dns;
+        uint32_t checksum;
+    };
 
+    enum State : uint8_t { IDLE, CONNECTING_FAST, CONNECTING_FULL, ONLINE, WAIT_RETRY };
+
+    void onWiFiEvent(arduino_event_id_t event, arduino_event_info_t info);
+    void beginFast();
+    void beginFull();
+    bool loadCache();
+    void saveCache();
+    void invalidateCache();
+    uint32_t checksum(const Cache& c) const;
+    uint32_t hashSsid() const;
+
+    const char* ssid;         // Tên mạng WiFi
+    const char* password;     // Mật khẩu WiFi
+    unsigned long timeout;    // Thời gian chờ kết nối (ms)
+    volatile bool connected;  // Trạng thái kết nối (cập nhật từ task sự kiện WiFi)
+
+    bool useStaticIP;
+    IPAddress staticIP, staticGateway, staticSubnet, staticDns;
+    bool reuseLease;
+
+    Cache cache;
+    bool cacheValid;
+    volatile bool cacheDirty;          // có BSSID/lease mới, update() ghi NVS
+    volatile State state;
+    volatile bool attemptFailed;       // task sự kiện báo lần thử hiện tại thất bại
+    uint32_t attemptStartMs;
+    uint32_t retryAtMs;
+    uint32_t retryDelayMs;
+    bool eventsRegistered;
+
+    volatile uint32_t lastConnectMs;
+    volatile uint32_t onlineAtMs;
+    volatile bool lastConnectFast;
+    uint32_t fastConnects;
+    uint32_t fullConnects;
+    uint32_t fallbacks;
+    uint32_t reconnects;
+};
@@ -1,17 +1,83 @@
 // sensors/UltrasonicSensor.h
 #pragma once
 #include <Arduino.h>
+#include <esp_timer.h>
+#include <functional>
+#include "Sensor.h"
 
-class UltrasonicSensor {
+// Callback nhận khoảng cách đã lọc median (cm), chạy trong task esp_timer nên phải ngắn
+using DistanceCallback = std::function<void(float distanceCm)>;
+
+class UltrasonicSensor : public Sensor {
 public:
+    static const uint8_t MAX_FILTER = 9;
+    static constexpr float SOUND_CM_PER_US = 0.0343f;
+
     UltrasonicSensor(int trig, int echo, String name);
     void begin();
+
+    // Đo đồng bộ bằng pulseIn, chờ tối đa theo tầm đo; trả về -1 nếu không có tiếng vọng
     float readDistance();
-    void checkObstacle();
+
+    // Tầm đo tối đa: quyết định timeout chờ echo (mặc định 400 cm ~ 23 ms)
+    void setMaxRange(float cm);
+    float getMaxRange() const;
+    // Số mẫu của bộ lọc median (1..MAX_FILTER, nên lẻ)
+    void setFilterSize(uint8_t n);
+
+    // ▶ Chế độ bất đồng bộ: esp_timer phát xung trigger mỗi intervalMs, ngắt GPIO
+    // bấm giờ cạnh lên/xuống của echo. Không chiếm CPU trong lúc chờ tiếng vọng.
+    bool startAsync(uint16_t intervalMs = 50);
+    void stopAsync();
+    bool isAsync() const;
+    void setOnDistance(DistanceCallback callback);
+
+    // Khoảng cách mới nhất sau lọc median; ngoài tầm đo thì bằng getMaxRange()
+    float getLatestDistance() const;
+    bool hasReading() const;
+    uint32_t getTimeouts() const;    // số lần đo không nhận được echo
+
+    // Vật cản gần hơn ngưỡng (cm) thì checkObstacle() trả về true
+    void setObstacleThreshold(float cm);
+    bool checkObstacle();
+    bool isObstacle() const;
+
     void printDistance();
     String getName() const;
+    const char *name() const override { return sensorName.c_str(); }
+
+protected:
+    // Khoảng cách mới nhất (async), không phát trigger; ngoài tầm đo là DEGRADED
+    SampleQuality read(float &value) override;
 
 private:
     int trigPin, echoPin;
     String sensorName;
+
+    float maxRangeCm;
+    uint32_t timeoutUs;
+    float obstacleCm;
+    bool obstacle;
+
+    // Cửa sổ mẫu cho median
+    float window[MAX_FILTER];
+    uint8_t filterSize;
+    uint8_t windowCount;
+    uint8_t windowPos;
+
+    // Trạng thái đo bất đồng bộ, ghi từ ISR và task esp_timer
+    esp_timer_handle_t timer;
+    volatile int64_t riseUs;
+    volatile uint32_t echoUs;        // độ rộng xung echo của lần đo gần nhất, 0 = chưa có
+    volatile float latestCm;
+    volatile bool haveReading;
+    bool async;
+    bool pending;                    // đã phát trigger, chờ kết quả
+    uint32_t timeouts;
+    DistanceCallback onDistance;
+
+    void trigger();
+    float pushSample(float cm);
+    static void IRAM_ATTR handleEcho(void *arg);
+    static void onTimer(void *arg);
 };
@@ -1,33 +1,219 @@
 #include "UltrasonicSensor.h"
 
 UltrasonicSensor::UltrasonicSensor(int trig, int echo, String name)
-: trigPin(trig), echoPin(echo), sensorName(name) {}
+: Sensor(SENSOR_DISTANCE), trigPin(trig), echoPin(echo), sensorName(name),
+  maxRangeCm(0), timeoutUs(0), obstacleCm(20.0f), obstacle(false),
+  filterSize(5), windowCount(0), windowPos(0),
+  timer(nullptr), riseUs(0), echoUs(0), latestCm(0), haveReading(false),
+  async(false), pending(false), timeouts(0) {
+    setMaxRange(400.0f);
+}
 
 void UltrasonicSensor::begin() {
     pinMode(trigPin, OUTPUT);
     pinMode(echoPin, INPUT);
 }
 
-float UltrasonicSensor::readDistance() {
+void UltrasonicSensor::trigger() {
     digitalWrite(trigPin, LOW);
     delayMicroseconds(2);
     digitalWrite(trigPin, HIGH);
     delayMicroseconds(10);
     digitalWrite(trigPin, LOW);
-    long duration = pulseIn(echoPin, HIGH);
-    return duration * 0.034 / 2.0;
+}
+
+float UltrasonicSensor::readDistance() {
+    trigger();
+    unsigned long duration = pulseIn(echoPin, HIGH, timeoutUs);
+    if (duration == 0) {
+        timeouts++;
+        return -1.0f;
+    }
+    return duration * SOUND_CM_PER_US / 2.0f;
+}
+
+void UltrasonicSensor::setMaxRange(float cm) {
+    maxRangeCm = cm;
+    // Thời gian đi - về của âm thanh, cộng biên cho thời gian module phát burst
+    timeoutUs = (uint32_t)(cm * 2.0f / SOUND_CM_PER_US) + 500;
+}
+
+float UltrasonicSensor::getMaxRange() const {
+    return maxRangeCm;
+}
+
+void UltrasonicSensor::setFilterSize(uint8_t n) {
+    filterSize = n == 0 ? 1 : (n > MAX_FILTER ? (uint8_t)MAX_FILTER : n);
+    windowCount = 0;
+    windowPos = 0;
+}
+
+// ============================================
+// ASYNC RANGING
+// ============================================
+
+void IRAM_ATTR UltrasonicSensor::handleEcho(void *arg) {
+    UltrasonicSensor *self = static_cast<UltrasonicSensor *>(arg);
+    int64_t now = esp_timer_get_time();
+    if (digitalRead(self->echoPin)) {
+        self->riseUs = now;
+    } else if (self->riseUs != 0) {
+        self->echoUs = (uint32_t)(now - self->riseUs);
+        self->riseUs = 0;
+    }
+}
+
+bool UltrasonicSensor::startAsync(uint16_t intervalMs) {
+    if (async) {
+        return true;
+    }
+    // Chu kỳ phải đủ dài để echo của lần trước về hết
+    uint32_t periodUs = max((uint32_t)intervalMs * 1000, timeoutUs + 1000);
+
+    if (timer == nullptr) {
+        esp_timer_create_args_t args = {};
+        args.callback = onTimer;
+        args.arg = this;
+        args.name = "ultrasonic";
+        if (esp_timer_create(&args, &timer) != ESP_OK) {
+            Serial.println("[Ultrasonic] esp_timer_create failed");
+            return false;
+        }
+    }
+
+    riseUs = 0;
+    echoUs = 0;
+    pending = false;
+    attachInterruptArg(digitalPinToInterrupt(echoPin), handleEcho, this, CHANGE);
+    if (esp_timer_start_periodic(timer, periodUs) != ESP_OK) {
+        detachInterrupt(digitalPinToInterrupt(echoPin));
+        return false;
+    }
+    async = true;
+    return true;
+}
+
+void UltrasonicSensor::stopAsync() {
+    if (!async) {
+        return;
+    }
+    esp_timer_stop(timer);
+    detachInterrupt(digitalPinToInterrupt(echoPin));
+    async = false;
+    pending = false;
+}
+
+bool UltrasonicSensor::isAsync() const {
+    return async;
+}
+
+void UltrasonicSensor::setOnDistance(DistanceCallback callback) {
+    onDistance = callback;
+}
+
+// Mỗi tick: lấy kết quả của xung trước (hoặc coi là timeout) rồi phát xung mới
+void UltrasonicSensor::onTimer(void *arg) {
+    UltrasonicSensor *self = static_cast<UltrasonicSensor *>(arg);
+    if (self->pending) {
+        uint32_t width = self->echoUs;
+        float cm;
+        if (width == 0 || width > self->timeoutUs) {
+            self->timeouts++;
+            cm = self->maxRangeCm;
+        } else {
+            cm = width * SOUND_CM_PER_US / 2.0f;
+        }
+        self->latestCm = self->pushSample(cm);
+        self->haveReading = true;
+        if (self->onDistance) {
+            self->onDistance(self->latestCm);
+        }
+    }
+
+    self->riseUs = 0;
+    self->echoUs = 0;
+    self->trigger();
+    self->pending = true;
+}
+
+float UltrasonicSensor::pushSample(float cm) {
+    window[windowPos] = cm;
+    windowPos = (windowPos + 1) % filterSize;
+    if (windowCount < filterSize) {
+        windowCount++;
+    }
+
+    // Insertion sort trên bản sao, cửa sổ tối đa MAX_FILTER phần tử
+    float sorted[MAX_FILTER];
+    for (uint8_t i = 0; i < windowCount; i++) {
+        float v = window[i];
+        int8_t j = i - 1;
+        while (j >= 0 && sorted[j] > v) {
+            sorted[j + 1] = sorted[j];
+            j--;
+        }
+        sorted[j + 1] = v;
+    }
+    return sorted[windowCount / 2];
+}
+
+float UltrasonicSensor::getLatestDistance() const {
+    return latestCm;
+}
+
+bool UltrasonicSensor::hasReading() const {
+    return haveReading;
+}
+
+uint32_t UltrasonicSensor::getTimeouts() const {
+    return timeouts;
+}
+
+// ============================================
+// OBSTACLE CHECK
+// ============================================
+
+void UltrasonicSensor::setObstacleThreshold(float cm) {
+    obstacleCm = cm;
+}
+
+bool UltrasonicSensor::checkObstacle() {
+    float distance;
+    if (async) {
+        if (!haveReading) {
+            return obstacle;
+        }
+        distance = latestCm;
+    } else {
+        distance = readDistance();
+    }
+    obstacle = distance >= 0 && distance < obstacleCm;
+    return obstacle;
+}
+
+bool UltrasonicSensor::isObstacle() const {
+    return obstacle;
 }
 
 void UltrasonicSensor::printDistance() {
-    long distance= readDistance();
+    float distance = async ? getLatestDistance() : readDistance();
     Serial.print("Distance: ");
+    if (distance < 0 || distance >= maxRangeCm) {
+        Serial.println("out of range");
+        return;
+    }
     Serial.print(distance);
     Serial.println(" cm");
-    delay(100);
 }
-void UltrasonicSensor::checkObstacle() {
-    // Đọc khoảng cách
+
+SampleQuality UltrasonicSensor::read(float &value) {
+    if (!haveReading) {
+        return SAMPLE_BAD;
+    }
+    value = latestCm;
+    return value >= maxRangeCm ? SAMPLE_DEGRADED : SAMPLE_GOOD;
 }
+
 String UltrasonicSensor::getName() const {
     return sensorName;
 }
@@ -0,0 +1,461 @@
+// ======================================================
+// 🧪 Firmware benchmark (env:bench)
+// ======================================================
+//
+// Đo lại được giữa các bản phát hành: fps decode từng clip, TJpgDec so với
+// JPEGDEC, thông lượng micro I2S, kernel DSP đường thu, chi phí mã hoá
+// JSON/bin1 của hàng đợi gửi và RTT WebSocket. Mỗi kết quả là một dòng
+//     BENCH <suite> key=value key=value ...
+// để lọc bằng grep và so sánh hai bản bằng tools/bench_compare.py.
+//
+//     pio run -e bench -t upload && pio device monitor | tee bench.log
+//
+// Clip video chiếm nhiều flash nên chia thành nhóm: -DBENCH_CLIP_SET=1..3
+// (video11 luôn có vì Screen.cpp đã nhúng sẵn). WiFi/server cho RTT đặt bằng
+// -DBENCH_WIFI_SSID=... -DBENCH_WIFI_PASS=... -DBENCH_WS_HOST=... -DBENCH_WS_PORT=...
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <esp_idf_version.h>
+#include "Screen.h"
+#include "DeltaAnim.h"
+#include "INMP441.h"
+#include "AudioDsp.h"
+#include "PcmRing.h"
+#include "WiFiConnector.h"
+#include "WebSocketClient.h"
+#include "Metrics.h"
+#include "pins.h"
+
+#if __has_include(<JPEGDEC.h>)
+#include <JPEGDEC.h>
+#define BENCH_HAS_JPEGDEC 1
+#endif
+
+#ifndef BENCH_CLIP_SET
+#define BENCH_CLIP_SET 0
+#endif
+#if BENCH_CLIP_SET == 1
+#include "video01.h"
+#include "video02.h"
+#include "video03.h"
+#include "video04.h"
+#elif BENCH_CLIP_SET == 2
+#include "video05.h"
+#include "video06.h"
+#include "video07.h"
+#include "video08.h"
+#elif BENCH_CLIP_SET == 3
+#include "video09.h"
+#include "video10.h"
+#include "video12.h"
+#endif
+
+#ifndef BENCH_WIFI_SSID
+#define BENCH_WIFI_SSID "LE HUE"
+#endif
+#ifndef BENCH_WIFI_PASS
+#define BENCH_WIFI_PASS "012345679"
+#endif
+#ifndef BENCH_WS_HOST
+#define BENCH_WS_HOST "your-server.com"
+#endif
+#ifndef BENCH_WS_PORT
+#define BENCH_WS_PORT 8080
+#endif
+
+static const uint16_t DECODE_ROUNDS = 3;       // mỗi clip decode-only 3 vòng
+static const uint32_t MIC_SECONDS = 3;
+static const uint16_t DSP_ITERS = 200;
+static const uint16_t SERIALIZE_ITERS = 500;
+static const uint8_t RTT_PINGS = 20;
+
+extern VideoInfo video11;
+
+struct BenchClip {
+    const char *name;
+    const VideoInfo *video;
+};
+
+static const BenchClip clips[] = {
+    { "video11", &video11 },
+#if BENCH_CLIP_SET == 1
+    { "video01", &video01 }, { "video02", &video02 }, { "video03", &video03 }, { "video04", &video04 },
+#elif BENCH_CLIP_SET == 2
+    { "video05", &video05 }, { "video06", &video06 }, { "video07", &video07 }, { "video08", &video08 },
+#elif BENCH_CLIP_SET == 3
+    { "video09", &video09 }, { "video10", &video10 }, { "video12", &video12 },
+#endif
+};
+static const uint8_t NUM_CLIPS = sizeof(clips) / sizeof(clips[0]);
+
+static Screen screen;
+static INMP441 microphone(I2S_NUM_1, INMP441_BCLK_PIN, INMP441_LRCL_PIN, INMP441_DOUT_PIN, 16000, 512);
+static WiFiConnector wifi(BENCH_WIFI_SSID, BENCH_WIFI_PASS, 10000);
+static WebSocketClient ws(BENCH_WS_HOST, BENCH_WS_PORT, "bench_001");
+
+// ============================================
+// TIỆN ÍCH
+// ============================================
+
+static void benchLine(const char *suite, const char *fmt, ...) {
+    char line[192];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    Serial.printf("BENCH %s %s\n", suite, line);
+}
+
+static uint32_t nowUs() {
+    return (uint32_t)esp_timer_get_time();
+}
+
+// Sink rỗng: chỉ đo decode, không đụng SPI
+static bool nullTileSink(int16_t, int16_t, uint16_t, uint16_t, uint16_t *) {
+    return true;
+}
+
+#ifdef BENCH_HAS_JPEGDEC
+static JPEGDEC jpegdec;
+
+static int jpegdecSink(JPEGDRAW *) {
+    return 1;
+}
+#endif
+
+// ============================================
+// DECODE (không có màn hình)
+// ============================================
+
+static void benchDecode(const BenchClip &clip) {
+    const VideoInfo &video = *clip.video;
+
+    if (video.format == VIDEO_DELTA) {
+        DeltaAnimInfo info;
+        if (!DeltaAnim::parseHeader(video.data, video.data_size, info)) {
+            return;
+        }
+        uint32_t start = nowUs();
+        for (uint16_t round = 0; round < DECODE_ROUNDS; round++) {
+            for (uint16_t i = 0; i < info.numFrames; i++) {
+                uint32_t offset, length;
+                if (DeltaAnim::frameRange(info, i, offset, length)) {
+                    DeltaAnim::decodeFrame(info, video.data + offset, length, nullTileSink);
+                }
+            }
+        }
+        uint32_t frames = (uint32_t)info.numFrames * DECODE_ROUNDS;
+        uint32_t elapsed = nowUs() - start;
+        benchLine("decode", "clip=%s decoder=hga1 frames=%u us_per_frame=%u fps=%.1f",
+                  clip.name, frames, elapsed / frames, frames * 1e6f / elapsed);
+        return;
+    }
+    if (video.format != VIDEO_JPEG || video.num_frames == 0) {
+        return;
+    }
+
+    uint32_t frames = (uint32_t)video.num_frames * DECODE_ROUNDS;
+    uint32_t bytes = 0;
+    TJpgDec.setJpgScale(1);
+    TJpgDec.setSwapBytes(true);
+    TJpgDec.setCallback(nullTileSink);
+    uint32_t start = nowUs();
+    for (uint16_t round = 0; round < DECODE_ROUNDS; round++) {
+        for (uint16_t i = 0; i < video.num_frames; i++) {
+            const uint8_t *jpg = (const uint8_t *)pgm_read_ptr(&video.frames[i]);
+            uint16_t size = pgm_read_word(&video.frame_sizes[i]);
+            TJpgDec.drawJpg(0, 0, jpg, size);
+            bytes += size;
+        }
+    }
+    uint32_t elapsed = nowUs() - start;
+    benchLine("decode", "clip=%s decoder=tjpgdec frames=%u us_per_frame=%u fps=%.1f kb_per_frame=%.1f",
+              clip.name, frames, elapsed / frames, frames * 1e6f / elapsed, bytes / 1024.0f / frames);
+
+#ifdef BENCH_HAS_JPEGDEC
+    start = nowUs();
+    for (uint16_t round = 0; round < DECODE_ROUNDS; round++) {
+        for (uint16_t i = 0; i < video.num_frames; i++) {
+            const uint8_t *jpg = (const uint8_t *)pgm_read_ptr(&video.frames[i]);
+            uint16_t size = pgm_read_word(&video.frame_sizes[i]);
+            if (jpegdec.openFLASH((uint8_t *)jpg, size, jpegdecSink)) {
+                jpegdec.setPixelType(RGB565_BIG_ENDIAN);
+                jpegdec.decode(0, 0, 0);
+                jpegdec.close();
+            }
+        }
+    }
+    elapsed = nowUs() - start;
+    benchLine("decode", "clip=%s decoder=jpegdec frames=%u us_per_frame=%u fps=%.1f",
+              clip.name, frames, elapsed / frames, frames * 1e6f / elapsed);
+#endif
+}
+
+// ============================================
+// DISPLAY (decode + SPI qua Screen)
+// ============================================
+
+// Chạy tick() tới khi histogram screen.frame_us đếm đủ `frames` frame
+static void runFrames(Histogram *frameHist, uint32_t frames, const char *clip, const char *mode) {
+    frameHist->reset();
+    uint32_t pushedBefore = screen.getPushedTiles();
+    uint32_t skippedBefore = screen.getSkippedTiles();
+    uint32_t start = nowUs();
+    uint32_t deadline = millis() + 30000;
+    while (frameHist->count < frames && screen.isPlaying() && (int32_t)(millis() - deadline) < 0) {
+        screen.tick();
+    }
+    uint32_t elapsed = nowUs() - start;
+    uint32_t drawn = frameHist->count;
+    if (drawn == 0) {
+        return;
+    }
+    benchLine("display", "clip=%s mode=%s frames=%u fps=%.1f p50_us=%u p99_us=%u max_us=%u pushed_tiles=%u skipped_tiles=%u",
+              clip, mode, drawn, drawn * 1e6f / elapsed, frameHist->percentile(50), frameHist->percentile(99),
+              frameHist->max, screen.getPushedTiles() - pushedBefore, screen.getSkippedTiles() - skippedBefore);
+}
+
+static void benchDisplay(const BenchClip &clip) {
+    Histogram *frameHist = Metrics::histogram("screen.frame_us");
+    uint16_t frames = clip.video->num_frames;
+    if (frames == 0) {
+        return;
+    }
+    // frame_ms = 0: không chờ nhịp, đo tốc độ tối đa. Vòng 1 nạp cache (clip lặp), vòng 2 đọc cache
+    screen.stop();
+    screen.invalidate();
+    screen.play(*clip.video, 0, true);
+    runFrames(frameHist, frames, clip.name, "cold");
+    runFrames(frameHist, frames, clip.name, "warm");
+    screen.stop();
+    const FrameCache &cache = screen.getFrameCache();
+    benchLine("display", "clip=%s mode=cache enabled=%d", clip.name, cache.isEnabled() ? 1 : 0);
+}
+
+// ============================================
+// MICRO I2S
+// ============================================
+
+static void benchMic() {
+    static PcmRing ring;
+    static int16_t drain[512];
+    if (!ring.begin(8192)) {
+        benchLine("mic", "skipped=1 reason=no_memory");
+        return;
+    }
+    microphone.begin();
+    Histogram *gapHist = Metrics::histogram("mic.read_gap_us");
+    Histogram *processHist = Metrics::histogram("mic.process_us");
+    gapHist->reset();
+    processHist->reset();
+    uint32_t overflowsBefore = microphone.getDmaOverflows();
+    uint32_t droppedBefore = microphone.getDroppedSamples();
+
+    if (!microphone.startCapture(ring, 0)) {
+        benchLine("mic", "skipped=1 reason=capture_task");
+        return;
+    }
+    uint64_t samples = 0;
+    uint32_t start = nowUs();
+    while (nowUs() - start < MIC_SECONDS * 1000000UL) {
+        samples += ring.read(drain, sizeof(drain) / sizeof(drain[0]));
+        vTaskDelay(pdMS_TO_TICKS(5));
+    }
+    uint32_t elapsed = nowUs() - start;
+    microphone.stopCapture();
+    samples += ring.read(drain, sizeof(drain) / sizeof(drain[0]));
+
+    benchLine("mic", "rate=16000 seconds=%.2f samples=%llu sps=%.0f dma_overflow=%u dropped=%u gap_p99_us=%u gap_max_us=%u process_p99_us=%u",
+              elapsed / 1e6f, samples, samples * 1e6f / elapsed,
+              microphone.getDmaOverflows() - overflowsBefore, microphone.getDroppedSamples() - droppedBefore,
+              gapHist->percentile(99), gapHist->max, processHist->percentile(99));
+}
+
+// ============================================
+// KERNEL DSP (1 buffer DMA 512 mẫu)
+// ============================================
+
+static const size_t DSP_BLOCK = 512;
+
+// budget_pct: phần trăm chu kỳ DMA của khối (512 mẫu ở rate Hz) mà kernel chiếm
+static void dspLine(const char *kernel, uint32_t elapsedUs, uint32_t rate) {
+    float us = (float)elapsedUs / DSP_ITERS;
+    benchLine("dsp", "kernel=%s block=%u iters=%u us_per_block=%.1f cycles_per_sample=%.1f budget_pct=%.2f esp_dsp=%d",
+              kernel, (unsigned)DSP_BLOCK, DSP_ITERS, us, us * getCpuFrequencyMhz() / DSP_BLOCK,
+              us * 100.0f * rate / (DSP_BLOCK * 1e6f), AudioDsp::hasEspDsp() ? 1 : 0);
+}
+
+static void fillRaw(int32_t *raw) {
+    // Sine 440 Hz + offset DC, căn trái như INMP441
+    for (size_t i = 0; i < DSP_BLOCK; i++) {
+        raw[i] = (int32_t)(3000.0f * sinf(2.0f * PI * 440.0f * i / 16000.0f) + 400.0f) * (1 << 14);
+    }
+}
+
+static void benchDsp() {
+    static int32_t raw[DSP_BLOCK];
+    static int16_t pcm[DSP_BLOCK];
+    static DcBlocker dcBlocker;
+    static BiquadHighPass highPass;
+    static Agc agc;
+    static Decimator3 decimator;
+    highPass.configure(16000, 80);
+    agc.configure(8000);
+
+    fillRaw(raw);
+    uint32_t start = nowUs();
+    for (uint16_t iter = 0; iter < DSP_ITERS; iter++) {
+        INMP441::convert32to16(raw, pcm, DSP_BLOCK);
+    }
+    dspLine("convert_copy", nowUs() - start, 16000);
+
+    uint32_t elapsed = 0;
+    for (uint16_t iter = 0; iter < DSP_ITERS; iter++) {
+        fillRaw(raw);
+        start = nowUs();
+        AudioDsp::convertInPlace(raw, DSP_BLOCK, 14);
+        elapsed += nowUs() - start;
+    }
+    dspLine("convert_in_place", elapsed, 16000);
+
+    INMP441::convert32to16(raw, pcm, DSP_BLOCK);
+    start = nowUs();
+    for (uint16_t iter = 0; iter < DSP_ITERS; iter++) {
+        dcBlocker.process(pcm, DSP_BLOCK);
+    }
+    dspLine("dc_block", nowUs() - start, 16000);
+
+    start = nowUs();
+    for (uint16_t iter = 0; iter < DSP_ITERS; iter++) {
+        highPass.process(pcm, DSP_BLOCK);
+    }
+    dspLine("biquad_hpf", nowUs() - start, 16000);
+
+    start = nowUs();
+    for (uint16_t iter = 0; iter < DSP_ITERS; iter++) {
+        agc.process(pcm, DSP_BLOCK);
+    }
+    dspLine("agc", nowUs() - start, 16000);
+
+    // Hạ tần nhận 512 mẫu 48 kHz mỗi lần (khối bị ghi đè nên nạp lại, không tính giờ)
+    elapsed = 0;
+    for (uint16_t iter = 0; iter < DSP_ITERS; iter++) {
+        fillRaw(raw);
+        INMP441::convert32to16(raw, pcm, DSP_BLOCK);
+        start = nowUs();
+        decimator.process(pcm, DSP_BLOCK);
+        elapsed += nowUs() - start;
+    }
+    dspLine("decimate_48k", elapsed, 48000);
+}
+
+// ============================================
+// MÃ HOÁ JSON / BIN1
+// ============================================
+
+static void benchSerialize() {
+    OutboundQueue &outbox = ws.getOutbox();
+    const uint8_t sizes[] = { 1, 16 };
+    for (uint8_t s = 0; s < sizeof(sizes); s++) {
+        uint8_t n = sizes[s];
+        for (uint8_t i = 0; i < n; i++) {
+            outbox.push(OUTBOUND_DATA, (SensorKind)(i % 4), AlertLevel::NORMAL, 20.0f + i * 0.25f, millis());
+        }
+        for (uint8_t binary = 0; binary < 2; binary++) {
+            String output;
+            size_t bytes = 0;
+            uint32_t start = nowUs();
+            for (uint16_t iter = 0; iter < SERIALIZE_ITERS; iter++) {
+                output = "";
+                bytes = ws.encodeOutboundBatch(n, binary != 0, output);
+            }
+            uint32_t elapsed = nowUs() - start;
+            benchLine("serialize", "encoding=%s records=%u iters=%u us_per_msg=%.1f bytes=%u bytes_per_record=%.1f",
+                      binary ? "bin1" : "json", n, SERIALIZE_ITERS, (float)elapsed / SERIALIZE_ITERS,
+                      (unsigned)bytes, (float)bytes / n);
+        }
+        // Bỏ các mục vừa đẩy để không bị gửi lên server ở phần RTT
+        outbox.ack((uint16_t)(outbox.firstPendingSeq() + n - 1));
+    }
+}
+
+// ============================================
+// RTT WEBSOCKET
+// ============================================
+
+static void benchRtt() {
+    wifi.connect();
+    if (!wifi.waitConnected(15000)) {
+        benchLine("ws_rtt", "skipped=1 reason=no_wifi");
+        return;
+    }
+    benchLine("wifi", "connect_ms=%u", wifi.getLastConnectMs());
+
+    ws.setLogMessages(0);
+    ws.connect();
+    uint32_t deadline = millis() + 10000;
+    while (!ws.isTransportConnected() && (int32_t)(millis() - deadline) < 0) {
+        ws.update();
+        delay(5);
+    }
+    if (!ws.isTransportConnected()) {
+        benchLine("ws_rtt", "skipped=1 reason=no_server host=%s port=%u", BENCH_WS_HOST, BENCH_WS_PORT);
+        return;
+    }
+
+    Histogram *rttHist = Metrics::histogram("ws.rtt_us");
+    rttHist->reset();
+    uint8_t lost = 0;
+    for (uint8_t i = 0; i < RTT_PINGS; i++) {
+        uint32_t before = rttHist->count;
+        ws.sendPing();
+        uint32_t pingDeadline = millis() + 2000;
+        while (rttHist->count == before && (int32_t)(millis() - pingDeadline) < 0) {
+            ws.update();
+        }
+        if (rttHist->count == before) {
+            lost++;
+        }
+        delay(50);
+    }
+    uint32_t n = rttHist->count;
+    benchLine("ws_rtt", "pings=%u lost=%u p50_us=%u p99_us=%u max_us=%u avg_us=%u",
+              RTT_PINGS, lost, rttHist->percentile(50), rttHist->percentile(99), rttHist->max,
+              n > 0 ? (uint32_t)(rttHist->sum / n) : 0);
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+void setup() {
+    Serial.begin(115200);
+    delay(500);
+    uint32_t benchStart = millis();
+    benchLine("meta", "fw=homeguard build=\"%s %s\" idf=%d.%d.%d cpu_mhz=%u heap=%u psram=%u clip_set=%d",
+              __DATE__, __TIME__, ESP_IDF_VERSION_MAJOR, ESP_IDF_VERSION_MINOR, ESP_IDF_VERSION_PATCH,
+              getCpuFrequencyMhz(), (unsigned)heap_caps_get_free_size(MALLOC_CAP_8BIT),
+              (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM), BENCH_CLIP_SET);
+
+    // Decode-only chạy trước screen.begin() vì begin() gắn lại callback của TJpgDec vào màn hình
+    for (uint8_t i = 0; i < NUM_CLIPS; i++) {
+        benchDecode(clips[i]);
+    }
+    screen.begin();
+    for (uint8_t i = 0; i < NUM_CLIPS; i++) {
+        benchDisplay(clips[i]);
+    }
+    benchMic();
+    benchDsp();
+    benchSerialize();
+    benchRtt();
+
+    benchLine("done", "ms=%u", millis() - benchStart);
+}
+
+void loop() {
+    delay(1000);
+}
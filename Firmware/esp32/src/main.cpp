@@ -2,6 +2,16 @@
 
 Robot robot;
 
+#ifdef HOMEGUARD_OPUS
+// opus_encode chạy trong loop task (VoiceStreamer) và cần nhiều stack hơn 8 KB mặc định
+SET_LOOP_TASK_STACK_SIZE(32 * 1024);
+#endif
+
+// Ảnh mới sau OTA giữ trạng thái PENDING_VERIFY, OtaUpdater tự xác nhận hoặc rollback
+extern "C" bool verifyRollbackLater() {
+  return true;
+}
+
 void setup() {
   robot.begin();
 }
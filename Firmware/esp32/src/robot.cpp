@@ -1,69 +1,577 @@
 #include "robot.h"
+#include <LittleFS.h>
+#include <esp_timer.h>
+#include "Provisioning.h"
+
+// Server mặc định khi NVS chưa provisioning (xem Provisioning.h)
+static const char* DEFAULT_WS_HOST = "your-server.com";
+static const uint16_t DEFAULT_WS_PORT = 8080;
 
 Robot::Robot()
        :screen(),             // Khởi tạo Player
         wifi("LE HUE", "012345679", 10000), // Thay "Your_SSID" và "Your_PASSWORD" bằng thông tin mạng của bạn
-        wsClient("ws://your-server.com", 8080, "robot_001"), // Thay "ws://your-server.com" và 8080 bằng địa chỉ và cổng của server WebSocket
+        wsClient(DEFAULT_WS_HOST, DEFAULT_WS_PORT, ""), // robotId và server đọc từ NVS trong begin()
         ultrasonicSensor(ULTRASONIC_TRIG_PIN, ULTRASONIC_ECHO_PIN, "Ultrasonic Sensor"),   // Khởi tạo cảm biến siêu âm
         gasSensor(GAS_SENSOR_PIN,500, "Gas Sensor"),           // Khởi tạo cảm biến khí gas
+        adc(20, 16, 3),        // 50 Hz, 16 lần đọc mỗi mẫu, EMA alpha = 1/8 (~160 ms)
         dhtSensor(DHT_PIN,DHT11, "DHT Sensor"), // Khởi tạo cảm biến DHT11
         motionSensor(PIR_PIN, 200, "PIR Sensor"), // Khởi tạo cảm biến PIR
         flameSensor(FLAME_PIN, 200, "Flame Sensor"), // Khởi tạo cảm biến lửa
         speaker(SPK_BCLK_PIN, SPK_LRC_PIN, SPK_DIN_PIN, "MAX98357A"), // Khởi tạo loa          
-        microphone(I2S_NUM_1, INMP441_BCLK_PIN, INMP441_LRCL_PIN, INMP441_DOUT_PIN, 16000, 512) // Khởi tạo micro thu âm
+        tts(speaker),
+        fireClip(-1),
+        gasClip(-1),
+        fsReady(false),
+        bootReported(false),
+        microphone(I2S_NUM_1, INMP441_BCLK_PIN, INMP441_LRCL_PIN, INMP441_DOUT_PIN, 16000, 512), // Khởi tạo micro thu âm
+        aec(16000),
+        telemetry(wsClient, 5000, 16), // Gửi lô mỗi 5 s hoặc khi đủ 16 mẫu
+        vad(16000),
+        wakeWord(wakeRing, 16000),
+        voice(micRing, wsClient, 16000),
+        motionTask(-1),
+        lastActivityMs(0),
+        sentinelPending(false),
+        wsResumePending(false),
+        ota(wsClient),
+        netTask(nullptr)
 
 {
     wsClient.setOnConnect([this]() { this->onWebSocketConnected(); });
-    wsClient.setOnActuatorCommand([this](const JsonDocument& doc) { 
-      this->handleActuatorCommand(doc); 
+    // Task mạng chỉ chép payload vào làn COMMAND; thực thi trong task dispatcher, không chờ loop
+    wsClient.setOnActuatorCommand([this](const JsonDocument& doc) {
+      if (!postJson(EVENT_ACTUATOR, doc["payload"])) {
+        Serial.println("[Robot] Actuator command dropped");
+      }
+    });
+    wsClient.setOnAudioFrame([this](const FrameHeader& header, const AudioHeader& audio,
+                                    const uint8_t* payload, size_t bytes) {
+      tts.handleFrame(header, audio, payload, bytes);
+    });
+    wsClient.setOnOtaFrame([this](const OtaHeader& header, const uint8_t* payload, size_t bytes) {
+      ota.handleFrame(header, payload, bytes);
+    });
+    // Ai-Engine đổi cảm xúc -> mặt chuyển dần sang preset mới (trong loop, cùng task với screen.tick)
+    wsClient.setMessageHandler(MessageType::EMOTION_UPDATE, [this](const JsonDocument& doc) {
+      postJson(EVENT_EMOTION, doc["payload"]);
     });
 }
 
 void Robot::begin() {
     Serial.begin(115200);
-    screen.begin();
-    wifi.connect(); // Kết nối WiFi
-    wsClient.connect();
+    boot.mark("setup");
+    // Màn hình trước tiên: frame đầu hiện ngay, animation chạy tiếp trong lúc chờ các bước sau
+    boot.step("screen", [this]() {
+        screen.begin();
+        // Mặt vẽ tham số (~30 fps, chỉ vẽ lại vùng đổi); thiếu RAM cho sprite thì về clip idle
+        if (!screen.showFace()) {
+            screen.play(*videoList[0], 40, true);
+        }
+        screen.tick();
+    });
+    boot.mark("first_frame");
+    // Bắt đầu kết nối WiFi (không block), task "wifi" theo dõi và kết nối lại
+    boot.step("wifi", [this]() { wifi.connect(); });
+    boot.step("littlefs", [this]() { fsReady = LittleFS.begin(true); });
+    boot.step("events", [this]() { registerEvents(); });
+    // Audio (I2S, clip/template trên LittleFS) và cảm biến không phụ thuộc nhau: khởi động
+    // song song trong lúc WiFi associate. Audio lên core 0 cùng task capture/mixer; cảm biến
+    // ở core 1 vì ISR gắn vào core gọi attachInterrupt, như khi còn chạy trong setup()
+    boot.spawn("audio", [this]() { beginAudio(); }, 0);
+    boot.spawn("sensors", [this]() { beginSensors(); }, 1);
+    boot.step("websocket", [this]() {
+        // Codec audio quảng bá trong connection_init theo thứ tự ưu tiên, server chọn một
+#ifdef HOMEGUARD_OPUS
+        voice.addEncoder(&opus);
+#endif
+        voice.addEncoder(&adpcm);
+        // Cảnh báo phát sinh lúc mất WiFi được giữ trên flash tới khi server ack
+        if (fsReady) {
+            wsClient.enableOfflineSpill();
+        }
+        ota.begin();
+#ifdef HOMEGUARD_WS_CA_CERT
+        wsClient.setSecure(HOMEGUARD_WS_CA_CERT);   // wss:// (chuỗi PEM của CA server)
+#endif
+        RobotProvision provision = Provisioning::load({ "", DEFAULT_WS_HOST, DEFAULT_WS_PORT });
+        wsClient.setRobotId(provision.robotId);
+        wsClient.setServer(provision.host, provision.port);
+        Serial.printf("[Robot] %s -> %s:%u\n", provision.robotId.c_str(), provision.host.c_str(), provision.port);
+        wsClient.connect();
+    });
+    // Task định kỳ, ISR cảm biến và task net đều dùng đối tượng mà beginAudio/beginSensors đang
+    // khởi tạo: chưa xong thì chưa đăng ký, vẫn chờ tiếp (màn hình vẫn chạy), join tự in bước còn dở
+    while (!boot.join(5000, [this]() { screen.tick(); })) {
+        Serial.println("[Robot] Boot jobs not finished, tasks held back");
+    }
+    boot.step("tasks", [this]() { registerTasks(); });
+    boot.mark("ready");
+    boot.printReport(Serial);
+    Serial.println("Robot initialized.");
+    // Serial.println("Playing music...");
+    // speaker.playVolume(5, "http://stream.radioparadise.com/rock-128");
+}
+
+void Robot::beginSensors() {
     ultrasonicSensor.begin();
+    ultrasonicSensor.startAsync(50); // Đo 20 Hz bằng ngắt echo, không block loop
     gasSensor.begin();
     dhtSensor.begin();
+    dhtSensor.startBackground(); // Task đọc DHT11 mỗi 1 s bằng RMT, getter chỉ đọc cache
     motionSensor.begin();
     flameSensor.begin();
+    // Kênh analog đăng ký trước adc.begin(); flame ở mode digital nên không nhận sampler
+    gasSensor.attachSampler(adc);
+    flameSensor.attachSampler(adc);
+    if (!adc.begin(1)) {
+        Serial.println("[Robot] ADC sampler not started, sensors fall back to analogRead");
+    }
+    // Lúc canh gác: ULP đọc gas/lửa với cùng ngưỡng, PIR đánh thức qua GPIO
+    sentinel.setGas(GAS_SENSOR_PIN, gasSensor.getThreshold());
+    sentinel.setFlame(FLAME_PIN, true);
+    sentinel.setMotion(PIR_PIN, true);
+    sentinel.setHeartbeat(SENTINEL_HEARTBEAT_MS);
+}
+
+void Robot::beginAudio() {
+    // AEC lấy tham chiếu từ đúng block mixer vừa ghi ra loa; gắn trước khi task mixer chạy
+    if (aec.begin()) {
+        speaker.getClips().setPlaybackTap([this](const int16_t *pcm, size_t n, int64_t playoutUs) {
+            aec.pushReference(pcm, n, playoutUs);
+        });
+        microphone.setCaptureProcessor([this](int16_t *pcm, size_t n, int64_t captureUs) {
+            aec.process(pcm, n, captureUs);
+        });
+    }
     speaker.begin();
+    loadAlertClips();
+    tts.begin(1000, 60); // Jitter buffer 1 s, bắt đầu phát khi có 60 ms
+    // Phát xong câu trả lời là hop cuối của lượt hỏi: gửi span, đóng trace
+    tts.setSpanSink([this](const char* name, int64_t startUs, int64_t endUs) {
+        wsClient.recordSpan(name, startUs, endUs);
+        wsClient.endTrace();
+    });
+    // High-pass 80 Hz bỏ DC và tiếng ù quạt/rung thân robot trước AEC và VAD
+    microphone.getDsp().setHighPass(80);
     microphone.begin();
-    Serial.println("Robot initialized.");
-    // Serial.println("Playing music...");
-    // speaker.playVolume(5, "http://stream.radioparadise.com/rock-128");
+    // Ring 8192 mẫu (~512 ms) đủ che các lần WiFi/WebSocket chậm
+    if (micRing.begin(8192) && wakeRing.begin(2048)) {
+        microphone.setCaptureCallback([this](const int16_t *pcm, size_t n) {
+            vad.process(pcm, n);
+            wakeRing.write(pcm, n);
+        });
+        microphone.startCapture(micRing, 0);
+        voice.setVad(&vad, 300); // Giữ 300 ms trước lúc VAD mở để không mất đầu câu
+        // Wake-word chạy cùng core 0 nhưng ưu tiên thấp hơn task capture
+        wakeWord.loadTemplates();
+        wakeWord.setOnWake([this](uint8_t, float) { voice.notifyWake(); });
+        if (wakeWord.begin(0) && wakeWord.getTemplateCount() > 0) {
+            voice.setWakeGate(8000);
+        }
+    }
+}
+
+void Robot::loadAlertClips() {
+    SpeakerI2S& clips = speaker.getClips();
+    fireClip = clips.loadClip("/alarm_fire.adp");
+    if (fireClip < 0) {
+        fireClip = clips.addTone(2000, 400);
+    }
+    gasClip = clips.loadClip("/alarm_gas.adp");
+    if (gasClip < 0) {
+        gasClip = clips.addTone(1200, 300);
+    }
+}
+
+void Robot::registerTasks() {
+    // Chu kỳ (ms) chọn theo tốc độ thay đổi của từng nguồn dữ liệu
+    scheduler.addTask("screen", 5, [this]() { screen.tick(); });
+    scheduler.addTask("wifi", 100, [this]() {
+        wifi.update();
+        if (wifi.isConnected()) {
+            boot.mark("wifi_online");
+        }
+        resumeWebSocket();
+    });
+    // WebSocket nhận trong task riêng: frame tới không phải chờ task khác của loop,
+    // lệnh điều khiển đi tiếp sang làn COMMAND của EventBus
+    if (xTaskCreatePinnedToCore(networkLoop, "net", 8192, this, 3, &netTask, 0) != pdPASS) {
+        netTask = nullptr;
+        scheduler.addTask("websocket", 10, [this]() {
+            wsClient.update();
+            ota.update();
+        });
+    }
+    scheduler.addTask("events", 20, [this]() { events.dispatchPending(); });
+    scheduler.addTask("speaker", 5, [this]() { speaker.loop(); });
+    // PIR và lửa chạy theo ngắt: ISR trigger task ngay, chu kỳ 500 ms chỉ để dự phòng
+    motionTask = scheduler.addTask("motion", 500, [this]() {
+        if (motionSensor.isMotionDetected()) {
+            Serial.println("[Robot] Motion detected");
+            wsClient.sendSensorAlert("motion", true, AlertLevel::WARNING,
+                                     motionSensor.getLastEdgeLatencyUs());
+        }
+    });
+    // Lửa: ISR post thẳng vào làn ALARM; task 500 ms chỉ để bắt trạng thái vừa qua debounce
+    scheduler.addTask("flame", 500, [this]() { events.post(EVENT_FLAME); });
+    motionSensor.enableInterrupt(Scheduler::triggerFromISR, scheduler.triggerHandle(motionTask));
+    flameSensor.enableInterrupt(EventBus::postFromISR, events.isrHandle(EVENT_FLAME));
+    scheduler.addTask("obstacle", 50, [this]() {
+        bool wasObstacle = ultrasonicSensor.isObstacle();
+        if (ultrasonicSensor.checkObstacle() != wasObstacle) {
+            Serial.println(wasObstacle ? "[Robot] Obstacle cleared" : "[Robot] Obstacle ahead");
+        }
+    });
+    scheduler.addTask("ultrasonic", 1000, [this]() {
+        ultrasonicSensor.printDistance();
+        if (ultrasonicSensor.sample()) {
+            telemetry.add(ultrasonicSensor);
+        }
+    });
+    scheduler.addTask("gas", 1000, [this]() {
+        gasSensor.printGas();
+        // Mức theo luật cục bộ (trễ + dwell); mẫu chỉ được gửi khi đổi đủ delta hoặc đổi mức
+        gasSensor.sample();
+        AlertLevel level = telemetry.add(gasSensor);
+        if (level >= AlertLevel::DANGER) {
+            events.post(EVENT_GAS);
+        }
+    });
+    scheduler.addTask("dht", 2000, [this]() {
+        dhtSensor.printValues();
+        // Nhiệt độ và độ ẩm cùng một giao dịch, đọc từ cache nên không chặn task
+        if (dhtSensor.sample() && dhtSensor.humidity().sample()) {
+            telemetry.add(dhtSensor);
+            telemetry.add(dhtSensor.humidity());
+        }
+    });
+    scheduler.addTask("telemetry", 250, [this]() {
+        // Mẫu đầu tiên sau khi online gửi ngay thay vì chờ đủ lô / flushMs
+        if (!bootReported && wsClient.isConnectedToServer() && telemetry.pending() > 0 && telemetry.flush()) {
+            boot.mark("first_telemetry");
+            bootReported = sendBootReport();
+        }
+        telemetry.update();
+    });
+    scheduler.addTask("voice", 10, [this]() {
+        // Barge-in: micro đã khử vọng, VAD nghe thấy người nói khi TTS đang phát -> ngắt TTS
+        if (tts.isActive() && vad.isSpeech()) {
+            tts.stop();
+            voice.notifyWake();
+            Serial.println("[Robot] Barge-in, TTS stopped");
+        }
+        voice.update();
+    });
+    // Có gì đang diễn ra thì hoãn canh gác; đủ lâu yên tĩnh thì run() vào sentinel
+    lastActivityMs = millis();
+    scheduler.addTask("sentinel", 1000, [this]() {
+        uint32_t now = millis();
+        if (motionSensor.getState() || flameSensor.getState() || gasSensor.isGasDetected() ||
+            tts.isActive() || voice.isStreaming() || vad.isSpeech() || ota.isActive()) {
+            lastActivityMs = now;
+        }
+        if (SENTINEL_IDLE_MS > 0 && now - lastActivityMs >= SENTINEL_IDLE_MS) {
+            sentinelPending = true;
+        }
+    });
+    // Lệnh Serial: e = thu template wake-word, s = lưu và bật gating, b = bật/tắt benchmark,
+    // m = in metrics, z = vào chế độ canh gác ngay, p id=... host=... port=... = provisioning rồi khởi động lại
+    scheduler.addTask("console", 100, [this]() {
+        while (Serial.available()) {
+            char cmd = Serial.read();
+            if (cmd == 'e') {
+                Serial.println(wakeWord.enrollNext() ? "[Robot] Say the wake word..." : "[Robot] Cannot enroll");
+            } else if (cmd == 's' && wakeWord.saveTemplates()) {
+                voice.setWakeGate(8000);
+                Serial.printf("[Robot] Saved %u wake-word template(s)\n", wakeWord.getTemplateCount());
+            } else if (cmd == 'b') {
+                static bool bench = false;
+                bench = !bench;
+                wakeWord.setBenchmark(bench);
+                Serial.println(bench ? "[Robot] Wake-word benchmark on" : "[Robot] Wake-word benchmark off");
+            } else if (cmd == 'm') {
+                Metrics::sampleHeap();
+                Metrics::print(Serial);
+            } else if (cmd == 'z') {
+                sentinelPending = true;
+            } else if (cmd == 'p') {
+                RobotProvision provision;
+                if (Provisioning::parse(Serial.readStringUntil('\n'), provision) && Provisioning::save(provision)) {
+                    Serial.println("[Robot] Provisioning saved, restarting...");
+                    delay(100);
+                    ESP.restart();
+                }
+                Serial.printf("[Robot] Provisioning unchanged (%s), usage: p id=robot_017 host=server port=8080\n",
+                              wsClient.getRobotId().c_str());
+            }
+        }
+    });
+    scheduler.addTask("stats", 30000, [this]() { printTaskStats(); });
+    // Snapshot metrics gửi lên server mỗi phút, histogram bắt đầu cửa sổ mới sau mỗi lần gửi
+    scheduler.addTask("metrics", 60000, [this]() {
+        Metrics::sampleHeap();
+        if (wsClient.sendStatusUpdate("metrics", [](JsonObject payload) { Metrics::toJson(payload); })) {
+            Metrics::resetWindow();
+        }
+    });
 }
 
 void Robot::run() {
-    //screen.playAll();
-    //wsClient.update();
-    // ultrasonicSensor.printDistance();
-    // gasSensor.printGas();
-    // dhtSensor.printValues();
-    // motionSensor.printState();
-     flameSensor.printState();
-    
-    //speaker.loop();
+    if (sentinelPending) {
+        sentinelPending = false;
+        enterSentinel();
+    }
+    if (sentinel.isArmed()) {
+        runSentinel();
+        return;
+    }
+    scheduler.run(); // Chạy task tới hạn rồi ngủ tới deadline kế tiếp
     // microphone.record(1); // Ghi âm 5 giây
     // microphone.printBuffer(1000); // In ra 16000 mẫu đầu tiên
-    delay(500); // Giãn cách 2 giây
+}
+
+// ============================================
+// 🛡️ SENTINEL
+// ============================================
+
+bool Robot::enterSentinel() {
+    Serial.println("[Robot] Entering sentinel mode");
+    telemetry.flush();
+    wsClient.update();
+    screen.sleep();
+    microphone.stopCapture();
+    // ULP giữ ADC1 và chân lửa; PIR chuyển sang GPIO wakeup theo mức
+    adc.stop();
+    motionSensor.disableInterrupt();
+    flameSensor.disableInterrupt();
+    wifi.powerDown();
+    if (!sentinel.arm()) {
+        Serial.println("[Robot] Sentinel not available, staying awake");
+        exitSentinel(WakeCause::NONE);
+        return false;
+    }
+    return true;
+}
+
+void Robot::runSentinel() {
+    WakeCause cause = sentinel.sleep();
+    if (cause == WakeCause::HEARTBEAT) {
+        sentinelHeartbeat();
+    } else if (cause != WakeCause::OTHER) {
+        // NONE = light sleep bị từ chối: thức dậy hẳn thay vì quay vòng
+        exitSentinel(cause);
+    }
+}
+
+void Robot::exitSentinel(WakeCause cause) {
+    sentinel.disarm();
+    // Còi báo trước tiên, trước cả khi có mạng: độ trễ phát hiện chỉ là chu kỳ ULP + thời gian dậy
+    if (cause == WakeCause::FLAME) {
+        speaker.playClip(fireClip, SpeakerI2S::PRIORITY_ALARM);
+    } else if (cause == WakeCause::GAS) {
+        speaker.playClip(gasClip, SpeakerI2S::PRIORITY_ALARM - 1);
+    }
+    flameSensor.begin();             // chân lửa vừa được trả từ RTC mux
+    flameSensor.enableInterrupt(EventBus::postFromISR, events.isrHandle(EVENT_FLAME));
+    motionSensor.enableInterrupt(Scheduler::triggerFromISR, scheduler.triggerHandle(motionTask));
+    adc.begin(1);
+    microphone.startCapture(micRing, 0);
+    screen.wake();
+    wifi.connect();
+    wsResumePending = true;          // mỗi chu kỳ ngủ làm rớt socket, không để backoff dồn lên 60 s
+
+    // Cạnh đánh thức đã qua trong lúc ngủ nên task của cảm biến không thấy: báo thẳng.
+    // Chưa có mạng thì cảnh báo nằm trong outbox (và LittleFS) tới khi server ack.
+    if (cause == WakeCause::FLAME) {
+        wsClient.sendSensorAlert("flame", true, AlertLevel::CRITICAL);
+    } else if (cause == WakeCause::GAS) {
+        wsClient.sendSensorAlert("gas", true, AlertLevel::DANGER);
+    } else if (cause == WakeCause::MOTION) {
+        wsClient.sendSensorAlert("motion", true, AlertLevel::WARNING);
+    }
+    Serial.printf("[Robot] Sentinel woke: %s\n", Sentinel::causeName(cause));
+    sentinel.printStats(Serial);
+    lastActivityMs = millis();
+    scheduler.resetStats();          // khoảng ngủ không tính là task bị lỡ chu kỳ
+}
+
+void Robot::sentinelHeartbeat() {
+    static const uint32_t ONLINE_TIMEOUT_MS = 8000;
+    static const uint32_t FLUSH_MS = 300;
+
+    wifi.connect();
+    wsResumePending = true;
+    uint32_t start = millis();
+    while (!wsClient.isConnectedToServer() && millis() - start < ONLINE_TIMEOUT_MS) {
+        wifi.update();
+        resumeWebSocket();
+        wsClient.update();
+        delay(10);
+    }
+    if (wsClient.isConnectedToServer()) {
+        wsClient.sendStatusUpdate("sentinel", [this](JsonObject payload) {
+            payload["event"] = "heartbeat";
+            payload["gasRaw"] = sentinel.getLastGasRaw();
+            payload["ulpSamples"] = sentinel.getUlpSamples();
+            payload["sleptS"] = (uint32_t)(sentinel.getSleptUs() / 1000000);
+            payload["heartbeats"] = sentinel.getWakeups(WakeCause::HEARTBEAT);
+            payload["connectMs"] = wifi.getLastConnectMs();
+        });
+        // Cho outbox (kể cả cảnh báo spill từ lần trước) đi hết trước khi tắt radio
+        uint32_t flushStart = millis();
+        while (millis() - flushStart < FLUSH_MS) {
+            wsClient.update();
+            delay(10);
+        }
+    } else {
+        Serial.println("[Robot] Sentinel heartbeat: server unreachable");
+    }
+    wifi.powerDown();
+}
+
+void Robot::resumeWebSocket() {
+    // Đợi có IP mới mở cửa sổ thử, để cả cửa sổ dùng cho handshake thay vì chờ WiFi
+    if (wsResumePending && wifi.isConnected()) {
+        wsResumePending = false;
+        wsClient.reconnectNow();
+    }
+}
+
+void Robot::printTaskStats() {
+    scheduler.printStats(Serial);
+    Serial.printf("[Robot] mic buffers=%u dma_overflow=%u dropped=%u max_us=%u | voice chunks=%u failed=%u\n",
+                  microphone.getCapturedBuffers(), microphone.getDmaOverflows(),
+                  microphone.getDroppedSamples(), microphone.getMaxCaptureUs(),
+                  voice.getSentChunks(), voice.getFailedChunks());
+    wakeWord.printBenchmark(Serial);
+    SpeakerI2S& clips = speaker.getClips();
+    Serial.printf("[Robot] clips started=%u preempted=%u rejected=%u start_latency last=%uus max=%uus\n",
+                  clips.getClipsStarted(), clips.getPreempted(), clips.getRejected(),
+                  clips.getLastStartLatencyUs(), clips.getMaxStartLatencyUs());
+    tts.printStats(Serial);
+    wsClient.printRxStats(Serial);
+    wifi.printStats(Serial);
+    sentinel.printStats(Serial);
+    ota.printStats(Serial);
+    events.printStats(Serial);
+    wsClient.getOutbox().printStats(Serial);
+    aec.printStats(Serial);
+    if (voice.getEncoder() != nullptr) {
+        voice.getEncoder()->printStats(Serial);
+    }
+}
+
+bool Robot::sendBootReport() {
+    boot.printReport(Serial);
+    return wsClient.sendStatusUpdate("boot", [this](JsonObject payload) {
+        payload["resetReason"] = (int)esp_reset_reason();
+        payload["savedByParallelMs"] = boot.getSavedUs() / 1000;
+        JsonArray steps = payload.createNestedArray("steps");
+        JsonObject marks = payload.createNestedObject("marks");
+        for (uint8_t i = 0; i < boot.getCount(); i++) {
+            const BootRecord &r = boot.getRecord(i);
+            if (r.core == BootProfiler::CORE_MARK) {
+                marks[r.name] = r.startUs / 1000;
+                continue;
+            }
+            JsonObject step = steps.createNestedObject();
+            step["name"] = r.name;
+            step["startMs"] = r.startUs / 1000;
+            step["durationUs"] = r.durationUs;
+            step["core"] = r.core;
+        }
+    });
 }
 
 void Robot::onWebSocketConnected() {
     Serial.println("WebSocket connected to server.");
+    boot.mark("ws_online");
     // Gửi dữ liệu cảm biến ban đầu hoặc thực hiện các thao tác khác khi kết nối thành công
 }
 
-void Robot::handleActuatorCommand(const JsonDocument& doc) {
-    // Serial.println("Received actuator command:");
-    // serializeJsonPretty(doc, Serial);
+void Robot::handleActuatorCommand(JsonVariantConst payload) {
+    const char* actuator = payload["actuator"] | "";
+    const char* action = payload["action"] | "on";
+    if (strcmp(actuator, "siren") == 0 || strcmp(actuator, "buzzer") == 0) {
+        if (strcmp(action, "off") == 0) {
+            speaker.stopClips();
+        } else {
+            speaker.playClip(fireClip, SpeakerI2S::PRIORITY_ALARM);
+        }
+    } else {
+        Serial.printf("[Robot] Unknown actuator '%s'\n", actuator);
+    }
 
-    // if (doc["payload"]["action"] == "play_sound") {
-    //     const char* url = doc["payload"]["url"];
-    //     int volume = doc["payload"]["volume"] | 5; // Mặc định volume là 5 nếu không có trong payload
+    // if (payload["action"] == "play_sound") {
+    //     const char* url = payload["url"];
+    //     int volume = payload["volume"] | 5; // Mặc định volume là 5 nếu không có trong payload
     //     speaker.playVolume(volume, url);
     //     Serial.println("Playing sound from URL: " + String(url) + " at volume: " + String(volume));
     // }
+}
+
+// ============================================
+// 🚨 EVENT BUS
+// ============================================
+
+void Robot::registerEvents() {
+    // Báo động: còi trước, rồi cảnh báo (không chờ khoá của task mạng, xem sendSensorAlert)
+    events.on(EVENT_FLAME, EventLane::ALARM, [this](const Event&) {
+        if (flameSensor.isFlameDetected()) {
+            Serial.println("[Robot] Flame detected");
+            speaker.playClip(fireClip, SpeakerI2S::PRIORITY_ALARM);
+            wsClient.sendSensorAlert("flame", true, AlertLevel::CRITICAL,
+                                     flameSensor.getLastEdgeLatencyUs());
+        }
+    });
+    events.on(EVENT_GAS, EventLane::ALARM, [this](const Event&) {
+        speaker.playClip(gasClip, SpeakerI2S::PRIORITY_ALARM - 1);
+    });
+    // Payload parse vào document mượn từ eventDocs (arena cố định), không cấp phát heap mỗi sự kiện
+    events.on(EVENT_ACTUATOR, EventLane::COMMAND, [this](const Event& event) {
+        JsonDocLease lease(eventDocs);
+        if (!lease) {
+            return;
+        }
+        JsonDocument& payload = *lease.get();
+        if (deserializeJson(payload, (const char*)event.data, event.length) == DeserializationError::Ok) {
+            handleActuatorCommand(payload.as<JsonVariantConst>());
+        }
+    });
+    events.on(EVENT_EMOTION, EventLane::NORMAL, [this](const Event& event) {
+        JsonDocLease lease(eventDocs);
+        if (!lease) {
+            return;
+        }
+        JsonDocument& payload = *lease.get();
+        if (deserializeJson(payload, (const char*)event.data, event.length) == DeserializationError::Ok) {
+            screen.face().apply(payload.as<JsonVariantConst>(), millis());
+            // Span từ lúc nhận emotion_update (32 bit thấp của esp_timer) tới khi mặt nhận preset
+            int64_t nowUs = esp_timer_get_time();
+            wsClient.recordSpan("screen.emotion", nowUs - (uint32_t)((uint32_t)nowUs - event.postedUs), nowUs);
+        }
+    });
+    // Không có queue/task thì post() và dispatchPending() chạy handler ngay trong task gọi
+    if (!events.begin(4, 8, 8) || !events.start(1, 5)) {
+        Serial.println("[Robot] Event dispatcher not started, alarms run in loop");
+    }
+}
+
+bool Robot::postJson(uint8_t kind, JsonVariantConst payload) {
+    char json[Event::DATA_SIZE];
+    size_t length = measureJson(payload);
+    if (length >= sizeof(json)) {
+        return events.post(kind, nullptr, sizeof(json) + 1);   // quá slot: đếm vào bus.dropped
+    }
+    serializeJson(payload, json, sizeof(json));
+    return events.post(kind, json, length);
+}
+
+void Robot::networkLoop(void* arg) {
+    Robot* self = static_cast<Robot*>(arg);
+    for (;;) {
+        self->wsClient.update();
+        self->ota.update();          // cùng task với ota.handleFrame(), không cần khoá riêng
+        vTaskDelay(pdMS_TO_TICKS(5));
+    }
 }
\ No newline at end of file
@@ -4,32 +4,105 @@
 #include "Screen.h"
 #include "UltrasonicSensor.h"
 #include "GasSensor.h"   
+#include "AnalogSampler.h"
 #include "DHTSensor.h"
 #include <MotionSensor.h>
 #include <FlameSensor.h>
 #include "MAX98357A.h"
+#include "TtsPlayer.h"
 #include "INMP441.h"
+#include "EchoCanceller.h"
+#include "VoiceStreamer.h"
+#include "WakeWord.h"
+#include "AudioEncoder.h"
+#include "OpusFrameEncoder.h"
 #include "WiFiConnector.h"
 #include "WebSocketClient.h"
+#include "TelemetryBatcher.h"
+#include "Scheduler.h"
+#include "EventBus.h"
+#include "BootProfiler.h"
+#include "Sentinel.h"
+#include "OtaUpdater.h"
 #include "pins.h"
 
+// Chế độ canh gác: sau SENTINEL_IDLE_MS không có hoạt động thì tắt WiFi/TFT và
+// light sleep, ULP trông gas/lửa. 0 = chỉ vào khi gõ 'z' trên Serial.
+#ifndef SENTINEL_IDLE_MS
+#define SENTINEL_IDLE_MS (10UL * 60 * 1000)
+#endif
+#ifndef SENTINEL_HEARTBEAT_MS
+#define SENTINEL_HEARTBEAT_MS (15UL * 60 * 1000)
+#endif
+
+// Sự kiện trên EventBus: ALARM / COMMAND chạy trong task dispatcher, NORMAL trong loop
+enum RobotEvent : uint8_t {
+    EVENT_FLAME = 0,             // ALARM: ISR của chân lửa hoặc task "flame" dự phòng
+    EVENT_GAS,                   // ALARM: task "gas" thấy mức DANGER
+    EVENT_ACTUATOR,              // COMMAND: payload JSON của actuator_command
+    EVENT_EMOTION                // NORMAL: payload JSON của emotion_update
+};
+
 class Robot {
 private:
     Screen screen;          // Quản lý màn hình/video
     WiFiConnector wifi;     // Quản lý kết nối WiFi
     UltrasonicSensor ultrasonicSensor; // Cảm biến siêu âm
     GasSensor gasSensor;         // Cảm biến khí gas MQ-2
+    AnalogSampler adc;           // Task lấy mẫu ADC1 nền cho các cảm biến analog
     DHTSensor dhtSensor;         // Cảm biến nhiệt độ và độ ẩm DHT11
     MotionSensor motionSensor;   // Cảm biến chuyển động PIR
     FlameSensor flameSensor;     // Cảm biến lửa
     MAX98357A speaker;          // Loa MAX98357A
+    TtsPlayer tts;              // Phát TTS server đẩy xuống qua WebSocket
+    int8_t fireClip;            // Clip còi báo cháy (SpeakerI2S)
+    int8_t gasClip;             // Clip cảnh báo gas
+    bool fsReady;               // LittleFS đã mount
+    bool bootReported;          // Đã gửi báo cáo khởi động (STATUS_UPDATE)
     INMP441 microphone;         // Micro thu âm
+    EchoCanceller aec;          // Khử tiếng loa khỏi micro để nói chen khi TTS đang phát
     WebSocketClient wsClient; // Quản lý kết nối WebSocket
+    TelemetryBatcher telemetry; // Gom mẫu cảm biến thành lô trước khi gửi
+    PcmRing micRing;            // PCM từ task capture của micro
+    VoiceActivity vad;          // Chỉ mở stream khi có tiếng nói
+    PcmRing wakeRing;           // Bản sao PCM cho wake-word trên core 0
+    WakeWord wakeWord;          // Mở cửa sổ stream khi nghe wake-word
+    AdpcmEncoder adpcm;         // Codec uplink rẻ CPU (64 kbit/s)
+#ifdef HOMEGUARD_OPUS
+    OpusFrameEncoder opus;      // Codec uplink tiết kiệm băng thông (16 kbit/s)
+#endif
+    VoiceStreamer voice;        // Stream micRing lên server
+    Scheduler scheduler;      // Lập lịch các subsystem trong run()
+    BootProfiler boot;          // Thời gian từng bước begin(), mốc frame/telemetry đầu tiên
+    Sentinel sentinel;          // Light sleep + ULP trông gas/lửa khi nhà không có gì
+    int8_t motionTask;          // id task, dùng lại khi bật ngắt PIR sau sentinel
+    uint32_t lastActivityMs;    // millis() lần cuối có chuyển động/cảnh báo/giọng nói
+    bool sentinelPending;       // task "sentinel" yêu cầu, run() vào chế độ ngoài scheduler
+    bool wsResumePending;       // WiFi bật lại sau sentinel, chờ có IP để bỏ backoff WebSocket
+    OtaUpdater ota;             // Patch firmware server đẩy qua CHANNEL_OTA
+    EventBus events;            // Làn ưu tiên cho báo động và lệnh điều khiển
+    JsonDocPool eventDocs;      // Document cho payload JSON của handler (COMMAND + NORMAL cùng lúc)
+    TaskHandle_t netTask;       // WebSocket + OTA, tách khỏi loop
+
+    void registerTasks();        // Đăng ký task cho từng subsystem với chu kỳ riêng
+    void registerEvents();       // Handler của EventBus, task dispatcher
+    bool postJson(uint8_t kind, JsonVariantConst payload); // Serialize payload vào slot của EventBus
+    static void networkLoop(void *arg); // Task mạng: wsClient.update() + ota.update()
+    void loadAlertClips();       // Nạp clip báo động từ LittleFS, thiếu thì tạo tone
+    void beginAudio();           // Loa, AEC, TTS, micro, wake-word (chạy song song khi boot)
+    void beginSensors();         // Các cảm biến GPIO/ADC (chạy song song khi boot)
+    bool sendBootReport();       // Gửi bảng thời gian khởi động qua STATUS_UPDATE
+    bool enterSentinel();        // Tắt WiFi/TFT/micro/ADC task, nạp ULP
+    void runSentinel();          // Một lần ngủ -> heartbeat hoặc thoát theo lý do đánh thức
+    void exitSentinel(WakeCause cause); // Bật lại mọi thứ, báo động ngay nếu là gas/lửa
+    void sentinelHeartbeat();    // Kết nối nhanh, gửi STATUS_UPDATE "sentinel", tắt WiFi lại
+    void resumeWebSocket();      // Có IP sau sentinel -> wsClient.reconnectNow()
     public:
     Robot();                     // Constructor
     void begin();                // Khởi tạo hệ thống
     void run();                  // Chạy robot
     void onWebSocketConnected(); // Xử lý khi kết nối WebSocket thành công
-    void handleActuatorCommand(const JsonDocument& doc); // Xử lý lệnh điều
+    void handleActuatorCommand(JsonVariantConst payload); // Thực thi lệnh điều khiển (task dispatcher)
+    void printTaskStats();       // In thời gian CPU / overrun của từng task
 };
 
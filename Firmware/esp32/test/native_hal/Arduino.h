@@ -0,0 +1,187 @@
+#pragma once
+
+// ======================================================
+// 🧪 HAL giả lập cho env:native (unit test + microbenchmark trên máy dev)
+// ======================================================
+//
+// Chỉ đủ cho phần logic trong lib/: đồng hồ millis()/micros() do test điều
+// khiển (không tự chạy), mảng chân giả cho digitalRead/analogRead, ngắt
+// attachInterruptArg được lưu lại và hal::setDigital() gọi ISR như phần cứng
+// khi mức chân đổi. I2S, LittleFS, WebSocketsClient có shim riêng cùng thư mục.
+//
+// Khác ESP32 cần nhớ: unsigned long là 64 bit nên phép trừ millis() không tràn
+// như trên chip; test tràn 32 bit phải dùng uint32_t.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include "WString.h"
+#include "Print.h"
+#include "freertos/FreeRTOS.h"
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define PROGMEM
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define INPUT_PULLDOWN 0x09
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define digitalPinToInterrupt(p) (p)
+
+using std::max;
+using std::min;
+
+template <typename T>
+inline T constrain(T v, T lo, T hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+namespace hal {
+
+static const uint8_t PIN_COUNT = 40;
+
+struct State {
+    uint64_t nowUs;
+    uint8_t mode[PIN_COUNT];
+    uint8_t digital[PIN_COUNT];
+    uint16_t analog[PIN_COUNT];
+    void (*isr[PIN_COUNT])(void *);
+    void *isrArg[PIN_COUNT];
+    int isrMode[PIN_COUNT];
+    uint32_t randomState;
+    uint32_t cpuMhz;
+};
+
+inline State &state() {
+    static State s;
+    return s;
+}
+
+// Gọi trong setUp() của mỗi test: đồng hồ về 0, chân LOW, gỡ mọi ngắt
+inline void reset(uint64_t startUs = 0) {
+    state() = State();
+    state().nowUs = startUs;
+    state().randomState = 1;
+    state().cpuMhz = 240;
+}
+
+inline void setMicros(uint64_t us) { state().nowUs = us; }
+inline void advanceMicros(uint64_t us) { state().nowUs += us; }
+inline void advanceMillis(uint32_t ms) { state().nowUs += (uint64_t)ms * 1000; }
+
+inline void setAnalog(uint8_t pin, uint16_t value) {
+    if (pin < PIN_COUNT) {
+        state().analog[pin] = value;
+    }
+}
+
+// Đổi mức chân; có ngắt CHANGE/RISING/FALLING khớp thì gọi ISR ngay (như phần cứng)
+inline void setDigital(uint8_t pin, uint8_t level) {
+    if (pin >= PIN_COUNT) {
+        return;
+    }
+    State &s = state();
+    uint8_t old = s.digital[pin];
+    s.digital[pin] = level ? HIGH : LOW;
+    if (s.isr[pin] == nullptr || old == s.digital[pin]) {
+        return;
+    }
+    int mode = s.isrMode[pin];
+    if (mode == CHANGE || (mode == RISING && level) || (mode == FALLING && !level)) {
+        s.isr[pin](s.isrArg[pin]);
+    }
+}
+
+inline bool hasInterrupt(uint8_t pin) { return pin < PIN_COUNT && state().isr[pin] != nullptr; }
+inline uint8_t pinModeOf(uint8_t pin) { return pin < PIN_COUNT ? state().mode[pin] : 0; }
+
+}  // namespace hal
+
+inline unsigned long micros() { return (uint32_t)hal::state().nowUs; }
+inline unsigned long millis() { return (uint32_t)(hal::state().nowUs / 1000); }
+inline void delay(uint32_t ms) { hal::advanceMillis(ms); }
+inline void delayMicroseconds(uint32_t us) { hal::advanceMicros(us); }
+inline void yield() {}
+inline void vTaskDelay(TickType_t ticks) { hal::advanceMillis(ticks); }
+inline TickType_t xTaskGetTickCount() { return (TickType_t)millis(); }
+inline void vTaskDelayUntil(TickType_t *lastWake, TickType_t period) {
+    *lastWake += period;
+    if (*lastWake > xTaskGetTickCount()) {
+        hal::advanceMillis(*lastWake - xTaskGetTickCount());
+    }
+}
+inline uint32_t getCpuFrequencyMhz() { return hal::state().cpuMhz; }
+// SNTP không chạy trên máy dev: gettimeofday() là giờ thật của host
+inline void configTime(long, int, const char *, const char * = nullptr, const char * = nullptr) {}
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < hal::PIN_COUNT) {
+        hal::state().mode[pin] = mode;
+    }
+}
+inline int digitalRead(uint8_t pin) { return pin < hal::PIN_COUNT ? hal::state().digital[pin] : LOW; }
+inline void digitalWrite(uint8_t pin, uint8_t level) { hal::setDigital(pin, level); }
+inline uint16_t analogRead(uint8_t pin) { return pin < hal::PIN_COUNT ? hal::state().analog[pin] : 0; }
+
+// Như esp32-hal-gpio: ADC1 là kênh 0..7 (GPIO36..39, 32..35), ADC2 là 10..19
+inline int8_t digitalPinToAnalogChannel(uint8_t pin) {
+    static const uint8_t adc1Pins[8] = { 36, 37, 38, 39, 32, 33, 34, 35 };
+    static const uint8_t adc2Pins[10] = { 4, 0, 2, 15, 13, 12, 14, 27, 25, 26 };
+    for (int8_t i = 0; i < 8; i++) {
+        if (adc1Pins[i] == pin) {
+            return i;
+        }
+    }
+    for (int8_t i = 0; i < 10; i++) {
+        if (adc2Pins[i] == pin) {
+            return 10 + i;
+        }
+    }
+    return -1;
+}
+
+inline void attachInterruptArg(uint8_t pin, void (*isr)(void *), void *arg, int mode) {
+    if (pin < hal::PIN_COUNT) {
+        hal::state().isr[pin] = isr;
+        hal::state().isrArg[pin] = arg;
+        hal::state().isrMode[pin] = mode;
+    }
+}
+inline void detachInterrupt(uint8_t pin) {
+    if (pin < hal::PIN_COUNT) {
+        hal::state().isr[pin] = nullptr;
+        hal::state().isrArg[pin] = nullptr;
+    }
+}
+
+// LCG cố định hạt giống: UUID, seq đầu của hàng đợi... lặp lại được giữa các lần chạy
+inline void randomSeed(uint32_t seed) { hal::state().randomState = seed ? seed : 1; }
+inline long random(long howBig) {
+    if (howBig <= 0) {
+        return 0;
+    }
+    uint32_t &x = hal::state().randomState;
+    x = x * 1664525u + 1013904223u;
+    return (long)(x % (uint32_t)howBig);
+}
+inline long random(long howSmall, long howBig) {
+    return howSmall >= howBig ? howSmall : howSmall + random(howBig - howSmall);
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <Arduino.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ======================================================
+// 🧪 Hệ file trong RAM cho env:native (thay LittleFS)
+// ======================================================
+//
+// Đủ cho OutboundQueue spill: open "r"/"r+"/"w"/"w+"/"a", đọc,
+// ghi, seek, size. Nội dung sống tới khi test gọi format(), nên "sống qua
+// reboot" thử được bằng cách tạo lại object dùng file.
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+using FileData = std::shared_ptr<std::vector<uint8_t>>;
+
+class File {
+public:
+    File() : pos(0), writable(false), appendMode(false) {}
+    File(FileData data, const std::string &path, bool writable, bool appendMode)
+        : data(data), path(path), pos(appendMode ? data->size() : 0), writable(writable), appendMode(appendMode) {}
+
+    explicit operator bool() const { return data != nullptr; }
+
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const uint8_t *buffer, size_t size) {
+        if (!data || !writable) {
+            return 0;
+        }
+        if (appendMode) {
+            pos = data->size();
+        }
+        if (pos + size > data->size()) {
+            data->resize(pos + size);
+        }
+        memcpy(data->data() + pos, buffer, size);
+        pos += size;
+        return size;
+    }
+
+    size_t read(uint8_t *buffer, size_t size) {
+        if (!data || pos >= data->size()) {
+            return 0;
+        }
+        size_t n = std::min(size, data->size() - pos);
+        memcpy(buffer, data->data() + pos, n);
+        pos += n;
+        return n;
+    }
+    int read() {
+        uint8_t c;
+        return read(&c, 1) == 1 ? c : -1;
+    }
+
+    bool seek(uint32_t offset, SeekMode mode = SeekSet) {
+        if (!data) {
+            return false;
+        }
+        size_t base = mode == SeekSet ? 0 : (mode == SeekCur ? pos : data->size());
+        if (base + offset > data->size()) {
+            return false;
+        }
+        pos = base + offset;
+        return true;
+    }
+
+    size_t position() const { return pos; }
+    size_t size() const { return data ? data->size() : 0; }
+    int available() const { return data && pos < data->size() ? (int)(data->size() - pos) : 0; }
+    const char *name() const { return path.c_str(); }
+    void flush() {}
+    void close() { data.reset(); }
+
+private:
+    FileData data;
+    std::string path;
+    size_t pos;
+    bool writable;
+    bool appendMode;
+};
+
+class FS {
+public:
+    File open(const char *path, const char *mode = "r") {
+        auto it = files.find(path);
+        bool exists = it != files.end();
+        if (mode[0] == 'r') {
+            return exists ? File(it->second, path, mode[1] == '+', false) : File();
+        }
+        if (!exists || mode[0] == 'w') {
+            files[path] = std::make_shared<std::vector<uint8_t>>();
+        }
+        return File(files[path], path, true, mode[0] == 'a');
+    }
+    File open(const String &path, const char *mode = "r") { return open(path.c_str(), mode); }
+
+    bool exists(const char *path) const { return files.count(path) > 0; }
+    bool remove(const char *path) { return files.erase(path) > 0; }
+    bool format() {
+        files.clear();
+        return true;
+    }
+
+protected:
+    std::map<std::string, FileData> files;
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
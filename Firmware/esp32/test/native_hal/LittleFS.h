@@ -0,0 +1,19 @@
+#pragma once
+
+#include "FS.h"
+
+namespace fs {
+
+class LittleFSFS : public FS {
+public:
+    bool begin(bool formatOnFail = false) {
+        (void)formatOnFail;
+        return true;
+    }
+    void end() {}
+    size_t totalBytes() const { return 1441792; }
+};
+
+}  // namespace fs
+
+inline fs::LittleFSFS LittleFS;
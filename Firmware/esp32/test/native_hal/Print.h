@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "WString.h"
+
+// ======================================================
+// 🧪 Print / Serial cho env:native: in thẳng ra stdout
+// ======================================================
+
+class Print {
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size) {
+        size_t n = 0;
+        while (size--) {
+            n += write(*buffer++);
+        }
+        return n;
+    }
+    size_t write(const char *s) { return s ? write((const uint8_t *)s, strlen(s)) : 0; }
+
+    int printf(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+        char buffer[512];
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        if (n > 0) {
+            write((const uint8_t *)buffer, (size_t)n < sizeof(buffer) ? (size_t)n : sizeof(buffer) - 1);
+        }
+        return n;
+    }
+
+    size_t print(const char *s) { return write(s); }
+    size_t print(const String &s) { return write(s.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v) { return printf("%d", v); }
+    size_t print(unsigned int v) { return printf("%u", v); }
+    size_t print(long v) { return printf("%ld", v); }
+    size_t print(unsigned long v) { return printf("%lu", v); }
+    size_t print(double v, int decimals = 2) { return printf("%.*f", decimals, v); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T &v) {
+        size_t n = print(v);
+        return n + println();
+    }
+};
+
+class HardwareSerial : public Print {
+public:
+    using Print::write;
+
+    void begin(unsigned long) {}
+    int available() { return 0; }
+    int read() { return -1; }
+    void flush() { fflush(stdout); }
+    size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+    size_t write(const uint8_t *buffer, size_t size) override { return fwrite(buffer, 1, size, stdout); }
+};
+
+inline HardwareSerial Serial;
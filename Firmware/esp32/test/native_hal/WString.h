@@ -0,0 +1,123 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+// ======================================================
+// 🧪 String của Arduino cho env:native, bọc std::string
+// ======================================================
+//
+// Chỉ các hàm lib/ và ArduinoJson (ARDUINOJSON_ENABLE_ARDUINO_STRING) dùng:
+// c_str/length để đọc, concat để serializeJson ghi vào, gán nullptr = rỗng.
+
+class String {
+public:
+    String() {}
+    String(const char *s) : s(s ? s : "") {}
+    String(const char *s, size_t length) : s(s ? std::string(s, length) : std::string()) {}
+    String(const std::string &s) : s(s) {}
+    explicit String(char c) : s(1, c) {}
+    String(int v) : s(std::to_string(v)) {}
+    String(unsigned int v) : s(std::to_string(v)) {}
+    String(long v) : s(std::to_string(v)) {}
+    String(unsigned long v) : s(std::to_string(v)) {}
+    String(long long v) : s(std::to_string(v)) {}
+    String(unsigned long long v) : s(std::to_string(v)) {}
+    String(double v, unsigned int decimals = 2) {
+        char buffer[48];
+        snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, v);
+        s = buffer;
+    }
+
+    String &operator=(const char *c) {
+        s = c ? c : "";
+        return *this;
+    }
+
+    const char *c_str() const { return s.c_str(); }
+    unsigned int length() const { return (unsigned int)s.size(); }
+    bool isEmpty() const { return s.empty(); }
+    bool reserve(unsigned int size) {
+        s.reserve(size);
+        return true;
+    }
+
+    bool concat(const String &o) {
+        s += o.s;
+        return true;
+    }
+    bool concat(const char *c) {
+        if (c != nullptr) {
+            s += c;
+        }
+        return c != nullptr;
+    }
+    bool concat(const char *c, unsigned int length) {
+        if (c != nullptr) {
+            s.append(c, length);
+        }
+        return c != nullptr;
+    }
+    bool concat(char c) {
+        s += c;
+        return true;
+    }
+    bool concat(int v) { return concat(String(v)); }
+    bool concat(unsigned int v) { return concat(String(v)); }
+    bool concat(long v) { return concat(String(v)); }
+    bool concat(unsigned long v) { return concat(String(v)); }
+    bool concat(double v) { return concat(String(v)); }
+
+    template <typename T>
+    String &operator+=(const T &v) {
+        concat(v);
+        return *this;
+    }
+
+    char operator[](unsigned int i) const { return i < s.size() ? s[i] : 0; }
+    bool operator==(const String &o) const { return s == o.s; }
+    bool operator==(const char *c) const { return s == (c ? c : ""); }
+    bool operator!=(const String &o) const { return s != o.s; }
+    bool operator!=(const char *c) const { return !(*this == c); }
+    bool equals(const String &o) const { return s == o.s; }
+
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t i = s.find(c, from);
+        return i == std::string::npos ? -1 : (int)i;
+    }
+    int indexOf(const String &o, unsigned int from = 0) const {
+        size_t i = s.find(o.s, from);
+        return i == std::string::npos ? -1 : (int)i;
+    }
+    bool startsWith(const String &o) const { return s.compare(0, o.s.size(), o.s) == 0; }
+    String substring(unsigned int from) const { return from < s.size() ? String(s.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        return from < to && from < s.size() ? String(s.substr(from, to - from)) : String();
+    }
+    long toInt() const { return strtol(s.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(s.c_str(), nullptr); }
+
+private:
+    std::string s;
+};
+
+// Kiểu trung gian của phép + như trong core Arduino (ArduinoJson có nhắc tới)
+class StringSumHelper : public String {
+public:
+    StringSumHelper(const String &s) : String(s) {}
+};
+
+template <typename T>
+inline StringSumHelper operator+(const String &a, const T &b) {
+    String out(a);
+    out.concat(b);
+    return out;
+}
+
+inline StringSumHelper operator+(const char *a, const String &b) {
+    String out(a);
+    out.concat(b);
+    return out;
+}
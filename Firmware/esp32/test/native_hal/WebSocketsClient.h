@@ -0,0 +1,154 @@
+#pragma once
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+
+// ======================================================
+// 🧪 WebSocketsClient (links2004) giả cho env:native
+// ======================================================
+//
+// Không có socket: message gửi đi được giữ trong sentText/sentBinary, còn
+// phía server do test đóng vai qua serverOpen/serverText/serverBinary/
+// serverClose, gọi thẳng callback onEvent như vòng loop() thật.
+// WebSocketClient giữ object này là thành viên private, nên test lấy nó qua
+// WebSocketsClient::last() (object được tạo gần nhất).
+
+typedef enum {
+    WStype_ERROR,
+    WStype_DISCONNECTED,
+    WStype_CONNECTED,
+    WStype_TEXT,
+    WStype_BIN,
+    WStype_FRAGMENT_TEXT_START,
+    WStype_FRAGMENT_BIN_START,
+    WStype_FRAGMENT,
+    WStype_FRAGMENT_FIN,
+    WStype_PING,
+    WStype_PONG,
+} WStype_t;
+
+class WebSocketsClient {
+public:
+    typedef void (*WebSocketClientEvent)(WStype_t type, uint8_t *payload, size_t length);
+
+    WebSocketsClient() : event(nullptr), connected(false), failSends(false), pings(0), began(false) {
+        current() = this;
+    }
+    ~WebSocketsClient() {
+        if (current() == this) {
+            current() = nullptr;
+        }
+    }
+
+    static WebSocketsClient *last() { return current(); }
+
+    void begin(const char *host, uint16_t port, const char *url = "/", const char *protocol = "arduino") {
+        (void)url;
+        (void)protocol;
+        this->host = host;
+        this->port = port;
+        began = true;
+    }
+    void begin(const String &host, uint16_t port, const String &url = "/", const String &protocol = "arduino") {
+        begin(host.c_str(), port, url.c_str(), protocol.c_str());
+    }
+    void beginSslWithCA(const char *host, uint16_t port, const char *url = "/", const char *CA_cert = nullptr,
+                        const char *protocol = "arduino") {
+        caCert = CA_cert;
+        begin(host, port, url, protocol);
+    }
+    void onEvent(WebSocketClientEvent cb) { event = cb; }
+    void loop() {}
+    void setReconnectInterval(unsigned long) {}
+    void enableHeartbeat(uint32_t, uint32_t, uint8_t) {}
+    bool isConnected() { return connected; }
+    void disconnect() {
+        if (connected) {
+            serverClose();
+        }
+    }
+
+    bool sendTXT(const char *payload, size_t length = 0) {
+        if (!connected || failSends) {
+            return false;
+        }
+        sentText.emplace_back(payload, length ? length : strlen(payload));
+        return true;
+    }
+    bool sendTXT(char *payload, size_t length = 0, bool headerToPayload = false) {
+        (void)headerToPayload;
+        return sendTXT((const char *)payload, length);
+    }
+    bool sendTXT(const uint8_t *payload, size_t length = 0) { return sendTXT((const char *)payload, length); }
+    bool sendTXT(uint8_t *payload, size_t length = 0, bool headerToPayload = false) {
+        (void)headerToPayload;
+        return sendTXT((const char *)payload, length);
+    }
+    bool sendTXT(String &payload) { return sendTXT(payload.c_str(), payload.length()); }
+
+    bool sendBIN(const uint8_t *payload, size_t length) {
+        if (!connected || failSends) {
+            return false;
+        }
+        sentBinary.emplace_back(payload, payload + length);
+        return true;
+    }
+    bool sendBIN(uint8_t *payload, size_t length, bool headerToPayload = false) {
+        (void)headerToPayload;
+        return sendBIN((const uint8_t *)payload, length);
+    }
+    bool sendPing(uint8_t *payload = nullptr, size_t length = 0) {
+        (void)payload;
+        (void)length;
+        if (!connected) {
+            return false;
+        }
+        pings++;
+        return true;
+    }
+
+    // ---- phía server, gọi từ test ----
+    void serverOpen() {
+        connected = true;
+        emit(WStype_CONNECTED, (const uint8_t *)"/", 1);
+    }
+    void serverText(const char *json) { emit(WStype_TEXT, (const uint8_t *)json, strlen(json)); }
+    void serverBinary(const uint8_t *payload, size_t length) { emit(WStype_BIN, payload, length); }
+    void serverPong() { emit(WStype_PONG, nullptr, 0); }
+    void serverClose() {
+        connected = false;
+        emit(WStype_DISCONNECTED, nullptr, 0);
+    }
+    void clearSent() {
+        sentText.clear();
+        sentBinary.clear();
+    }
+
+    std::string host;
+    uint16_t port = 0;
+    const char *caCert = nullptr;           // beginSslWithCA(): wss://
+    WebSocketClientEvent event;
+    bool connected;
+    bool failSends;                         // true: mọi lần gửi trả về false (socket nghẽn)
+    uint32_t pings;
+    bool began;
+    std::vector<std::string> sentText;
+    std::vector<std::vector<uint8_t>> sentBinary;
+
+private:
+    static WebSocketsClient *&current() {
+        static WebSocketsClient *client = nullptr;
+        return client;
+    }
+
+    // Payload chép ra buffer riêng có '\0' cuối, như thư viện thật
+    void emit(WStype_t type, const uint8_t *payload, size_t length) {
+        if (event == nullptr) {
+            return;
+        }
+        std::vector<uint8_t> copy(payload, payload + length);
+        copy.push_back(0);
+        event(type, copy.data(), length);
+    }
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ======================================================
+// 🧪 Driver ADC1 oneshot giả cho env:native
+// ======================================================
+//
+// adc1_get_raw đọc giá trị test đặt bằng hal::setAnalog() trên chân của kênh,
+// và đếm số lần đọc để kiểm tra oversampling.
+
+typedef int esp_err_t;
+#define ESP_OK 0
+
+typedef enum {
+    ADC1_CHANNEL_0 = 0,
+    ADC1_CHANNEL_1,
+    ADC1_CHANNEL_2,
+    ADC1_CHANNEL_3,
+    ADC1_CHANNEL_4,
+    ADC1_CHANNEL_5,
+    ADC1_CHANNEL_6,
+    ADC1_CHANNEL_7,
+    ADC1_CHANNEL_MAX
+} adc1_channel_t;
+
+typedef enum { ADC_ATTEN_DB_0 = 0, ADC_ATTEN_DB_2_5, ADC_ATTEN_DB_6, ADC_ATTEN_DB_11 } adc_atten_t;
+typedef enum { ADC_WIDTH_BIT_9 = 0, ADC_WIDTH_BIT_10, ADC_WIDTH_BIT_11, ADC_WIDTH_BIT_12 } adc_bits_width_t;
+typedef enum { ADC_UNIT_1 = 1, ADC_UNIT_2 = 2 } adc_unit_t;
+
+namespace hal {
+
+inline uint32_t &adcReads() {
+    static uint32_t reads = 0;
+    return reads;
+}
+
+inline uint8_t adc1ChannelPin(adc1_channel_t channel) {
+    static const uint8_t pins[ADC1_CHANNEL_MAX] = { 36, 37, 38, 39, 32, 33, 34, 35 };
+    return channel < ADC1_CHANNEL_MAX ? pins[channel] : 0;
+}
+
+}  // namespace hal
+
+inline esp_err_t adc1_config_width(adc_bits_width_t) { return ESP_OK; }
+inline esp_err_t adc1_config_channel_atten(adc1_channel_t, adc_atten_t) { return ESP_OK; }
+
+inline int adc1_get_raw(adc1_channel_t channel) {
+    hal::adcReads()++;
+    return analogRead(hal::adc1ChannelPin(channel));
+}
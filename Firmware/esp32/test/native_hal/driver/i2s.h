@@ -0,0 +1,122 @@
+#pragma once
+
+#include <Arduino.h>
+#include <vector>
+
+// ======================================================
+// 🧪 Driver I2S legacy giả cho env:native
+// ======================================================
+//
+// i2s_read lấy byte từ hal::i2sRx() (test nạp trước), hết dữ liệu thì trả về
+// im lặng thay vì chặn như portMAX_DELAY trên chip. i2s_write ghi vào
+// hal::i2sTx() để test kiểm tra dữ liệu phát ra loa.
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_INTR_FLAG_LEVEL1 (1 << 1)
+#define I2S_PIN_NO_CHANGE (-1)
+
+typedef enum { I2S_NUM_0 = 0, I2S_NUM_1 = 1, I2S_NUM_MAX } i2s_port_t;
+typedef enum {
+    I2S_MODE_MASTER = 1,
+    I2S_MODE_SLAVE = 2,
+    I2S_MODE_TX = 4,
+    I2S_MODE_RX = 8,
+} i2s_mode_t;
+typedef enum { I2S_BITS_PER_SAMPLE_16BIT = 16, I2S_BITS_PER_SAMPLE_32BIT = 32 } i2s_bits_per_sample_t;
+typedef enum {
+    I2S_CHANNEL_FMT_RIGHT_LEFT,
+    I2S_CHANNEL_FMT_ALL_RIGHT,
+    I2S_CHANNEL_FMT_ALL_LEFT,
+    I2S_CHANNEL_FMT_ONLY_RIGHT,
+    I2S_CHANNEL_FMT_ONLY_LEFT,
+} i2s_channel_fmt_t;
+typedef enum { I2S_COMM_FORMAT_STAND_I2S = 1, I2S_COMM_FORMAT_I2S = 1 } i2s_comm_format_t;
+typedef enum { I2S_CHANNEL_MONO = 1, I2S_CHANNEL_STEREO = 2 } i2s_channel_t;
+typedef enum { I2S_EVENT_DMA_ERROR, I2S_EVENT_TX_DONE, I2S_EVENT_RX_DONE, I2S_EVENT_TX_Q_OVF, I2S_EVENT_RX_Q_OVF } i2s_event_type_t;
+
+typedef struct {
+    i2s_mode_t mode;
+    int sample_rate;
+    i2s_bits_per_sample_t bits_per_sample;
+    i2s_channel_fmt_t channel_format;
+    i2s_comm_format_t communication_format;
+    int intr_alloc_flags;
+    int dma_buf_count;
+    int dma_buf_len;
+    bool use_apll;
+    bool tx_desc_auto_clear;
+    int fixed_mclk;
+} i2s_config_t;
+
+typedef struct {
+    int bck_io_num;
+    int ws_io_num;
+    int data_out_num;
+    int data_in_num;
+} i2s_pin_config_t;
+
+typedef struct {
+    i2s_event_type_t type;
+    size_t size;
+} i2s_event_t;
+
+namespace hal {
+inline std::vector<uint8_t> &i2sRx() {
+    static std::vector<uint8_t> bytes;
+    return bytes;
+}
+inline std::vector<uint8_t> &i2sTx() {
+    static std::vector<uint8_t> bytes;
+    return bytes;
+}
+inline int &i2sSampleRate() {
+    static int rate = 0;
+    return rate;
+}
+// Nạp mẫu 32-bit như micro đẩy ra DMA
+inline void i2sFeed(const int32_t *samples, size_t count) {
+    const uint8_t *bytes = (const uint8_t *)samples;
+    i2sRx().insert(i2sRx().end(), bytes, bytes + count * sizeof(int32_t));
+}
+}  // namespace hal
+
+inline esp_err_t i2s_driver_install(i2s_port_t, const i2s_config_t *config, int, void *queue) {
+    hal::i2sSampleRate() = config->sample_rate;
+    if (queue) {
+        *(QueueHandle_t *)queue = nullptr;
+    }
+    return ESP_OK;
+}
+inline esp_err_t i2s_driver_uninstall(i2s_port_t) { return ESP_OK; }
+inline esp_err_t i2s_set_pin(i2s_port_t, const i2s_pin_config_t *) { return ESP_OK; }
+inline esp_err_t i2s_set_clk(i2s_port_t, uint32_t rate, uint32_t, i2s_channel_t) {
+    hal::i2sSampleRate() = (int)rate;
+    return ESP_OK;
+}
+inline esp_err_t i2s_set_sample_rates(i2s_port_t, uint32_t rate) {
+    hal::i2sSampleRate() = (int)rate;
+    return ESP_OK;
+}
+inline esp_err_t i2s_start(i2s_port_t) { return ESP_OK; }
+inline esp_err_t i2s_stop(i2s_port_t) { return ESP_OK; }
+inline esp_err_t i2s_zero_dma_buffer(i2s_port_t) { return ESP_OK; }
+
+inline esp_err_t i2s_read(i2s_port_t, void *dest, size_t size, size_t *bytesRead, TickType_t) {
+    std::vector<uint8_t> &rx = hal::i2sRx();
+    size_t n = std::min(size, rx.size());
+    memcpy(dest, rx.data(), n);
+    memset((uint8_t *)dest + n, 0, size - n);
+    rx.erase(rx.begin(), rx.begin() + n);
+    *bytesRead = size;
+    return ESP_OK;
+}
+
+inline esp_err_t i2s_write(i2s_port_t, const void *src, size_t size, size_t *bytesWritten, TickType_t) {
+    const uint8_t *bytes = (const uint8_t *)src;
+    hal::i2sTx().insert(hal::i2sTx().end(), bytes, bytes + size);
+    *bytesWritten = size;
+    return ESP_OK;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "driver/adc.h"
+
+// ======================================================
+// 🧪 esp_adc_cal giả cho env:native: đường thẳng 0..3100 mV (11 dB), không có eFuse
+// ======================================================
+
+typedef enum {
+    ESP_ADC_CAL_VAL_EFUSE_VREF = 0,
+    ESP_ADC_CAL_VAL_EFUSE_TP = 1,
+    ESP_ADC_CAL_VAL_DEFAULT_VREF = 2
+} esp_adc_cal_value_t;
+
+typedef struct {
+    adc_unit_t adc_num;
+    adc_atten_t atten;
+    adc_bits_width_t bit_width;
+    uint32_t vref;
+} esp_adc_cal_characteristics_t;
+
+inline esp_adc_cal_value_t esp_adc_cal_characterize(adc_unit_t unit, adc_atten_t atten, adc_bits_width_t width,
+                                                    uint32_t defaultVref, esp_adc_cal_characteristics_t *chars) {
+    chars->adc_num = unit;
+    chars->atten = atten;
+    chars->bit_width = width;
+    chars->vref = defaultVref;
+    return ESP_ADC_CAL_VAL_DEFAULT_VREF;
+}
+
+inline uint32_t esp_adc_cal_raw_to_voltage(uint32_t raw, const esp_adc_cal_characteristics_t *) {
+    return raw * 3100 / 4095;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+
+// ======================================================
+// 🧪 heap_caps cho env:native: malloc thường, PSRAM giả có dung lượng cố định
+// ======================================================
+
+#define MALLOC_CAP_EXEC (1 << 0)
+#define MALLOC_CAP_32BIT (1 << 1)
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+namespace hal {
+// Con số báo cáo cho heap_caps_get_*: test đặt psramBytes = 0 để giả lập board không có PSRAM
+inline size_t &psramBytes() {
+    static size_t bytes = 4 * 1024 * 1024;
+    return bytes;
+}
+inline size_t &heapBytes() {
+    static size_t bytes = 200 * 1024;
+    return bytes;
+}
+}  // namespace hal
+
+inline void *heap_caps_malloc(size_t size, uint32_t caps) {
+    if ((caps & MALLOC_CAP_SPIRAM) && hal::psramBytes() < size) {
+        return nullptr;
+    }
+    return malloc(size);
+}
+inline void heap_caps_free(void *ptr) { free(ptr); }
+inline size_t heap_caps_get_free_size(uint32_t caps) {
+    return (caps & MALLOC_CAP_SPIRAM) ? hal::psramBytes() : hal::heapBytes();
+}
+inline size_t heap_caps_get_minimum_free_size(uint32_t caps) { return heap_caps_get_free_size(caps); }
+inline size_t heap_caps_get_largest_free_block(uint32_t caps) { return heap_caps_get_free_size(caps); }
@@ -0,0 +1,6 @@
+#pragma once
+
+// Khớp IDF của Arduino core 2.x mà env:esp32doit-devkit-v1 đang dùng
+#define ESP_IDF_VERSION_MAJOR 4
+#define ESP_IDF_VERSION_MINOR 4
+#define ESP_IDF_VERSION_PATCH 0
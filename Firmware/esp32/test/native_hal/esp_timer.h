@@ -0,0 +1,6 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Cùng đồng hồ giả với micros(), nhưng 64 bit như trên chip
+inline int64_t esp_timer_get_time() { return (int64_t)hal::state().nowUs; }
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+
+// ======================================================
+// 🧪 FreeRTOS giả cho env:native: một luồng, không scheduler
+// ======================================================
+//
+// Đoạn găng và mutex là no-op; tạo task/queue luôn thất bại để code rơi về nhánh
+// đồng bộ. vTaskDelay được định nghĩa trong Arduino.h (tua đồng hồ giả).
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void *TaskHandle_t;
+typedef void *QueueHandle_t;
+typedef void *SemaphoreHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY 0xFFFFFFFFu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define configMAX_PRIORITIES 25
+#define portYIELD_FROM_ISR(...)
+
+typedef struct {
+    int owner;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux))
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char *, uint32_t, void *, UBaseType_t,
+                                          TaskHandle_t *handle, BaseType_t) {
+    if (handle) {
+        *handle = nullptr;
+    }
+    return pdFAIL;
+}
+inline void vTaskDelete(TaskHandle_t) {}
+inline BaseType_t xPortGetCoreID() { return 1; }
+
+inline QueueHandle_t xQueueCreate(UBaseType_t, UBaseType_t) { return nullptr; }
+inline BaseType_t xQueueSend(QueueHandle_t, const void *, TickType_t) { return pdFAIL; }
+inline BaseType_t xQueueReceive(QueueHandle_t, void *, TickType_t) { return pdFAIL; }
+
+inline SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() { return nullptr; }
+inline BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t, TickType_t) { return pdTRUE; }
+inline BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t) { return pdTRUE; }
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <Arduino.h>
+
+// CCOUNT suy từ đồng hồ giả: CycleTimer đo ra đúng số µs test đã tua
+inline uint32_t esp_cpu_get_ccount() { return (uint32_t)(hal::state().nowUs * hal::state().cpuMhz); }
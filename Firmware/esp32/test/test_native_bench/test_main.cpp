@@ -0,0 +1,240 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <chrono>
+#include <vector>
+#include "AudioDsp.h"
+#include "BinaryFrame.h"
+#include "DeltaAnim.h"
+#include "MessageTypes.h"
+#include "Metrics.h"
+#include "MotionSensor.h"
+#include "OutboundQueue.h"
+#include "WebSocketClient.h"
+
+// ======================================================
+// ⏱️ Microbenchmark trên máy host (env:native_bench, -O2, không sanitizer)
+// ======================================================
+//
+// Mỗi hàm chạy theo lô, nhân đôi số lần tới khi một lô tốn >= 50 ms, rồi in
+//   BENCH native name=<tên> ns_op=<ns mỗi lần> iters=<số lần>
+// cùng định dạng với env:bench nên so sánh được bằng tools/bench_compare.py.
+// Số đo trên host chỉ để thấy hồi quy tương đối giữa hai commit, không thay cho
+// số đo trên ESP32.
+
+static volatile uint32_t sink = 0;   // giữ kết quả để -O2 không bỏ vòng lặp
+
+template <typename F>
+static double runBench(const char *name, F fn) {
+    using Clock = std::chrono::steady_clock;
+    const double minNs = 50e6;
+
+    uint64_t iters = 16;
+    double elapsed = 0;
+    for (;;) {
+        Clock::time_point start = Clock::now();
+        for (uint64_t i = 0; i < iters; i++) {
+            fn(i);
+        }
+        elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        if (elapsed >= minNs || iters >= (1ULL << 34)) {
+            break;
+        }
+        iters *= 2;
+    }
+
+    double nsOp = elapsed / (double)iters;
+    printf("BENCH native name=%s ns_op=%.2f iters=%llu\n", name, nsOp, (unsigned long long)iters);
+    return nsOp;
+}
+
+void setUp() {
+    hal::reset(10 * 1000 * 1000);
+}
+
+void tearDown() {}
+
+// ============================================
+// GIAO THỨC
+// ============================================
+
+static WebSocketClient client("localhost", 3000, "robot-bench");
+
+void bench_alert_level() {
+    static const char *const sensors[] = { "temperature", "humidity", "gas", "distance" };
+    double ns = runBench("alert_level", [](uint64_t i) {
+        sink += (uint8_t)client.getAlertLevel(sensors[i & 3], (float)(i % 400));
+    });
+    TEST_ASSERT_TRUE(ns > 0);
+}
+
+void bench_message_type_from_name() {
+    double ns = runBench("message_type_from_name", [](uint64_t i) {
+        MessageType type;
+        sink += messageTypeFromName(MESSAGE_TYPE_NAMES[i % MESSAGE_TYPE_COUNT], type) ? (uint8_t)type : 0xFF;
+    });
+    TEST_ASSERT_TRUE(ns > 0);
+}
+
+void bench_binary_frame_16_records() {
+    static uint8_t buffer[BINARY_MAX_FRAME];
+    double ns = runBench("binary_frame_16", [](uint64_t i) {
+        BinaryFrameWriter frame(buffer, sizeof(buffer));
+        frame.begin(CHANNEL_SENSOR_DATA, (uint16_t)i, (uint32_t)i);
+        for (uint8_t r = 0; r < 16; r++) {
+            frame.addRecord(SENSOR_TEMPERATURE, 0, r, 20.0f + r);
+        }
+        sink += frame.size();
+    });
+    TEST_ASSERT_TRUE(ns > 0);
+    TEST_ASSERT_EQUAL_UINT8(16, buffer[sizeof(FrameHeader)]);
+}
+
+void bench_outbox_cycle() {
+    static OutboundQueue queue;
+    double ns = runBench("outbox_push_batch_ack", [](uint64_t i) {
+        for (uint8_t r = 0; r < 8; r++) {
+            queue.push(OUTBOUND_DATA, SENSOR_HUMIDITY, AlertLevel::NORMAL, 50.0f + r, (uint32_t)i);
+        }
+        uint8_t n = queue.nextBatch(16);
+        queue.markSent(n, (uint32_t)i);
+        queue.ack((uint16_t)(queue.firstPendingSeq() + n - 1));
+        sink += n;
+    });
+    TEST_ASSERT_TRUE(ns > 0);
+    TEST_ASSERT_EQUAL_UINT8(0, queue.pending());
+}
+
+static void benchEncode(const char *name, bool binary) {
+    OutboundQueue &outbox = client.getOutbox();
+    for (uint8_t r = 0; r < 16; r++) {
+        outbox.push(OUTBOUND_DATA, SENSOR_GAS, AlertLevel::NORMAL, 80.0f + r, millis());
+    }
+    static bool isBinary;
+    isBinary = binary;
+    double ns = runBench(name, [](uint64_t) {
+        String output;
+        sink += client.encodeOutboundBatch(16, isBinary, output);
+    });
+    TEST_ASSERT_TRUE(ns > 0);
+    outbox.ack((uint16_t)(outbox.firstPendingSeq() + outbox.pending() - 1));
+}
+
+void bench_encode_batch_json() {
+    benchEncode("encode_batch_16 encoding=json", false);
+}
+
+void bench_encode_batch_bin1() {
+    benchEncode("encode_batch_16 encoding=bin1", true);
+}
+
+// ============================================
+// CẢM BIẾN, MÀN HÌNH, METRICS
+// ============================================
+
+void bench_motion_edge() {
+    static MotionSensor pir(27, 200, "pir");
+    pir.begin();
+    pir.enableInterrupt();
+    double ns = runBench("motion_isr_process", [](uint64_t) {
+        hal::setDigital(27, HIGH);
+        hal::advanceMillis(250);
+        hal::setDigital(27, LOW);
+        sink += pir.isMotionDetected();
+    });
+    pir.disableInterrupt();
+    TEST_ASSERT_TRUE(ns > 0);
+}
+
+// Clip 64x64, tile 16: mỗi tile một run 128 px màu + một run 128 px màu khác
+static std::vector<uint8_t> buildClip() {
+    std::vector<uint8_t> frame;
+    frame.push_back(16);
+    frame.push_back(0);
+    for (uint16_t t = 0; t < 16; t++) {
+        frame.push_back(t & 0xFF);
+        frame.push_back(t >> 8);
+        for (uint8_t run = 0; run < 2; run++) {
+            frame.push_back(0x80 | 127);
+            frame.push_back(0x1F);
+            frame.push_back(run ? 0xF8 : 0x00);
+        }
+    }
+
+    std::vector<uint8_t> blob = { 'H', 'G', 'A', '1', 64, 0, 64, 0, 16, 0, 1, 0 };
+    uint32_t start = DeltaAnim::HEADER_SIZE + 2 * 4;
+    uint32_t end = start + frame.size();
+    for (uint32_t v : { start, end }) {
+        for (uint8_t b = 0; b < 4; b++) {
+            blob.push_back((v >> (8 * b)) & 0xFF);
+        }
+    }
+    blob.insert(blob.end(), frame.begin(), frame.end());
+    return blob;
+}
+
+static bool countTile(int16_t, int16_t, uint16_t w, uint16_t h, uint16_t *pixels) {
+    sink += pixels[w * h - 1];
+    return true;
+}
+
+void bench_delta_decode_frame() {
+    static std::vector<uint8_t> blob = buildClip();
+    static DeltaAnimInfo info;
+    static uint32_t offset, length;
+    TEST_ASSERT_TRUE(DeltaAnim::parseHeader(blob.data(), blob.size(), info));
+    TEST_ASSERT_TRUE(DeltaAnim::frameRange(info, 0, offset, length));
+    TEST_ASSERT_TRUE(DeltaAnim::decodeFrame(info, blob.data() + offset, length, countTile));
+
+    double ns = runBench("delta_decode_64x64", [](uint64_t) {
+        DeltaAnim::decodeFrame(info, blob.data() + offset, length, countTile);
+    });
+    TEST_ASSERT_TRUE(ns > 0);
+}
+
+void bench_histogram_record() {
+    static Histogram *hist = Metrics::histogram("bench.hist");
+    hist->reset();
+    double ns = runBench("histogram_record", [](uint64_t i) {
+        hist->record((uint32_t)(i * 2654435761u) >> 12);
+    });
+    TEST_ASSERT_TRUE(ns > 0);
+    TEST_ASSERT_TRUE(hist->count > 0);
+}
+
+// ============================================
+// DSP ĐƯỜNG THU
+// ============================================
+
+void bench_capture_dsp_block() {
+    static int32_t raw[512];
+    static CaptureDsp dsp;
+    dsp.setDcBlock(true);
+    dsp.setHighPass(80);
+    dsp.setAgc(8000);
+    dsp.begin(16000);
+    double ns = runBench("capture_dsp_512", [](uint64_t i) {
+        for (uint16_t k = 0; k < 512; k++) {
+            raw[k] = (int32_t)(((k * 37 + i) & 0x0FFF) - 0x0800) * (1 << 16);
+        }
+        int16_t *pcm = AudioDsp::convertInPlace(raw, 512, 14);
+        size_t n = dsp.pre(pcm, 512);
+        dsp.post(pcm, n);
+        sink += pcm[n - 1];
+    });
+    TEST_ASSERT_TRUE(ns > 0);
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(bench_alert_level);
+    RUN_TEST(bench_message_type_from_name);
+    RUN_TEST(bench_binary_frame_16_records);
+    RUN_TEST(bench_outbox_cycle);
+    RUN_TEST(bench_encode_batch_json);
+    RUN_TEST(bench_encode_batch_bin1);
+    RUN_TEST(bench_motion_edge);
+    RUN_TEST(bench_delta_decode_frame);
+    RUN_TEST(bench_histogram_record);
+    RUN_TEST(bench_capture_dsp_block);
+    return UNITY_END();
+}
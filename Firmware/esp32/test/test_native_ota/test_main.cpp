@@ -0,0 +1,173 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <vector>
+#include "DeltaPatch.h"
+
+// ======================================================
+// 🧪 Áp patch HGP2 theo stream: các op, đoạn cắt tuỳ ý, patch hỏng
+// ======================================================
+//
+// Patch được dựng tay bằng cùng cách mã hoá op như tools/mkdelta.py, nguồn và
+// đích là vector trong RAM thay cho hai phân vùng OTA.
+
+static std::vector<uint8_t> source;
+static std::vector<uint8_t> target;
+static uint32_t writes = 0;
+static bool failWrites = false;
+
+static void putOp(std::vector<uint8_t> &out, uint8_t op, uint32_t n) {
+    uint32_t rest = n >> 5;
+    out.push_back((uint8_t)((op << 6) | (rest ? 0x20 : 0) | (n & 0x1F)));
+    while (rest) {
+        uint8_t b = rest & 0x7F;
+        rest >>= 7;
+        out.push_back(b | (rest ? 0x80 : 0));
+    }
+}
+
+static std::vector<uint8_t> makeHeader(uint32_t sourceSize, uint32_t targetSize) {
+    std::vector<uint8_t> h = { 'H', 'G', 'P', '2' };
+    for (uint32_t v : { sourceSize, targetSize }) {
+        for (uint8_t i = 0; i < 4; i++) {
+            h.push_back((uint8_t)(v >> (8 * i)));
+        }
+    }
+    h.resize(DeltaPatch::HEADER_SIZE, 0xAB);             // SHA, version, chữ ký: DeltaPatch không tự kiểm
+    return h;
+}
+
+static void beginPatch(DeltaPatch &patch, uint32_t targetSize) {
+    std::vector<uint8_t> raw = makeHeader(source.size(), targetSize);
+    DeltaPatch::Header header;
+    TEST_ASSERT_TRUE(DeltaPatch::parseHeader(raw.data(), raw.size(), header));
+    target.clear();
+    writes = 0;
+    patch.begin(header,
+                [](uint32_t offset, uint8_t *dst, size_t length) {
+                    if (offset + length > source.size()) {
+                        return false;
+                    }
+                    memcpy(dst, source.data() + offset, length);
+                    return true;
+                },
+                [](const uint8_t *data, size_t length) {
+                    writes++;
+                    target.insert(target.end(), data, data + length);
+                    return !failWrites;
+                });
+}
+
+void setUp() {
+    source.resize(3000);
+    for (size_t i = 0; i < source.size(); i++) {
+        source[i] = (uint8_t)(i * 7 + (i >> 8));
+    }
+    failWrites = false;
+}
+
+void tearDown() {}
+
+// COPY 2000 | ADD 500 (+1) | INSERT 3 | SEEK -2500 | COPY 100  -> 2603 byte đích
+static std::vector<uint8_t> mixedOps() {
+    std::vector<uint8_t> ops;
+    putOp(ops, DeltaPatch::OP_COPY, 2000);
+    putOp(ops, DeltaPatch::OP_ADD, 500);
+    ops.insert(ops.end(), 500, 1);
+    putOp(ops, DeltaPatch::OP_INSERT, 3);
+    ops.insert(ops.end(), { 'a', 'b', 'c' });
+    putOp(ops, DeltaPatch::OP_SEEK, 2 * 2500 - 1);       // zigzag(-2500)
+    putOp(ops, DeltaPatch::OP_COPY, 100);
+    return ops;
+}
+
+static void assertMixedTarget() {
+    TEST_ASSERT_EQUAL(2603, target.size());
+    TEST_ASSERT_EQUAL_MEMORY(source.data(), target.data(), 2000);
+    for (size_t i = 2000; i < 2500; i++) {
+        TEST_ASSERT_EQUAL_UINT8((uint8_t)(source[i] + 1), target[i]);
+    }
+    TEST_ASSERT_EQUAL_MEMORY("abc", target.data() + 2500, 3);
+    TEST_ASSERT_EQUAL_MEMORY(source.data(), target.data() + 2503, 100);
+}
+
+void test_patch_applies_all_ops() {
+    DeltaPatch patch;
+    std::vector<uint8_t> ops = mixedOps();
+    beginPatch(patch, 2603);
+    TEST_ASSERT_EQUAL(DeltaPatch::PATCH_DONE, patch.feed(ops.data(), ops.size()));
+    TEST_ASSERT_EQUAL_UINT32(ops.size(), patch.getConsumed());
+    TEST_ASSERT_EQUAL_UINT32(3, writes);                 // 1024 + 1024 + 555
+    assertMixedTarget();
+}
+
+void test_patch_survives_any_split() {
+    std::vector<uint8_t> ops = mixedOps();
+    for (size_t chunk : { (size_t)1, (size_t)2, (size_t)7, (size_t)129 }) {
+        DeltaPatch patch;
+        beginPatch(patch, 2603);
+        DeltaPatch::Status status = DeltaPatch::PATCH_OK;
+        for (size_t i = 0; i < ops.size(); i += chunk) {
+            TEST_ASSERT_EQUAL(DeltaPatch::PATCH_OK, status);
+            status = patch.feed(ops.data() + i, min(chunk, ops.size() - i));
+        }
+        TEST_ASSERT_EQUAL(DeltaPatch::PATCH_DONE, status);
+        assertMixedTarget();
+    }
+}
+
+void test_patch_rejects_bad_input() {
+    DeltaPatch::Header header;
+    std::vector<uint8_t> raw = makeHeader(10, 10);
+    TEST_ASSERT_TRUE(DeltaPatch::parseHeader(raw.data(), raw.size(), header));
+    TEST_ASSERT_EQUAL_HEX32(0xABABABAB, header.version);
+    TEST_ASSERT_EQUAL_HEX8(0xAB, header.signature[63]);
+    raw[3] = '1';                                        // định dạng cũ không có chữ ký
+    TEST_ASSERT_FALSE(DeltaPatch::parseHeader(raw.data(), raw.size(), header));
+    raw = makeHeader(10, 10);
+    TEST_ASSERT_FALSE(DeltaPatch::parseHeader(raw.data(), raw.size() - 1, header));
+
+    DeltaPatch patch;
+    std::vector<uint8_t> ops;
+    putOp(ops, DeltaPatch::OP_COPY, 3001);               // quá ảnh nguồn
+    beginPatch(patch, 4000);
+    TEST_ASSERT_EQUAL(DeltaPatch::PATCH_ERR_SOURCE, patch.feed(ops.data(), ops.size()));
+
+    ops.clear();
+    putOp(ops, DeltaPatch::OP_SEEK, 1);                  // lùi trước byte 0
+    beginPatch(patch, 10);
+    TEST_ASSERT_EQUAL(DeltaPatch::PATCH_ERR_SOURCE, patch.feed(ops.data(), ops.size()));
+
+    ops.clear();
+    putOp(ops, DeltaPatch::OP_INSERT, 11);               // quá targetSize
+    beginPatch(patch, 10);
+    TEST_ASSERT_EQUAL(DeltaPatch::PATCH_ERR_OVERFLOW, patch.feed(ops.data(), ops.size()));
+
+    ops.clear();
+    putOp(ops, DeltaPatch::OP_COPY, 10);
+    ops.push_back(0);                                    // thừa sau op cuối
+    beginPatch(patch, 10);
+    TEST_ASSERT_EQUAL(DeltaPatch::PATCH_ERR_CORRUPT, patch.feed(ops.data(), ops.size()));
+
+    ops = { 0x3F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };        // varint quá 32 bit
+    beginPatch(patch, 10);
+    TEST_ASSERT_EQUAL(DeltaPatch::PATCH_ERR_CORRUPT, patch.feed(ops.data(), ops.size()));
+}
+
+void test_patch_reports_write_failure() {
+    DeltaPatch patch;
+    std::vector<uint8_t> ops;
+    putOp(ops, DeltaPatch::OP_COPY, 10);
+    failWrites = true;
+    beginPatch(patch, 10);
+    TEST_ASSERT_EQUAL(DeltaPatch::PATCH_ERR_WRITE, patch.feed(ops.data(), ops.size()));
+    TEST_ASSERT_EQUAL(DeltaPatch::PATCH_ERR_WRITE, patch.status());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_patch_applies_all_ops);
+    RUN_TEST(test_patch_survives_any_split);
+    RUN_TEST(test_patch_rejects_bad_input);
+    RUN_TEST(test_patch_reports_write_failure);
+    return UNITY_END();
+}
@@ -0,0 +1,246 @@
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <unity.h>
+#include "BinaryFrame.h"
+#include "MessageTypes.h"
+#include "OutboundQueue.h"
+
+// ======================================================
+// 🧪 Bảng tên message, frame bin1 và hàng đợi gửi tin cậy (seq/ack/spill)
+// ======================================================
+
+void setUp() {
+    hal::reset(5000 * 1000);
+    LittleFS.format();
+}
+
+void tearDown() {}
+
+static void pushData(OutboundQueue &queue, uint8_t n, float base = 20.0f) {
+    for (uint8_t i = 0; i < n; i++) {
+        TEST_ASSERT_TRUE(queue.push(OUTBOUND_DATA, SENSOR_TEMPERATURE, AlertLevel::NORMAL, base + i, millis()));
+    }
+}
+
+// ============================================
+// MESSAGE TYPES
+// ============================================
+
+void test_message_type_names_round_trip() {
+    for (uint8_t i = 0; i < MESSAGE_TYPE_COUNT; i++) {
+        MessageType type;
+        TEST_ASSERT_TRUE(messageTypeFromName(messageTypeName((MessageType)i), type));
+        TEST_ASSERT_EQUAL_UINT8(i, (uint8_t)type);
+    }
+}
+
+void test_message_type_rejects_unknown_names() {
+    MessageType type = MessageType::ACK;
+    TEST_ASSERT_FALSE(messageTypeFromName(nullptr, type));
+    TEST_ASSERT_FALSE(messageTypeFromName("", type));
+    TEST_ASSERT_FALSE(messageTypeFromName("sensor_dat", type));
+    TEST_ASSERT_FALSE(messageTypeFromName("SENSOR_DATA", type));
+    TEST_ASSERT_FALSE(messageTypeFromName("heartbeats", type));
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)MessageType::ACK, (uint8_t)type);
+    TEST_ASSERT_EQUAL_STRING("unknown", messageTypeName((MessageType)MESSAGE_TYPE_COUNT));
+    TEST_ASSERT_EQUAL_STRING("critical", alertLevelName(AlertLevel::CRITICAL));
+}
+
+// ============================================
+// BINARY FRAME
+// ============================================
+
+void test_binary_frame_layout() {
+    uint8_t buffer[BINARY_MAX_FRAME];
+    BinaryFrameWriter frame(buffer, sizeof(buffer));
+    frame.begin(CHANNEL_SENSOR_DATA, 0xBEEF, 0x01020304);
+    TEST_ASSERT_TRUE(frame.addRecord(SENSOR_GAS, (uint8_t)AlertLevel::DANGER, 250, 231.5f));
+    TEST_ASSERT_TRUE(frame.addRecord(SENSOR_HUMIDITY, (uint8_t)AlertLevel::NORMAL, 0, 55.0f));
+    TEST_ASSERT_EQUAL(sizeof(FrameHeader) + 1 + 2 * sizeof(SensorRecord), frame.size());
+
+    const uint8_t header[] = { BINARY_VERSION, CHANNEL_SENSOR_DATA, 0xEF, 0xBE, 0x04, 0x03, 0x02, 0x01, 2 };
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(header, buffer, sizeof(header));
+
+    SensorRecord record;
+    memcpy(&record, buffer + sizeof(header), sizeof(record));
+    TEST_ASSERT_EQUAL_UINT8(SENSOR_GAS, record.sensor);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)AlertLevel::DANGER, record.level);
+    TEST_ASSERT_EQUAL_UINT16(250, record.ageMs);
+    TEST_ASSERT_EQUAL_FLOAT(231.5f, record.value);
+}
+
+void test_binary_frame_stops_at_capacity() {
+    uint8_t buffer[BINARY_MAX_FRAME];
+    BinaryFrameWriter frame(buffer, sizeof(buffer));
+    frame.begin(CHANNEL_SENSOR_DATA, 1, 0);
+    uint8_t added = 0;
+    while (frame.addRecord(SENSOR_TEMPERATURE, 0, 0, 1.0f)) {
+        added++;
+    }
+    TEST_ASSERT_EQUAL_UINT8(BINARY_MAX_RECORDS, added);
+    TEST_ASSERT_EQUAL_UINT8(BINARY_MAX_RECORDS, buffer[sizeof(FrameHeader)]);
+    TEST_ASSERT_LESS_OR_EQUAL(BINARY_MAX_FRAME, frame.size());
+}
+
+void test_audio_codec_names() {
+    TEST_ASSERT_EQUAL(AUDIO_IMA_ADPCM, audioCodecFromName("adpcm"));
+    TEST_ASSERT_EQUAL(AUDIO_PCM16, audioCodecFromName("mp3"));
+    TEST_ASSERT_EQUAL(AUDIO_PCM16, audioCodecFromName(nullptr));
+    TEST_ASSERT_EQUAL_STRING("pcm16", audioCodecName(0x7F));
+}
+
+// ============================================
+// OUTBOUND QUEUE
+// ============================================
+
+void test_outbox_seq_is_contiguous_and_acks_are_cumulative() {
+    OutboundQueue queue;
+    queue.setOnline(true);
+    uint16_t first = queue.firstPendingSeq();
+    pushData(queue, 5);
+    for (uint8_t i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_UINT16((uint16_t)(first + i), queue.unsent(i).seq);
+    }
+
+    TEST_ASSERT_EQUAL_UINT8(5, queue.nextBatch(16));
+    queue.markSent(5, millis());
+    TEST_ASSERT_EQUAL_UINT8(0, queue.unsentCount());
+    TEST_ASSERT_FALSE(queue.canSend());
+
+    queue.ack((uint16_t)(first + 2));
+    TEST_ASSERT_EQUAL_UINT8(2, queue.pending());
+    TEST_ASSERT_EQUAL_UINT16((uint16_t)(first + 3), queue.firstPendingSeq());
+    queue.ack((uint16_t)(first + 1));                   // ack cũ: không đổi gì
+    TEST_ASSERT_EQUAL_UINT8(2, queue.pending());
+    queue.ack((uint16_t)(first + 4));
+    TEST_ASSERT_EQUAL_UINT8(0, queue.pending());
+    TEST_ASSERT_EQUAL_UINT32(5, queue.getAcked());
+}
+
+void test_outbox_seq_wraps_around() {
+    // seq đầu là ngẫu nhiên: đẩy/ack từng mục tới sát 0xFFFF
+    OutboundQueue queue;
+    queue.setOnline(true);
+    while (queue.firstPendingSeq() != 0xFFFE) {
+        pushData(queue, 1);
+        queue.markSent(1, millis());
+        queue.ack(queue.firstPendingSeq());
+    }
+
+    pushData(queue, 4);                                  // 0xFFFE, 0xFFFF, 0, 1
+    TEST_ASSERT_EQUAL_UINT8(4, queue.nextBatch(16));
+    queue.markSent(4, millis());
+    queue.ack(0);
+    TEST_ASSERT_EQUAL_UINT8(1, queue.pending());
+    TEST_ASSERT_EQUAL_UINT16(1, queue.firstPendingSeq());
+}
+
+void test_outbox_alerts_go_alone_and_survive_eviction() {
+    OutboundQueue queue;
+    queue.setOnline(true);
+    pushData(queue, 3);
+    TEST_ASSERT_TRUE(queue.push(OUTBOUND_ALERT, SENSOR_FLAME, AlertLevel::CRITICAL, 1.0f, millis(), 120));
+    pushData(queue, OutboundQueue::CAPACITY - 4);
+    TEST_ASSERT_EQUAL_UINT8(OutboundQueue::CAPACITY, queue.pending());
+
+    // Đầy: mẫu dữ liệu cũ nhất bị bỏ, cảnh báo thì không
+    pushData(queue, 3, 100.0f);
+    TEST_ASSERT_EQUAL_UINT32(3, queue.getEvicted());
+    TEST_ASSERT_EQUAL(OUTBOUND_ALERT, queue.unsent(0).kind);
+    TEST_ASSERT_EQUAL_UINT32(120, queue.unsent(0).latencyUs);
+
+    TEST_ASSERT_EQUAL_UINT8(1, queue.nextBatch(16));
+    queue.markSent(1, millis());
+    TEST_ASSERT_EQUAL_UINT8(16, queue.nextBatch(16));
+}
+
+void test_outbox_batch_respects_window() {
+    OutboundQueue queue;
+    queue.setOnline(true);
+    pushData(queue, 40);
+    queue.markSent(queue.nextBatch(16), millis());
+    queue.markSent(queue.nextBatch(16), millis());
+    TEST_ASSERT_EQUAL_UINT8(0, queue.nextBatch(16));   // 32 mục chờ ack = WINDOW
+    TEST_ASSERT_FALSE(queue.canSend());
+}
+
+void test_outbox_timeout_resends_with_backoff() {
+    OutboundQueue queue;
+    queue.setOnline(true);
+    pushData(queue, 2);
+    queue.markSent(2, millis());
+
+    TEST_ASSERT_FALSE(queue.checkTimeout(millis() + OutboundQueue::RTO_MIN_MS - 1));
+    TEST_ASSERT_TRUE(queue.checkTimeout(millis() + OutboundQueue::RTO_MIN_MS));
+    TEST_ASSERT_EQUAL_UINT8(2, queue.unsentCount());     // go-back-N: gửi lại từ đầu
+    TEST_ASSERT_EQUAL_UINT32(1, queue.getRetransmits());
+
+    queue.markSent(2, millis());
+    TEST_ASSERT_FALSE(queue.checkTimeout(millis() + 2 * OutboundQueue::RTO_MIN_MS - 1));
+    TEST_ASSERT_TRUE(queue.checkTimeout(millis() + 2 * OutboundQueue::RTO_MIN_MS));
+
+    queue.markSent(2, millis());
+    queue.ack(queue.firstPendingSeq());                  // tiến được: rto về mức min
+    TEST_ASSERT_TRUE(queue.checkTimeout(millis() + OutboundQueue::RTO_MIN_MS));
+}
+
+void test_outbox_spills_offline_alerts_across_reboot() {
+    {
+        OutboundQueue queue;
+        TEST_ASSERT_TRUE(queue.enableSpill("/outbox.bin", 4));
+        queue.setOnline(false);
+        for (uint8_t i = 0; i < 5; i++) {
+            TEST_ASSERT_TRUE(queue.push(OUTBOUND_ALERT, SENSOR_MOTION, AlertLevel::DANGER, i, millis()));
+        }
+        TEST_ASSERT_EQUAL_UINT8(0, queue.pending());
+        TEST_ASSERT_EQUAL_UINT16(4, queue.spilled());    // ring 4 bản ghi: bản cũ nhất bị ghi đè
+        TEST_ASSERT_EQUAL_UINT32(1, queue.getDropped());
+    }
+
+    // "Reboot": object mới đọc lại ring từ flash, bootId khác lần trước
+    hal::reset(1000);
+    randomSeed(42);
+    OutboundQueue queue;
+    TEST_ASSERT_TRUE(queue.enableSpill("/outbox.bin", 4));
+    TEST_ASSERT_EQUAL_UINT16(4, queue.spilled());
+    queue.setOnline(true);
+    queue.refillFromSpill();
+    TEST_ASSERT_EQUAL_UINT16(0, queue.spilled());
+    TEST_ASSERT_EQUAL_UINT8(4, queue.pending());
+    for (uint8_t i = 0; i < 4; i++) {
+        const OutboundEntry &e = queue.unsent(i);
+        TEST_ASSERT_EQUAL(OUTBOUND_ALERT, e.kind);
+        TEST_ASSERT_EQUAL_FLOAT(1.0f + i, e.value);
+        TEST_ASSERT_TRUE(e.flags & OUTBOUND_RESTORED);
+    }
+}
+
+void test_outbox_full_of_alerts_without_spill() {
+    OutboundQueue queue;
+    queue.setOnline(true);
+    for (uint8_t i = 0; i < OutboundQueue::CAPACITY; i++) {
+        TEST_ASSERT_TRUE(queue.push(OUTBOUND_ALERT, SENSOR_FLAME, AlertLevel::CRITICAL, 1.0f, millis()));
+    }
+    TEST_ASSERT_FALSE(queue.push(OUTBOUND_ALERT, SENSOR_FLAME, AlertLevel::CRITICAL, 1.0f, millis()));
+    TEST_ASSERT_EQUAL_UINT32(1, queue.getDropped());
+    TEST_ASSERT_FALSE(queue.push(OUTBOUND_DATA, SENSOR_GAS, AlertLevel::NORMAL, 80.0f, millis()));
+    TEST_ASSERT_EQUAL_UINT32(1, queue.getEvicted());
+    TEST_ASSERT_EQUAL_UINT8(OutboundQueue::CAPACITY, queue.pending());
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_message_type_names_round_trip);
+    RUN_TEST(test_message_type_rejects_unknown_names);
+    RUN_TEST(test_binary_frame_layout);
+    RUN_TEST(test_binary_frame_stops_at_capacity);
+    RUN_TEST(test_audio_codec_names);
+    RUN_TEST(test_outbox_seq_is_contiguous_and_acks_are_cumulative);
+    RUN_TEST(test_outbox_seq_wraps_around);
+    RUN_TEST(test_outbox_alerts_go_alone_and_survive_eviction);
+    RUN_TEST(test_outbox_batch_respects_window);
+    RUN_TEST(test_outbox_timeout_resends_with_backoff);
+    RUN_TEST(test_outbox_spills_offline_alerts_across_reboot);
+    RUN_TEST(test_outbox_full_of_alerts_without_spill);
+    return UNITY_END();
+}
@@ -0,0 +1,371 @@
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <unity.h>
+#include <vector>
+#include "DeltaAnim.h"
+#include "FrameCache.h"
+#include "FaceAnimator.h"
+
+// ======================================================
+// 🧪 Chỉ số frame / giải mã HGA1, cache LRU frame và tham số mặt của Screen
+// ======================================================
+
+static const uint16_t WIDTH = 20;            // 2 tile mỗi hàng, tile thứ hai chỉ rộng 4 px
+static const uint16_t HEIGHT = 16;
+static const uint16_t RED = 0x00F8;          // thứ tự byte SPI
+static const uint16_t BLUE = 0x1F00;
+
+struct Tile {
+    int16_t x, y;
+    uint16_t w, h;
+    uint16_t first, last;
+};
+
+static std::vector<Tile> tiles;
+static uint8_t stopAfter = 0;
+
+static bool collectTile(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *pixels) {
+    tiles.push_back({ x, y, w, h, pixels[0], pixels[w * h - 1] });
+    return stopAfter == 0 || tiles.size() < stopAfter;
+}
+
+static void putU16(std::vector<uint8_t> &out, uint16_t v) {
+    out.push_back(v & 0xFF);
+    out.push_back(v >> 8);
+}
+
+static void putU32(std::vector<uint8_t> &out, uint32_t v) {
+    putU16(out, v & 0xFFFF);
+    putU16(out, v >> 16);
+}
+
+static void putRun(std::vector<uint8_t> &out, uint8_t n, uint16_t color) {
+    out.push_back(0x80 | (n - 1));
+    out.push_back(color & 0xFF);
+    out.push_back(color >> 8);
+}
+
+// Frame 0: tile 0 đỏ, tile 1 xanh. Frame 1: chỉ tile 1, 4 pixel literal rồi đỏ
+static std::vector<uint8_t> buildClip() {
+    std::vector<uint8_t> frame0, frame1;
+    putU16(frame0, 2);
+    putU16(frame0, 0);
+    putRun(frame0, 128, RED);
+    putRun(frame0, 128, RED);
+    putU16(frame0, 1);
+    putRun(frame0, 64, BLUE);
+
+    putU16(frame1, 1);
+    putU16(frame1, 1);
+    frame1.push_back(3);
+    for (uint16_t i = 0; i < 4; i++) {
+        putU16(frame1, 0x1234 + i);
+    }
+    putRun(frame1, 60, RED);
+
+    std::vector<uint8_t> blob = { 'H', 'G', 'A', '1' };
+    putU16(blob, WIDTH);
+    putU16(blob, HEIGHT);
+    blob.push_back(16);
+    blob.push_back(0);
+    putU16(blob, 2);
+    uint32_t start = DeltaAnim::HEADER_SIZE + 3 * 4;
+    putU32(blob, start);
+    putU32(blob, start + frame0.size());
+    putU32(blob, start + frame0.size() + frame1.size());
+    blob.insert(blob.end(), frame0.begin(), frame0.end());
+    blob.insert(blob.end(), frame1.begin(), frame1.end());
+    return blob;
+}
+
+void setUp() {
+    hal::reset();
+    tiles.clear();
+    stopAfter = 0;
+}
+
+void tearDown() {}
+
+// ============================================
+// DELTA ANIM
+// ============================================
+
+void test_delta_parse_header() {
+    std::vector<uint8_t> blob = buildClip();
+    DeltaAnimInfo info;
+    TEST_ASSERT_TRUE(DeltaAnim::parseHeader(blob.data(), blob.size(), info));
+    TEST_ASSERT_EQUAL_UINT16(WIDTH, info.width);
+    TEST_ASSERT_EQUAL_UINT16(HEIGHT, info.height);
+    TEST_ASSERT_EQUAL_UINT8(16, info.tile);
+    TEST_ASSERT_EQUAL_UINT16(2, info.numFrames);
+
+    TEST_ASSERT_FALSE(DeltaAnim::parseHeader(blob.data(), DeltaAnim::HEADER_SIZE - 1, info));
+    blob[8] = DeltaAnim::MAX_TILE + 1;
+    TEST_ASSERT_FALSE(DeltaAnim::parseHeader(blob.data(), blob.size(), info));
+    blob[8] = 16;
+    blob[0] = 'J';
+    TEST_ASSERT_FALSE(DeltaAnim::parseHeader(blob.data(), blob.size(), info));
+}
+
+void test_delta_frame_range() {
+    std::vector<uint8_t> blob = buildClip();
+    DeltaAnimInfo info;
+    DeltaAnim::parseHeader(blob.data(), blob.size(), info);
+
+    uint32_t offset0, length0, offset1, length1;
+    TEST_ASSERT_TRUE(DeltaAnim::frameRange(info, 0, offset0, length0));
+    TEST_ASSERT_TRUE(DeltaAnim::frameRange(info, 1, offset1, length1));
+    TEST_ASSERT_EQUAL_UINT32(DeltaAnim::HEADER_SIZE + 12, offset0);
+    TEST_ASSERT_EQUAL_UINT32(offset0 + length0, offset1);
+    TEST_ASSERT_EQUAL_UINT32(blob.size(), offset1 + length1);
+
+    uint32_t offset, length;
+    TEST_ASSERT_FALSE(DeltaAnim::frameRange(info, 2, offset, length));
+}
+
+void test_delta_decode_tiles() {
+    std::vector<uint8_t> blob = buildClip();
+    DeltaAnimInfo info;
+    DeltaAnim::parseHeader(blob.data(), blob.size(), info);
+    uint32_t offset, length;
+
+    DeltaAnim::frameRange(info, 0, offset, length);
+    TEST_ASSERT_TRUE(DeltaAnim::decodeFrame(info, blob.data() + offset, length, collectTile));
+    TEST_ASSERT_EQUAL(2, tiles.size());
+    TEST_ASSERT_EQUAL(0, tiles[0].x);
+    TEST_ASSERT_EQUAL_UINT16(16, tiles[0].w);
+    TEST_ASSERT_EQUAL_HEX16(RED, tiles[0].last);
+    TEST_ASSERT_EQUAL(16, tiles[1].x);                   // tile cuối hàng bị cắt theo width
+    TEST_ASSERT_EQUAL_UINT16(4, tiles[1].w);
+    TEST_ASSERT_EQUAL_UINT16(16, tiles[1].h);
+    TEST_ASSERT_EQUAL_HEX16(BLUE, tiles[1].first);
+
+    tiles.clear();
+    DeltaAnim::frameRange(info, 1, offset, length);
+    TEST_ASSERT_TRUE(DeltaAnim::decodeFrame(info, blob.data() + offset, length, collectTile));
+    TEST_ASSERT_EQUAL(1, tiles.size());
+    TEST_ASSERT_EQUAL_HEX16(0x1234, tiles[0].first);
+    TEST_ASSERT_EQUAL_HEX16(RED, tiles[0].last);
+}
+
+void test_delta_rejects_corrupt_frames() {
+    std::vector<uint8_t> blob = buildClip();
+    DeltaAnimInfo info;
+    DeltaAnim::parseHeader(blob.data(), blob.size(), info);
+    uint32_t offset, length;
+    DeltaAnim::frameRange(info, 1, offset, length);
+
+    // Cụt giữa pixel literal
+    TEST_ASSERT_FALSE(DeltaAnim::decodeFrame(info, blob.data() + offset, 8, collectTile));
+    TEST_ASSERT_FALSE(DeltaAnim::decodeFrame(info, blob.data() + offset, 1, collectTile));
+
+    // Run dài hơn số pixel còn lại của tile
+    std::vector<uint8_t> frame(blob.begin() + offset, blob.begin() + offset + length);
+    frame[frame.size() - 3] = 0x80 | 61;
+    TEST_ASSERT_FALSE(DeltaAnim::decodeFrame(info, frame.data(), frame.size(), collectTile));
+    TEST_ASSERT_EQUAL(0, tiles.size());
+
+    // Tile ngoài khung 2x1 (y vượt height -> w/h âm)
+    frame[frame.size() - 3] = 0x80 | 59;
+    frame[2] = 2;
+    TEST_ASSERT_FALSE(DeltaAnim::decodeFrame(info, frame.data(), frame.size(), collectTile));
+    TEST_ASSERT_EQUAL(0, tiles.size());
+
+    // Header: width 0, bảng offset cụt
+    std::vector<uint8_t> bad = blob;
+    bad[4] = 0;
+    TEST_ASSERT_FALSE(DeltaAnim::parseHeader(bad.data(), bad.size(), info));
+    TEST_ASSERT_FALSE(DeltaAnim::parseHeader(blob.data(), DeltaAnim::HEADER_SIZE + 8, info));
+
+    // Offset trỏ ra ngoài blob / ngược chiều
+    TEST_ASSERT_TRUE(DeltaAnim::parseHeader(blob.data(), blob.size() - 1, info));
+    TEST_ASSERT_FALSE(DeltaAnim::frameRange(info, 1, offset, length));
+    bad = blob;
+    bad[DeltaAnim::HEADER_SIZE + 4] = 0;
+    TEST_ASSERT_TRUE(DeltaAnim::parseHeader(bad.data(), bad.size(), info));
+    TEST_ASSERT_FALSE(DeltaAnim::frameRange(info, 0, offset, length));
+    TEST_ASSERT_FALSE(DeltaAnim::frameRange(info, 1, offset, length));
+}
+
+void test_delta_callback_can_stop_early() {
+    std::vector<uint8_t> blob = buildClip();
+    DeltaAnimInfo info;
+    DeltaAnim::parseHeader(blob.data(), blob.size(), info);
+    uint32_t offset, length;
+    DeltaAnim::frameRange(info, 0, offset, length);
+
+    stopAfter = 1;
+    TEST_ASSERT_TRUE(DeltaAnim::decodeFrame(info, blob.data() + offset, length, collectTile));
+    TEST_ASSERT_EQUAL(1, tiles.size());
+}
+
+// ============================================
+// FRAME CACHE
+// ============================================
+
+static const size_t FRAME_BYTES = WIDTH * HEIGHT * sizeof(uint16_t);
+
+// Tĩnh để bộ nhớ slot còn tham chiếu tới lúc thoát (FrameCache không có end())
+static FrameCache cache;
+static FrameCache unusedCache;
+static const char clipA[] = "a";
+static const char clipB[] = "b";
+
+void test_cache_needs_two_slots() {
+    TEST_ASSERT_FALSE(unusedCache.begin(WIDTH, HEIGHT, FRAME_BYTES * 2 - 1));
+    TEST_ASSERT_FALSE(unusedCache.isEnabled());
+    hal::psramBytes() = 0;
+    TEST_ASSERT_FALSE(unusedCache.begin(WIDTH, HEIGHT));
+    hal::psramBytes() = 4 * 1024 * 1024;
+    TEST_ASSERT_NULL(unusedCache.beginInsert(clipA, 0, nullptr));
+}
+
+void test_cache_hit_miss_and_lru_eviction() {
+    TEST_ASSERT_TRUE(cache.begin(WIDTH, HEIGHT, FRAME_BYTES * 3));
+    TEST_ASSERT_EQUAL_UINT8(3, cache.getSlots());
+
+    TEST_ASSERT_NULL(cache.lookup(clipA, 0));
+    for (uint16_t frame = 0; frame < 3; frame++) {
+        uint16_t *pixels = cache.beginInsert(clipA, frame, nullptr);
+        TEST_ASSERT_NOT_NULL(pixels);
+        pixels[0] = frame;
+        TEST_ASSERT_EQUAL_PTR(pixels, cache.commitInsert(true));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, cache.getEvictions());
+
+    // Cùng số frame nhưng khác clip là khoá khác
+    TEST_ASSERT_NULL(cache.lookup(clipB, 0));
+    const uint16_t *frame0 = cache.lookup(clipA, 0);
+    TEST_ASSERT_NOT_NULL(frame0);
+    TEST_ASSERT_EQUAL_UINT16(0, frame0[0]);
+
+    // Frame 1 là LRU (frame 0 vừa được dùng) nên bị thay
+    cache.beginInsert(clipA, 3, frame0);
+    cache.commitInsert(true);
+    TEST_ASSERT_EQUAL_UINT32(1, cache.getEvictions());
+    TEST_ASSERT_NULL(cache.lookup(clipA, 1));
+    TEST_ASSERT_NOT_NULL(cache.lookup(clipA, 0));
+    const uint16_t *frame3 = cache.lookup(clipA, 3);
+    TEST_ASSERT_NOT_NULL(frame3);
+    TEST_ASSERT_EQUAL_UINT16(0, frame3[0]);               // khởi tạo từ nền là frame 0
+    TEST_ASSERT_EQUAL_UINT32(3, cache.getHits());
+    TEST_ASSERT_EQUAL_UINT32(3, cache.getMisses());
+}
+
+void test_cache_records_clipped_tiles_and_discards_incomplete() {
+    cache.clear();
+    cache.resetStats();
+
+    uint16_t tile[16 * 16];
+    for (uint16_t i = 0; i < 16 * 16; i++) {
+        tile[i] = i;
+    }
+    TEST_ASSERT_NOT_NULL(cache.beginInsert(clipB, 7, nullptr));
+    TEST_ASSERT_TRUE(cache.isRecording());
+    cache.record(16, 8, 16, 16, tile);                   // chỉ 4 x 8 pixel nằm trong màn hình
+    const uint16_t *frame = cache.commitInsert(true);
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_FALSE(cache.isRecording());
+    TEST_ASSERT_EQUAL_UINT16(0, frame[8 * WIDTH + 15]);
+    TEST_ASSERT_EQUAL_UINT16(0, frame[8 * WIDTH + 16]);
+    TEST_ASSERT_EQUAL_UINT16(3, frame[8 * WIDTH + 19]);
+    TEST_ASSERT_EQUAL_UINT16(7 * 16 + 3, frame[15 * WIDTH + 19]);
+
+    // Delta chưa có nền: huỷ, slot không được tìm thấy
+    cache.beginInsert(clipB, 8, nullptr);
+    TEST_ASSERT_NULL(cache.commitInsert(false));
+    TEST_ASSERT_NULL(cache.lookup(clipB, 8));
+    TEST_ASSERT_NOT_NULL(cache.lookup(clipB, 7));
+}
+
+// ============================================
+// FACE ANIMATOR
+// ============================================
+
+void test_face_emotion_names() {
+    TEST_ASSERT_EQUAL(EMOTION_SURPRISED, emotionFromName("surprised", EMOTION_NEUTRAL));
+    TEST_ASSERT_EQUAL(EMOTION_HAPPY, emotionFromName("bored", EMOTION_HAPPY));
+    TEST_ASSERT_EQUAL(EMOTION_SAD, emotionFromName(nullptr, EMOTION_SAD));
+    TEST_ASSERT_EQUAL_STRING("afraid", emotionName(EMOTION_AFRAID));
+    TEST_ASSERT_EQUAL_STRING("neutral", emotionName(EMOTION_COUNT));
+}
+
+void test_face_transition_settles() {
+    FaceAnimator anim;
+    anim.setIdleMotion(false);
+    TEST_ASSERT_TRUE(anim.update(0));
+    TEST_ASSERT_FALSE(anim.update(33));
+
+    anim.setEmotion(EMOTION_HAPPY, 0.5f, 300, 100);
+    TEST_ASSERT_TRUE(anim.isTransitioning(250));
+    TEST_ASSERT_TRUE(anim.update(250));
+    float curve = (EMOTION_FACES[EMOTION_NEUTRAL].mouthCurve + EMOTION_FACES[EMOTION_HAPPY].mouthCurve) / 2;
+    TEST_ASSERT_TRUE(anim.params().mouthCurve > EMOTION_FACES[EMOTION_NEUTRAL].mouthCurve);
+    TEST_ASSERT_TRUE(anim.params().mouthCurve < curve);
+
+    TEST_ASSERT_TRUE(anim.update(400));
+    TEST_ASSERT_FALSE(anim.isTransitioning(400));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, curve, anim.params().mouthCurve);
+    TEST_ASSERT_FALSE(anim.update(433));                  // đứng yên thì không vẽ lại
+
+    // Đổi giữa chừng: bắt đầu từ mặt đang hiển thị, không nhảy về preset cũ
+    anim.setEmotion(EMOTION_SAD, 1.0f, 300, 500);
+    anim.setEmotion(EMOTION_ANGRY, 1.0f, 300, 650);
+    anim.update(650);
+    TEST_ASSERT_TRUE(anim.params().mouthCurve < curve);
+    TEST_ASSERT_TRUE(anim.params().mouthCurve > EMOTION_FACES[EMOTION_SAD].mouthCurve);
+}
+
+void test_face_blink_reopens_to_preset() {
+    FaceAnimator anim;
+    anim.setIdleMotion(false);
+    anim.setEmotion(EMOTION_CURIOUS, 1.0f, 0, 0);
+    anim.update(0);
+
+    // Giữa lần chớp mắt nhắm hẳn, hết BLINK_MS thì mở lại theo preset
+    anim.blink(10);
+    anim.update(80);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, anim.params().eyeOpen);
+    anim.update(10 + FaceAnimator::BLINK_MS + 5);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, EMOTION_FACES[EMOTION_CURIOUS].eyeOpen, anim.params().eyeOpen);
+}
+
+void test_face_apply_payload() {
+    FaceAnimator anim;
+    anim.setIdleMotion(false);
+    anim.update(0);
+
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(anim.apply(doc.as<JsonVariantConst>(), 10));
+    doc["current_emotion"] = "surprised";
+    doc["intensity"] = 0.5f;
+    doc["transitionMs"] = 0;
+    JsonObject gaze = doc["gaze"].to<JsonObject>();
+    gaze["x"] = 1.0f;
+    gaze["holdMs"] = 1000;
+    TEST_ASSERT_TRUE(anim.apply(doc.as<JsonVariantConst>(), 10));
+    TEST_ASSERT_EQUAL(EMOTION_SURPRISED, anim.emotion());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.5f, anim.intensity());
+
+    anim.update(500);
+    TEST_ASSERT_TRUE(anim.params().gazeX > 0.9f);
+    anim.update(2000);                                    // hết holdMs, idle tắt nên giữ nguyên
+    TEST_ASSERT_TRUE(anim.params().gazeX > 0.9f);
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_delta_parse_header);
+    RUN_TEST(test_delta_frame_range);
+    RUN_TEST(test_delta_decode_tiles);
+    RUN_TEST(test_delta_rejects_corrupt_frames);
+    RUN_TEST(test_delta_callback_can_stop_early);
+    RUN_TEST(test_cache_needs_two_slots);
+    RUN_TEST(test_cache_hit_miss_and_lru_eviction);
+    RUN_TEST(test_cache_records_clipped_tiles_and_discards_incomplete);
+    RUN_TEST(test_face_emotion_names);
+    RUN_TEST(test_face_transition_settles);
+    RUN_TEST(test_face_blink_reopens_to_preset);
+    RUN_TEST(test_face_apply_payload);
+    return UNITY_END();
+}
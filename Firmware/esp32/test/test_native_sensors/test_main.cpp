@@ -0,0 +1,393 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "MotionSensor.h"
+#include "FlameSensor.h"
+#include "INMP441.h"
+#include "AudioDsp.h"
+#include "AnalogSampler.h"
+#include "SampleRing.h"
+
+// ======================================================
+// 🧪 Debounce cảm biến GPIO (poll + ngắt), lấy mẫu ADC, history Sensor, đọc micro I2S và kernel DSP, trên HAL giả
+// ======================================================
+
+static const uint8_t PIR_PIN = 27;
+static const uint8_t FLAME_PIN = 14;
+static const uint8_t FLAME_ANALOG_PIN = 34;
+
+static uint32_t notifyCount = 0;
+
+static void countNotify(void *) {
+    notifyCount++;
+}
+
+void setUp() {
+    hal::reset(10 * 1000 * 1000);        // bắt đầu ở giây thứ 10, tránh lastTrigger = 0 trùng "bây giờ"
+    notifyCount = 0;
+}
+
+void tearDown() {}
+
+// ============================================
+// MOTION SENSOR
+// ============================================
+
+void test_motion_poll_debounce() {
+    MotionSensor pir(PIR_PIN, 200, "pir");
+    pir.begin();
+    TEST_ASSERT_EQUAL(INPUT, hal::pinModeOf(PIR_PIN));
+
+    TEST_ASSERT_FALSE(pir.isMotionDetected());
+    hal::setDigital(PIR_PIN, HIGH);
+    TEST_ASSERT_TRUE(pir.isMotionDetected());
+    TEST_ASSERT_FALSE(pir.isMotionDetected());          // vẫn HIGH: không phải sự kiện mới
+    TEST_ASSERT_EQUAL_UINT32(millis(), pir.getLastTriggerTime());
+
+    // Xung mới trong cửa sổ debounce bị bỏ qua tới khi đủ 200 ms
+    hal::advanceMillis(50);
+    hal::setDigital(PIR_PIN, LOW);
+    TEST_ASSERT_FALSE(pir.isMotionDetected());
+    hal::setDigital(PIR_PIN, HIGH);
+    TEST_ASSERT_FALSE(pir.isMotionDetected());
+    hal::advanceMillis(150);
+    TEST_ASSERT_TRUE(pir.isMotionDetected());
+}
+
+void test_motion_poll_misses_short_pulse() {
+    MotionSensor pir(PIR_PIN, 200, "pir");
+    pir.begin();
+    hal::setDigital(PIR_PIN, HIGH);
+    hal::advanceMillis(5);
+    hal::setDigital(PIR_PIN, LOW);
+    TEST_ASSERT_FALSE(pir.isMotionDetected());
+}
+
+void test_motion_interrupt_catches_short_pulse() {
+    MotionSensor pir(PIR_PIN, 200, "pir");
+    pir.begin();
+    pir.enableInterrupt(countNotify);
+    TEST_ASSERT_TRUE(pir.isInterruptMode());
+    TEST_ASSERT_TRUE(hal::hasInterrupt(PIR_PIN));
+
+    uint32_t edgeMs = millis();
+    hal::setDigital(PIR_PIN, HIGH);
+    hal::advanceMillis(5);
+    hal::setDigital(PIR_PIN, LOW);
+    TEST_ASSERT_EQUAL_UINT32(2, notifyCount);
+
+    hal::advanceMillis(20);
+    TEST_ASSERT_TRUE(pir.isMotionDetected());
+    TEST_ASSERT_FALSE(pir.getState());                   // xung đã kết thúc
+    TEST_ASSERT_EQUAL_UINT32(edgeMs, pir.getLastTriggerTime());
+    TEST_ASSERT_EQUAL_UINT32(25000, pir.getLastEdgeLatencyUs());
+
+    pir.disableInterrupt();
+    TEST_ASSERT_FALSE(hal::hasInterrupt(PIR_PIN));
+}
+
+void test_motion_interrupt_debounce_by_edge_time() {
+    MotionSensor pir(PIR_PIN, 200, "pir");
+    pir.begin();
+    pir.enableInterrupt();
+
+    // Hai xung cách 50 ms xử lý trong cùng một lần gọi: chỉ một sự kiện
+    hal::setDigital(PIR_PIN, HIGH);
+    hal::advanceMillis(10);
+    hal::setDigital(PIR_PIN, LOW);
+    hal::advanceMillis(40);
+    hal::setDigital(PIR_PIN, HIGH);
+    hal::advanceMillis(10);
+    hal::setDigital(PIR_PIN, LOW);
+    TEST_ASSERT_TRUE(pir.isMotionDetected());
+    TEST_ASSERT_FALSE(pir.isMotionDetected());
+
+    hal::advanceMillis(300);
+    hal::setDigital(PIR_PIN, HIGH);
+    TEST_ASSERT_TRUE(pir.isMotionDetected());
+    TEST_ASSERT_TRUE(pir.getState());
+}
+
+void test_motion_ring_overflow_counts_dropped_edges() {
+    MotionSensor pir(PIR_PIN, 200, "pir");
+    pir.begin();
+    pir.enableInterrupt();
+    for (uint8_t i = 0; i < 20; i++) {
+        hal::advanceMicros(100);
+        hal::setDigital(PIR_PIN, i % 2 == 0 ? HIGH : LOW);
+    }
+    TEST_ASSERT_EQUAL_UINT32(4, pir.getDroppedEdges());
+    TEST_ASSERT_TRUE(pir.isMotionDetected());
+}
+
+// ============================================
+// FLAME SENSOR
+// ============================================
+
+void test_flame_digital_is_active_low() {
+    hal::setDigital(FLAME_PIN, HIGH);                    // module kéo LOW khi có lửa
+    FlameSensor flame(FLAME_PIN, 100, "flame");
+    flame.begin();
+
+    TEST_ASSERT_FALSE(flame.isFlameDetected());
+    hal::setDigital(FLAME_PIN, LOW);
+    TEST_ASSERT_TRUE(flame.isFlameDetected());
+    TEST_ASSERT_TRUE(flame.getState());
+    TEST_ASSERT_FALSE(flame.isFlameDetected());
+
+    hal::setDigital(FLAME_PIN, HIGH);
+    TEST_ASSERT_FALSE(flame.isFlameDetected());
+    TEST_ASSERT_FALSE(flame.getState());
+}
+
+void test_flame_analog_threshold() {
+    FlameSensor flame(FLAME_ANALOG_PIN, 2000, 100, "flame_analog");
+    flame.begin();
+    TEST_ASSERT_FALSE(flame.enableInterrupt());          // ngắt chỉ có ở mode digital
+
+    hal::setAnalog(FLAME_ANALOG_PIN, 1999);
+    TEST_ASSERT_FALSE(flame.isFlameDetected());
+    hal::setAnalog(FLAME_ANALOG_PIN, 2000);
+    TEST_ASSERT_TRUE(flame.isFlameDetected());
+
+    flame.setAnalogThreshold(3000);
+    TEST_ASSERT_FALSE(flame.isFlameDetected());
+    TEST_ASSERT_FALSE(flame.getState());
+    hal::advanceMillis(100);
+    hal::setAnalog(FLAME_ANALOG_PIN, 3500);
+    TEST_ASSERT_TRUE(flame.isFlameDetected());
+}
+
+void test_flame_interrupt_catches_short_flash() {
+    hal::setDigital(FLAME_PIN, HIGH);
+    FlameSensor flame(FLAME_PIN, 100, "flame");
+    flame.begin();
+    TEST_ASSERT_TRUE(flame.enableInterrupt(countNotify));
+    TEST_ASSERT_FALSE(flame.getState());
+
+    hal::setDigital(FLAME_PIN, LOW);
+    hal::advanceMillis(2);
+    hal::setDigital(FLAME_PIN, HIGH);
+    hal::advanceMillis(8);
+    TEST_ASSERT_TRUE(flame.isFlameDetected());
+    TEST_ASSERT_FALSE(flame.getState());
+    TEST_ASSERT_EQUAL_UINT32(2, notifyCount);
+    TEST_ASSERT_EQUAL_UINT32(10000, flame.getLastEdgeLatencyUs());
+
+    // Đổi sang analog thì gỡ ngắt
+    flame.setMode(FlameSensor::ANALOG_MODE);
+    TEST_ASSERT_FALSE(flame.isInterruptMode());
+    TEST_ASSERT_FALSE(hal::hasInterrupt(FLAME_PIN));
+}
+
+// ============================================
+// ADC SAMPLER
+// ============================================
+
+void test_sampler_oversample_and_ema() {
+    static const uint8_t GAS_PIN = 34;
+    AnalogSampler adc(20, 16, 3);
+    TEST_ASSERT_EQUAL_INT8(-1, adc.addChannel(27));          // ADC2: WiFi chiếm
+    int8_t gas = adc.addChannel(GAS_PIN);
+    TEST_ASSERT_EQUAL_INT8(0, gas);
+    TEST_ASSERT_EQUAL_INT8(gas, adc.addChannel(GAS_PIN));
+
+    // begin() lấy một lượt ngay: có giá trị dù task không chạy (HAL không có FreeRTOS)
+    hal::adcReads() = 0;
+    hal::setAnalog(GAS_PIN, 1000);
+    TEST_ASSERT_FALSE(adc.begin());
+    TEST_ASSERT_EQUAL_UINT32(16, hal::adcReads());
+    TEST_ASSERT_EQUAL_UINT16(1000, adc.readRaw(gas));
+    TEST_ASSERT_EQUAL_UINT16(1000 * 3100 / 4095, adc.readMilliVolts(gas));
+
+    // Bước nhảy: EMA 1/8 tiến dần, không nhảy ngay
+    hal::setAnalog(GAS_PIN, 1800);
+    adc.sample();
+    TEST_ASSERT_EQUAL_UINT16(1100, adc.readRaw(gas));
+    for (uint8_t i = 0; i < 60; i++) {
+        adc.sample();
+    }
+    TEST_ASSERT_UINT16_WITHIN(1, 1800, adc.readRaw(gas));
+    TEST_ASSERT_EQUAL_UINT32(62, adc.getSweeps());
+    TEST_ASSERT_EQUAL_UINT16(0, adc.readRaw(5));
+}
+
+void test_flame_analog_reads_sampler() {
+    AnalogSampler adc(20, 4, 0);                             // shift 0: không lọc, theo ngay mẫu
+    FlameSensor digital(FLAME_PIN, 100, "flame");
+    TEST_ASSERT_FALSE(digital.attachSampler(adc));           // digital giữ chân ở GPIO mux
+
+    FlameSensor flame(FLAME_ANALOG_PIN, 2000, 100, "flame_analog");
+    flame.begin();
+    TEST_ASSERT_TRUE(flame.attachSampler(adc));
+    hal::setAnalog(FLAME_ANALOG_PIN, 2500);
+    TEST_ASSERT_FALSE(flame.isFlameDetected());              // chưa quét: giá trị cũ
+    adc.sample();
+    TEST_ASSERT_TRUE(flame.isFlameDetected());
+}
+
+// ============================================
+// SAMPLE RING / SENSOR
+// ============================================
+
+void test_sample_ring_overwrites_oldest() {
+    SampleRing<int, 4> ring;
+    TEST_ASSERT_TRUE(ring.empty());
+    for (int i = 1; i <= 6; i++) {
+        ring.push(i * 1000, i);
+    }
+    TEST_ASSERT_EQUAL_UINT16(4, ring.size());
+    TEST_ASSERT_EQUAL(6, ring.back().value);
+    TEST_ASSERT_EQUAL(3, ring.back(3).value);          // 1 và 2 đã bị ghi đè
+
+    SampleStats<int> all = ring.stats();
+    TEST_ASSERT_EQUAL_UINT16(4, all.count);
+    TEST_ASSERT_EQUAL(3, all.min);
+    TEST_ASSERT_EQUAL(6, all.max);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 4.5f, all.mean);
+}
+
+void test_sample_ring_window_skips_bad() {
+    SampleRing<float, 8> ring;
+    ring.push(1000, 50.0f);
+    ring.push(2000, 10.0f);
+    ring.push(3000, -1.0f, SAMPLE_BAD);
+    ring.push(4000, 20.0f, SAMPLE_DEGRADED);
+
+    // Cửa sổ 3 ms tính từ 4.5 ms: chỉ mẫu 2000 (10) và 4000 (20); 3000 lỗi bị bỏ
+    SampleStats<float> recent = ring.stats(3000, 4500);
+    TEST_ASSERT_EQUAL_UINT16(2, recent.count);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 10.0f, recent.min);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 20.0f, recent.max);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 15.0f, recent.mean);
+
+    ring.clear();
+    TEST_ASSERT_EQUAL_UINT16(0, ring.stats().count);
+}
+
+void test_sensor_sample_records_history() {
+    MotionSensor pir(PIR_PIN, 200, "pir");
+    pir.begin();
+    TEST_ASSERT_EQUAL(SENSOR_MOTION, pir.kind());
+    TEST_ASSERT_EQUAL_STRING("pir", pir.name());
+
+    float value;
+    TEST_ASSERT_FALSE(pir.latest(value));
+    TEST_ASSERT_TRUE(pir.sample());
+    hal::setDigital(PIR_PIN, HIGH);
+    TEST_ASSERT_TRUE(pir.isMotionDetected());
+    hal::advanceMillis(5);
+    TEST_ASSERT_TRUE(pir.sample());
+
+    TEST_ASSERT_TRUE(pir.latest(value));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f, value);
+    const SampleRing<float, Sensor::HISTORY> &history = pir.history();
+    TEST_ASSERT_EQUAL_UINT16(2, history.size());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, history.back(1).value);
+    TEST_ASSERT_TRUE(history.back().timestampUs - history.back(1).timestampUs == 5000);
+}
+
+// ============================================
+// MICRO I2S
+// ============================================
+
+void test_mic_read_converts_32_to_16_bit() {
+    hal::i2sRx().clear();
+    INMP441 mic(I2S_NUM_0, 26, 25, 33, 16000, 512);
+    mic.begin();
+    TEST_ASSERT_EQUAL(16000, hal::i2sSampleRate());
+
+    // > 64 mẫu để đi qua nhiều lần i2s_read của read()
+    int32_t raw[100];
+    int16_t expected[100];
+    for (int i = 0; i < 100; i++) {
+        expected[i] = (int16_t)((i - 50) * 300);
+        raw[i] = (int32_t)expected[i] * (1 << 14) + 0x1FFF;   // bit thấp bị bỏ khi >> 14
+    }
+    hal::i2sFeed(raw, 100);
+
+    int16_t samples[100];
+    mic.read(samples, 100);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(expected, samples, 100);
+
+    int32_t one = -1234 * (1 << 14);
+    hal::i2sFeed(&one, 1);
+    TEST_ASSERT_EQUAL_INT16(-1234, mic.readSample());
+    TEST_ASSERT_EQUAL_INT16(0, mic.readSample());        // hết dữ liệu: im lặng
+}
+
+void test_dsp_convert_in_place_matches_copy() {
+    int32_t raw[512];
+    int16_t expected[512];
+    for (int i = 0; i < 512; i++) {
+        raw[i] = (int32_t)((i - 256) * 120) * (1 << 14) + 0x1FFF;
+    }
+    INMP441::convert32to16(raw, expected, 512);
+    int16_t *pcm = AudioDsp::convertInPlace(raw, 512, 14);
+    TEST_ASSERT_EQUAL_PTR(raw, pcm);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(expected, pcm, 512);
+}
+
+void test_dsp_block_kernels() {
+    int16_t block[512];
+
+    // DC blocker: offset cố định về 0 sau vài khối
+    DcBlocker dc;
+    for (int b = 0; b < 8; b++) {
+        for (int i = 0; i < 512; i++) {
+            block[i] = 1000;
+        }
+        dc.process(block, 512);
+    }
+    TEST_ASSERT_INT16_WITHIN(1, 0, block[511]);
+
+    // Hạ tần: giữ pha giữa các khối 512 mẫu, DC đi qua nguyên vẹn
+    Decimator3 decimator;
+    size_t produced = 0;
+    for (int b = 0; b < 3; b++) {
+        for (int i = 0; i < 512; i++) {
+            block[i] = 1200;
+        }
+        size_t n = decimator.process(block, 512);
+        TEST_ASSERT_TRUE(n == 170 || n == 171);
+        produced += n;
+    }
+    TEST_ASSERT_EQUAL_UINT32(512, produced);
+    TEST_ASSERT_EQUAL_INT16(1200, block[100]);
+
+    // AGC: tín hiệu nhỏ được nâng dần tới đích, tiếng lớn đột ngột không bị clip
+    Agc agc;
+    agc.configure(8000);
+    for (int b = 0; b < 60; b++) {
+        for (int i = 0; i < 512; i++) {
+            block[i] = (i % 32) < 16 ? 1000 : -1000;
+        }
+        agc.process(block, 512);
+    }
+    TEST_ASSERT_INT16_WITHIN(400, 8000, (int16_t)AudioDsp::peak(block, 512));
+    for (int i = 0; i < 512; i++) {
+        block[i] = (i % 32) < 16 ? 20000 : -20000;
+    }
+    agc.process(block, 512);
+    TEST_ASSERT_INT16_WITHIN(10, 8000, (int16_t)AudioDsp::peak(block, 512));
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_motion_poll_debounce);
+    RUN_TEST(test_motion_poll_misses_short_pulse);
+    RUN_TEST(test_motion_interrupt_catches_short_pulse);
+    RUN_TEST(test_motion_interrupt_debounce_by_edge_time);
+    RUN_TEST(test_motion_ring_overflow_counts_dropped_edges);
+    RUN_TEST(test_flame_digital_is_active_low);
+    RUN_TEST(test_flame_analog_threshold);
+    RUN_TEST(test_flame_interrupt_catches_short_flash);
+    RUN_TEST(test_sampler_oversample_and_ema);
+    RUN_TEST(test_flame_analog_reads_sampler);
+    RUN_TEST(test_sample_ring_overwrites_oldest);
+    RUN_TEST(test_sample_ring_window_skips_bad);
+    RUN_TEST(test_sensor_sample_records_history);
+    RUN_TEST(test_mic_read_converts_32_to_16_bit);
+    RUN_TEST(test_dsp_convert_in_place_matches_copy);
+    RUN_TEST(test_dsp_block_kernels);
+    return UNITY_END();
+}
@@ -0,0 +1,519 @@
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <WebSocketsClient.h>
+#include <esp_timer.h>
+#include <unity.h>
+#include "WebSocketClient.h"
+
+// ======================================================
+// 🧪 WebSocketClient qua socket giả: mức cảnh báo, (de)serialize, dispatch, backoff, hạn mức
+// ======================================================
+//
+// WebSocketClient giữ con trỏ instance tĩnh cho callback của thư viện, nên cả
+// file dùng chung một client; mỗi test mở lại kết nối bằng serverOpen().
+
+static WebSocketClient client("localhost", 3000, "robot-test");
+
+static WebSocketsClient &socket() {
+    return *WebSocketsClient::last();
+}
+
+static void openConnection(const char *encoding) {
+    if (socket().connected) {
+        socket().serverClose();
+    }
+    client.connect();                                    // gắn onEvent nếu test chạy riêng lẻ
+    socket().failSends = false;
+    socket().serverOpen();
+
+    char ack[160];
+    snprintf(ack, sizeof(ack),
+             "{\"type\":\"ack\",\"payload\":{\"connectionId\":\"conn-1\",\"encoding\":\"%s\"}}", encoding);
+    socket().serverText(ack);
+    socket().clearSent();                                // bỏ connection_init
+}
+
+// Bỏ mọi mục còn trong hàng đợi để test sau bắt đầu sạch
+static void ackEverything() {
+    OutboundQueue &outbox = client.getOutbox();
+    if (outbox.pending() > 0) {
+        outbox.ack((uint16_t)(outbox.firstPendingSeq() + outbox.pending() - 1));
+    }
+}
+
+void setUp() {
+    hal::reset(60 * 1000 * 1000);
+    ackEverything();
+}
+
+void tearDown() {}
+
+// ============================================
+// MỨC CẢNH BÁO
+// ============================================
+
+void test_alert_levels_at_thresholds() {
+    TEST_ASSERT_EQUAL(AlertLevel::NORMAL, client.getAlertLevel("temperature", 25.0f));
+    TEST_ASSERT_EQUAL(AlertLevel::NORMAL, client.getAlertLevel("temperature", 35.0f));
+    TEST_ASSERT_EQUAL(AlertLevel::DANGER, client.getAlertLevel("temperature", 35.1f));
+    TEST_ASSERT_EQUAL(AlertLevel::DANGER, client.getAlertLevel("temperature", 40.0f));
+    TEST_ASSERT_EQUAL(AlertLevel::CRITICAL, client.getAlertLevel("temperature", 40.1f));
+    TEST_ASSERT_EQUAL(AlertLevel::NORMAL, client.getAlertLevel("temperature", 15.0f));
+    TEST_ASSERT_EQUAL(AlertLevel::WARNING, client.getAlertLevel("temperature", 14.9f));
+
+    TEST_ASSERT_EQUAL(AlertLevel::NORMAL, client.getAlertLevel("humidity", 20.0f));
+    TEST_ASSERT_EQUAL(AlertLevel::WARNING, client.getAlertLevel("humidity", 19.9f));
+    TEST_ASSERT_EQUAL(AlertLevel::WARNING, client.getAlertLevel("humidity", 85.1f));
+
+    TEST_ASSERT_EQUAL(AlertLevel::NORMAL, client.getAlertLevel("gas", 100.0f));
+    TEST_ASSERT_EQUAL(AlertLevel::WARNING, client.getAlertLevel("gas", 100.5f));
+    TEST_ASSERT_EQUAL(AlertLevel::DANGER, client.getAlertLevel("gas", 250.0f));
+    TEST_ASSERT_EQUAL(AlertLevel::CRITICAL, client.getAlertLevel("gas", 301.0f));
+
+    TEST_ASSERT_EQUAL(AlertLevel::NORMAL, client.getAlertLevel("distance", 1000.0f));
+}
+
+// ============================================
+// LUẬT CẢNH BÁO
+// ============================================
+
+void test_rules_hysteresis_and_dwell() {
+    AlertRules rules;
+    AlertRule &gas = *rules.rule(SENSOR_GAS);
+    TEST_ASSERT_EQUAL(AlertLevel::DANGER, rules.classify(SENSOR_GAS, 250.0f));
+
+    // Lên DANGER phải giữ đủ dwell (1 s)
+    TEST_ASSERT_EQUAL(AlertLevel::NORMAL, rules.evaluate(SENSOR_GAS, 90.0f, 0).level);
+    TEST_ASSERT_EQUAL(AlertLevel::NORMAL, rules.evaluate(SENSOR_GAS, 250.0f, 10000).level);
+    AlertDecision d = rules.evaluate(SENSOR_GAS, 250.0f, 11000);
+    TEST_ASSERT_EQUAL(AlertLevel::DANGER, d.level);
+    TEST_ASSERT_TRUE(d.changed);
+    TEST_ASSERT_TRUE(d.report);
+
+    // Trong dải trễ: vẫn DANGER dù đã dưới ngưỡng 200
+    TEST_ASSERT_EQUAL(AlertLevel::DANGER, rules.evaluate(SENSOR_GAS, 195.0f, 20000).level);
+    TEST_ASSERT_EQUAL(AlertLevel::DANGER, rules.evaluate(SENSOR_GAS, 195.0f, 30000).level);
+
+    // Lùi qua ngưỡng - hysteresis: hạ về WARNING sau dwell
+    TEST_ASSERT_EQUAL(AlertLevel::DANGER, rules.evaluate(SENSOR_GAS, 185.0f, 40000).level);
+    TEST_ASSERT_EQUAL(AlertLevel::WARNING, rules.evaluate(SENSOR_GAS, 185.0f, 41000).level);
+    TEST_ASSERT_EQUAL(AlertLevel::WARNING, rules.currentLevel(SENSOR_GAS));
+
+    gas.dwellMs = 0;
+    TEST_ASSERT_EQUAL(AlertLevel::CRITICAL, rules.evaluate(SENSOR_GAS, 400.0f, 50000).level);
+}
+
+void test_rules_rate_of_change() {
+    AlertRules rules;
+    // 30 -> 31 °C trong 10 s = 0.1 °C/s > 0.05: WARNING dù dưới ngưỡng 35
+    rules.evaluate(SENSOR_TEMPERATURE, 30.0f, 0);
+    rules.evaluate(SENSOR_TEMPERATURE, 31.0f, 10000);
+    TEST_ASSERT_EQUAL(AlertLevel::WARNING, rules.evaluate(SENSOR_TEMPERATURE, 32.0f, 20000).level);
+    // Ổn định lại: hết WARNING sau dwell 2 s
+    rules.evaluate(SENSOR_TEMPERATURE, 32.0f, 30000);
+    TEST_ASSERT_EQUAL(AlertLevel::NORMAL, rules.evaluate(SENSOR_TEMPERATURE, 32.0f, 32000).level);
+}
+
+void test_rules_send_on_delta() {
+    AlertRules rules;
+    TEST_ASSERT_TRUE(rules.evaluate(SENSOR_HUMIDITY, 50.0f, 0).report);     // mẫu đầu luôn gửi
+    TEST_ASSERT_FALSE(rules.evaluate(SENSOR_HUMIDITY, 51.0f, 2000).report);
+    TEST_ASSERT_TRUE(rules.evaluate(SENSOR_HUMIDITY, 52.5f, 4000).report);  // lệch 2.5 so với lần gửi
+    TEST_ASSERT_FALSE(rules.evaluate(SENSOR_HUMIDITY, 52.0f, 30000).report);
+    TEST_ASSERT_TRUE(rules.evaluate(SENSOR_HUMIDITY, 52.0f, 64000).report); // heartbeat 60 s
+    TEST_ASSERT_TRUE(rules.evaluate(SENSOR_MOTION, 1.0f, 0).report);        // delta 0: gửi mọi mẫu
+    TEST_ASSERT_TRUE(rules.evaluate(SENSOR_MOTION, 1.0f, 10).report);
+    TEST_ASSERT_EQUAL_UINT32(2, rules.getSuppressed());
+}
+
+void test_rules_update_from_behavior_message() {
+    openConnection("json");
+    client.getAlertRules().loadDefaults();
+    socket().serverText("{\"id\":\"rules-1\",\"type\":\"behavior_update\",\"payload\":{\"alertRules\":["
+                        "{\"sensor\":\"gas\",\"high\":[50,null,80],\"dwellMs\":0,\"rateLevel\":\"danger\"},"
+                        "{\"sensor\":\"nope\",\"delta\":1}]}}");
+
+    AlertRules &rules = client.getAlertRules();
+    TEST_ASSERT_EQUAL(AlertLevel::WARNING, rules.classify(SENSOR_GAS, 60.0f));
+    TEST_ASSERT_EQUAL(AlertLevel::CRITICAL, rules.classify(SENSOR_GAS, 90.0f));
+    TEST_ASSERT_EQUAL(AlertLevel::WARNING, client.getAlertLevel("gas", 70.0f));       // DANGER đã tắt
+    TEST_ASSERT_EQUAL(AlertLevel::DANGER, rules.rule(SENSOR_GAS)->rateLevel);
+    TEST_ASSERT_EQUAL_FLOAT(10.0f, rules.rule(SENSOR_GAS)->hysteresis);               // vắng mặt: giữ nguyên
+    TEST_ASSERT_EQUAL(1, socket().sentText.size());
+    TEST_ASSERT_NOT_NULL(strstr(socket().sentText[0].c_str(), "rules-1"));
+
+    // "high": null tắt cả ba mức (khác với vắng mặt: giữ nguyên)
+    socket().serverText("{\"id\":\"rules-2\",\"type\":\"behavior_update\",\"payload\":{\"alertRules\":["
+                        "{\"sensor\":\"gas\",\"high\":null}]}}");
+    TEST_ASSERT_TRUE(isnan(rules.rule(SENSOR_GAS)->high[0]));
+    TEST_ASSERT_TRUE(isnan(rules.rule(SENSOR_GAS)->high[2]));
+    TEST_ASSERT_EQUAL(AlertLevel::NORMAL, rules.classify(SENSOR_GAS, 500.0f));
+    rules.loadDefaults();
+}
+
+// ============================================
+// KẾT NỐI VÀ SERIALIZE
+// ============================================
+
+void test_connection_init_and_ack() {
+    client.setLogMessages(0);
+    client.connect();
+    TEST_ASSERT_TRUE(socket().began);
+
+    socket().clearSent();
+    socket().serverOpen();
+    TEST_ASSERT_FALSE(client.isConnectedToServer());     // chưa có ack
+    TEST_ASSERT_EQUAL(1, socket().sentText.size());
+
+    JsonDocument init;
+    TEST_ASSERT_FALSE(deserializeJson(init, socket().sentText[0]));
+    TEST_ASSERT_EQUAL_STRING("connection_init", init["type"].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING("robot-test", init["robotId"].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING("bin1", init["payload"]["encodings"][0].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING("dict1", init["payload"]["compression"][0].as<const char*>());
+    TEST_ASSERT_EQUAL_UINT16(client.getOutbox().firstPendingSeq(), init["payload"]["resumeSeq"].as<uint16_t>());
+
+    socket().serverText("{\"type\":\"ack\",\"payload\":{\"connectionId\":\"conn-1\",\"encoding\":\"json\"}}");
+    TEST_ASSERT_TRUE(client.isConnectedToServer());
+    TEST_ASSERT_FALSE(client.isBinaryMode());
+    TEST_ASSERT_EQUAL_STRING("conn-1", client.getConnectionId().c_str());
+}
+
+void test_sensor_batch_as_json() {
+    openConnection("json");
+
+    uint32_t now = millis();
+    SensorSample samples[3] = {
+        { now - 20, 24.5f, SENSOR_TEMPERATURE, AlertLevel::NORMAL },
+        { now - 10, 61.0f, SENSOR_HUMIDITY, AlertLevel::NORMAL },
+        { now, 220.0f, SENSOR_GAS, AlertLevel::DANGER },
+    };
+    TEST_ASSERT_TRUE(client.sendSensorBatch(samples, 3));
+    TEST_ASSERT_EQUAL(1, socket().sentText.size());      // cả lô trong một message
+
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, socket().sentText[0]));
+    TEST_ASSERT_EQUAL_STRING("sensor_data", doc["type"].as<const char*>());
+    TEST_ASSERT_TRUE(doc["requiresAck"].as<bool>());
+    JsonArrayConst readings = doc["payload"]["readings"];
+    TEST_ASSERT_EQUAL(3, readings.size());
+    TEST_ASSERT_EQUAL_STRING("humidity", readings[1]["sensorType"].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING("danger", readings[2]["alertLevel"].as<const char*>());
+    TEST_ASSERT_EQUAL_FLOAT(220.0f, readings[2]["value"].as<float>());
+    TEST_ASSERT_EQUAL_UINT32(samples[0].timestamp, readings[0]["timestamp"].as<uint32_t>());
+
+    // seq của message = seq mục cuối; ack cộng dồn theo nó dọn hàng đợi
+    uint16_t seq = doc["seq"];
+    TEST_ASSERT_EQUAL_UINT8(3, client.getOutbox().pending());
+    char ack[96];
+    snprintf(ack, sizeof(ack), "{\"type\":\"ack\",\"payload\":{\"ackSeq\":%u}}", seq);
+    socket().serverText(ack);
+    TEST_ASSERT_EQUAL_UINT8(0, client.getOutbox().pending());
+}
+
+void test_sensor_data_as_bin1() {
+    openConnection("bin1");
+    TEST_ASSERT_TRUE(client.isBinaryMode());
+
+    client.sendSensorData(SENSOR_TEMPERATURE, 41.0f, AlertLevel::CRITICAL);
+    TEST_ASSERT_EQUAL(0, socket().sentText.size());
+    TEST_ASSERT_EQUAL(1, socket().sentBinary.size());
+
+    const std::vector<uint8_t> &frame = socket().sentBinary[0];
+    TEST_ASSERT_EQUAL(sizeof(FrameHeader) + 1 + sizeof(SensorRecord), frame.size());
+    FrameHeader header;
+    memcpy(&header, frame.data(), sizeof(header));
+    TEST_ASSERT_EQUAL_UINT8(BINARY_VERSION, header.version);
+    TEST_ASSERT_EQUAL_UINT8(CHANNEL_SENSOR_DATA, header.channel);
+    TEST_ASSERT_EQUAL_UINT32(millis(), header.timestamp);
+    TEST_ASSERT_EQUAL_UINT8(1, frame[sizeof(FrameHeader)]);
+
+    SensorRecord record;
+    memcpy(&record, frame.data() + sizeof(FrameHeader) + 1, sizeof(record));
+    TEST_ASSERT_EQUAL_UINT8(SENSOR_TEMPERATURE, record.sensor);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)AlertLevel::CRITICAL, record.level);
+    TEST_ASSERT_EQUAL_FLOAT(41.0f, record.value);
+}
+
+void test_send_failure_keeps_entries_queued() {
+    openConnection("json");
+    socket().failSends = true;
+    client.sendSensorData(SENSOR_GAS, 90.0f, AlertLevel::NORMAL);
+    TEST_ASSERT_EQUAL_UINT8(1, client.getOutbox().unsentCount());
+
+    socket().failSends = false;
+    client.update();
+    TEST_ASSERT_EQUAL_UINT8(0, client.getOutbox().unsentCount());
+    TEST_ASSERT_EQUAL(1, socket().sentText.size());
+}
+
+void test_disconnect_rewinds_unacked_entries() {
+    openConnection("json");
+    client.sendSensorData(SENSOR_HUMIDITY, 50.0f, AlertLevel::NORMAL);
+    TEST_ASSERT_EQUAL_UINT8(0, client.getOutbox().unsentCount());
+
+    socket().serverClose();
+    TEST_ASSERT_FALSE(client.isConnectedToServer());
+    TEST_ASSERT_EQUAL_UINT8(1, client.getOutbox().unsentCount());
+
+    openConnection("json");                                // ack kết nối: gửi lại ngay
+    client.update();
+    TEST_ASSERT_EQUAL(1, socket().sentText.size());
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, socket().sentText[0]));
+    TEST_ASSERT_EQUAL_FLOAT(50.0f, doc["payload"]["readings"][0]["value"].as<float>());
+}
+
+// ============================================
+// NHẬN VÀ DISPATCH
+// ============================================
+
+static uint32_t behaviorCount = 0;
+static uint32_t fallbackCount = 0;
+static String lastError;
+
+void test_dispatch_by_message_type() {
+    openConnection("json");
+    client.setMessageHandler(MessageType::BEHAVIOR_UPDATE, [](const JsonDocument &doc) {
+        behaviorCount++;
+        TEST_ASSERT_EQUAL_STRING("patrol", doc["payload"]["mode"].as<const char*>());
+    });
+    client.setOnMessage([](const JsonDocument &) { fallbackCount++; });
+    client.setOnError([](const String &error) { lastError = error; });
+
+    socket().serverText("{\"type\":\"behavior_update\",\"payload\":{\"mode\":\"patrol\"}}");
+    socket().serverText("{\"type\":\"emotion_update\",\"payload\":{}}");
+    socket().serverText("{\"type\":\"no_such_type\"}");
+    TEST_ASSERT_EQUAL_UINT32(1, behaviorCount);
+    TEST_ASSERT_EQUAL_UINT32(2, fallbackCount);
+
+    socket().serverText("{\"type\":");
+    TEST_ASSERT_EQUAL_STRING("JSON parse error", lastError.c_str());
+    TEST_ASSERT_EQUAL_UINT32(2, fallbackCount);
+}
+
+void test_actuator_command_is_acknowledged() {
+    openConnection("json");
+    static bool called = false;
+    client.setOnActuatorCommand([](const JsonDocument &doc) {
+        called = strcmp(doc["payload"]["actuator"] | "", "buzzer") == 0;
+    });
+    socket().serverText("{\"id\":\"cmd-7\",\"type\":\"actuator_command\",\"payload\":{\"actuator\":\"buzzer\"}}");
+    TEST_ASSERT_TRUE(called);
+    TEST_ASSERT_EQUAL(1, socket().sentText.size());
+
+    JsonDocument ack;
+    TEST_ASSERT_FALSE(deserializeJson(ack, socket().sentText[0]));
+    TEST_ASSERT_EQUAL_STRING("ack", ack["type"].as<const char*>());
+    TEST_ASSERT_NOT_NULL(strstr(socket().sentText[0].c_str(), "cmd-7"));
+}
+
+void test_pong_records_rtt() {
+    openConnection("json");
+    TEST_ASSERT_TRUE(client.sendPing());
+    hal::advanceMicros(1800);
+    socket().serverPong();
+    TEST_ASSERT_EQUAL_UINT32(1800, client.getLastRttUs());
+}
+
+void test_ota_frames_dispatch_and_ack() {
+    openConnection("bin1");
+    static uint32_t otaOffset = 0;
+    static size_t otaBytes = 0;
+    client.setOnOtaFrame([](const OtaHeader &ota, const uint8_t *, size_t bytes) {
+        otaOffset = ota.offset;
+        otaBytes = bytes;
+        client.sendOtaFrame(OTA_ACK, OTA_OK, ota.offset + bytes);
+    });
+
+    uint8_t frame[sizeof(FrameHeader) + sizeof(OtaHeader) + 5] = {};
+    FrameHeader header = { BINARY_VERSION, CHANNEL_OTA, 1, 0 };
+    OtaHeader data = { OTA_DATA, 0, 0, 76 };
+    memcpy(frame, &header, sizeof(header));
+    memcpy(frame + sizeof(header), &data, sizeof(data));
+    socket().serverBinary(frame, sizeof(frame));
+    TEST_ASSERT_EQUAL_UINT32(76, otaOffset);
+    TEST_ASSERT_EQUAL(5, otaBytes);
+
+    TEST_ASSERT_EQUAL(1, socket().sentBinary.size());
+    const std::vector<uint8_t> &sent = socket().sentBinary[0];
+    TEST_ASSERT_EQUAL(sizeof(FrameHeader) + sizeof(OtaHeader), sent.size());
+    OtaHeader ack;
+    memcpy(&ack, sent.data() + sizeof(FrameHeader), sizeof(ack));
+    TEST_ASSERT_EQUAL_UINT8(CHANNEL_OTA, sent[1]);
+    TEST_ASSERT_EQUAL_UINT8(OTA_ACK, ack.op);
+    TEST_ASSERT_EQUAL_UINT32(81, ack.offset);
+}
+
+void test_clock_sync_keeps_lowest_rtt_sample() {
+    ClockSync clock;
+    TEST_ASSERT_FALSE(clock.isSynced());
+    const int64_t wall = 1700000000LL * 1000000;
+    // rtt 10 ms, offset lệch 3 ms do đường lên chậm
+    TEST_ASSERT_TRUE(clock.addSample(1000, wall + 9000, wall + 9000, 11000));
+    // rtt 1 ms: mẫu tốt hơn, offset đúng = wall
+    TEST_ASSERT_TRUE(clock.addSample(20000, wall + 20500, wall + 20500, 21000));
+    // rtt 6 ms tới sau vẫn không thay mẫu tốt nhất
+    TEST_ASSERT_TRUE(clock.addSample(30000, wall + 33000, wall + 33000, 36000));
+    TEST_ASSERT_EQUAL(ClockSync::CLOCK_SERVER, clock.getSource());
+    TEST_ASSERT_EQUAL_UINT32(1000, clock.getRttUs());
+    TEST_ASSERT_TRUE(wall == clock.getBootEpochUs());
+    TEST_ASSERT_FALSE(clock.addSample(5000, wall, wall + 9000, 6000));   // rtt âm
+    clock.setSntp(wall + 123456, 0);                                      // đã có server thì bỏ qua SNTP
+    TEST_ASSERT_TRUE(wall == clock.getBootEpochUs());
+}
+
+void test_clock_ack_and_trace_id_in_envelope() {
+    openConnection("json");
+    const int64_t t0 = esp_timer_get_time() - 2000;
+    const int64_t t1 = 1700000000LL * 1000000;
+    char ack[200];
+    snprintf(ack, sizeof(ack),
+             "{\"type\":\"ack\",\"payload\":{\"clock\":{\"clientSentUs\":%lld,\"serverRecvUs\":%lld,"
+             "\"serverSendUs\":%lld}}}", (long long)t0, (long long)t1, (long long)(t1 + 400));
+    socket().serverText(ack);
+    TEST_ASSERT_EQUAL(ClockSync::CLOCK_SERVER, client.getClock().getSource());
+    TEST_ASSERT_EQUAL_UINT32(1600, client.getClock().getRttUs());
+    TEST_ASSERT_TRUE(t1 + 1200 == client.getClock().nowUs());
+
+    const char *trace = client.beginTrace();
+    TEST_ASSERT_EQUAL(TRACE_ID_LEN, strlen(trace));
+    client.sendVoiceCommand("start", 1, 16000, "pcm16");
+    JsonDocument sent;
+    TEST_ASSERT_FALSE(deserializeJson(sent, socket().sentText[0]));
+    TEST_ASSERT_EQUAL_STRING(trace, sent["traceId"].as<const char*>());
+    TEST_ASSERT_TRUE(t1 + 1200 == sent["timeUs"].as<int64_t>());
+
+    // Span gửi khi đóng trace, thời điểm đổi sang giờ thực
+    socket().clearSent();
+    client.recordSpan("voice.upload", esp_timer_get_time() - 5000, esp_timer_get_time());
+    client.endTrace();
+    TEST_ASSERT_EQUAL_STRING("", client.getTraceId());
+    TEST_ASSERT_EQUAL(1, socket().sentText.size());
+    TEST_ASSERT_FALSE(deserializeJson(sent, socket().sentText[0]));
+    JsonObject span = sent["payload"]["spans"][0];
+    TEST_ASSERT_EQUAL_STRING("trace", sent["payload"]["status"].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING("voice.upload", span["name"].as<const char*>());
+    TEST_ASSERT_TRUE(t1 + 1200 - 5000 == span["startUs"].as<int64_t>());
+    TEST_ASSERT_EQUAL_UINT32(5000, span["durUs"].as<uint32_t>());
+}
+
+void test_dict1_compression_round_trip() {
+    openConnection("json");
+    socket().serverText("{\"type\":\"ack\",\"payload\":{\"connectionId\":\"conn-2\",\"compression\":\"dict1\"}}");
+    TEST_ASSERT_TRUE(client.isCompressionMode());
+    socket().clearSent();
+
+    client.sendError("Lỗi cảm biến");                   // UTF-8 ngoài ASCII đi qua escape
+    TEST_ASSERT_EQUAL(0, socket().sentText.size());
+    TEST_ASSERT_EQUAL(1, socket().sentBinary.size());
+    const std::vector<uint8_t> &frame = socket().sentBinary[0];
+    TEST_ASSERT_EQUAL_UINT8(CHANNEL_JSON, frame[1]);
+
+    char json[512];
+    size_t length = JsonPacker::unpack(frame.data() + sizeof(FrameHeader), frame.size() - sizeof(FrameHeader),
+                                       json, sizeof(json));
+    TEST_ASSERT_TRUE(length > 0);
+    TEST_ASSERT_TRUE(frame.size() < length * 7 / 10);
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, json, length));
+    TEST_ASSERT_EQUAL_STRING("error", doc["type"].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING("esp32", doc["source"].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING("Lỗi cảm biến", doc["payload"]["error"].as<const char*>());
+}
+
+// ============================================
+// NHIỀU ROBOT: BACKOFF VÀ HẠN MỨC
+// ============================================
+
+void test_reconnect_backoff_grows_with_jitter() {
+    openConnection("json");
+    client.setReconnectBackoff(1000, 8000);
+    socket().serverClose();
+    uint32_t delay = client.getReconnectDelayMs();
+    TEST_ASSERT_TRUE(delay >= 500 && delay <= 1000);
+
+    // Server không lên: mỗi cửa sổ thử hết hạn thì trần backoff gấp đôi, tối đa 8 s
+    uint32_t ceiling = 1000;
+    for (int i = 0; i < 5; i++) {
+        hal::advanceMillis(client.getReconnectDelayMs());
+        client.update();                                 // mở cửa sổ thử
+        hal::advanceMillis(4000);
+        client.update();                                 // hết cửa sổ mà chưa kết nối
+        ceiling = ceiling * 2 > 8000 ? 8000 : ceiling * 2;
+        delay = client.getReconnectDelayMs();
+        TEST_ASSERT_TRUE(delay >= ceiling / 2 && delay <= ceiling);
+    }
+    TEST_ASSERT_EQUAL_UINT8(6, client.getReconnectAttempts());
+
+    // Radio bật lại có chủ đích (sau sentinel): thử ngay, backoff về từ đầu
+    client.reconnectNow();
+    TEST_ASSERT_EQUAL_UINT32(0, client.getReconnectDelayMs());
+    TEST_ASSERT_EQUAL_UINT8(0, client.getReconnectAttempts());
+    client.update();
+    hal::advanceMillis(4000);
+    client.update();
+    delay = client.getReconnectDelayMs();
+    TEST_ASSERT_TRUE(delay >= 500 && delay <= 1000);
+
+    openConnection("json");                              // connect() lại từ đầu
+    TEST_ASSERT_EQUAL_UINT8(0, client.getReconnectAttempts());
+    client.setReconnectBackoff(5000, 60000);
+}
+
+void test_rate_limit_throttles_telemetry_and_audio() {
+    openConnection("bin1");
+    socket().serverText("{\"type\":\"ack\",\"payload\":{\"rateLimit\":{\"telemetry\":{\"perSec\":1,\"burst\":1},"
+                        "\"audio\":{\"perSec\":0,\"burst\":1000,\"credits\":600}}}}");
+    TEST_ASSERT_TRUE(client.getTelemetryBudget().isLimited());
+
+    client.sendSensorData(SENSOR_GAS, 10.0f, AlertLevel::NORMAL);
+    client.sendSensorData(SENSOR_GAS, 11.0f, AlertLevel::NORMAL);   // hết token: nằm lại hàng đợi
+    TEST_ASSERT_EQUAL(1, socket().sentBinary.size());
+    TEST_ASSERT_EQUAL_UINT8(1, client.getOutbox().unsentCount());
+
+    // Cảnh báo không chờ hạn mức, kéo theo lô dữ liệu xếp trước nó
+    client.sendSensorAlert("flame", true, AlertLevel::CRITICAL);
+    TEST_ASSERT_EQUAL(3, socket().sentBinary.size());
+    TEST_ASSERT_EQUAL_UINT8(0, client.getOutbox().unsentCount());
+
+    hal::advanceMillis(1000);                            // nạp lại 1 token
+    client.sendSensorData(SENSOR_GAS, 12.0f, AlertLevel::NORMAL);
+    TEST_ASSERT_EQUAL(4, socket().sentBinary.size());
+
+    // Audio chỉ-credit: 600 byte cho 1 chunk 500, chunk sau chờ credit mới
+    uint8_t chunk[500] = {};
+    TEST_ASSERT_TRUE(client.sendAudioFrame(1, AUDIO_PCM16, 0, 250, chunk, sizeof(chunk)));
+    TEST_ASSERT_FALSE(client.sendAudioFrame(1, AUDIO_PCM16, 0, 250, chunk, sizeof(chunk)));
+    socket().serverText("{\"type\":\"ack\",\"payload\":{\"rateLimit\":{\"audio\":{\"credits\":500}}}}");
+    TEST_ASSERT_TRUE(client.sendAudioFrame(1, AUDIO_PCM16, 0, 250, chunk, sizeof(chunk)));
+
+    // Mất kết nối thì bỏ hạn mức, server cấp lại trong ack sau
+    socket().serverClose();
+    TEST_ASSERT_FALSE(client.getTelemetryBudget().isLimited());
+    TEST_ASSERT_FALSE(client.getAudioBudget().isLimited());
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_alert_levels_at_thresholds);
+    RUN_TEST(test_rules_hysteresis_and_dwell);
+    RUN_TEST(test_rules_rate_of_change);
+    RUN_TEST(test_rules_send_on_delta);
+    RUN_TEST(test_connection_init_and_ack);
+    RUN_TEST(test_sensor_batch_as_json);
+    RUN_TEST(test_sensor_data_as_bin1);
+    RUN_TEST(test_send_failure_keeps_entries_queued);
+    RUN_TEST(test_disconnect_rewinds_unacked_entries);
+    RUN_TEST(test_rules_update_from_behavior_message);   // trước khi dispatch thay handler behavior_update
+    RUN_TEST(test_dispatch_by_message_type);
+    RUN_TEST(test_actuator_command_is_acknowledged);
+    RUN_TEST(test_pong_records_rtt);
+    RUN_TEST(test_ota_frames_dispatch_and_ack);
+    RUN_TEST(test_clock_sync_keeps_lowest_rtt_sample);
+    RUN_TEST(test_clock_ack_and_trace_id_in_envelope);
+    RUN_TEST(test_dict1_compression_round_trip);
+    RUN_TEST(test_reconnect_backoff_grows_with_jitter);
+    RUN_TEST(test_rate_limit_throttles_telemetry_and_audio);
+    return UNITY_END();
+}
@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""So sánh hai log của env:bench (src/bench/bench_main.cpp) và báo hồi quy.
+
+Mỗi dòng kết quả có dạng `BENCH <suite> key=value ...`. Giá trị không phải số
+(clip, decoder, mode, encoding, kernel...) cùng với suite, `records` và
+`esp_dsp` tạo thành khoá của phép đo; giá trị số là chỉ số. fps/sps càng cao càng tốt, còn lại (thời gian,
+byte, số lần mất/tràn) càng thấp càng tốt.
+
+Ví dụ:
+    python tools/bench_compare.py bench-v1.2.log bench-v1.3.log
+    python tools/bench_compare.py old.log new.log --threshold 10
+
+Thoát với mã 1 nếu có chỉ số tệ đi quá ngưỡng (mặc định 5%).
+"""
+
+import argparse
+import shlex
+import sys
+
+HIGHER_IS_BETTER = ("fps", "sps")
+IGNORED = {"frames", "iters", "samples", "seconds", "pings", "ms", "build", "heap", "psram",
+           "pushed_tiles", "skipped_tiles", "enabled", "clip_set", "cpu_mhz", "connect_ms", "block"}
+IDENTITY = {"records", "esp_dsp"}
+
+
+def parse(path):
+    """Trả về {(suite, khoá...): {chỉ số: float}}."""
+    results = {}
+    with open(path, "r", encoding="utf-8", errors="replace") as f:
+        for line in f:
+            start = line.find("BENCH ")
+            if start < 0:
+                continue
+            try:
+                parts = shlex.split(line[start:].strip())
+            except ValueError:
+                continue
+            if len(parts) < 2:
+                continue
+            suite = parts[1]
+            identity = [suite]
+            metrics = {}
+            for item in parts[2:]:
+                key, _, value = item.partition("=")
+                try:
+                    number = float(value)
+                except ValueError:
+                    identity.append(f"{key}={value}")
+                    continue
+                if key in IDENTITY:
+                    identity.append(f"{key}={value}")
+                elif key not in IGNORED:
+                    metrics[key] = number
+            if metrics:
+                results[tuple(identity)] = metrics
+    return results
+
+
+def change(key, old, new):
+    """% thay đổi, dương = tệ đi."""
+    if old == 0:
+        return 0.0 if new == 0 else 100.0
+    delta = (new - old) / abs(old) * 100.0
+    return -delta if key in HIGHER_IS_BETTER else delta
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline")
+    parser.add_argument("candidate")
+    parser.add_argument("--threshold", type=float, default=5.0, help="%% tệ đi tối đa cho phép")
+    args = parser.parse_args()
+
+    base = parse(args.baseline)
+    cand = parse(args.candidate)
+    regressions = 0
+    for identity in sorted(base.keys() | cand.keys()):
+        name = " ".join(identity)
+        if identity not in cand:
+            print(f"MISSING  {name}")
+            continue
+        if identity not in base:
+            print(f"NEW      {name}")
+            continue
+        for key, old in sorted(base[identity].items()):
+            new = cand[identity].get(key)
+            if new is None:
+                continue
+            worse = change(key, old, new)
+            tag = "REGRESS" if worse > args.threshold else ("IMPROVE" if worse < -args.threshold else "ok")
+            if tag == "REGRESS":
+                regressions += 1
+            if tag != "ok":
+                print(f"{tag:8} {name} {key}: {old:g} -> {new:g} ({worse:+.1f}%)")
+    print(f"{regressions} regression(s) over {args.threshold:g}%")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,293 @@
+#!/usr/bin/env python3
+"""Tạo patch HGP2 (có chữ ký) giữa hai ảnh firmware để OTA qua WebSocket.
+
+Robot áp patch lên chính ảnh đang chạy (lib/Ota/DeltaPatch.h), nên chỉ cần gửi
+phần khác nhau: sửa vài hàm thường cho patch vài chục KB thay vì cả ảnh
+nhiều MB (animation biên dịch sẵn vào ảnh gần như không đổi giữa các bản).
+
+Cách tìm vùng giống nhau theo tinh thần bsdiff: tìm đoạn khớp chính xác qua
+bảng băm các cửa sổ WINDOW byte của ảnh cũ, rồi kéo dài vùng khớp gần đúng
+tới khi hơn nửa số byte còn giống. Trong vùng đó chỉ lưu hiệu từng byte; hiệu
+của code bị dịch địa chỉ hầu hết bằng 0, nên được tách thành COPY (chạy 0) và
+ADD (chạy khác 0). Phần còn lại là INSERT.
+
+Header được ký ECDSA P-256 bằng khoá riêng của người phát hành (cần gói
+cryptography); robot kiểm bằng khoá công khai biên dịch vào firmware
+(-DHOMEGUARD_OTA_PUBKEY, xem lib/Ota/OtaUpdater.h) và chỉ nhận version lớn hơn
+HOMEGUARD_FW_VERSION của nó.
+
+Ví dụ:
+    openssl ecparam -name prime256v1 -genkey -noout -out ota-key.pem      # một lần, giữ bí mật
+    python tools/mkdelta.py --key ota-key.pem --print-pubkey               # giá trị cho HOMEGUARD_OTA_PUBKEY
+    python tools/mkdelta.py old/firmware.bin .pio/build/esp32doit-devkit-v1/firmware.bin -o update.hgp \
+        --key ota-key.pem --version 42
+    python tools/mkdelta.py old.bin new.bin -o update.hgp --key ota-key.pem --version 42 --check
+
+old.bin phải đúng là ảnh robot đang chạy: robot so SHA-256 của phân vùng hiện
+tại với sourceSha trong header và từ chối patch lệch bản.
+"""
+
+import argparse
+import hashlib
+import struct
+import sys
+
+MAGIC = b"HGP2"
+SIGNED_SIZE = 80
+HEADER_SIZE = SIGNED_SIZE + 64
+OP_COPY, OP_ADD, OP_INSERT, OP_SEEK = range(4)
+
+WINDOW = 12            # độ dài cửa sổ băm, cũng là độ dài khớp tối thiểu
+MIN_ZERO_RUN = 4       # chạy 0 ngắn hơn gộp vào ADD (rẻ hơn một op COPY)
+MAX_CANDIDATES = 8     # số vị trí cũ thử cho mỗi cửa sổ
+
+
+def encode_op(op, n):
+    """Byte op (2 bit loại, bit 5 = còn varint, 5 bit thấp của n) + varint n >> 5."""
+    out = bytearray()
+    low = n & 0x1F
+    rest = n >> 5
+    out.append((op << 6) | (0x20 if rest else 0) | low)
+    while rest:
+        b = rest & 0x7F
+        rest >>= 7
+        out.append(b | (0x80 if rest else 0))
+    return bytes(out)
+
+
+def zigzag(delta):
+    return (delta << 1) if delta >= 0 else ((-delta) << 1) - 1
+
+
+class PatchWriter:
+    def __init__(self):
+        self.out = bytearray()
+        self.source_pos = 0
+        self.stats = {"copy": 0, "add": 0, "insert": 0, "seek": 0}
+
+    def seek(self, pos):
+        if pos != self.source_pos:
+            self.out += encode_op(OP_SEEK, zigzag(pos - self.source_pos))
+            self.source_pos = pos
+            self.stats["seek"] += 1
+
+    def insert(self, data):
+        if data:
+            self.out += encode_op(OP_INSERT, len(data)) + data
+            self.stats["insert"] += len(data)
+
+    def region(self, old, new, src, dst, length):
+        """Vùng khớp gần đúng: tách hiệu thành chạy 0 (COPY) và chạy khác 0 (ADD)."""
+        self.seek(src)
+        diff = bytes((new[dst + i] - old[src + i]) & 0xFF for i in range(length))
+        i = 0
+        while i < length:
+            j = i
+            while j < length and diff[j] == 0:
+                j += 1
+            if j - i >= MIN_ZERO_RUN or j == length:
+                if j > i:
+                    self.out += encode_op(OP_COPY, j - i)
+                    self.stats["copy"] += j - i
+                i = j
+                continue
+            # ADD tới chạy 0 đủ dài kế tiếp
+            k = i
+            zeros = 0
+            while k < length:
+                zeros = zeros + 1 if diff[k] == 0 else 0
+                if zeros >= MIN_ZERO_RUN:
+                    k -= zeros - 1
+                    break
+                k += 1
+            k = min(k, length)
+            self.out += encode_op(OP_ADD, k - i) + diff[i:k]
+            self.stats["add"] += k - i
+            i = k
+        self.source_pos = src + length
+
+
+def build_index(old):
+    index = {}
+    for i in range(len(old) - WINDOW + 1):
+        key = old[i:i + WINDOW]
+        slot = index.get(key)
+        if slot is None:
+            index[key] = [i]
+        elif len(slot) < MAX_CANDIDATES:
+            slot.append(i)
+    return index
+
+
+def exact_length(old, new, src, dst):
+    n = 0
+    limit = min(len(old) - src, len(new) - dst)
+    while n < limit and old[src + n] == new[dst + n]:
+        n += 1
+    return n
+
+
+def approx_length(old, new, src, dst):
+    """Kéo dài như bsdiff: lấy độ dài có (số byte giống * 2 - độ dài) lớn nhất."""
+    limit = min(len(old) - src, len(new) - dst)
+    score = best_score = best = 0
+    for i in range(limit):
+        if old[src + i] == new[dst + i]:
+            score += 1
+        if score * 2 - (i + 1) > best_score * 2 - best:
+            best_score = score
+            best = i + 1
+        elif (i + 1) - best > 4 * WINDOW and score * 2 - (i + 1) < 0:
+            break
+    return best
+
+
+def load_key(path):
+    try:
+        from cryptography.hazmat.primitives import serialization
+    except ImportError:
+        sys.exit("cần gói cryptography để ký patch: pip install cryptography")
+    with open(path, "rb") as f:
+        return serialization.load_pem_private_key(f.read(), password=None)
+
+
+def public_key_hex(key):
+    from cryptography.hazmat.primitives import serialization
+    point = key.public_key().public_bytes(serialization.Encoding.X962,
+                                          serialization.PublicFormat.UncompressedPoint)
+    return point.hex()
+
+
+def sign_header(key, signed):
+    """ECDSA P-256 trên SHA-256(signed), chữ ký dạng r || s mỗi số 32 byte big-endian."""
+    from cryptography.hazmat.primitives import hashes
+    from cryptography.hazmat.primitives.asymmetric import ec, utils
+    r, s = utils.decode_dss_signature(key.sign(signed, ec.ECDSA(hashes.SHA256())))
+    return r.to_bytes(32, "big") + s.to_bytes(32, "big")
+
+
+def verify_header(key, patch):
+    from cryptography.exceptions import InvalidSignature
+    from cryptography.hazmat.primitives import hashes
+    from cryptography.hazmat.primitives.asymmetric import ec, utils
+    sig = patch[SIGNED_SIZE:HEADER_SIZE]
+    der = utils.encode_dss_signature(int.from_bytes(sig[:32], "big"), int.from_bytes(sig[32:], "big"))
+    try:
+        key.public_key().verify(der, patch[:SIGNED_SIZE], ec.ECDSA(hashes.SHA256()))
+        return True
+    except InvalidSignature:
+        return False
+
+
+def make_patch(old, new, key, version):
+    index = build_index(old)
+    writer = PatchWriter()
+    dst = 0
+    literal = dst
+    expected = 0                       # vị trí cũ tương ứng nếu ảnh chỉ dịch đi
+    while dst < len(new):
+        best_src, best_len = -1, 0
+        key = new[dst:dst + WINDOW]
+        candidates = index.get(key, []) if len(key) == WINDOW else []
+        if 0 <= expected < len(old) and old[expected:expected + WINDOW] == key:
+            candidates = [expected] + candidates
+        for src in candidates:
+            n = exact_length(old, new, src, dst)
+            if n > best_len:
+                best_src, best_len = src, n
+        if best_len < WINDOW:
+            dst += 1
+            expected += 1
+            continue
+        writer.insert(new[literal:dst])
+        length = max(best_len, approx_length(old, new, best_src, dst))
+        writer.region(old, new, best_src, dst, length)
+        dst += length
+        literal = dst
+        expected = best_src + length
+    writer.insert(new[literal:])
+    signed = MAGIC + struct.pack("<II", len(old), len(new)) + hashlib.sha256(old).digest() + \
+        hashlib.sha256(new).digest() + struct.pack("<I", version)
+    return signed + sign_header(key, signed) + bytes(writer.out), writer.stats
+
+
+def read_varint(patch, pos, first):
+    n = first & 0x1F
+    shift = 5
+    if first & 0x20:
+        while True:
+            b = patch[pos]
+            pos += 1
+            n |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                break
+    return n, pos
+
+
+def apply_patch(old, patch):
+    """Bản tham chiếu của DeltaPatch::feed(), dùng cho --check."""
+    if patch[:4] != MAGIC:
+        raise ValueError("không phải patch HGP2")
+    source_size, target_size = struct.unpack_from("<II", patch, 4)
+    if hashlib.sha256(old).digest() != patch[12:44]:
+        raise ValueError("ảnh nguồn không khớp sourceSha")
+    out = bytearray()
+    pos = HEADER_SIZE
+    src = 0
+    while len(out) < target_size:
+        first = patch[pos]
+        n, pos = read_varint(patch, pos + 1, first)
+        op = first >> 6
+        if op == OP_COPY:
+            out += old[src:src + n]
+            src += n
+        elif op == OP_ADD:
+            out += bytes((old[src + i] + patch[pos + i]) & 0xFF for i in range(n))
+            src += n
+            pos += n
+        elif op == OP_INSERT:
+            out += patch[pos:pos + n]
+            pos += n
+        else:
+            src += (n >> 1) ^ -(n & 1)
+    if pos != len(patch) or hashlib.sha256(out).digest() != patch[44:76]:
+        raise ValueError("patch hỏng")
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("old", nargs="?", help="ảnh đang chạy trên robot")
+    parser.add_argument("new", nargs="?", help="ảnh mới (firmware.bin)")
+    parser.add_argument("-o", "--output")
+    parser.add_argument("--key", required=True, help="khoá riêng ECDSA P-256 (PEM) để ký header")
+    parser.add_argument("--version", type=int, help="HOMEGUARD_FW_VERSION của ảnh mới (u32)")
+    parser.add_argument("--print-pubkey", action="store_true", help="in khoá công khai cho HOMEGUARD_OTA_PUBKEY")
+    parser.add_argument("--check", action="store_true", help="kiểm chữ ký, áp lại patch và so với ảnh mới")
+    args = parser.parse_args()
+
+    key = load_key(args.key)
+    if args.print_pubkey:
+        print(public_key_hex(key))
+        return
+    if not (args.old and args.new and args.output) or args.version is None:
+        parser.error("cần old, new, -o và --version")
+    if not 0 < args.version < 1 << 32:
+        parser.error("--version phải là số u32 dương")
+
+    with open(args.old, "rb") as f:
+        old = f.read()
+    with open(args.new, "rb") as f:
+        new = f.read()
+    patch, stats = make_patch(old, new, key, args.version)
+    if args.check and (not verify_header(key, patch) or apply_patch(old, patch) != new):
+        sys.exit("kiểm tra thất bại: chữ ký sai hoặc patch không tái tạo được ảnh mới")
+    with open(args.output, "wb") as f:
+        f.write(patch)
+    print(f"{args.output}: {len(patch)} byte ({100.0 * len(patch) / len(new):.1f}% ảnh mới) | "
+          f"copy={stats['copy']} add={stats['add']} insert={stats['insert']} seek={stats['seek']}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,30 @@
+"""extra_script của env:native và env:native_bench (pio test trên máy dev).
+
+lib/Screen, lib/Microphone và lib/Ota nằm trong lib_ignore vì kéo theo TFT_eSPI,
+task capture, esp_ota_ops... Script chỉ biên dịch các file logic thuần của các
+thư viện đó (header lấy qua -I trong build_flags), để test và microbenchmark gọi
+được mà không cần shim cho cả màn hình.
+
+custom_sanitize = address,undefined bật sanitizer cho cả bước biên dịch lẫn link
+(build_flags chỉ đi vào bước biên dịch).
+"""
+
+Import("env")
+
+NATIVE_SOURCES = {
+    "Screen": ["DeltaAnim.cpp", "FrameCache.cpp", "FaceAnimator.cpp"],
+    "Microphone": ["INMP441.cpp", "AudioDsp.cpp"],
+    "Ota": ["DeltaPatch.cpp"],
+}
+
+for lib, files in NATIVE_SOURCES.items():
+    env.BuildSources(
+        "$BUILD_DIR/native_%s" % lib,
+        "$PROJECT_DIR/lib/%s" % lib,
+        src_filter=["-<*>"] + ["+<%s>" % name for name in files],
+    )
+
+sanitize = env.GetProjectOption("custom_sanitize", "")
+if sanitize:
+    flags = ["-fsanitize=" + sanitize, "-fno-sanitize-recover=all", "-fno-omit-frame-pointer"]
+    env.Append(CCFLAGS=flags, LINKFLAGS=flags)
@@ -0,0 +1,215 @@
+#!/usr/bin/env python3
+"""Chuyển các header video*.h (frame JPEG PROGMEM) sang định dạng HGA1.
+
+HGA1 lưu frame đầu đầy đủ, các frame sau chỉ lưu những tile 16x16 thay đổi,
+mỗi tile nén RLE trên pixel RGB565. Bố cục chi tiết xem lib/Screen/DeltaAnim.h.
+
+Với --bin, blob được ghi ra file để nạp lên LittleFS (thư mục data/, rồi
+`pio run -t uploadfs`) và phát bằng fileVideo("/video01.hga").
+--format jpeg đóng gói nguyên các frame JPEG thành HGJ1 (không cần Pillow).
+
+Ví dụ:
+    python tools/video2delta.py lib/Screen/video01.h                # -> lib/Screen/video01_delta.h
+    python tools/video2delta.py lib/Screen/video*.h --tolerance 2
+    python tools/video2delta.py lib/Screen/video01.h --bin data/video01.hga
+    python tools/video2delta.py lib/Screen/video01.h --format jpeg --bin data/video01.hgj
+
+Cần Pillow (pip install pillow) để giải mã JPEG.
+"""
+
+import argparse
+import io
+import os
+import re
+import struct
+import sys
+
+FRAME_RE = re.compile(r"const uint8_t (\w+?)_jpg_frame_(\d+)\[\] PROGMEM = \{(.*?)\};", re.S)
+BYTE_RE = re.compile(r"0x([0-9A-Fa-f]{2})")
+
+MAX_RUN = 128
+
+
+def load_jpeg_frames(path):
+    """Trả về (tên video, danh sách frame JPEG theo thứ tự)."""
+    with open(path, "r", encoding="utf-8") as f:
+        text = f.read()
+    frames = {}
+    name = None
+    for match in FRAME_RE.finditer(text):
+        name = match.group(1)
+        frames[int(match.group(2))] = bytes(int(b, 16) for b in BYTE_RE.findall(match.group(3)))
+    if not frames:
+        raise ValueError(f"{path}: không tìm thấy frame JPEG nào")
+    return name, [frames[i] for i in sorted(frames)]
+
+
+def decode_rgb565(jpeg, width, height):
+    """Giải mã JPEG, cắt/đệm về width x height (giống TFT cắt phần tràn), trả về list RGB565."""
+    from PIL import Image
+
+    img = Image.open(io.BytesIO(jpeg)).convert("RGB")
+    canvas = Image.new("RGB", (width, height))
+    canvas.paste(img.crop((0, 0, min(width, img.width), min(height, img.height))), (0, 0))
+    return [((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3) for r, g, b in canvas.getdata()]
+
+
+def close_enough(a, b, tolerance):
+    """So sánh 2 pixel RGB565 theo từng kênh, bỏ qua nhiễu JPEG nhỏ."""
+    if tolerance == 0:
+        return a == b
+    return (abs((a >> 11) - (b >> 11)) <= tolerance
+            and abs(((a >> 5) & 0x3F) - ((b >> 5) & 0x3F)) <= tolerance * 2
+            and abs((a & 0x1F) - (b & 0x1F)) <= tolerance)
+
+
+def rle_encode(pixels):
+    """RLE: op & 0x80 = lặp 1 màu, ngược lại = chuỗi literal; pixel ghi big-endian (thứ tự SPI)."""
+    out = bytearray()
+    i = 0
+    n = len(pixels)
+    while i < n:
+        run = 1
+        while i + run < n and run < MAX_RUN and pixels[i + run] == pixels[i]:
+            run += 1
+        if run >= 2:
+            out.append(0x80 | (run - 1))
+            out += struct.pack(">H", pixels[i])
+            i += run
+            continue
+        start = i
+        while i < n and i - start < MAX_RUN:
+            if i + 1 < n and pixels[i + 1] == pixels[i]:
+                break
+            i += 1
+        out.append(i - start - 1)
+        for p in pixels[start:i]:
+            out += struct.pack(">H", p)
+    return bytes(out)
+
+
+def tile_rect(index, width, height, tile):
+    per_row = (width + tile - 1) // tile
+    x = (index % per_row) * tile
+    y = (index // per_row) * tile
+    return x, y, min(tile, width - x), min(tile, height - y)
+
+
+def encode_frames(frames, width, height, tile=16, tolerance=0, keyframe=0):
+    """Mã hoá danh sách frame RGB565 thành blob HGA1, trả về (blob, số tile đã ghi)."""
+    tiles_x = (width + tile - 1) // tile
+    tiles_y = (height + tile - 1) // tile
+    shown = None          # ảnh đang hiển thị trên màn hình sau khi áp delta
+    payloads = []
+    written = 0
+
+    for index, frame in enumerate(frames):
+        full = shown is None or (keyframe and index % keyframe == 0)
+        if shown is None:
+            shown = [0] * (width * height)
+        body = bytearray()
+        count = 0
+        for t in range(tiles_x * tiles_y):
+            x, y, w, h = tile_rect(t, width, height, tile)
+            rows = [range((y + r) * width + x, (y + r) * width + x + w) for r in range(h)]
+            if not full and all(close_enough(frame[i], shown[i], tolerance) for row in rows for i in row):
+                continue
+            pixels = [frame[i] for row in rows for i in row]
+            for row in rows:
+                for i in row:
+                    shown[i] = frame[i]
+            body += struct.pack("<H", t) + rle_encode(pixels)
+            count += 1
+        payloads.append(struct.pack("<H", count) + bytes(body))
+        written += count
+
+    header = b"HGA1" + struct.pack("<HHBBH", width, height, tile, 0, len(frames))
+    offset = len(header) + 4 * (len(frames) + 1)
+    offsets = []
+    for payload in payloads:
+        offsets.append(offset)
+        offset += len(payload)
+    offsets.append(offset)
+    blob = header + struct.pack(f"<{len(offsets)}I", *offsets) + b"".join(payloads)
+    return blob, written
+
+
+def pack_jpeg(jpegs, width, height):
+    """Đóng gói frame JPEG nguyên bản thành HGJ1 (cùng header + bảng offset với HGA1)."""
+    header = b"HGJ1" + struct.pack("<HHBBH", width, height, 0, 0, len(jpegs))
+    offset = len(header) + 4 * (len(jpegs) + 1)
+    offsets = []
+    for jpeg in jpegs:
+        offsets.append(offset)
+        offset += len(jpeg)
+    offsets.append(offset)
+    return header + struct.pack(f"<{len(offsets)}I", *offsets) + b"".join(jpegs)
+
+
+def write_header(path, name, blob, num_frames):
+    with open(path, "w", encoding="utf-8") as f:
+        f.write(f"// {name}: HGA1 delta animation, {num_frames} frames, {len(blob)} bytes\n")
+        f.write("// Generated by tools/video2delta.py - do not edit\n")
+        f.write("#pragma once\n#include \"Screen.h\"\n\n")
+        f.write(f"const uint8_t {name}_delta_data[] PROGMEM = {{\n")
+        for i in range(0, len(blob), 16):
+            f.write(", ".join(f"0x{b:02X}" for b in blob[i:i + 16]) + ", \n")
+        f.write("};\n\n")
+        f.write(f"VideoInfo {name}_delta = {{\n")
+        f.write(f"    nullptr,\n    nullptr,\n    {num_frames},\n    VIDEO_DELTA,\n")
+        f.write(f"    {name}_delta_data,\n    sizeof({name}_delta_data)\n}};\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("inputs", nargs="+", help="các file video*.h nguồn")
+    parser.add_argument("--width", type=int, default=240)
+    parser.add_argument("--height", type=int, default=240)
+    parser.add_argument("--tile", type=int, default=16, help="cạnh tile, tối đa 16")
+    parser.add_argument("--tolerance", type=int, default=1,
+                        help="sai khác tối đa mỗi kênh 565 vẫn coi là không đổi (0 = lossless)")
+    parser.add_argument("--keyframe", type=int, default=0, help="chèn frame đầy đủ mỗi N frame (0 = chỉ frame đầu)")
+    parser.add_argument("--format", choices=("delta", "jpeg"), default="delta",
+                        help="delta = HGA1, jpeg = HGJ1 giữ nguyên frame JPEG (chỉ với --bin)")
+    parser.add_argument("--bin", help="ghi blob nhị phân (chỉ dùng với 1 input)")
+    parser.add_argument("--out-dir", help="thư mục ghi *_delta.h (mặc định cạnh file nguồn)")
+    args = parser.parse_args()
+
+    if not 0 < args.tile <= 16:
+        parser.error("--tile phải trong khoảng 1..16")
+    if args.bin and len(args.inputs) != 1:
+        parser.error("--bin chỉ nhận 1 input")
+    if args.format == "jpeg" and not args.bin:
+        parser.error("--format jpeg cần --bin")
+
+    total_in = total_out = 0
+    for path in args.inputs:
+        name, jpegs = load_jpeg_frames(path)
+        if args.format == "jpeg":
+            blob, tiles = pack_jpeg(jpegs, args.width, args.height), 0
+        else:
+            frames = [decode_rgb565(j, args.width, args.height) for j in jpegs]
+            blob, tiles = encode_frames(frames, args.width, args.height, args.tile, args.tolerance, args.keyframe)
+
+        if args.bin:
+            with open(args.bin, "wb") as f:
+                f.write(blob)
+            out = args.bin
+        else:
+            out_dir = args.out_dir or os.path.dirname(path)
+            out = os.path.join(out_dir, f"{name}_delta.h")
+            write_header(out, name, blob, len(jpegs))
+
+        jpeg_size = sum(len(j) for j in jpegs)
+        total_in += jpeg_size
+        total_out += len(blob)
+        print(f"{name}: {len(jpegs)} frames, {tiles} tiles, "
+              f"JPEG {jpeg_size} B -> {blob[:4].decode()} {len(blob)} B ({100.0 * len(blob) / jpeg_size:.0f}%) -> {out}")
+
+    if len(args.inputs) > 1:
+        print(f"total: {total_in} B -> {total_out} B")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,84 @@
+// Cumulative acks for the firmware's reliable outbound queue
+// (Firmware/esp32/lib/WebSocketClient/OutboundQueue.h).
+//
+// Every sensor sample / alert carries a 16-bit seq; a message's seq is the seq
+// of its last record and records within a message are contiguous. The server
+// keeps the highest seq seen per device, drops replayed records and sends one
+// coalesced `ack { ackSeq }` per ACK_DELAY_MS instead of one per message.
+
+const SEQ_MASK = 0xffff;
+const ACK_DELAY_MS = 100;
+// Stored seq is trusted on reconnect only if it lies within this many seqs
+// after the device's resumeSeq; anything else means the device rebooted.
+const RESUME_WINDOW = 256;
+
+const seqDistance = (from: number, to: number): number => (to - from) & SEQ_MASK;
+
+// a comes after b in 16-bit wrap-around order
+export const seqAfter = (a: number, b: number): boolean => {
+  const d = seqDistance(b, a);
+  return d !== 0 && d < 0x8000;
+};
+
+// Survives socket reconnects so replays after a Wi-Fi blip are recognised
+const lastSeqByDevice = new Map<string, number>();
+
+export class AckTracker {
+  private timer: NodeJS.Timeout | null = null;
+
+  constructor(
+    private readonly deviceId: string,
+    private readonly sendAck: (ackSeq: number) => void,
+  ) {}
+
+  // connection_init.resumeSeq = oldest unacked seq on the device.
+  // Returns the ackSeq to put in the connection ack.
+  resume(resumeSeq: unknown): number | undefined {
+    if (typeof resumeSeq !== 'number') {
+      return lastSeqByDevice.get(this.deviceId);
+    }
+    const baseline = (resumeSeq - 1) & SEQ_MASK;
+    const stored = lastSeqByDevice.get(this.deviceId);
+    if (stored === undefined || seqDistance(baseline, stored) > RESUME_WINDOW) {
+      lastSeqByDevice.set(this.deviceId, baseline);
+      return baseline;
+    }
+    return stored;
+  }
+
+  // Message with `count` contiguous records ending at `seq`.
+  // Returns how many leading records were already received (skip them).
+  accept(seq: number, count: number): number {
+    const last = lastSeqByDevice.get(this.deviceId);
+    const first = (seq - count + 1) & SEQ_MASK;
+    let duplicates = 0;
+    if (last !== undefined && !seqAfter(first, last)) {
+      duplicates = seqAfter(seq, last) ? seqDistance(first, last) + 1 : count;
+    }
+    if (last === undefined || seqAfter(seq, last)) {
+      lastSeqByDevice.set(this.deviceId, seq & SEQ_MASK);
+    }
+    this.scheduleAck();
+    return Math.min(duplicates, count);
+  }
+
+  dispose(): void {
+    if (this.timer) {
+      clearTimeout(this.timer);
+      this.timer = null;
+    }
+  }
+
+  private scheduleAck(): void {
+    if (this.timer) {
+      return;
+    }
+    this.timer = setTimeout(() => {
+      this.timer = null;
+      const ackSeq = lastSeqByDevice.get(this.deviceId);
+      if (ackSeq !== undefined) {
+        this.sendAck(ackSeq);
+      }
+    }, ACK_DELAY_MS);
+  }
+}
@@ -2,7 +2,20 @@ import { Socket } from 'socket.io';
 import { logger } from '@/utils/logger';
 import { WebSocketEvent } from '@homeguard/types';
 import { processFaceDetection, processMotionDetection, processAIResult } from '@/services/ai-engine.service';
-import { broadcastToRoom } from './index';
+import { broadcastToRoom, getIO } from './index';
+import { AudioCodec, encodeAudioFrame } from './binary-frame';
+
+// Audio-down sequence numbers per device, so the firmware can count gaps
+const ttsSeq = new Map<string, number>();
+
+interface TtsChunk {
+  deviceId: string;
+  streamId: number;
+  codec: AudioCodec;
+  flags: number;
+  samples: number;
+  payload: Buffer;
+}
 
 export const handleAIEngineConnection = (socket: Socket) => {
   const engineId = socket.handshake.query.engineId as string || socket.id;
@@ -96,6 +109,26 @@ export const handleAIEngineConnection = (socket: Socket) => {
     });
   });
 
+  // TTS chunks: forwarded to the robot as binary frames as soon as they arrive,
+  // so playback starts before the whole answer is synthesized
+  socket.on('tts:audio', (chunk: TtsChunk) => {
+    try {
+      const seq = ttsSeq.get(chunk.deviceId) ?? 0;
+      ttsSeq.set(chunk.deviceId, (seq + 1) & 0xffff);
+      const frame = encodeAudioFrame(
+        seq,
+        chunk.streamId,
+        chunk.codec,
+        chunk.flags,
+        chunk.samples,
+        Buffer.from(chunk.payload)
+      );
+      getIO().to(`esp32:${chunk.deviceId}`).emit('audio:bin', frame);
+    } catch (error) {
+      logger.error('Error forwarding TTS audio:', error);
+    }
+  });
+
   // AI Engine status updates
   socket.on(WebSocketEvent.AI_STATUS, (status: any) => {
     logger.debug({ event: 'ai_status', engineId, status });
@@ -0,0 +1,235 @@
+import { SensorType } from '@homeguard/types';
+
+// Binary telemetry frames sent by the ESP32 firmware once "bin1" is negotiated.
+// Layout mirrors Firmware/esp32/lib/Protocol/BinaryFrame.h (little-endian).
+
+export const BINARY_ENCODING = 'bin1';
+export const BINARY_VERSION = 1;
+
+const HEADER_SIZE = 8;
+const RECORD_SIZE = 8;
+
+export enum BinaryChannel {
+  SENSOR_DATA = 1,
+  SENSOR_ALERT = 2,
+  AUDIO_UP = 3,
+  AUDIO_DOWN = 4,
+  // ESP32-CAM: VideoHeader (8 bytes) + JPEG, sent as one fragmented message
+  VIDEO = 5,
+  // Firmware update: OtaHeader (8 bytes) + signed HGP2 patch bytes (tools/mkdelta.py)
+  OTA = 6,
+  // Uplink JSON message, dictionary-coded "dict1" (json-pack.ts)
+  JSON = 7,
+}
+
+export enum OtaOp {
+  BEGIN = 1,
+  DATA = 2,
+  END = 3,
+  ABORT = 4,
+  ACK = 5,
+  RESULT = 6,
+}
+
+export enum OtaStatus {
+  OK = 0,
+  ERR_BUSY = 1,
+  ERR_HEADER = 2,
+  ERR_SOURCE = 3,
+  ERR_NO_PARTITION = 4,
+  ERR_WRITE = 5,
+  ERR_PATCH = 6,
+  ERR_VERIFY = 7,
+  ERR_RESYNC = 8,
+  // Bad signature, or an unsigned build on plain ws://
+  ERR_AUTH = 9,
+  // Patch version not newer than the running build
+  ERR_VERSION = 10,
+}
+
+export enum AudioCodec {
+  PCM16 = 0,
+  IMA_ADPCM = 1,
+  OPUS = 2,
+}
+
+// Names used in connection_init.audioCodecs and voice_command.codec
+export const AUDIO_CODEC_NAMES: Record<AudioCodec, string> = {
+  [AudioCodec.PCM16]: 'pcm16',
+  [AudioCodec.IMA_ADPCM]: 'adpcm',
+  [AudioCodec.OPUS]: 'opus',
+};
+
+// Codecs the server can forward; the firmware's list is in preference order
+const SUPPORTED_AUDIO_CODECS = new Set(Object.values(AUDIO_CODEC_NAMES));
+
+export const AUDIO_FLAG_START = 0x01;
+export const AUDIO_FLAG_END = 0x02;
+const AUDIO_HEADER_SIZE = 6;
+
+export const ALERT_LEVELS = ['normal', 'warning', 'danger', 'critical'] as const;
+
+// Index = SensorKind on the device
+const SENSOR_KINDS: { type: string; unit: string }[] = [
+  { type: SensorType.TEMPERATURE, unit: 'C' },
+  { type: SensorType.HUMIDITY, unit: '%' },
+  { type: SensorType.GAS, unit: 'raw' },
+  { type: SensorType.DISTANCE, unit: 'cm' },
+  { type: SensorType.MOTION, unit: '' },
+  { type: 'flame', unit: '' },
+  { type: SensorType.LIGHT, unit: 'lux' },
+  { type: SensorType.SOUND, unit: 'dB' },
+];
+
+export interface BinaryRecord {
+  sensorType: string;
+  unit: string;
+  alertLevel: (typeof ALERT_LEVELS)[number];
+  value: number;
+  // Device millis() when the sample was taken
+  sampledAt: number;
+}
+
+export interface BinaryFrame {
+  channel: BinaryChannel;
+  seq: number;
+  timestamp: number;
+  records: BinaryRecord[];
+}
+
+// Pick the first encoding offered in connection_init that the server understands
+export const negotiateEncoding = (offered: unknown): string => {
+  if (Array.isArray(offered) && offered.includes(BINARY_ENCODING)) {
+    return BINARY_ENCODING;
+  }
+  return 'json';
+};
+
+// Pick the first audio codec in the firmware's preference list that the server supports
+export const negotiateAudioCodec = (offered: unknown): string => {
+  if (Array.isArray(offered)) {
+    const match = offered.find((codec) => SUPPORTED_AUDIO_CODECS.has(codec));
+    if (match) {
+      return match;
+    }
+  }
+  return AUDIO_CODEC_NAMES[AudioCodec.PCM16];
+};
+
+export const decodeBinaryFrame = (buf: Buffer): BinaryFrame => {
+  if (buf.length < HEADER_SIZE + 1) {
+    throw new Error(`Binary frame too short: ${buf.length} bytes`);
+  }
+  const version = buf.readUInt8(0);
+  if (version !== BINARY_VERSION) {
+    throw new Error(`Unsupported binary frame version ${version}`);
+  }
+
+  const channel = buf.readUInt8(1) as BinaryChannel;
+  const seq = buf.readUInt16LE(2);
+  const timestamp = buf.readUInt32LE(4);
+  const count = buf.readUInt8(HEADER_SIZE);
+  if (buf.length < HEADER_SIZE + 1 + count * RECORD_SIZE) {
+    throw new Error(`Binary frame truncated: ${count} records in ${buf.length} bytes`);
+  }
+
+  const records: BinaryRecord[] = [];
+  for (let i = 0; i < count; i++) {
+    const offset = HEADER_SIZE + 1 + i * RECORD_SIZE;
+    const kind = SENSOR_KINDS[buf.readUInt8(offset)] ?? { type: 'unknown', unit: '' };
+    records.push({
+      sensorType: kind.type,
+      unit: kind.unit,
+      alertLevel: ALERT_LEVELS[buf.readUInt8(offset + 1)] ?? 'normal',
+      sampledAt: timestamp - buf.readUInt16LE(offset + 2),
+      value: buf.readFloatLE(offset + 4),
+    });
+  }
+
+  return { channel, seq, timestamp, records };
+};
+
+export interface AudioFrame {
+  channel: BinaryChannel;
+  seq: number;
+  timestamp: number;
+  streamId: number;
+  codec: AudioCodec;
+  flags: number;
+  samples: number;
+  payload: Buffer;
+}
+
+export const isAudioFrame = (buf: Buffer): boolean =>
+  buf.length >= HEADER_SIZE && (buf.readUInt8(1) === BinaryChannel.AUDIO_UP || buf.readUInt8(1) === BinaryChannel.AUDIO_DOWN);
+
+export const decodeAudioFrame = (buf: Buffer): AudioFrame => {
+  if (buf.length < HEADER_SIZE + AUDIO_HEADER_SIZE) {
+    throw new Error(`Audio frame too short: ${buf.length} bytes`);
+  }
+  return {
+    channel: buf.readUInt8(1) as BinaryChannel,
+    seq: buf.readUInt16LE(2),
+    timestamp: buf.readUInt32LE(4),
+    streamId: buf.readUInt16LE(HEADER_SIZE),
+    codec: buf.readUInt8(HEADER_SIZE + 2) as AudioCodec,
+    flags: buf.readUInt8(HEADER_SIZE + 3),
+    samples: buf.readUInt16LE(HEADER_SIZE + 4),
+    payload: buf.subarray(HEADER_SIZE + AUDIO_HEADER_SIZE),
+  };
+};
+
+// Build a CHANNEL_AUDIO_DOWN frame (TTS) for the firmware's TtsPlayer
+export const encodeAudioFrame = (
+  seq: number,
+  streamId: number,
+  codec: AudioCodec,
+  flags: number,
+  samples: number,
+  payload: Buffer
+): Buffer => {
+  const buf = Buffer.alloc(HEADER_SIZE + AUDIO_HEADER_SIZE + payload.length);
+  buf.writeUInt8(BINARY_VERSION, 0);
+  buf.writeUInt8(BinaryChannel.AUDIO_DOWN, 1);
+  buf.writeUInt16LE(seq & 0xffff, 2);
+  buf.writeUInt32LE(Date.now() >>> 0, 4);
+  buf.writeUInt16LE(streamId & 0xffff, HEADER_SIZE);
+  buf.writeUInt8(codec, HEADER_SIZE + 2);
+  buf.writeUInt8(flags, HEADER_SIZE + 3);
+  buf.writeUInt16LE(samples, HEADER_SIZE + 4);
+  payload.copy(buf, HEADER_SIZE + AUDIO_HEADER_SIZE);
+  return buf;
+};
+
+const IMA_STEPS = [
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88,
+  97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+  724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660,
+  4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818,
+  18500, 20350, 22385, 24623, 27086, 29794, 32767,
+];
+const IMA_INDEX_ADJUST = [-1, -1, -1, -1, 2, 4, 6, 8];
+
+// IMA-ADPCM payload: i16 predictor, u8 step index, u8 reserved, then 4-bit codes (low nibble first)
+export const decodeImaAdpcm = (payload: Buffer, samples: number): Int16Array => {
+  if (payload.length < 4 + Math.ceil(samples / 2)) {
+    throw new Error(`ADPCM payload truncated: ${samples} samples in ${payload.length} bytes`);
+  }
+  const pcm = new Int16Array(samples);
+  let predictor = payload.readInt16LE(0);
+  let index = Math.min(Math.max(payload.readUInt8(2), 0), 88);
+
+  for (let i = 0; i < samples; i++) {
+    const byte = payload.readUInt8(4 + (i >> 1));
+    const code = i & 1 ? byte >> 4 : byte & 0x0f;
+    const step = IMA_STEPS[index];
+    let delta = step >> 3;
+    if (code & 4) delta += step;
+    if (code & 2) delta += step >> 1;
+    if (code & 1) delta += step >> 2;
+    predictor = Math.min(Math.max(code & 8 ? predictor - delta : predictor + delta, -32768), 32767);
+    index = Math.min(Math.max(index + IMA_INDEX_ADJUST[code & 7], 0), 88);
+    pcm[i] = predictor;
+  }
+  return pcm;
+};
@@ -0,0 +1,25 @@
+// Clock samples for the firmware's ClockSync
+// (Firmware/esp32/lib/WebSocketClient/Trace.h).
+//
+// connection_init and heartbeat carry `clientSentUs` (device esp_timer, t0).
+// The reply echoes it with the server's receive (t1) and send (t2) times in
+// Unix epoch microseconds; the device stamps t3 on receipt and derives its
+// offset NTP-style, keeping the lowest-RTT sample of the last few heartbeats.
+// Device messages then carry `timeUs` (synced wall clock) and `traceId`.
+
+export interface ClockSample {
+  clientSentUs: number;
+  serverRecvUs: number;
+  serverSendUs: number;
+}
+
+// Wall clock with sub-millisecond resolution (Date.now() is ms only)
+export const nowUs = (): number => Math.round((performance.timeOrigin + performance.now()) * 1000);
+
+// receivedUs must be taken as soon as the request arrives, before any work
+export const clockSample = (clientSentUs: unknown, receivedUs: number): ClockSample | undefined => {
+  if (typeof clientSentUs !== 'number') {
+    return undefined;
+  }
+  return { clientSentUs, serverRecvUs: receivedUs, serverSendUs: nowUs() };
+};
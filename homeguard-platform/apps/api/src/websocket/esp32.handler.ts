@@ -3,6 +3,11 @@ import { logger } from '@/utils/logger';
 import { WebSocketEvent, SensorReading, RobotStatus } from '@homeguard/types';
 import { saveSensorData, saveRobotStatus } from '@/services/esp32.service';
 import { broadcastToRoom } from './index';
+import { BinaryChannel, decodeBinaryFrame, negotiateAudioCodec, negotiateEncoding } from './binary-frame';
+import { AckTracker } from './ack-tracker';
+import { clockSample, nowUs } from './clock';
+import { negotiateCompression, unpackJson } from './json-pack';
+import { defaultRateLimit } from './rate-limit';
 
 export const handleESP32Connection = (socket: Socket) => {
   const deviceId = socket.handshake.query.deviceId as string;
@@ -19,11 +24,109 @@ export const handleESP32Connection = (socket: Socket) => {
   socket.join(`esp32:${deviceId}`);
   socket.join('esp32');
 
+  // Coalesced cumulative acks for the firmware's outbound queue (see ack-tracker.ts)
+  const acks = new AckTracker(deviceId, (ackSeq) => {
+    socket.emit('ack', { type: 'ack', payload: { ackSeq }, timestamp: Date.now() });
+  });
+
+  // Encoding negotiation: firmware lists supported encodings in connection_init
+  let encoding = 'json';
+  socket.on('connection_init', (message: any) => {
+    const receivedUs = nowUs();
+    encoding = negotiateEncoding(message?.payload?.encodings);
+    const audioCodec = negotiateAudioCodec(message?.payload?.audioCodecs);
+    const ackSeq = acks.resume(message?.payload?.resumeSeq);
+    const compression = negotiateCompression(message?.payload?.compression);
+    logger.info(
+      `ESP32 ${deviceId} using ${encoding} telemetry encoding, ${audioCodec} audio, ${compression ?? 'no'} compression`
+    );
+    socket.emit('ack', {
+      type: 'ack',
+      payload: {
+        connectionId: socket.id,
+        encoding,
+        audioCodec,
+        ackSeq,
+        compression,
+        clock: clockSample(message?.payload?.clientSentUs, receivedUs),
+        rateLimit: defaultRateLimit(),
+      },
+      timestamp: Date.now(),
+    });
+  });
+
+  // Binary telemetry frames (encoding "bin1", see binary-frame.ts)
+  socket.on('telemetry:bin', async (buf: Buffer) => {
+    try {
+      // Compressed JSON: hand it to the same handler as the text message
+      if (buf.length > 8 && buf[1] === BinaryChannel.JSON) {
+        const message = JSON.parse(unpackJson(Buffer.from(buf).subarray(8)));
+        for (const listener of socket.listeners(message?.type)) {
+          listener(message);
+        }
+        return;
+      }
+      const frame = decodeBinaryFrame(Buffer.from(buf));
+      const receivedAt = Date.now();
+      // Records replayed after a reconnect / ack timeout were already stored
+      const firstSeq = frame.seq - frame.records.length + 1;
+      const skip = acks.accept(frame.seq, frame.records.length);
+      const records = frame.records.slice(skip);
+      if (records.length === 0) {
+        return;
+      }
+      const readings: SensorReading[] = records.map((record, i) => ({
+        id: `${deviceId}-${(firstSeq + skip + i) & 0xffff}-${record.sensorType}`,
+        type: record.sensorType as SensorReading['type'],
+        value: record.value,
+        unit: record.unit,
+        timestamp: new Date(receivedAt - (frame.timestamp - record.sampledAt)),
+        deviceId,
+      }));
+
+      if (frame.channel === BinaryChannel.SENSOR_ALERT) {
+        broadcastToRoom('web-clients', WebSocketEvent.SENSOR_ALERT, {
+          deviceId,
+          alerts: records,
+          timestamp: new Date(receivedAt),
+        });
+        return;
+      }
+
+      await saveSensorData(readings);
+      broadcastToRoom('web-clients', WebSocketEvent.SENSOR_DATA, {
+        deviceId,
+        data: readings,
+        timestamp: new Date(receivedAt),
+      });
+    } catch (error) {
+      logger.error('Error handling binary telemetry:', error);
+      socket.emit(WebSocketEvent.ERROR, {
+        code: 'BINARY_FRAME_ERROR',
+        message: 'Failed to decode binary telemetry frame',
+      });
+    }
+  });
+
   // Handle sensor data
   socket.on(WebSocketEvent.SENSOR_DATA, async (data: SensorReading | SensorReading[]) => {
     try {
       logger.debug({ event: 'sensor_data', deviceId, data });
 
+      // Queued firmware messages carry seq (= last reading); drop replayed readings
+      const message = data as any;
+      if (typeof message?.seq === 'number') {
+        const batch = message.payload?.readings;
+        const count = Array.isArray(batch) ? batch.length : 1;
+        const skip = acks.accept(message.seq, count);
+        if (skip >= count) {
+          return;
+        }
+        if (skip > 0) {
+          message.payload.readings = batch.slice(skip);
+        }
+      }
+
       // Save to database
       await saveSensorData(data);
 
@@ -42,6 +145,18 @@ export const handleESP32Connection = (socket: Socket) => {
     }
   });
 
+  // JSON alerts from the outbound queue (binary alerts arrive on telemetry:bin)
+  socket.on(WebSocketEvent.SENSOR_ALERT, (message: any) => {
+    if (typeof message?.seq === 'number' && acks.accept(message.seq, 1) > 0) {
+      return;
+    }
+    broadcastToRoom('web-clients', WebSocketEvent.SENSOR_ALERT, {
+      deviceId,
+      alerts: [message?.payload],
+      timestamp: new Date(),
+    });
+  });
+
   // Handle robot status updates
   socket.on(WebSocketEvent.ROBOT_STATUS, async (status: RobotStatus) => {
     try {
@@ -83,14 +198,36 @@ export const handleESP32Connection = (socket: Socket) => {
     // Command acknowledgment from ESP32
   });
 
-  // Heartbeat
-  socket.on('heartbeat', () => {
-    socket.emit('heartbeat_ack', { timestamp: Date.now() });
+  // End-to-end trace spans (robot hops: voice.capture, voice.upload, tts.playback,
+  // screen.emotion), startUs in epoch microseconds once the device clock is synced
+  socket.on('status_update', (message: any) => {
+    if (message?.payload?.status !== 'trace') {
+      return;
+    }
+    const spans = Array.isArray(message.payload.spans) ? message.payload.spans : [];
+    logger.debug({ event: 'trace_spans', deviceId, clock: message.payload.clock, spans });
+    broadcastToRoom('web-clients', 'trace:spans', {
+      deviceId,
+      clock: message.payload.clock,
+      clockRttUs: message.payload.clockRttUs,
+      spans,
+    });
+  });
+
+  // Heartbeat: typed as an ack so the firmware takes the clock sample from it
+  socket.on('heartbeat', (message: any) => {
+    const receivedUs = nowUs();
+    socket.emit('heartbeat_ack', {
+      type: 'ack',
+      payload: { clock: clockSample(message?.payload?.clientSentUs, receivedUs) },
+      timestamp: Date.now(),
+    });
   });
 
   // Disconnection
   socket.on('disconnect', (reason) => {
     logger.info(`ESP32 device disconnected: ${deviceId} - ${reason}`);
+    acks.dispose();
     
     // Notify web clients
     broadcastToRoom('web-clients', WebSocketEvent.ESP32_DISCONNECTED, {
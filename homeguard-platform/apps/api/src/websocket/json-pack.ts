@@ -0,0 +1,72 @@
+// "dict1": dictionary-coded JSON sent by the ESP32 firmware on CHANNEL_JSON.
+// Mirrors Firmware/esp32/lib/WebSocketClient/JsonPack.h; the dictionary is part
+// of the format, so any change needs a new name on both sides.
+//
+//   byte < 0x80          ASCII character as is
+//   0x80 + i (i < 127)   JSON_PACK_DICT[i]
+//   0xFF b               literal byte b >= 0x80 (UTF-8 inside strings)
+
+export const JSON_PACK_NAME = 'dict1';
+
+const ESCAPE = 0xff;
+
+// Order matters: index i is code 0x80 + i
+const JSON_PACK_DICT: string[] = [
+  // Envelope
+  '{"id":"', '","type":"', '","source":"esp32","robotId":"', '","timestamp":',
+  ',"timeUs":', ',"traceId":"', '","payload":{', ',"payload":{', ',"seq":',
+  ',"requiresAck":true', '","target":"ai_engine"',
+  // Message types
+  'connection_init', 'sensor_data', 'sensor_alert', 'voice_command', 'heartbeat', 'status_update',
+  'error', 'ack',
+  // Sensors
+  '"sensorType":"', '","sensorName":"', ',"value":', ',"unit":"', '","alertLevel":"',
+  ',"location":"robot_main"}', '"readings":[{', '},{', ',"active":', ',"latencyUs":',
+  ',"restored":true', 'temperature', 'humidity', 'distance', 'motion', 'flame', 'light', 'sound',
+  'normal"', 'warning"', 'danger"', 'critical"',
+  // Voice / status / trace
+  '"status":"', '"action":"', ',"streamId":', ',"sampleRate":16000', ',"codec":"',
+  'pcm16', 'adpcm', 'opus', ',"durationMs":', '"messageId":"', '"error":"',
+  '"clientSentUs":', ',"bootEpochUs":', ',"clock":"server"', '"clock":"',
+  ',"clockRttUs":', ',"dropped":', ',"spans":[{', '"traceId":"', '","name":"',
+  '","startUs":', ',"durUs":', 'voice.capture', 'voice.upload', 'tts.playback', 'screen.emotion',
+  // connection_init
+  '"userId":null', ',"ipAddress":"', '","resumeSeq":', ',"clientSentUs":',
+  ',"encodings":["bin1","json"]', ',"audioCodecs":["', ',"compression":["dict1"]',
+  // Common
+  'true', 'false', '}}', '","', '":"', '":',
+];
+
+const DICT_BYTES = JSON_PACK_DICT.map((entry) => Buffer.from(entry, 'utf8'));
+
+// Accept "dict1" if the firmware offered it in connection_init.compression
+export const negotiateCompression = (offered: unknown): string | undefined =>
+  Array.isArray(offered) && offered.includes(JSON_PACK_NAME) ? JSON_PACK_NAME : undefined;
+
+export const unpackJson = (data: Buffer): string => {
+  const parts: Buffer[] = [];
+  let start = 0;
+  for (let pos = 0; pos < data.length; pos++) {
+    const b = data[pos];
+    if (b < 0x80) {
+      continue;
+    }
+    parts.push(data.subarray(start, pos));
+    if (b === ESCAPE) {
+      if (pos + 1 >= data.length) {
+        throw new Error('dict1: truncated escape');
+      }
+      pos++;
+      parts.push(data.subarray(pos, pos + 1));
+    } else {
+      const entry = DICT_BYTES[b - 0x80];
+      if (!entry) {
+        throw new Error(`dict1: unknown code 0x${b.toString(16)}`);
+      }
+      parts.push(entry);
+    }
+    start = pos + 1;
+  }
+  parts.push(data.subarray(start));
+  return Buffer.concat(parts).toString('utf8');
+};
@@ -0,0 +1,63 @@
+// Per-robot upload limits for the firmware's RateBudget
+// (Firmware/esp32/lib/WebSocketClient/RateBudget.h).
+//
+// Sent as `rateLimit` in the connection_init ack (and any later ack or
+// behavior_update). Telemetry is counted in sensor_data messages, audio in
+// payload bytes. `perSec` refills a token bucket capped at `burst` (defaults
+// to one second's worth); `credits` is a one-off top-up; `false` lifts the
+// limit. Alerts are never throttled by the firmware. Limits reset on
+// reconnect, so the ack must always carry the current values.
+
+import { logger } from '@/utils/logger';
+
+export interface RateBudgetSpec {
+  perSec?: number;
+  burst?: number;
+  credits?: number;
+}
+
+export interface RateLimit {
+  telemetry?: RateBudgetSpec | false;
+  audio?: RateBudgetSpec | false;
+}
+
+// Empty or whitespace-only values count as unset: Number('') is 0, which
+// would otherwise turn `ROBOT_TELEMETRY_PER_SEC=` into a zero budget
+const envNumber = (name: string): number | undefined => {
+  const raw = process.env[name];
+  if (raw === undefined || raw.trim() === '') {
+    return undefined;
+  }
+  const value = Number(raw);
+  return Number.isFinite(value) && value >= 0 ? Math.floor(value) : undefined;
+};
+
+const warned = new Set<string>();
+
+const budgetFromEnv = (perSecVar: string, burstVar: string): RateBudgetSpec | undefined => {
+  const perSec = envNumber(perSecVar);
+  if (perSec === undefined) {
+    return undefined;
+  }
+  const burst = envNumber(burstVar);
+  // No refill and no bucket blocks that channel on every robot until credits
+  // arrive; treat it as a misconfiguration and leave the channel unlimited
+  if (perSec === 0 && !burst) {
+    if (!warned.has(perSecVar)) {
+      warned.add(perSecVar);
+      logger.warn(`${perSecVar}=0 with no ${burstVar} would block every robot; ignoring it`);
+    }
+    return undefined;
+  }
+  return burst === undefined ? { perSec } : { perSec, burst };
+};
+
+// Fleet-wide defaults; unset variables leave that channel unlimited
+export const defaultRateLimit = (): RateLimit | undefined => {
+  const telemetry = budgetFromEnv('ROBOT_TELEMETRY_PER_SEC', 'ROBOT_TELEMETRY_BURST');
+  const audio = budgetFromEnv('ROBOT_AUDIO_BYTES_PER_SEC', 'ROBOT_AUDIO_BURST');
+  if (!telemetry && !audio) {
+    return undefined;
+  }
+  return { ...(telemetry && { telemetry }), ...(audio && { audio }) };
+};